@@ -0,0 +1,612 @@
+/**
+ * main.cpp - nppopenai-cli, a headless front-end for the NppOpenAI request pipeline
+ *
+ * Reads the question from stdin, applies a prompt from the instructions file and
+ * writes the answer to stdout. Requests go through the same ChatPipeline,
+ * HTTPClient, formatters and parsers as the Notepad++ plugin, so end-to-end
+ * latency can be measured with the usual tools (time, perf, strace, ...).
+ *
+ * Built with -DNPPOPENAI_COUNT_ALLOCATIONS=ON, --verbose also reports heap
+ * allocations per streamed token, the transient peak and the bytes still held
+ * after the request, and --soak sends the question N times and fails if the
+ * retained memory keeps growing.
+ *
+ * --preconnect treats the question like a selection the user keeps for the
+ * dwell time, so the connection is opened before the request (as the plugin
+ * does with preconnect=1), and reports whether the request used it.
+ *
+ * --follow-up sends a second question after the answer, in the same
+ * conversation; with ollama_context=1 it continues from the first exchange's
+ * Ollama context like a second ask on the same document in the plugin.
+ * --pause waits before it, e.g. to let a realtime session (realtime=1) go idle.
+ *
+ * --warm-up only loads the configured Ollama model (the plugin's background
+ * warm-up) and reports how long the load took and whether /api/ps lists it.
+ *
+ * Usage: nppopenai-cli [--config NppOpenAI.ini] [--instructions NppOpenAI_instructions]
+ *                      [--prompt name] [--profile name] [--no-stream] [--verbose]
+ *                      [--capture-dir dir] [--soak N [--soak-tolerance bytes]] [--trace file]
+ *                      [--preconnect] [--follow-up text [--pause ms]]
+ *        nppopenai-cli --warm-up [--config NppOpenAI.ini] [--profile name]
+ *        nppopenai-cli --replay file.fixture [--replay-speed 1] [--verbose] [--trace file]
+ */
+
+#include "api/ChatPipeline.h"
+#include "api/HTTPClient.h"
+#include "api/ModelWarmup.h"
+#include "api/Preconnector.h"
+#include "api/RealtimeSession.h"
+#include "api/ResponseParsers.h"
+#include "api/StreamFixture.h"
+#include "api/TransferHost.h"
+#include "config/ConfigSnapshot.h"
+#include "config/IniFile.h"
+#include "config/ProfileManager.h"
+#include "config/PromptManager.h"
+#include "utils/EncodingUtils.h"
+#include "utils/Trace.h"
+#ifdef NPPOPENAI_COUNT_ALLOCATIONS
+#include "AllocationCounter.h"
+#endif
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Debug switch read by StreamParser (the plugin toggles it from its menu)
+bool debugMode = false;
+
+namespace
+{
+    std::atomic<bool> g_interrupted(false);
+    int g_slowOutputMs = 0; // --slow-output: simulated busy front-end
+
+    extern "C" void onInterrupt(int)
+    {
+        g_interrupted = true;
+    }
+
+    /**
+     * Console TransferHost: answer to stdout, progress to stderr, Ctrl+C cancels
+     */
+    class ConsoleTransferHost : public TransferHost
+    {
+    public:
+        explicit ConsoleTransferHost(bool verbose) : _verbose(verbose) {}
+
+        bool isCancelled() const override
+        {
+            return g_interrupted;
+        }
+
+        void showStatus(const std::wstring &message) override
+        {
+            std::fprintf(stderr, "%s\n", toUTF8(message).c_str());
+        }
+
+        void showDebugStatus(const std::wstring &message) override
+        {
+            if (_verbose)
+            {
+                showStatus(message);
+            }
+        }
+
+        bool deliverContent(const std::string &content) override
+        {
+            TraceSpan span("write output", "output");
+            span.setArg("bytes", static_cast<int64_t>(content.size()));
+            if (!_firstContent)
+            {
+                _firstContent = true;
+                _firstContentAt = std::chrono::steady_clock::now();
+            }
+            std::fwrite(content.data(), 1, content.size(), stdout);
+            std::fflush(stdout);
+            if (g_slowOutputMs > 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(g_slowOutputMs));
+            }
+            return true;
+        }
+
+        bool hasFirstContent() const { return _firstContent; }
+        std::chrono::steady_clock::time_point firstContentAt() const { return _firstContentAt; }
+
+    private:
+        bool _verbose;
+        bool _firstContent = false;
+        std::chrono::steady_clock::time_point _firstContentAt;
+    };
+
+    void printUsage()
+    {
+        std::fprintf(stderr,
+                     "Usage: nppopenai-cli [options] < question.txt\n"
+                     "  --config FILE        NppOpenAI.ini to read [API] and [Profile:name] from (default: NppOpenAI.ini)\n"
+                     "  --instructions FILE  Prompt file, same format as NppOpenAI_instructions\n"
+                     "  --prompt NAME        Prompt of the instructions file to use\n"
+                     "  --profile NAME       Send to this profile instead of [API]\n"
+                     "  --no-stream          Disable streaming\n"
+                     "  --slow-output MS     Block MS milliseconds after each piece of output, like a busy editor\n"
+                     "  --verbose            Show debug and timing information on stderr\n"
+                     "  --capture-dir DIR    Save the raw response as a replay fixture in DIR\n"
+                     "  --replay FILE        Play a recorded fixture through the parsers instead of sending a request\n"
+                     "  --replay-speed X     Replay timing scale (1 = recorded pace, 0 = no delays; default 1)\n"
+                     "  --soak N             Send the question N times, fail if retained memory grows\n"
+                     "                       (needs a build with NPPOPENAI_COUNT_ALLOCATIONS)\n"
+                     "  --soak-tolerance B   Growth in bytes allowed between the first and last request (default 16384)\n"
+                     "  --trace FILE         Write the timeline of the run to FILE (Chrome trace format, open in ui.perfetto.dev)\n"
+                     "  --preconnect         Connect during a simulated selection dwell, then send (see preconnect=1)\n"
+                     "  --follow-up TEXT     Then send TEXT in the same conversation (see ollama_context=1)\n"
+                     "  --pause MS           Wait MS milliseconds before the follow-up\n"
+                     "  --warm-up            Only load the Ollama model of the profile and report the load time\n");
+    }
+
+    /**
+     * Records a trace while in scope and writes it to 'path' at the end of the run
+     */
+    class TraceFile
+    {
+    public:
+        explicit TraceFile(const std::string &path) : _path(path)
+        {
+            if (!_path.empty())
+            {
+                Trace::setEnabled(true);
+                Trace::setThreadName("main");
+            }
+        }
+
+        ~TraceFile()
+        {
+            if (!_path.empty() && !Trace::exportJson(_path))
+            {
+                std::fprintf(stderr, "Cannot write %s\n", _path.c_str());
+            }
+        }
+
+    private:
+        std::string _path;
+    };
+
+    void printTransferStats(const TransferStats &stats)
+    {
+        std::fprintf(stderr, "received: %zu bytes in %zu chunks, %zu content events, peak buffer %zu bytes\n",
+                     stats.bytesReceived, stats.chunks, stats.contentEvents, stats.peakBufferBytes);
+        if (stats.peakQueuedBytes > 0)
+        {
+            std::fprintf(stderr, "output queue: peak %zu bytes, paused %zu times for %.1f ms\n",
+                         stats.peakQueuedBytes, stats.pauses, stats.pausedMs);
+        }
+    }
+
+#ifdef NPPOPENAI_COUNT_ALLOCATIONS
+    /**
+     * Heap usage of one request: taken before it starts and after its result is gone
+     */
+    struct MemoryProbe
+    {
+        AllocationCounter::Counts before;
+
+        MemoryProbe()
+        {
+            AllocationCounter::resetPeak();
+            before = AllocationCounter::snapshot();
+        }
+
+        // Heap bytes held now that were not held before the request
+        int64_t retainedBytes() const
+        {
+            return AllocationCounter::snapshot().liveBytes - before.liveBytes;
+        }
+
+        void print(size_t contentEvents) const
+        {
+            AllocationCounter::Counts after = AllocationCounter::snapshot();
+            uint64_t allocations = after.allocations - before.allocations;
+            std::fprintf(stderr, "heap: %llu allocations (%.1f per token), %llu bytes allocated, peak transient %lld bytes, retained %lld bytes\n",
+                         static_cast<unsigned long long>(allocations),
+                         contentEvents ? double(allocations) / contentEvents : 0.0,
+                         static_cast<unsigned long long>(after.bytes - before.bytes),
+                         static_cast<long long>(after.peakBytes - before.liveBytes),
+                         static_cast<long long>(after.liveBytes - before.liveBytes));
+        }
+    };
+#endif
+
+    /**
+     * Replay a fixture through HTTPClient's callbacks and the response parsers
+     */
+    int replayFixture(const std::string &path, double speed, bool verbose)
+    {
+        StreamFixture fixture;
+        if (!fixture.load(path))
+        {
+            std::fprintf(stderr, "Cannot read fixture %s\n", path.c_str());
+            return 1;
+        }
+
+        ConsoleTransferHost host(verbose);
+        TransferHost::install(&host);
+
+        auto startTime = std::chrono::steady_clock::now();
+        std::string response;
+        TransferInfo transferInfo;
+        bool ok = HTTPClient::replay(fixture, speed, response, &transferInfo);
+        if (ok && !fixture.streaming)
+        {
+            // No configuration is read for a replay: reasoning is handled like the plugin's default
+            host.deliverContent(ResponseParsers::getParserForEndpoint(stringToWstring(fixture.apiType))(response, ConfigSnapshot().showReasoning));
+        }
+        std::fputc('\n', stdout);
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        TransferHost::install(nullptr);
+
+        if (verbose)
+        {
+            std::fprintf(stderr, "%s, HTTP %ld, %zu chunks, %zu bytes in %.2f ms (%.1f MB/s), recorded %.1f ms\n",
+                         fixture.apiType.c_str(), fixture.httpStatus, fixture.chunks.size(), fixture.totalBytes(), elapsedMs,
+                         elapsedMs > 0 ? fixture.totalBytes() / elapsedMs / 1000.0 : 0.0, fixture.durationUs() / 1000.0);
+            printTransferStats(transferInfo.stats);
+        }
+        if (!ok)
+        {
+            std::fprintf(stderr, "Recorded transfer failed (HTTP %ld, cURL %d)\n", fixture.httpStatus, transferInfo.curlCode);
+            if (!response.empty())
+                std::fprintf(stderr, "%s\n", response.c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+    /**
+     * Send 'question' once, print the answer to stdout and, with 'verbose', timing and counters to stderr
+     *
+     * @return Process exit code (0 = answered, 1 = failed, 130 = interrupted)
+     */
+    int sendQuestion(const std::string &question, const std::wstring &systemPrompt,
+                     const std::shared_ptr<const ConfigSnapshot> &config, bool verbose, TransferStats &stats)
+    {
+        ConsoleTransferHost host(verbose);
+        TransferHost::install(&host);
+        TraceSpan askSpan("ask", "cli");
+
+        auto startTime = std::chrono::steady_clock::now();
+        ChatResult result = ChatPipeline::send(question, systemPrompt, config, ChatPipeline::candidateEndpoints(*config), L"cli");
+        if ((result.ok || (g_interrupted && result.collected)) && !config->streaming)
+        {
+            // Interrupted: print what was collected so far, as a stream would have
+            host.deliverContent(ChatPipeline::answerText(result, config->showReasoning));
+        }
+        if (result.ok)
+        {
+            std::fputc('\n', stdout);
+        }
+        auto endTime = std::chrono::steady_clock::now();
+
+        TransferHost::install(nullptr);
+        stats = result.stats;
+
+        if (!result.ok)
+        {
+            if (!g_interrupted)
+            {
+                std::fprintf(stderr, "%s\n", toUTF8(ChatPipeline::errorMessage(result)).c_str());
+            }
+            return g_interrupted ? 130 : 1;
+        }
+
+        if (verbose)
+        {
+            auto ms = [&](std::chrono::steady_clock::time_point at)
+            { return std::chrono::duration<double, std::milli>(at - startTime).count(); };
+            std::fprintf(stderr, "endpoint: %s, ttfb: %.1f ms, first content: %.1f ms, total: %.1f ms\n",
+                         toUTF8(result.endpointName).c_str(), result.ttfbMs,
+                         host.hasFirstContent() ? ms(host.firstContentAt()) : -1.0, ms(endTime));
+            printTransferStats(result.stats);
+            if (result.realtime)
+            {
+                std::fprintf(stderr, "realtime: session %s (%d opened so far)\n", result.sessionOpened ? "opened" : "reused",
+                             RealtimeSession::instance().connects());
+            }
+            if (result.usage.known())
+            {
+                std::fprintf(stderr, "usage: %lld prompt tokens (%lld cached, %lld written to cache), %lld completion tokens\n",
+                             static_cast<long long>(result.usage.promptTokens), static_cast<long long>(result.usage.cachedTokens),
+                             static_cast<long long>(result.usage.cacheWriteTokens), static_cast<long long>(result.usage.completionTokens));
+            }
+            if (result.usage.serverPromptMs >= 0)
+            {
+                std::fprintf(stderr, "server: prompt %.1f ms, %.1f tokens/s\n", result.usage.serverPromptMs, result.usage.tokensPerSecond);
+            }
+            if (config->ollamaContext)
+            {
+                std::fprintf(stderr, "context: %zu tokens sent, %zu tokens received\n",
+                             result.contextTokensSent, result.contextTokensReceived);
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * Pre-connect as the plugin does when 'question' is selected and the selection is kept for the dwell time
+     */
+    void preconnectForSelection(const std::shared_ptr<const ConfigSnapshot> &config, const std::string &question, bool verbose)
+    {
+        std::shared_ptr<ConfigSnapshot> enabled = std::make_shared<ConfigSnapshot>(*config);
+        enabled->preconnect = true;
+
+        Preconnector &preconnector = Preconnector::instance();
+        preconnector.configure(enabled);
+        auto startTime = std::chrono::steady_clock::now();
+        preconnector.noteSelection(question.size());
+        preconnector.waitIdle(enabled->preconnectDwellMs + 30000);
+        if (verbose)
+        {
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+            std::fprintf(stderr, "preconnect: dwell and connect took %.1f ms\n", ms);
+        }
+    }
+
+    /**
+     * Load the model of 'config' the way the plugin does on startup and report the result
+     *
+     * @return 0 if the model was loaded and is listed by /api/ps
+     */
+    int warmUpModel(const std::shared_ptr<const ConfigSnapshot> &config)
+    {
+        if (config->provider != Provider::Ollama || !config->ollamaWarmup)
+        {
+            std::fprintf(stderr, "Warm-up needs response_type=ollama and ollama_warmup=1\n");
+            return 2;
+        }
+
+        ModelWarmup &warmup = ModelWarmup::instance();
+        warmup.warmUp(config);
+        bool idle = warmup.waitIdle(600000);
+        ModelWarmup::Status status = warmup.status();
+        warmup.shutdown();
+        HTTPClient::shutdown();
+
+        std::string model = toUTF8(config->model);
+        if (!idle || status.lastLoadMs < 0)
+        {
+            std::fprintf(stderr, "Loading %s failed\n", model.c_str());
+            return 1;
+        }
+        std::fprintf(stderr, "Loaded %s in %.0f ms, %s\n", model.c_str(), status.lastLoadMs,
+                     status.resident ? "resident" : "not listed by /api/ps");
+        return status.resident ? 0 : 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::string configPath = "NppOpenAI.ini";
+    std::string instructionsPath;
+    std::string promptName;
+    std::string profileName;
+    std::string captureDir;
+    std::string replayPath;
+    double replaySpeed = 1.0;
+    int soakCount = 0;
+    long long soakTolerance = 16384;
+    std::string tracePath;
+    std::string followUp;
+    int pauseMs = 0;
+    bool warmUp = false;
+    bool preconnect = false;
+    bool noStream = false;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--config" && hasValue)
+            configPath = argv[++i];
+        else if (arg == "--instructions" && hasValue)
+            instructionsPath = argv[++i];
+        else if (arg == "--prompt" && hasValue)
+            promptName = argv[++i];
+        else if (arg == "--profile" && hasValue)
+            profileName = argv[++i];
+        else if (arg == "--capture-dir" && hasValue)
+            captureDir = argv[++i];
+        else if (arg == "--replay" && hasValue)
+            replayPath = argv[++i];
+        else if (arg == "--replay-speed" && hasValue)
+            replaySpeed = std::atof(argv[++i]);
+        else if (arg == "--soak" && hasValue)
+            soakCount = std::atoi(argv[++i]);
+        else if (arg == "--soak-tolerance" && hasValue)
+            soakTolerance = std::atoll(argv[++i]);
+        else if (arg == "--trace" && hasValue)
+            tracePath = argv[++i];
+        else if (arg == "--follow-up" && hasValue)
+            followUp = argv[++i];
+        else if (arg == "--pause" && hasValue)
+            pauseMs = std::atoi(argv[++i]);
+        else if (arg == "--slow-output" && hasValue)
+            g_slowOutputMs = std::atoi(argv[++i]);
+        else if (arg == "--warm-up")
+            warmUp = true;
+        else if (arg == "--preconnect")
+            preconnect = true;
+        else if (arg == "--no-stream")
+            noStream = true;
+        else if (arg == "--verbose")
+            verbose = true;
+        else
+        {
+            printUsage();
+            return (arg == "--help" || arg == "-h") ? 0 : 2;
+        }
+    }
+
+#ifndef NPPOPENAI_COUNT_ALLOCATIONS
+    if (soakCount > 0)
+    {
+        std::fprintf(stderr, "--soak needs a build configured with -DNPPOPENAI_COUNT_ALLOCATIONS=ON\n");
+        return 2;
+    }
+#endif
+
+    std::signal(SIGINT, onInterrupt);
+    TraceFile traceFile(tracePath);
+    if (!replayPath.empty())
+    {
+        return replayFixture(replayPath, replaySpeed, verbose);
+    }
+
+    // Configuration: [API] is the base, [Profile:name] sections override it like in the plugin
+    IniFile ini;
+    if (!ini.load(stringToWstring(configPath)))
+    {
+        std::fprintf(stderr, "Cannot read %s\n", configPath.c_str());
+        return 1;
+    }
+    std::shared_ptr<ConfigSnapshot> base = ConfigSnapshot::fromSection(ConfigSnapshot(), ini, L"API");
+    std::vector<std::shared_ptr<const ConfigSnapshot>> profiles;
+    for (const std::wstring &section : ini.sections())
+    {
+        if (section.size() > 8 && section.compare(0, 8, L"Profile:") == 0)
+        {
+            profiles.push_back(ConfigSnapshot::forProfile(*base, ini, section.substr(8)));
+        }
+    }
+    ProfileManager::instance().setProfiles(base, profiles, L"");
+
+    std::shared_ptr<const ConfigSnapshot> config = ProfileManager::instance().snapshot(stringToWstring(profileName));
+    if (!config)
+    {
+        std::fprintf(stderr, "Unknown profile: %s\n", profileName.c_str());
+        return 1;
+    }
+    if (warmUp)
+    {
+        return warmUpModel(config);
+    }
+
+    // Prompt: the named one, or the only one in the file
+    std::vector<Prompt> prompts;
+    if (!instructionsPath.empty())
+    {
+        parseInstructionsFile(stringToWstring(instructionsPath).c_str(), prompts);
+    }
+    setPromptCatalog(std::move(prompts));
+    std::shared_ptr<const std::vector<Prompt>> catalog = promptCatalog();
+    const Prompt *selectedPrompt = nullptr;
+    for (const Prompt &prompt : *catalog)
+    {
+        if (toUTF8(prompt.name) == promptName)
+        {
+            selectedPrompt = &prompt;
+            break;
+        }
+    }
+    if (!selectedPrompt && !promptName.empty())
+    {
+        std::fprintf(stderr, "Unknown prompt: %s\n", promptName.c_str());
+        return 1;
+    }
+    if (!selectedPrompt && catalog->size() == 1)
+    {
+        selectedPrompt = &catalog->front();
+    }
+    config = resolvePromptConfig(selectedPrompt, config);
+    if ((noStream && config->streaming) || !captureDir.empty())
+    {
+        std::shared_ptr<ConfigSnapshot> copy = std::make_shared<ConfigSnapshot>(*config);
+        copy->streaming = copy->streaming && !noStream;
+        if (!captureDir.empty())
+            copy->captureDir = captureDir;
+        config = copy;
+    }
+    std::wstring systemPrompt = selectedPrompt ? selectedPrompt->content : config->instructions;
+
+    std::string question((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+    if (question.empty())
+    {
+        std::fprintf(stderr, "No question on stdin.\n");
+        return 2;
+    }
+
+    if (preconnect)
+    {
+        preconnectForSelection(config, question, verbose);
+    }
+
+    if (soakCount <= 0)
+    {
+#ifdef NPPOPENAI_COUNT_ALLOCATIONS
+        MemoryProbe probe;
+#endif
+        TransferStats stats;
+        int exitCode = sendQuestion(question, systemPrompt, config, verbose, stats);
+#ifdef NPPOPENAI_COUNT_ALLOCATIONS
+        if (verbose && exitCode == 0)
+            probe.print(stats.contentEvents);
+#endif
+        if (exitCode == 0 && !followUp.empty())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(pauseMs));
+            exitCode = sendQuestion(followUp, systemPrompt, config, verbose, stats);
+        }
+        if (preconnect && verbose)
+        {
+            Preconnector::Stats preconnectStats = Preconnector::instance().stats();
+            std::fprintf(stderr, "preconnect: %d made (%d new connections), %d used, %d wasted, %d skipped, %d failed\n",
+                         preconnectStats.preconnects, preconnectStats.newConnections, preconnectStats.hits,
+                         preconnectStats.wasted, preconnectStats.skipped, preconnectStats.failures);
+        }
+        Preconnector::instance().shutdown();
+        HTTPClient::shutdown();
+        return exitCode;
+    }
+
+#ifdef NPPOPENAI_COUNT_ALLOCATIONS
+    // Soak: the first request warms up the connection cache and lazily built state;
+    // what the following ones retain on top of that is a leak
+    MemoryProbe baseline;
+    int64_t firstRetained = 0;
+    int64_t lastRetained = 0;
+    for (int i = 1; i <= soakCount; ++i)
+    {
+        MemoryProbe probe;
+        TransferStats stats;
+        int exitCode = sendQuestion(question, systemPrompt, config, verbose, stats);
+        if (exitCode != 0)
+        {
+            HTTPClient::shutdown();
+            return exitCode;
+        }
+        if (verbose)
+            probe.print(stats.contentEvents);
+
+        lastRetained = baseline.retainedBytes();
+        if (i == 1)
+            firstRetained = lastRetained;
+        std::fprintf(stderr, "soak %d/%d: retained %lld bytes\n", i, soakCount, static_cast<long long>(lastRetained));
+    }
+    HTTPClient::shutdown();
+
+    long long growth = static_cast<long long>(lastRetained - firstRetained);
+    if (growth > soakTolerance)
+    {
+        std::fprintf(stderr, "Retained memory grew by %lld bytes over %d requests (tolerance %lld)\n",
+                     growth, soakCount - 1, soakTolerance);
+        return 1;
+    }
+    std::fprintf(stderr, "Retained memory stable: %+lld bytes over %d requests\n", growth, soakCount - 1);
+#endif
+    return 0;
+}
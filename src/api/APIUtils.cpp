@@ -1,7 +1,7 @@
 #include "APIUtils.h"
 #include "EncodingUtils.h"
 #include "config/PromptManager.h"
-#include "core/external_globals.h"
+#include "config/ConfigSnapshot.h"
 #include "RequestFormatters.h"
 
 /**
@@ -49,6 +49,49 @@ std::string APIUtils::buildApiUrl(const std::string &baseUrl, const std::string
     return url;
 }
 
+/**
+ * Build the URL of a chat request for an endpoint
+ *
+ * Like buildApiUrl, plus "{model}" in the route is replaced by the model
+ * (Gemini: models/{model}:generateContent). Gemini streams from a different
+ * method of the same model, so a streaming request goes to
+ * :streamGenerateContent?alt=sse (Server-Sent Events) instead.
+ *
+ * @param baseUrl The base URL of the API
+ * @param chatRoute The chat route of the endpoint
+ * @param model The model of the endpoint
+ * @param responseType The response type of the endpoint
+ * @param streaming Whether the request streams
+ * @return The complete URL for the request
+ */
+std::string APIUtils::buildRequestUrl(const std::string &baseUrl, const std::string &chatRoute, const std::wstring &model,
+                                      const std::wstring &responseType, bool streaming)
+{
+    std::string route = chatRoute;
+    const std::string placeholder = "{model}";
+    size_t pos = route.find(placeholder);
+    if (pos != std::string::npos)
+    {
+        route.replace(pos, placeholder.size(), toUTF8(model));
+    }
+
+    std::string url = buildApiUrl(baseUrl, route);
+    if (streaming && responseType == L"gemini")
+    {
+        const std::string method = ":generateContent";
+        pos = url.find(method);
+        if (pos != std::string::npos)
+        {
+            url.replace(pos, method.size(), ":streamGenerateContent");
+        }
+        if (url.find("alt=sse") == std::string::npos)
+        {
+            url += (url.find('?') == std::string::npos) ? "?alt=sse" : "&alt=sse";
+        }
+    }
+    return url;
+}
+
 /**
  * Get the system prompt from configuration or prompt file
  *
@@ -56,13 +99,13 @@ std::string APIUtils::buildApiUrl(const std::string &baseUrl, const std::string
  */
 std::wstring APIUtils::getSystemPrompt()
 {
-    // Parse prompts from instructions file
-    std::vector<Prompt> prompts;
-    parseInstructionsFile(instructionsFilePath, prompts);
+    // Prompts parsed from the instructions file when the configuration was loaded
+    std::shared_ptr<const std::vector<Prompt>> catalog = promptCatalog();
+    const std::vector<Prompt> &prompts = *catalog;
 
     // If no prompts in file, use default from configuration
     if (prompts.empty())
-        return configAPIValue_instructions;
+        return ConfigSnapshot::current()->instructions;
 
     // If only one prompt, use it
     if (prompts.size() == 1)
@@ -107,7 +150,7 @@ std::string APIUtils::prepareApiRequest(
     // Format request using the selected formatter
     std::string request = formatter(
         model,
-        multiByteToWideChar(selectedText.c_str()),
+        multiByteToWstring(selectedText),
         systemPrompt,
         temperature,
         maxTokens,
@@ -116,8 +159,8 @@ std::string APIUtils::prepareApiRequest(
         presencePenalty,
         keepAlive);
 
-    // Add streaming parameter if needed
-    if (streaming)
+    // Add streaming parameter if needed (Gemini selects streaming by URL and rejects unknown fields)
+    if (streaming && responseType != L"gemini")
     {
         auto pos = request.rfind('}');
         if (pos != std::string::npos)
@@ -12,6 +12,10 @@ namespace APIUtils
     // Build API URL with proper endpoints
     std::string buildApiUrl(const std::string &baseUrl, const std::string &chatRoute);
 
+    // Build the URL of a chat request ("{model}" in the route, Gemini's streaming method)
+    std::string buildRequestUrl(const std::string &baseUrl, const std::string &chatRoute, const std::wstring &model,
+                                const std::wstring &responseType, bool streaming);
+
     // Get system prompt from configuration or selected file
     std::wstring getSystemPrompt();
 
@@ -0,0 +1,313 @@
+/**
+ * ChatPipeline.cpp - Endpoint selection, failover and hedging for one chat request
+ *
+ * Moved out of askChatGPT so the command-line client sends requests exactly
+ * like the plugin does.
+ */
+
+#include "ChatPipeline.h"
+#include "APIUtils.h"
+#include "EncodingUtils.h" // for toUTF8
+#include "HTTPClient.h"
+#include "HedgePolicy.h"
+#include "LlamaCppSlots.h"
+#include "OllamaContext.h"
+#include "Preconnector.h"
+#include "ProviderTraits.h"
+#include "RealtimeSession.h"
+#include "ResponseParsers.h"
+#include "TransferHost.h"
+#include "Trace.h"
+#include "config/ConfigSnapshot.h"
+#include "config/ProfileManager.h"
+#include <nlohmann/json.hpp>
+
+std::vector<Endpoint> ChatPipeline::candidateEndpoints(const ConfigSnapshot &config)
+{
+    // Candidate endpoints, best first; the others are tried in order if it is unavailable.
+    // A named profile is a single backend of its own.
+    std::vector<Endpoint> endpoints;
+    if (config.profile.empty())
+    {
+        endpoints = EndpointRouter::instance().rankedEndpoints();
+
+        // The endpoints carry the [API] model; a prompt's model= override replaces it on each of them
+        std::shared_ptr<const ConfigSnapshot> api = ProfileManager::instance().snapshot(L"");
+        if (api && config.model != api->model)
+        {
+            for (Endpoint &endpoint : endpoints)
+            {
+                endpoint.model = config.model;
+            }
+        }
+    }
+    if (endpoints.empty())
+    {
+        Endpoint endpoint;
+        endpoint.name = ProfileManager::displayName(config.profile);
+        endpoint.baseUrl = stringToWstring(config.baseUrl);
+        endpoint.chatRoute = stringToWstring(config.chatRoute);
+        endpoint.responseType = config.responseTypeW;
+        endpoint.secretKey = stringToWstring(config.secretKey);
+        endpoint.model = config.model;
+        endpoints.push_back(endpoint);
+    }
+    return endpoints;
+}
+
+ChatResult ChatPipeline::send(const std::string &text,
+                              const std::wstring &systemPrompt,
+                              const std::shared_ptr<const ConfigSnapshot> &config,
+                              const std::vector<Endpoint> &endpoints,
+                              const std::wstring &conversation)
+{
+    ChatResult result;
+    if (endpoints.empty())
+    {
+        return result;
+    }
+
+    TransferHost &host = TransferHost::current();
+    bool streaming = config->streaming;
+    std::string proxy = config->proxy;
+    result.responseType = endpoints.front().responseType;
+    result.endpointName = endpoints.front().name;
+
+    // With streaming off, the answer is still received as a stream where the API offers one, so the transfer
+    // reports the time to first token, fails on the first error line and leaves a partial answer on cancel
+    auto streamsAnswer = [&](const Endpoint &endpoint)
+    {
+        return streaming || (config->streamTransport && ProviderOps::forType(toUTF8(endpoint.responseType)).streams);
+    };
+
+    // Prepare API request with all necessary parameters, formatted for the endpoint's API type
+    auto prepareRequest = [&](const Endpoint &endpoint)
+    {
+        TraceSpan span("build request", "request");
+        span.setArg("text_bytes", static_cast<int64_t>(text.size()));
+        return APIUtils::prepareApiRequest(
+            text,
+            systemPrompt,
+            endpoint.model,
+            endpoint.responseType,
+            config->temperature,
+            config->maxTokens,
+            config->topP,
+            config->frequencyPenalty,
+            config->presencePenalty, config->keepAlive, streamsAnswer(endpoint));
+    };
+
+    // Only /api/generate has a context; what it is valid for depends on the endpoint
+    auto usesContext = [&](const Endpoint &endpoint)
+    {
+        return config->ollamaContext && !conversation.empty() && endpoint.responseType == L"ollama" &&
+               endpoint.chatRoute.find(L"generate") != std::wstring::npos;
+    };
+    auto contextFingerprint = [&](const Endpoint &endpoint)
+    {
+        return OllamaContext::fingerprint(APIUtils::buildApiUrl(toUTF8(endpoint.baseUrl), toUTF8(endpoint.chatRoute)),
+                                          endpoint.model, systemPrompt);
+    };
+    auto prepareForConversation = [&](const Endpoint &endpoint, size_t &contextTokens)
+    {
+        std::string request = prepareRequest(endpoint);
+        contextTokens = 0;
+        if (usesContext(endpoint))
+        {
+            std::string context = OllamaContext::instance().lookup(conversation, contextFingerprint(endpoint));
+            contextTokens = OllamaContext::tokenCount(context);
+            OllamaContext::addToRequest(request, context);
+        }
+
+        // A document keeps its llama-server slot, so the slot's KV cache still holds its prompt prefix
+        if (endpoint.responseType == L"llamacpp" && config->llamacppSlots > 0 && !conversation.empty())
+        {
+            LlamaCppSlots::addToRequest(request, LlamaCppSlots::instance().slotFor(conversation, config->llamacppSlots));
+        }
+        return request;
+    };
+
+    // OpenAI endpoints can stream over the persistent Realtime API session instead of a request per ask
+    auto usesRealtime = [&](const Endpoint &endpoint)
+    {
+        return config->realtime && streaming && endpoint.responseType == L"openai";
+    };
+
+    for (size_t i = 0; i < endpoints.size(); ++i)
+    {
+        const Endpoint &endpoint = endpoints[i];
+        result.responseType = endpoint.responseType;
+        result.endpointName = endpoint.name;
+        std::string request = prepareForConversation(endpoint, result.contextTokensSent);
+        bool streamed = streamsAnswer(endpoint);
+
+        // Build API URL with base URL and chat route
+        result.url = APIUtils::buildRequestUrl(toUTF8(endpoint.baseUrl), toUTF8(endpoint.chatRoute), endpoint.model,
+                                               endpoint.responseType, streamed);
+        std::string apiType = toUTF8(endpoint.responseType);
+        std::string secretKey = toUTF8(endpoint.secretKey);
+        bool preconnected = Preconnector::instance().noteAsk(result.url);
+        if (i == 0)
+        {
+            result.preconnected = preconnected;
+        }
+
+        TransferInfo transferInfo;
+        transferInfo.config = config;
+        transferInfo.failoverAvailable = (i + 1 < endpoints.size());
+
+        // A hedged duplicate goes to the next endpoint, so a queue on this one is sidestepped
+        HedgeTarget hedgeTarget;
+        size_t hedgeContextTokens = 0;
+        if (streaming && transferInfo.failoverAvailable && HedgePolicy::instance().isEnabled())
+        {
+            const Endpoint &alternate = endpoints[i + 1];
+            hedgeTarget.url = APIUtils::buildRequestUrl(toUTF8(alternate.baseUrl), toUTF8(alternate.chatRoute), alternate.model,
+                                                        alternate.responseType, streaming);
+            hedgeTarget.request = prepareForConversation(alternate, hedgeContextTokens);
+            hedgeTarget.apiType = toUTF8(alternate.responseType);
+            hedgeTarget.secretKey = toUTF8(alternate.secretKey);
+            transferInfo.hedgeTarget = &hedgeTarget;
+        }
+
+        result.response.clear();
+        result.answer.clear();
+        result.realtime = false;
+        result.collected = streamed && !streaming;
+        if (result.collected)
+        {
+            transferInfo.collect = &result.answer;
+        }
+        if (streamed)
+        {
+            if (usesRealtime(endpoint))
+            {
+                std::string realtimeUrl = RealtimeSession::buildUrl(toUTF8(endpoint.baseUrl), config->realtimeRoute, endpoint.model);
+                TransferInfo realtimeInfo = transferInfo;
+                result.ok = HTTPClient::performRealtimeRequest(realtimeUrl, RealtimeSession::responseEvent(text, systemPrompt, *config),
+                                                               result.response, secretKey, &realtimeInfo);
+
+                // Without a session (or with nothing delivered yet) the ask goes over HTTP as usual
+                result.realtime = result.ok || realtimeInfo.contentDelivered || host.isCancelled();
+                if (result.realtime)
+                {
+                    result.url = realtimeUrl;
+                    result.sessionOpened = realtimeInfo.sessionOpened;
+                    transferInfo = realtimeInfo;
+                }
+                else
+                {
+                    host.showStatus(L"NppOpenAI: realtime session unavailable (" + errorMessage(result) + L"), using HTTP...");
+                    result.response.clear();
+                }
+            }
+            if (!result.realtime)
+            {
+                host.showDebugStatus((result.collected ? L"Collecting stream, URL: " : L"Streaming enabled, URL: ") + stringToWstring(result.url));
+                result.ok = HTTPClient::performStreamingRequest(result.url, request, result.response, apiType, secretKey, proxy, &transferInfo);
+            }
+        }
+        else
+        {
+            result.ok = HTTPClient::performRequest(result.url, request, result.response, apiType, secretKey, proxy, &transferInfo);
+        }
+
+        result.ttfbMs = transferInfo.ttfbMs;
+        result.stats = transferInfo.stats;
+        result.usage = transferInfo.usage;
+        if (!streamed && result.ok)
+        {
+            result.usage.update(result.response);
+        }
+        if (result.usage.serverPromptMs >= 0)
+        {
+            // Next to the client-side timeline: how much of the time to first token the server spent on the prompt
+            Trace::instant("server prompt", "request", "prompt_us", static_cast<int64_t>(result.usage.serverPromptMs * 1000));
+        }
+        if (result.ok)
+        {
+            const Endpoint &answered = (transferInfo.hedgeWon && transferInfo.hedgeTarget) ? endpoints[i + 1] : endpoint;
+            if (&answered != &endpoint)
+            {
+                result.responseType = answered.responseType;
+                result.endpointName = answered.name;
+                result.contextTokensSent = hedgeContextTokens;
+            }
+            EndpointRouter::instance().recordSuccess(answered.name, transferInfo.ttfbMs);
+
+            // Keep the context for the next ask on this conversation (streaming: from the done line)
+            if (usesContext(answered))
+            {
+                std::string context = OllamaContext::extract(streamed ? transferInfo.finalPayload : result.response);
+                result.contextTokensReceived = OllamaContext::tokenCount(context);
+                OllamaContext::instance().store(conversation, contextFingerprint(answered), std::move(context),
+                                                static_cast<size_t>(config->ollamaContextMaxTokens));
+            }
+            break;
+        }
+        if (host.isCancelled())
+        {
+            break;
+        }
+
+        // Only unreachable or overloaded endpoints are penalized and skipped; other errors
+        // (invalid request, bad key) are reported as they are
+        bool endpointUnavailable = (transferInfo.httpStatus >= 400)
+                                       ? RetryPolicy::isRetryableStatus(transferInfo.httpStatus)
+                                       : RetryPolicy::isRetryableTransportError(transferInfo.curlCode);
+        if (!endpointUnavailable)
+        {
+            break;
+        }
+        EndpointRouter::instance().recordFailure(endpoint.name);
+
+        // A stream that already delivered content cannot be repeated elsewhere
+        if (transferInfo.contentDelivered || i + 1 >= endpoints.size())
+        {
+            break;
+        }
+
+        host.showStatus(L"NppOpenAI: " + endpoint.name + L" unavailable, trying " + endpoints[i + 1].name + L"...");
+    }
+
+    // The response text is empty after a stream (it went to the host), the transfer counted what arrived
+    ProfileManager::instance().recordRequest(config->profile, result.ok, result.stats.bytesReceived, result.ttfbMs);
+    if (result.usage.promptTokens >= 0)
+    {
+        ProfileManager::instance().recordPromptTokens(config->profile, result.usage.promptTokens, result.usage.cachedTokens);
+    }
+    return result;
+}
+
+std::string ChatPipeline::answerText(const ChatResult &result, bool showReasoning)
+{
+    if (result.collected)
+    {
+        // The stream parsers leave reasoning in the text, the response parsers handle it
+        return ResponseParsers::processThinkingSections(result.answer, showReasoning);
+    }
+    TraceSpan span("parse response", "request");
+    span.setArg("bytes", static_cast<int64_t>(result.response.size()));
+    return ResponseParsers::getParserForEndpoint(result.responseType)(result.response, showReasoning);
+}
+
+std::wstring ChatPipeline::errorMessage(const ChatResult &result)
+{
+    std::wstring errorMsg = stringToWstring(result.url) + L": Request failed";
+    try
+    {
+        if (!result.response.empty())
+        {
+            nlohmann::json errorJson = nlohmann::json::parse(result.response);
+            if (errorJson.contains("error") && errorJson["error"].contains("message"))
+            {
+                errorMsg = L"API Error: " + stringToWstring(errorJson["error"]["message"].get<std::string>());
+            }
+        }
+    }
+    catch (...)
+    {
+        // Error parsing response - use default error message
+    }
+    return errorMsg;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "EndpointRouter.h"
+#include "HTTPClient.h"
+
+struct ConfigSnapshot;
+
+/**
+ * Outcome of ChatPipeline::send
+ */
+struct ChatResult
+{
+    bool ok = false;
+    std::string response;      // Full response body (non-streaming), error body, or what streaming left over
+    std::string url;           // URL of the last endpoint tried
+    std::wstring responseType; // response_type of the endpoint that answered (selects the parser)
+    std::wstring endpointName; // Endpoint that answered
+    double ttfbMs = -1;        // Time to first byte of the last attempt (-1 if unknown)
+    TransferStats stats;       // Volume and buffer counters of the last endpoint's transfer
+    bool preconnected = false; // The first endpoint had been pre-connected while the text was selected (see Preconnector)
+    size_t contextTokensSent = 0;     // Ollama context continued from the previous ask (see OllamaContext)
+    size_t contextTokensReceived = 0; // Ollama context returned for the next ask
+    TokenUsage usage;                 // Tokens the provider reported, prompt cache hits included
+    bool realtime = false;            // Answered over the Realtime API session (see RealtimeSession)
+    bool sessionOpened = false;       // ... which had to be opened (or reopened) for this ask
+    bool collected = false;           // streaming=0 answer received as a stream (see stream_transport)
+    std::string answer;               // ... its text, complete or up to a cancel
+};
+
+/**
+ * ChatPipeline - Sends one chat request with endpoint failover and hedging
+ *
+ * Front-end independent: the request is built from a ConfigSnapshot, sent
+ * through HTTPClient and streamed content goes to the installed TransferHost.
+ * Used by the Notepad++ command and by the command-line client.
+ */
+namespace ChatPipeline
+{
+    // Endpoints to try for 'config', best first (a named profile is a single backend of its own)
+    std::vector<Endpoint> candidateEndpoints(const ConfigSnapshot &config);
+
+    // Send 'text' with 'systemPrompt' to 'endpoints' in order until one answers or an error is not retryable elsewhere;
+    // asks with the same 'conversation' (e.g. one per document) continue each other's Ollama context
+    ChatResult send(const std::string &text,
+                    const std::wstring &systemPrompt,
+                    const std::shared_ptr<const ConfigSnapshot> &config,
+                    const std::vector<Endpoint> &endpoints,
+                    const std::wstring &conversation = L"");
+
+    // Text to insert for a non-streaming ask: the collected stream, or the parsed response body
+    // (reasoning sections kept with show_reasoning of the ask's snapshot)
+    std::string answerText(const ChatResult &result, bool showReasoning);
+
+    // Human-readable error for a failed request ("API Error: ..." if the body carries one)
+    std::wstring errorMessage(const ChatResult &result);
+}
@@ -0,0 +1,164 @@
+/**
+ * EndpointRouter.cpp - Health tracking and ranking of API endpoints
+ *
+ * Keeps per-endpoint EWMAs of time to first byte and error rate and turns them
+ * into the order in which askChatGPT tries endpoints.
+ */
+
+#include "EndpointRouter.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace
+{
+    const double kEwmaAlpha = 0.3;            // Weight of the newest sample
+    const double kErrorPenalty = 4.0;         // Expected latency multiplier per unit of error rate
+    const int64_t kBaseCooldownMs = 2000;     // Cooldown after the first failure
+    const int64_t kMaxCooldownMs = 60000;     // Cooldown cap for endpoints that keep failing
+}
+
+EndpointRouter &EndpointRouter::instance()
+{
+    static EndpointRouter router;
+    return router;
+}
+
+void EndpointRouter::setEndpoints(const std::vector<Endpoint> &endpoints)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::vector<Entry> entries;
+    entries.reserve(endpoints.size());
+    for (const Endpoint &endpoint : endpoints)
+    {
+        Entry entry;
+        entry.endpoint = endpoint;
+
+        // Keep measurements of endpoints that still point to the same server
+        for (const Entry &previous : _entries)
+        {
+            if (previous.endpoint.name == endpoint.name && previous.endpoint.baseUrl == endpoint.baseUrl)
+            {
+                entry.health = previous.health;
+                break;
+            }
+        }
+        entries.push_back(entry);
+    }
+    _entries.swap(entries);
+}
+
+std::vector<Endpoint> EndpointRouter::rankedEndpoints() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    int64_t now = nowMs();
+
+    // Unmeasured endpoints are assumed to be as fast as the best measured one
+    double bestTtfb = std::numeric_limits<double>::max();
+    for (const Entry &entry : _entries)
+    {
+        if (entry.health.samples > 0 && entry.health.ewmaTtfbMs > 0)
+            bestTtfb = std::min(bestTtfb, entry.health.ewmaTtfbMs);
+    }
+    if (bestTtfb == std::numeric_limits<double>::max())
+        bestTtfb = 0;
+
+    struct Candidate
+    {
+        size_t index;
+        bool down;
+        double score;
+    };
+    std::vector<Candidate> candidates;
+    candidates.reserve(_entries.size());
+    for (size_t i = 0; i < _entries.size(); ++i)
+    {
+        const EndpointHealth &health = _entries[i].health;
+        double ttfb = (health.ewmaTtfbMs > 0) ? health.ewmaTtfbMs : bestTtfb;
+        candidates.push_back({i, health.downUntilMs > now, ttfb * (1.0 + kErrorPenalty * health.ewmaErrorRate)});
+    }
+
+    // Healthy endpoints first, by expected latency; ties keep the configured order
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b)
+                     {
+                         if (a.down != b.down)
+                             return !a.down;
+                         return a.score < b.score; });
+
+    std::vector<Endpoint> ranked;
+    ranked.reserve(candidates.size());
+    for (const Candidate &candidate : candidates)
+    {
+        ranked.push_back(_entries[candidate.index].endpoint);
+    }
+    return ranked;
+}
+
+size_t EndpointRouter::size() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _entries.size();
+}
+
+void EndpointRouter::recordSuccess(const std::wstring &name, double ttfbMs)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry *entry = find(name);
+    if (!entry)
+        return;
+
+    EndpointHealth &health = entry->health;
+    if (ttfbMs > 0)
+    {
+        health.ewmaTtfbMs = (health.ewmaTtfbMs > 0) ? kEwmaAlpha * ttfbMs + (1 - kEwmaAlpha) * health.ewmaTtfbMs : ttfbMs;
+    }
+    health.ewmaErrorRate = (1 - kEwmaAlpha) * health.ewmaErrorRate;
+    health.consecutiveFailures = 0;
+    health.downUntilMs = 0;
+    ++health.samples;
+}
+
+void EndpointRouter::recordFailure(const std::wstring &name)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry *entry = find(name);
+    if (!entry)
+        return;
+
+    EndpointHealth &health = entry->health;
+    health.ewmaErrorRate = kEwmaAlpha + (1 - kEwmaAlpha) * health.ewmaErrorRate;
+    ++health.consecutiveFailures;
+    ++health.samples;
+
+    int exponent = std::min(health.consecutiveFailures - 1, 5);
+    health.downUntilMs = nowMs() + std::min(kMaxCooldownMs, kBaseCooldownMs << exponent);
+}
+
+EndpointHealth EndpointRouter::health(const std::wstring &name) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const Entry &entry : _entries)
+    {
+        if (entry.endpoint.name == name)
+            return entry.health;
+    }
+    return EndpointHealth();
+}
+
+EndpointRouter::Entry *EndpointRouter::find(const std::wstring &name)
+{
+    for (Entry &entry : _entries)
+    {
+        if (entry.endpoint.name == name)
+            return &entry;
+    }
+    return nullptr;
+}
+
+int64_t EndpointRouter::nowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+/**
+ * One API endpoint a request can be sent to
+ *
+ * Values mirror the [API] settings; endpoints listed in 'endpoints=' are read
+ * from their own [Endpoint:name] sections and inherit unset values from [API].
+ */
+struct Endpoint
+{
+    std::wstring name;         // Section name, or "default" for the plain [API] configuration
+    std::wstring baseUrl;      // api_url
+    std::wstring chatRoute;    // route_chat_completions
+    std::wstring responseType; // openai, ollama, claude, simple
+    std::wstring secretKey;    // secret_key
+    std::wstring model;        // model
+};
+
+/**
+ * Health of one endpoint, derived from recent requests
+ */
+struct EndpointHealth
+{
+    double ewmaTtfbMs = 0;          // Smoothed time to first byte of successful requests
+    double ewmaErrorRate = 0;       // Smoothed failure ratio (0 = always succeeds, 1 = always fails)
+    int samples = 0;                // Number of requests recorded
+    int consecutiveFailures = 0;    // Failures since the last success
+    int64_t downUntilMs = 0;        // Steady-clock time until which the endpoint is considered down
+};
+
+/**
+ * EndpointRouter - Orders configured endpoints by health for failover and load balancing
+ *
+ * Each endpoint's time to first byte and error rate are tracked as exponentially
+ * weighted moving averages. New requests go to the endpoint with the lowest
+ * expected latency (TTFB inflated by its error rate); the remaining endpoints are
+ * the failover order. An endpoint that failed is put in a cooldown that grows with
+ * consecutive failures and is only tried after all healthy endpoints. Endpoints
+ * without measurements are assumed as fast as the best measured one, so with no
+ * problems the configured order is kept.
+ */
+class EndpointRouter
+{
+public:
+    static EndpointRouter &instance();
+
+    // Replace the endpoint list; health of endpoints that keep name and URL is preserved
+    void setEndpoints(const std::vector<Endpoint> &endpoints);
+
+    // All endpoints, best candidate first
+    std::vector<Endpoint> rankedEndpoints() const;
+
+    // Number of configured endpoints
+    size_t size() const;
+
+    // Record a successful request and its time to first byte
+    void recordSuccess(const std::wstring &name, double ttfbMs);
+
+    // Record a failed request (connection error, timeout, 429/5xx)
+    void recordFailure(const std::wstring &name);
+
+    // Snapshot of an endpoint's health (default values if unknown)
+    EndpointHealth health(const std::wstring &name) const;
+
+private:
+    EndpointRouter() = default;
+
+    struct Entry
+    {
+        Endpoint endpoint;
+        EndpointHealth health;
+    };
+
+    Entry *find(const std::wstring &name);
+    static int64_t nowMs();
+
+    mutable std::mutex _mutex;
+    std::vector<Entry> _entries;
+};
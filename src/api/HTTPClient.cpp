@@ -1,23 +1,892 @@
 #include "HTTPClient.h"
 #include <curl/curl.h>
-#include "OpenAIClient.h"  // For callback functions
-#include "EncodingUtils.h" // for toUTF8
-#include "editor/EditorInterface.h" // For getCurrentScintilla
-#include "core/external_globals.h"
-#include "npp/Notepad_plus_msgs.h"
+#include "config/ConfigSnapshot.h"
+#include "EncodingUtils.h" // for stringToWstring
+#include "HedgePolicy.h"
+#include "ProviderTraits.h"
+#include "RateLimiter.h"
+#include "RealtimeSession.h"
+#include "StreamBuffer.h"
+#include "StreamFixture.h"
+#include "StreamParser.h"
+#include "TransferDriver.h"
+#include "TransferHost.h"
+#include "Trace.h"
+#include <cstdio>
+#include <cwchar>
 #include <future>
 #include <chrono>
-#include <windows.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <nlohmann/json.hpp>
+
+namespace
+{
+    /**
+     * Connection cache of one profile
+     *
+     * One mutex per shareable data type, as required by curl_share_setopt(CURLSHOPT_LOCKFUNC)
+     */
+    struct SharePool
+    {
+        CURLSH *share = nullptr;
+        std::mutex locks[CURL_LOCK_DATA_LAST];
+    };
+
+    std::mutex g_poolsMutex;
+    std::map<std::wstring, std::unique_ptr<SharePool>> g_pools; // Profile name ("" for [API]) -> pool
+
+    void lockShare(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr)
+    {
+        (void)handle;
+        (void)access;
+        static_cast<SharePool *>(userptr)->locks[data].lock();
+    }
+
+    void unlockShare(CURL *handle, curl_lock_data data, void *userptr)
+    {
+        (void)handle;
+        static_cast<SharePool *>(userptr)->locks[data].unlock();
+    }
+
+    /**
+     * Returns the share handle used by the requests of a profile
+     *
+     * Sharing the connection cache keeps idle connections alive between asks, so
+     * the next request to the same host skips the TCP and TLS handshakes. DNS and
+     * TLS sessions are shared as well so reconnects skip the full handshake.
+     * Transfers in flight at the same time run on the TransferDriver's multi
+     * handle, where they also share HTTP/2 connections.
+     * Each profile has its own cache, so the connections of one profile are not
+     * evicted by another and switching back finds them still open.
+     *
+     * @param profile Name of the profile the request belongs to
+     */
+    CURLSH *getShareHandle(const std::wstring &profile)
+    {
+        std::lock_guard<std::mutex> lock(g_poolsMutex);
+        std::unique_ptr<SharePool> &pool = g_pools[profile];
+        if (!pool)
+        {
+            pool.reset(new SharePool());
+            pool->share = curl_share_init();
+            if (pool->share)
+            {
+                curl_share_setopt(pool->share, CURLSHOPT_LOCKFUNC, lockShare);
+                curl_share_setopt(pool->share, CURLSHOPT_UNLOCKFUNC, unlockShare);
+                curl_share_setopt(pool->share, CURLSHOPT_USERDATA, pool.get());
+                curl_share_setopt(pool->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+                curl_share_setopt(pool->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+                curl_share_setopt(pool->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+            }
+        }
+        return pool->share;
+    }
+
+    /**
+     * Add the connection phases cURL measured for a finished transfer to the trace
+     *
+     * @param curl The cURL easy handle of the transfer
+     * @param startUs Trace time at which curl_easy_perform was called
+     */
+    void traceTransferPhases(CURL *curl, double startUs)
+    {
+        if (!Trace::isEnabled())
+        {
+            return;
+        }
+
+        // Times since the start of the transfer; 0 for phases that did not happen (reused connection, plain HTTP)
+        curl_off_t dnsUs = 0, connectUs = 0, tlsUs = 0, preTransferUs = 0, firstByteUs = 0, totalUs = 0;
+        curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &dnsUs);
+        curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connectUs);
+        curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &tlsUs);
+        curl_easy_getinfo(curl, CURLINFO_PRETRANSFER_TIME_T, &preTransferUs);
+        curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &firstByteUs);
+        curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &totalUs);
+
+        auto phase = [startUs](const char *name, curl_off_t fromUs, curl_off_t toUs)
+        {
+            if (toUs > fromUs)
+            {
+                Trace::complete(name, "http", startUs + static_cast<double>(fromUs), static_cast<double>(toUs - fromUs));
+            }
+        };
+        phase("dns", 0, dnsUs);
+        phase("connect", dnsUs, connectUs);
+        phase("tls", connectUs, tlsUs);
+        phase("wait for first byte", preTransferUs, firstByteUs);
+        phase("receive", firstByteUs, totalUs);
+    }
+
+    // A hedged transfer whose twin delivered content first
+    bool lostRace(const StreamContext &context)
+    {
+        return context.raceWinner && *context.raceWinner && *context.raceWinner != &context;
+    }
+}
+
+/**
+ * cURL write callback for standard requests: appends the data to the response body
+ *
+ * @param contents The received data buffer
+ * @param size Always 1
+ * @param nmemb The size of the data received
+ * @param userp The ResponseBody that collects the response
+ * @return The number of bytes processed (0 aborts the transfer)
+ */
+size_t HTTPClient::writeCallback(void *contents, size_t size, size_t nmemb, void *userp)
+{
+    size_t totalSize = size * nmemb;
+    TraceSpan span("body chunk", "http");
+    span.setArg("bytes", static_cast<int64_t>(totalSize));
+    ResponseBody *body = static_cast<ResponseBody *>(userp);
+    if (body->recorder)
+    {
+        body->recorder->record(static_cast<char *>(contents), totalSize);
+    }
+    body->data->append(static_cast<char *>(contents), totalSize);
+    body->stats.bytesReceived += totalSize;
+    body->stats.chunks++;
+    body->stats.peakBufferBytes = (std::max)(body->stats.peakBufferBytes, body->data->capacity());
+    return TransferHost::current().isCancelled() ? 0 : totalSize;
+}
+
+/**
+ * Hand the content of one complete stream line to the TransferHost
+ *
+ * SSE metadata lines (event:, id:, retry:, comments) and completion markers are
+ * skipped; "data:" payloads and NDJSON lines are handed to StreamParser. The
+ * last payload without content is kept in the context as finalPayload, and the
+ * token usage such payloads report is merged into its usage. A context with
+ * 'collected' set appends the content there instead (stream_transport), one
+ * with a 'buffer' queues it for the requesting thread.
+ *
+ * @param line One line of the response body without its line terminator
+ * @param context The stream context (API type, receives finalPayload and usage)
+ * @return true if content was delivered
+ */
+bool HTTPClient::processStreamLine(const std::string &line, StreamContext &context)
+{
+    std::string payload = StreamParser::extractLinePayload(line);
+    if (payload.empty())
+    {
+        return false;
+    }
+
+    if (!context.provider)
+    {
+        context.provider = &ProviderOps::forType(context.apiType); // Replays set only apiType
+    }
+    const ProviderOps &provider = *context.provider;
+
+    std::string content;
+    try
+    {
+        TraceSpan span("parse line", "stream");
+        if (provider.plainTextLines && payload.front() != '{')
+        {
+            // Plain-text stream: keep the line structure
+            content = payload + "\n";
+        }
+        else
+        {
+            content = provider.delta(payload);
+        }
+    }
+    catch (...)
+    {
+        // Malformed line - skip it rather than inserting protocol noise into the document
+        return false;
+    }
+
+    if (content.empty())
+    {
+        // Metadata line (end of stream, usage); the caller may need what it carries
+        if (provider.reportsUsage(payload))
+        {
+            context.usage.update(payload);
+        }
+        context.finalPayload = payload;
+        return false;
+    }
+
+    // Hedged request: the first transfer with content wins, the other one is stopped by its write callback
+    if (context.raceWinner)
+    {
+        if (!*context.raceWinner)
+        {
+            *context.raceWinner = &context;
+        }
+        else if (*context.raceWinner != &context)
+        {
+            return false;
+        }
+    }
+    if (context.collected)
+    {
+        context.collected->append(content);
+        return true;
+    }
+    if (!context.contentDelivered)
+    {
+        TransferHost::current().beginAnswer(context.apiType);
+    }
+    if (context.buffer)
+    {
+        context.buffer->push(content);
+        return true;
+    }
+    return TransferHost::current().deliverContent(content);
+}
+
+/**
+ * cURL write callback for streaming: delivers each complete line's content
+ *
+ * Chunks are split on transport boundaries (HTTP/1.1 chunks, HTTP/2 frames), not on
+ * event boundaries, so incomplete trailing lines are kept in the StreamContext until
+ * the rest arrives. Bodies of non-2xx responses are collected as error details
+ * instead of being delivered. While the context's StreamBuffer is full, the
+ * chunk is left to cURL and the transfer paused.
+ *
+ * @param contents The received data buffer
+ * @param size Always 1
+ * @param nmemb The size of the data received
+ * @param userp The StreamContext of the transfer
+ * @return The number of bytes processed (0 aborts the transfer)
+ */
+size_t HTTPClient::streamCallback(void *contents, size_t size, size_t nmemb, void *userp)
+{
+    size_t totalSize = size * nmemb;
+    TraceSpan span("stream chunk", "stream");
+    span.setArg("bytes", static_cast<int64_t>(totalSize));
+    StreamContext *context = static_cast<StreamContext *>(userp);
+    if (!context)
+    {
+        return totalSize;
+    }
+
+    // The front-end is behind: cURL keeps the chunk until the transfer loop resumes the transfer
+    if (context->buffer && !context->headers.isError() && context->buffer->isFull())
+    {
+        if (!context->paused)
+        {
+            context->paused = true;
+            context->pausedAt = std::chrono::steady_clock::now();
+            context->stats.pauses++;
+        }
+        return CURL_WRITEFUNC_PAUSE;
+    }
+
+    if (context->recorder)
+    {
+        context->recorder->record(static_cast<char *>(contents), totalSize);
+    }
+    context->stats.bytesReceived += totalSize;
+    context->stats.chunks++;
+
+    if (context->headers.isError())
+    {
+        context->errorBody.append(static_cast<char *>(contents), totalSize);
+        return totalSize;
+    }
+
+    // Hedged request: the other transfer already delivered content
+    if (lostRace(*context))
+    {
+        return 0;
+    }
+
+    context->pending.append(static_cast<char *>(contents), totalSize);
+
+    size_t lineStart = 0;
+    size_t newline;
+    while ((newline = context->pending.find('\n', lineStart)) != std::string::npos)
+    {
+        if (processStreamLine(context->pending.substr(lineStart, newline - lineStart), *context))
+        {
+            context->stats.contentEvents++;
+            if (!context->contentDelivered)
+            {
+                context->contentDelivered = true;
+                context->firstContentAt = std::chrono::steady_clock::now();
+            }
+        }
+        lineStart = newline + 1;
+    }
+    context->stats.peakBufferBytes = (std::max)(context->stats.peakBufferBytes, context->pending.capacity());
+    context->pending.erase(0, lineStart);
+
+    return (TransferHost::current().isCancelled() || lostRace(*context)) ? 0 : totalSize;
+}
+
+/**
+ * Process a final unterminated line left in the stream buffer
+ *
+ * @param context The stream context used for the transfer
+ */
+void HTTPClient::flushStreamContext(StreamContext &context)
+{
+    if (!context.pending.empty() && !context.headers.isError() && !TransferHost::current().isCancelled())
+    {
+        if (processStreamLine(context.pending, context))
+        {
+            context.stats.contentEvents++;
+            if (!context.contentDelivered)
+            {
+                context.contentDelivered = true;
+                context.firstContentAt = std::chrono::steady_clock::now();
+            }
+        }
+    }
+    context.pending.clear();
+}
+
+/**
+ * Map the http_version configuration value to a cURL HTTP version constant
+ *
+ * - "auto" (default) / "2": negotiate HTTP/2 via ALPN on HTTPS, HTTP/1.1 on plain HTTP
+ * - "2-prior-knowledge": speak HTTP/2 immediately, also over plain HTTP (h2c)
+ * - "1.1": always use HTTP/1.1
+ *
+ * @param httpVersion The configured HTTP version string
+ * @return The matching CURL_HTTP_VERSION_* value
+ */
+long HTTPClient::resolveHttpVersion(const std::string &httpVersion)
+{
+    if (httpVersion == "1.1" || httpVersion == "1")
+    {
+        return CURL_HTTP_VERSION_1_1;
+    }
+    if (httpVersion == "2-prior-knowledge" || httpVersion == "h2c")
+    {
+        return CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE;
+    }
+
+    // "auto", "2" and anything unrecognized: ALPN h2 with fallback to HTTP/1.1
+    return CURL_HTTP_VERSION_2TLS;
+}
+
+/**
+ * Stop the transfer driver and release the shared connection caches
+ *
+ * Must only be called when no request is in flight (on Notepad++ shutdown).
+ */
+void HTTPClient::shutdown()
+{
+    TransferDriver::instance().shutdown();
+    std::lock_guard<std::mutex> lock(g_poolsMutex);
+    for (auto &entry : g_pools)
+    {
+        if (entry.second->share)
+        {
+            curl_share_cleanup(entry.second->share);
+        }
+    }
+    g_pools.clear();
+    RealtimeSession::instance().close();
+}
+
+/**
+ * Apply the options shared by standard and streaming requests
+ *
+ * Sets the JSON content type and provider-specific authentication headers,
+ * attaches the shared connection cache, selects the HTTP version, sets the
+ * connect timeout and configures the optional proxy.
+ *
+ * @param curl The cURL easy handle
+ * @param apiType The type of API (openai, claude, ollama, etc.)
+ * @param secretKey The API key for authentication
+ * @param proxy Optional proxy server to use (or "0" for no proxy)
+ * @param config The configuration snapshot of the request
+ * @return The header list; the caller frees it with curl_slist_free_all after the transfer
+ */
+curl_slist *HTTPClient::setupCommonOptions(void *curl, const std::string &apiType, const std::string &secretKey, const std::string &proxy,
+                                           const ConfigSnapshot &config)
+{
+    struct curl_slist *headers = nullptr;
+
+    // Content-Type is always JSON
+    headers = curl_slist_append(headers, "Content-Type: application/json");
+
+    // Add authentication headers based on API type (Bearer token, x-api-key, x-goog-api-key)
+    const ProviderOps &provider = ProviderOps::forType(apiType);
+    std::string authHeader = provider.authHeader + secretKey;
+    headers = curl_slist_append(headers, authHeader.c_str());
+    if (provider.extraHeader)
+    {
+        headers = curl_slist_append(headers, provider.extraHeader);
+    }
+
+    // Reuse pooled idle connections; on the TransferDriver's multi handle wait for the
+    // HTTP/2 connection being opened to multiplex on rather than opening a second one
+    CURLSH *share = getShareHandle(config.profile);
+    if (share)
+    {
+        curl_easy_setopt(curl, CURLOPT_SHARE, share);
+    }
+    long httpVersion = resolveHttpVersion(config.httpVersion);
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, httpVersion);
+    curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+
+    // libcurl 7.x fails the request (CURLE_HTTP2) when it takes over an h2c connection
+    // another easy handle opened, and keeps the connection pooled; there each h2c request
+    // gets a connection of its own
+    if (httpVersion == CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE && curl_version_info(CURLVERSION_NOW)->version_num < 0x080000)
+    {
+        curl_easy_setopt(curl, CURLOPT_FRESH_CONNECT, 1L);
+        curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+    }
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+
+    // Give up on unreachable endpoints quickly so failover to the next one can start
+    if (config.connectTimeoutMs > 0)
+    {
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, config.connectTimeoutMs);
+    }
+
+    // Set proxy if provided
+    if (!proxy.empty() && proxy != "0")
+    {
+        curl_easy_setopt(curl, CURLOPT_PROXY, proxy.c_str());
+    }
+
+    return headers;
+}
+
+/**
+ * Apply the options specific to streaming requests
+ *
+ * @param curl The cURL easy handle
+ * @param headers The header list built by setupCommonOptions
+ * @param apiType The type of API (openai, claude, ollama, etc.)
+ * @return The extended header list
+ */
+curl_slist *HTTPClient::setupStreamingOptions(void *curl, curl_slist *headers, const std::string &apiType)
+{
+    // Add Accept header for handling streaming response
+    if (ProviderOps::forType(apiType).acceptEventStream)
+    {
+        headers = curl_slist_append(headers, "Accept: text/event-stream");
+    }
+
+    // SSE / NDJSON framing is handled by the write callback (see StreamContext), so no
+    // transport-specific options are needed and HTTP/2 works the same as HTTP/1.1
+    (void)curl;
+
+    return headers;
+}
+
+/**
+ * Configure an easy handle for a streaming request
+ *
+ * @param curl The cURL easy handle
+ * @param url The full API endpoint URL
+ * @param request The JSON request body (must outlive the transfer)
+ * @param apiType The type of API (openai, claude, ollama, etc.)
+ * @param secretKey The API key for authentication
+ * @param proxy Optional proxy server to use (or "0" for no proxy)
+ * @param config The configuration snapshot of the request
+ * @param context The stream context that receives the response
+ * @return The header list; the caller frees it with curl_slist_free_all after the transfer
+ */
+curl_slist *HTTPClient::setupStreamingHandle(void *curl, const std::string &url, const std::string &request, const std::string &apiType,
+                                             const std::string &secretKey, const std::string &proxy, const ConfigSnapshot &config,
+                                             StreamContext &context)
+{
+    struct curl_slist *headers = setupCommonOptions(curl, apiType, secretKey, proxy, config);
+    headers = setupStreamingOptions(curl, headers, apiType);
+
+    context.apiType = apiType;
+    context.provider = &ProviderOps::forType(apiType);
+
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str()); // Set URL before async call
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, streamCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &context);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, ResponseHeaders::curlHeaderCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &context.headers);
+
+    return headers;
+}
+
+/**
+ * Run a transfer on the TransferDriver while pumping the UI message loop
+ *
+ * Keeps the loader dialog animated and the cancel button responsive (see TransferHost::idle).
+ *
+ * @param curl The configured cURL easy handle
+ * @return The CURLcode of the transfer
+ */
+int HTTPClient::performWithMessagePump(void *curl)
+{
+    TraceSpan span("transfer", "http");
+    double startUs = Trace::isEnabled() ? Trace::nowUs() : 0;
+    int result = runWithMessagePump([curl]()
+                                    { return TransferDriver::instance().start(curl).get(); });
+    traceTransferPhases(static_cast<CURL *>(curl), startUs);
+    return result;
+}
+
+/**
+ * Run a blocking transfer function on a worker thread while pumping the UI message loop
+ *
+ * With a 'buffer', the text the transfer queues is handed to the TransferHost
+ * here, on the requesting thread, as soon as it arrives.
+ *
+ * @param work The function to run; its return value is passed through
+ * @param buffer Optional queue of streamed text to deliver while waiting
+ * @return The result of 'work'
+ */
+int HTTPClient::runWithMessagePump(const std::function<int()> &work, StreamBuffer *buffer)
+{
+    auto futureRes = std::async(std::launch::async, [&work]()
+                                {
+        if (Trace::isEnabled())
+            Trace::setThreadName("transfer");
+        return work(); });
+
+    // Pump UI message loop until request completes
+    TransferHost &host = TransferHost::current();
+    for (;;)
+    {
+        if (buffer)
+        {
+            buffer->waitForContent(std::chrono::milliseconds(10));
+            deliverQueued(*buffer);
+            if (futureRes.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready)
+                break;
+        }
+        else if (futureRes.wait_for(std::chrono::milliseconds(10)) == std::future_status::ready)
+        {
+            break;
+        }
+        host.idle();
+    }
+    return futureRes.get();
+}
+
+/**
+ * Hand the text queued in a StreamBuffer to the TransferHost (requesting thread)
+ *
+ * @param buffer The queue of the streaming request
+ */
+void HTTPClient::deliverQueued(StreamBuffer &buffer)
+{
+    // Text still queued at a cancel is dropped, like the write callback stops delivering at once without a queue
+    std::string content = buffer.take();
+    TransferHost &host = TransferHost::current();
+    if (!content.empty() && !host.isCancelled())
+    {
+        host.deliverContent(content);
+    }
+}
+
+/**
+ * Resume a transfer paused by its write callback once the front-end has caught up
+ *
+ * Called on the transfer's own thread, between multi handle iterations: the
+ * held chunk may be delivered (and the transfer paused again) from within
+ * curl_easy_pause.
+ *
+ * @param curl The easy handle of the transfer
+ * @param context Its stream context
+ */
+void HTTPClient::resumeIfDrained(void *curl, StreamContext &context)
+{
+    if (context.paused && context.buffer->hasRoom())
+    {
+        endPause(context);
+        curl_easy_pause(static_cast<CURL *>(curl), CURLPAUSE_CONT);
+    }
+}
+
+/**
+ * Add the time since the transfer was paused to its counters (no-op if it is running)
+ *
+ * @param context The stream context of the transfer
+ */
+void HTTPClient::endPause(StreamContext &context)
+{
+    if (!context.paused)
+    {
+        return;
+    }
+    context.paused = false;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - context.pausedAt).count();
+    context.stats.pausedMs += ms;
+    if (Trace::isEnabled())
+    {
+        Trace::complete("paused", "stream", Trace::nowUs() - ms * 1000, ms * 1000);
+    }
+}
+
+/**
+ * Run a streaming transfer that delivers through a StreamBuffer
+ *
+ * The transfer's tick resumes it when the front-end has drained the buffer,
+ * and stops a paused transfer that is cancelled (its write callback, which
+ * normally notices the cancel, is not called while paused).
+ *
+ * @param curl The configured easy handle
+ * @param context Its stream context (with 'buffer' set)
+ * @return The CURLcode of the transfer
+ */
+int HTTPClient::performBuffered(void *curl, StreamContext &context)
+{
+    TraceSpan span("transfer", "http");
+    double startUs = Trace::isEnabled() ? Trace::nowUs() : 0;
+    TransferHost &host = TransferHost::current();
+    int result = runWithMessagePump([&]() -> int
+                                    {
+        int transferResult = TransferDriver::instance().start(curl, [&]()
+                                                              {
+            if (host.isCancelled())
+                return false;
+            resumeIfDrained(curl, context);
+            return true; }).get();
+        endPause(context);
+        return transferResult; }, context.buffer);
+    traceTransferPhases(static_cast<CURL *>(curl), startUs);
+    return result;
+}
+
+/**
+ * Run a streaming transfer with a hedged duplicate
+ *
+ * Both easy handles run on the TransferDriver. The primary starts
+ * immediately; if it has not claimed the race (parsed content from its
+ * stream) after 'hedgeDelayMs' and the hedge budget allows it, the duplicate
+ * is started. As soon as one transfer claims the race the other one's tick
+ * stops it, which closes its connection (over HTTP/2, resets its stream).
+ *
+ * @param primary The configured primary easy handle
+ * @param primaryContext The primary's stream context
+ * @param hedge The configured duplicate easy handle
+ * @param hedgeContext The duplicate's stream context
+ * @param hedgeDelayMs Milliseconds to wait before sending the duplicate
+ * @param hedgeStarted Set to true if the duplicate was sent
+ * @param hedgeWon Set to true if the duplicate delivered the response
+ * @return The CURLcode of the winning transfer (the primary's if neither won)
+ */
+int HTTPClient::performHedged(void *primary, StreamContext &primaryContext, void *hedge, StreamContext &hedgeContext,
+                              int hedgeDelayMs, bool &hedgeStarted, bool &hedgeWon)
+{
+    TraceSpan span("hedged transfer", "http");
+    double startUs = Trace::isEnabled() ? Trace::nowUs() : 0;
+    StreamContext *winner = nullptr;
+    TransferHost &host = TransferHost::current();
+    primaryContext.raceWinner = &winner;
+    hedgeContext.raceWinner = &winner;
+    hedgeStarted = false;
+
+    // The ticks run on the driver thread, like the write callbacks that claim the race
+    TransferDriver &driver = TransferDriver::instance();
+    std::future<int> hedgeDone;
+    auto start = std::chrono::steady_clock::now();
+    bool hedgeDeclined = false;
+    auto keepRunning = [&](void *curl, StreamContext &context, StreamContext &twin)
+    {
+        if (winner == &twin || host.isCancelled())
+            return false; // The twin is streaming: cancel this one
+        if (context.buffer)
+            resumeIfDrained(curl, context);
+        return true;
+    };
+    TransferDriver::Tick hedgeTick = [&]()
+    { return keepRunning(hedge, hedgeContext, primaryContext); };
+    TransferDriver::Tick primaryTick = [&]()
+    {
+        if (!keepRunning(primary, primaryContext, hedgeContext))
+            return false;
+
+        // Send the duplicate once the primary is slower than the configured percentile
+        if (!hedgeStarted && !hedgeDeclined && !winner &&
+            std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(hedgeDelayMs))
+        {
+            hedgeDeclined = !HedgePolicy::instance().tryAcquireHedge();
+            if (!hedgeDeclined)
+            {
+                hedgeDone = driver.start(hedge, hedgeTick);
+                hedgeStarted = true;
+            }
+        }
+        return true;
+    };
+
+    int result = runWithMessagePump([&]() -> int
+                                    {
+        // The primary's tick no longer runs once its result is in, so the hedge state is settled
+        int primaryResult = driver.start(primary, primaryTick).get();
+        int hedgeResult = hedgeStarted ? hedgeDone.get() : -1;
+        endPause(primaryContext);
+        endPause(hedgeContext);
+
+        return (winner == &hedgeContext) ? hedgeResult : primaryResult; }, primaryContext.buffer);
+
+    hedgeWon = (winner == &hedgeContext);
+    traceTransferPhases(static_cast<CURL *>(hedgeWon ? hedge : primary), startUs);
+    primaryContext.raceWinner = nullptr;
+    hedgeContext.raceWinner = nullptr;
+    return result;
+}
+
+/**
+ * Wait before a retry while keeping the UI responsive
+ *
+ * Shows the reason and remaining attempts in the status bar.
+ *
+ * @param delayMs Milliseconds to wait
+ * @param attempt The attempt that just failed
+ * @param maxAttempts The configured maximum number of attempts
+ * @param headers Headers of the failed response (for the status message)
+ * @return false if the user cancelled while waiting
+ */
+bool HTTPClient::waitBeforeRetry(int delayMs, int attempt, int maxAttempts, const ResponseHeaders &headers)
+{
+    TraceSpan span("retry wait", "http");
+    wchar_t statusMsg[160];
+    std::wstring reason = headers.statusCode ? L"HTTP " + std::to_wstring(headers.statusCode) : L"Connection error";
+    swprintf(statusMsg, 160, L"NppOpenAI: %ls, retrying in %.1f s (attempt %d/%d)",
+             reason.c_str(), delayMs / 1000.0, attempt + 1, maxAttempts);
+    TransferHost::current().showStatus(statusMsg);
+
+    return waitWithMessagePump(delayMs);
+}
+
+/**
+ * Hold a request back until the client-side rate limiter lets it through
+ *
+ * @param delayMs Milliseconds returned by RateLimiter::reserve (0 = no wait)
+ * @return false if the user cancelled while waiting
+ */
+bool HTTPClient::waitForRateLimit(int64_t delayMs)
+{
+    if (delayMs <= 0)
+    {
+        return !TransferHost::current().isCancelled();
+    }
+
+    TraceSpan span("rate limit wait", "http");
+    wchar_t statusMsg[160];
+    swprintf(statusMsg, 160, L"NppOpenAI: rate limit reached, sending in %.1f s", delayMs / 1000.0);
+    TransferHost::current().showStatus(statusMsg);
+
+    return waitWithMessagePump(delayMs);
+}
+
+/**
+ * Sleep while pumping the UI message loop
+ *
+ * @param delayMs Milliseconds to wait
+ * @return false if the user cancelled while waiting
+ */
+bool HTTPClient::waitWithMessagePump(int64_t delayMs)
+{
+    TransferHost &host = TransferHost::current();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs);
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        host.idle();
+        if (host.isCancelled())
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return !host.isCancelled();
+}
+
+/**
+ * Report the outcome of a transfer to the caller
+ *
+ * @param curl The cURL easy handle of the finished transfer
+ * @param curlCode The CURLcode of the last attempt
+ * @param httpStatus The HTTP status of the last attempt
+ * @param attempts Number of attempts made
+ * @param transferInfo Caller's TransferInfo (may be null)
+ */
+void HTTPClient::recordTransfer(void *curl, int curlCode, long httpStatus, int attempts, TransferInfo *transferInfo)
+{
+    if (!transferInfo)
+    {
+        return;
+    }
+
+    transferInfo->curlCode = curlCode;
+    transferInfo->httpStatus = httpStatus;
+    transferInfo->attempts = attempts;
+
+    curl_off_t startTransferUs = 0;
+    if (curl_easy_getinfo(static_cast<CURL *>(curl), CURLINFO_STARTTRANSFER_TIME_T, &startTransferUs) == CURLE_OK && startTransferUs > 0)
+    {
+        transferInfo->ttfbMs = static_cast<double>(startTransferUs) / 1000.0;
+    }
+    else
+    {
+        transferInfo->ttfbMs = -1;
+    }
+}
+
+/**
+ * Get the rate limiter for an API key, with the configured per-minute limits applied
+ *
+ * @param apiType The type of API (keys of different providers never share quota)
+ * @param secretKey The API key
+ * @param config The configuration snapshot of the request
+ */
+RateLimiter &HTTPClient::rateLimiterFor(const std::string &apiType, const std::string &secretKey, const ConfigSnapshot &config)
+{
+    RateLimiter &rateLimiter = RateLimiter::forKey(apiType + ":" + secretKey);
+    rateLimiter.configure(config.rateLimitRpm, config.rateLimitTpm);
+    return rateLimiter;
+}
+
+/**
+ * Build the retry policy from the retry_* configuration values
+ */
+RetryPolicy HTTPClient::retryPolicyFromConfig(const ConfigSnapshot &config)
+{
+    return RetryPolicy(config.retryMaxAttempts, config.retryBaseDelayMs, config.retryMaxDelayMs);
+}
+
+/**
+ * Write a captured response to the capture directory
+ *
+ * @param recorder The recorder of the request (null when capturing is off)
+ * @param config The configuration snapshot of the request
+ * @param httpStatus The HTTP status of the recorded attempt
+ * @param curlCode The CURLcode of the recorded attempt
+ */
+void HTTPClient::saveCapture(StreamRecorder *recorder, const ConfigSnapshot &config, long httpStatus, int curlCode)
+{
+    if (!recorder)
+    {
+        return;
+    }
+
+    recorder->finish(httpStatus, curlCode);
+    std::string path = recorder->saveTo(config.captureDir);
+    TransferHost::current().showDebugStatus(path.empty() ? L"Capture failed: " + stringToWstring(config.captureDir)
+                                                         : L"Captured " + stringToWstring(path));
+}
 
 /**
  * Performs a standard HTTP request to an LLM API
  *
+ * Transient failures (429, 5xx, dropped connections) are retried according to
+ * the configured RetryPolicy. On final failure 'response' holds the last error body.
+ *
  * @param url The full API endpoint URL to call
  * @param request The JSON request body as a string
  * @param response Output parameter that will store the API response
  * @param apiType The type of API (openai, claude, ollama, etc.)
  * @param secretKey The API key for authentication
  * @param proxy Optional proxy server to use (or "0" for no proxy)
+ * @param transferInfo Optional failover control and transfer measurements
  * @return true if the request was successful (200-level response), false otherwise
  */
 bool HTTPClient::performRequest(
@@ -26,185 +895,640 @@ bool HTTPClient::performRequest(
     std::string &response,
     const std::string &apiType,
     const std::string &secretKey,
-    const std::string &proxy)
+    const std::string &proxy,
+    TransferInfo *transferInfo)
 {
+    TraceSpan span("http request", "http");
     CURL *curl = curl_easy_init();
     if (!curl)
         return false;
 
-    struct curl_slist *headers = nullptr;
+    // Settings stay fixed for the whole request, even if the configuration is reloaded meanwhile
+    std::shared_ptr<const ConfigSnapshot> config = (transferInfo && transferInfo->config) ? transferInfo->config : ConfigSnapshot::current();
 
-    // Content-Type is always JSON
-    headers = curl_slist_append(headers, "Content-Type: application/json");
+    struct curl_slist *headers = setupCommonOptions(curl, apiType, secretKey, proxy, *config);
+    ResponseHeaders responseHeaders;
 
-    // Add authentication headers based on API type
-    if (apiType == "claude")
+    // Raw response capture for regression fixtures (see StreamFixture)
+    std::unique_ptr<StreamRecorder> recorder;
+    if (!config->captureDir.empty())
     {
-        std::string authHeader = "x-api-key: " + secretKey;
-        headers = curl_slist_append(headers, authHeader.c_str());
-        headers = curl_slist_append(headers, "anthropic-version: 2023-06-01");
-    }
-    else
-    {
-        std::string authHeader = "Authorization: Bearer " + secretKey;
-        headers = curl_slist_append(headers, authHeader.c_str());
+        recorder.reset(new StreamRecorder(apiType, false));
     }
+    ResponseBody body;
+    body.data = &response;
+    body.recorder = recorder.get();
 
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request.c_str());
 
-    // Set proxy if provided
-    if (!proxy.empty() && proxy != "0")
+    // Setup callback to capture response
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, ResponseHeaders::curlHeaderCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &responseHeaders);
+
+    RetryPolicy retryPolicy = retryPolicyFromConfig(*config);
+    RateLimiter &rateLimiter = rateLimiterFor(apiType, secretKey, *config);
+    double estimatedTokens = RateLimiter::estimateTokens(request);
+    CURLcode res = CURLE_OK;
+    bool ok = false;
+    int attempt = 1;
+    for (;; ++attempt)
     {
-        curl_easy_setopt(curl, CURLOPT_PROXY, proxy.c_str());
+        response.clear();
+        responseHeaders.reset();
+
+        // Queue locally instead of sending a request the provider would reject with 429
+        if (!waitForRateLimit(rateLimiter.reserve(estimatedTokens)))
+        {
+            res = CURLE_ABORTED_BY_CALLBACK;
+            break;
+        }
+        if (recorder)
+        {
+            recorder->restart();
+        }
+
+        // Perform the request asynchronously to allow UI timers to run
+        res = static_cast<CURLcode>(performWithMessagePump(curl));
+        rateLimiter.updateFromHeaders(responseHeaders);
+
+        // Succeed only if both curl succeeded and HTTP status is 2xx
+        ok = (res == CURLE_OK && responseHeaders.isSuccess());
+        if (ok || TransferHost::current().isCancelled())
+            break;
+
+        // A retryable failure goes to the next endpoint instead, if there is one
+        int delayMs = retryPolicy.nextDelayMs(attempt, res, responseHeaders);
+        if (delayMs >= 0 && transferInfo && transferInfo->failoverAvailable)
+            break;
+        if (delayMs < 0 || !waitBeforeRetry(delayMs, attempt, retryPolicy.maxAttempts(), responseHeaders))
+            break;
+    }
+    recordTransfer(curl, res, responseHeaders.statusCode, attempt, transferInfo);
+    saveCapture(recorder.get(), *config, responseHeaders.statusCode, res);
+    if (transferInfo)
+    {
+        transferInfo->stats = body.stats;
     }
 
-    // Setup callback to capture response
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, OpenAIcURLCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(curl);
 
-    // Perform the request asynchronously to allow UI timers to run
-    auto futureRes = std::async(std::launch::async, [curl]()
-                                { return curl_easy_perform(curl); });
-    CURLcode res;
+    return ok;
+}
 
-    // Pump UI message loop until request completes
-    while (futureRes.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready)
+/**
+ * Performs a request on a background thread, outside any ask
+ *
+ * Used for housekeeping requests such as loading an Ollama model ahead of the
+ * first ask (see ModelWarmup). Unlike performRequest it never touches the
+ * TransferHost, which belongs to the UI thread, and makes a single attempt.
+ *
+ * @param url The full URL to call
+ * @param request The JSON request body; empty sends a GET
+ * @param response Output parameter that receives the response body
+ * @param apiType The type of API (openai, claude, ollama, etc.)
+ * @param secretKey The API key for authentication
+ * @param config The configuration snapshot of the request (proxy, connection cache)
+ * @param timeoutMs Limit for the whole transfer (0 = none)
+ * @param abort Optional flag that cancels the transfer when set
+ * @return The HTTP status code, or 0 if the request failed without a response
+ */
+long HTTPClient::performBackgroundRequest(
+    const std::string &url,
+    const std::string &request,
+    std::string &response,
+    const std::string &apiType,
+    const std::string &secretKey,
+    const ConfigSnapshot &config,
+    long timeoutMs,
+    const std::atomic<bool> *abort)
+{
+    TraceSpan span("background request", "http");
+    CURL *curl = curl_easy_init();
+    if (!curl)
+        return 0;
+
+    struct curl_slist *headers = setupCommonOptions(curl, apiType, secretKey, config.proxy, config);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    if (!request.empty())
+    {
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request.c_str());
+    }
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    if (timeoutMs > 0)
+    {
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeoutMs);
+    }
+
+    auto write = [](char *contents, size_t size, size_t nmemb, void *userp) -> size_t
+    {
+        static_cast<std::string *>(userp)->append(contents, size * nmemb);
+        return size * nmemb;
+    };
+    response.clear();
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, static_cast<curl_write_callback>(write));
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+
+    // Checked about once per second even while the server sends nothing (e.g. while a model loads)
+    if (abort)
     {
-        MSG msg;
-        while (::PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+        auto progress = [](void *clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t) -> int
         {
-            ::TranslateMessage(&msg);
-            ::DispatchMessage(&msg);
-        }
-        ::Sleep(10);
+            return static_cast<const std::atomic<bool> *>(clientp)->load() ? 1 : 0;
+        };
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, static_cast<curl_xferinfo_callback>(progress));
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, const_cast<std::atomic<bool> *>(abort));
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
     }
-    res = futureRes.get();
 
-    // Get HTTP status code
-    long http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    long httpStatus = 0;
+    if (curl_easy_perform(curl) == CURLE_OK)
+    {
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpStatus);
+    }
+    span.setArg("status", httpStatus);
 
     curl_slist_free_all(headers);
     curl_easy_cleanup(curl);
+    return httpStatus;
+}
+
+/**
+ * Warms up the connection to an endpoint before a request is made
+ *
+ * Sends a HEAD request through the profile's connection cache: a new
+ * connection stays in the pool for the following request, and the DNS entry
+ * and TLS session are cached even if the server closes it. The status of the
+ * response does not matter; most APIs answer HEAD on the chat route with 404
+ * or 405, which is enough. No body is transferred.
+ *
+ * @param url The full API endpoint URL the next request will use
+ * @param apiType The type of API (openai, claude, ollama, etc.)
+ * @param secretKey The API key for authentication
+ * @param config The configuration snapshot of the request (proxy, connection cache)
+ * @param timeoutMs Limit for the whole exchange (0 = none)
+ * @param reused Output: true if an open connection was found and no new one was made
+ * @return true if the server was reached
+ */
+bool HTTPClient::preconnect(
+    const std::string &url,
+    const std::string &apiType,
+    const std::string &secretKey,
+    const ConfigSnapshot &config,
+    long timeoutMs,
+    bool &reused)
+{
+    TraceSpan span("preconnect", "http");
+    reused = false;
+    CURL *curl = curl_easy_init();
+    if (!curl)
+        return false;
+
+    struct curl_slist *headers = setupCommonOptions(curl, apiType, secretKey, config.proxy, config);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    if (timeoutMs > 0)
+    {
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeoutMs);
+    }
 
-    // Return true only if both curl succeeded and HTTP status is 2xx
-    return (res == CURLE_OK && (http_code >= 200 && http_code < 300));
+    double startUs = Trace::isEnabled() ? Trace::nowUs() : 0;
+    bool ok = (curl_easy_perform(curl) == CURLE_OK);
+    traceTransferPhases(curl, startUs);
+    long connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+    reused = ok && connects == 0;
+    span.setArg("new_connections", connects);
+
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(curl);
+    return ok;
 }
 
 /**
  * Performs a streaming HTTP request to an LLM API
  *
+ * Failures are retried like in performRequest, but only as long as nothing has
+ * been inserted into the editor yet: once the first token is in the document a
+ * retry would duplicate text, so a broken stream is reported instead.
+ *
+ * With hedging enabled (see HedgePolicy), a first attempt that produces no
+ * content within the hedge delay gets a duplicate request, and whichever of the
+ * two starts streaming first is kept.
+ *
  * @param url The full API endpoint URL to call
  * @param request The JSON request body as a string
+ * @param response Output parameter that receives the error body if the request fails
  * @param apiType The type of API (openai, claude, ollama, etc.)
  * @param secretKey The API key for authentication
- * @param targetWindow The window handle to receive streaming chunks
- * @param streamMessageType The Windows message type for streaming chunks
  * @param proxy Optional proxy server to use (or "0" for no proxy)
+ * @param transferInfo Optional failover control and transfer measurements
  * @return true if the request was successful (200-level response), false otherwise
  */
 bool HTTPClient::performStreamingRequest(
     const std::string &url,
     const std::string &request,
+    std::string &response,
     const std::string &apiType,
     const std::string &secretKey,
-    void *targetWindow,
-    unsigned int streamMessageType,
-    const std::string &proxy)
+    const std::string &proxy,
+    TransferInfo *transferInfo)
 {
-    // The streamMessageType parameter contains the message ID to use for posting chunks
-    // We still need to cast it to void to suppress any unused parameter warnings
-    (void)streamMessageType; // Will actually use WM_OPENAI_STREAM_CHUNK from OpenAIClient.cpp
-
+    TraceSpan span("streaming request", "http");
     CURL *curl = curl_easy_init();
     if (!curl)
         return false;
 
-    struct curl_slist *headers = nullptr;
+    // Settings stay fixed for the whole request, even if the configuration is reloaded meanwhile
+    std::shared_ptr<const ConfigSnapshot> config = (transferInfo && transferInfo->config) ? transferInfo->config : ConfigSnapshot::current();
 
-    // Set required headers
-    headers = curl_slist_append(headers, "Content-Type: application/json");
+    // Per-request stream state: partial-line buffer and response status
+    StreamContext streamContext;
+    std::unique_ptr<StreamRecorder> recorder;
+    if (!config->captureDir.empty())
+    {
+        recorder.reset(new StreamRecorder(apiType, true));
+        streamContext.recorder = recorder.get();
+    }
+    std::string *collected = transferInfo ? transferInfo->collect : nullptr;
+    streamContext.collected = collected;
 
-    // Add Accept header for handling streaming response
-    if (apiType == "openai" || apiType == "ollama")
+    // Streamed text reaches the front-end through a bounded queue, so a busy UI thread pauses the transfer
+    std::unique_ptr<StreamBuffer> buffer;
+    if (!collected && config->streamBufferKb > 0)
     {
-        headers = curl_slist_append(headers, "Accept: text/event-stream");
+        buffer.reset(new StreamBuffer(static_cast<size_t>(config->streamBufferKb) * 1024, static_cast<size_t>(config->streamResumeKb) * 1024));
+        streamContext.buffer = buffer.get();
     }
+    struct curl_slist *headers = setupStreamingHandle(curl, url, request, apiType, secretKey, proxy, *config, streamContext);
 
-    // Add authentication headers based on API type
-    if (apiType == "claude")
+    // Prepare a duplicate for hedging the first attempt (sent only if the primary is slow; streaming asks only)
+    int hedgeDelayMs = collected ? -1 : HedgePolicy::instance().hedgeDelayMs();
+    CURL *hedgeCurl = nullptr;
+    struct curl_slist *hedgeHeaders = nullptr;
+    StreamContext hedgeContext;
+    hedgeContext.buffer = buffer.get();
+    if (hedgeDelayMs >= 0)
     {
-        std::string authHeader = "x-api-key: " + secretKey;
-        headers = curl_slist_append(headers, authHeader.c_str());
-        headers = curl_slist_append(headers, "anthropic-version: 2023-06-01");
+        hedgeCurl = curl_easy_init();
+        const HedgeTarget *target = transferInfo ? transferInfo->hedgeTarget : nullptr;
+        if (hedgeCurl && target)
+        {
+            hedgeHeaders = setupStreamingHandle(hedgeCurl, target->url, target->request, target->apiType, target->secretKey, proxy, *config, hedgeContext);
+        }
+        else if (hedgeCurl)
+        {
+            hedgeHeaders = setupStreamingHandle(hedgeCurl, url, request, apiType, secretKey, proxy, *config, hedgeContext);
+        }
     }
-    else
+
+    // Add debugging for streaming requests
+    TransferHost &host = TransferHost::current();
+    host.showDebugStatus(L"Starting streaming request...");
+
+    // Let the host group the streamed text (one undo action in the editor)
+    if (!collected)
     {
-        std::string authHeader = "Authorization: Bearer " + secretKey;
-        headers = curl_slist_append(headers, authHeader.c_str());
+        host.beginStream();
     }
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str()); // Set URL before async call
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, OpenAIStreamCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, targetWindow);
 
-    // Important: Set these options for proper streaming behavior
-    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
-    curl_easy_setopt(curl, CURLOPT_TRANSFER_ENCODING, 1L);
-    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    RetryPolicy retryPolicy = retryPolicyFromConfig(*config);
+    RateLimiter &rateLimiter = rateLimiterFor(apiType, secretKey, *config);
+    double estimatedTokens = RateLimiter::estimateTokens(request);
+    CURLcode res = CURLE_OK;
+    bool ok = false;
+    bool hedgeStarted = false;
+    bool hedgeWon = false;
+    StreamContext *activeContext = &streamContext;
+    auto attemptStart = std::chrono::steady_clock::now();
+    int attempt = 1;
+    for (;; ++attempt)
+    {
+        streamContext.pending.clear();
+        streamContext.errorBody.clear();
+        streamContext.finalPayload.clear();
+        streamContext.usage = TokenUsage();
+        streamContext.headers.reset();
+        if (collected)
+        {
+            collected->clear();
+        }
 
-    // Set proxy if provided before async call
-    if (!proxy.empty() && proxy != "0")
+        // Queue locally instead of sending a request the provider would reject with 429
+        if (!waitForRateLimit(rateLimiter.reserve(estimatedTokens)))
+        {
+            res = CURLE_ABORTED_BY_CALLBACK;
+            break;
+        }
+        attemptStart = std::chrono::steady_clock::now();
+        if (recorder)
+        {
+            recorder->restart();
+        }
+
+        // Perform the request asynchronously, processing the message queue meanwhile
+        if (attempt == 1 && hedgeCurl)
+        {
+            res = static_cast<CURLcode>(performHedged(curl, streamContext, hedgeCurl, hedgeContext, hedgeDelayMs, hedgeStarted, hedgeWon));
+        }
+        else
+        {
+            hedgeWon = false;
+            res = static_cast<CURLcode>(buffer ? performBuffered(curl, streamContext) : performWithMessagePump(curl));
+        }
+        activeContext = hedgeWon ? &hedgeContext : &streamContext;
+        if (!hedgeWon)
+        {
+            rateLimiter.updateFromHeaders(activeContext->headers);
+        }
+
+        // Process a final line that was not terminated by a newline
+        flushStreamContext(*activeContext);
+        if (buffer)
+        {
+            deliverQueued(*buffer);
+        }
+
+        ok = (res == CURLE_OK && activeContext->headers.isSuccess());
+        // Collected content has not reached the editor, so it can be received again
+        if (ok || host.isCancelled() || (activeContext->contentDelivered && !collected))
+            break;
+
+        // A retryable failure goes to the next endpoint instead, if there is one
+        int delayMs = retryPolicy.nextDelayMs(attempt, res, activeContext->headers);
+        if (delayMs >= 0 && transferInfo && transferInfo->failoverAvailable)
+            break;
+        if (delayMs < 0 || !waitBeforeRetry(delayMs, attempt, retryPolicy.maxAttempts(), activeContext->headers))
+            break;
+    }
+    response = activeContext->errorBody;
+    recordTransfer(hedgeWon ? hedgeCurl : curl, res, activeContext->headers.statusCode, attempt, transferInfo);
+
+    // Only the primary transfer is recorded; a response won by the hedge is not captured
+    if (!hedgeWon)
     {
-        curl_easy_setopt(curl, CURLOPT_PROXY, proxy.c_str());
-    } // Add debugging for streaming requests
-    if (debugMode)
+        saveCapture(recorder.get(), *config, streamContext.headers.statusCode, res);
+    }
+    if (transferInfo)
     {
-        ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, (LPARAM)L"Starting streaming request...");
+        transferInfo->contentDelivered = activeContext->contentDelivered && !collected;
+        transferInfo->hedged = hedgeStarted;
+        transferInfo->hedgeWon = hedgeWon;
+        transferInfo->stats = activeContext->stats;
+        transferInfo->stats.peakQueuedBytes = buffer ? buffer->peakBytes() : 0;
+        transferInfo->finalPayload = activeContext->finalPayload;
+        transferInfo->usage = activeContext->usage;
     }
 
-	// Begin undo action in Scintilla editor to allow for proper undo/redo behavior
-    HWND curScintilla = EditorInterface::getCurrentScintilla();
-    ::SendMessage(curScintilla, SCI_BEGINUNDOACTION, 0, 0);
+    // Time to first token (from the start of the attempt, so a winning hedge counts its delay too)
+    if (ok && activeContext->contentDelivered)
+    {
+        HedgePolicy::instance().recordTimeToFirstToken(
+            std::chrono::duration<double, std::milli>(activeContext->firstContentAt - attemptStart).count());
+    }
 
-    // Perform the request asynchronously
-    auto futureRes = std::async(std::launch::async, [curl]()
-                                {
-                                   CURLcode r = curl_easy_perform(curl);
-                                   return r; });
+    if (!collected)
+    {
+        host.endStream();
+    }
+
+    // Add debugging for the HTTP response
+    host.showDebugStatus(L"HTTP " + std::to_wstring(streamContext.headers.statusCode) + L", cURL: " + std::to_wstring(res));
+
+    curl_easy_cleanup(curl);
+    curl_slist_free_all(headers);
+    if (hedgeCurl)
+    {
+        curl_easy_cleanup(hedgeCurl);
+        curl_slist_free_all(hedgeHeaders);
+    }
 
-    // Process message queue while request is in progress
-    CURLcode res;
-    while (futureRes.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready)
+    return ok;
+}
+
+/**
+ * Sends one ask over the persistent Realtime API session
+ *
+ * The server events go through processStreamLine like SSE lines (response type
+ * "realtime"): text deltas reach the TransferHost, the other events update
+ * finalPayload and the usage. "response.done" ends the answer; an "error"
+ * event or a failed response ends it with the error as the response body.
+ *
+ * Nothing is retried here: RealtimeSession replaces a stale session once, and
+ * ChatPipeline falls back to HTTP when nothing was delivered.
+ *
+ * @param url ws(s):// URL of the session (see RealtimeSession::buildUrl)
+ * @param event The "response.create" event (see RealtimeSession::responseEvent)
+ * @param response Output parameter that receives the error body if the request fails
+ * @param secretKey The API key for authentication
+ * @param transferInfo Optional transfer measurements
+ * @return true if the response completed
+ */
+bool HTTPClient::performRealtimeRequest(
+    const std::string &url,
+    const std::string &event,
+    std::string &response,
+    const std::string &secretKey,
+    TransferInfo *transferInfo)
+{
+    using json = nlohmann::json;
+    TraceSpan span("realtime request", "http");
+    std::shared_ptr<const ConfigSnapshot> config = (transferInfo && transferInfo->config) ? transferInfo->config : ConfigSnapshot::current();
+    TransferHost &host = TransferHost::current();
+    response.clear();
+
+    // The session shares the key's budget with its HTTP requests
+    RateLimiter &rateLimiter = rateLimiterFor("openai", secretKey, *config);
+    if (!waitForRateLimit(rateLimiter.reserve(RateLimiter::estimateTokens(event))))
+    {
+        return false;
+    }
+
+    StreamContext context;
+    context.apiType = "realtime";
+    context.provider = &ProviderOps::forType(context.apiType);
+    std::string errorBody;
+    auto start = std::chrono::steady_clock::now();
+    double ttfbMs = -1;
+    auto onEvent = [&](const std::string &message)
     {
-        MSG msg;
-        while (::PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+        if (ttfbMs < 0)
+        {
+            ttfbMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        context.stats.bytesReceived += message.size();
+        context.stats.chunks++;
+        context.stats.peakBufferBytes = (std::max)(context.stats.peakBufferBytes, message.capacity());
+        if (processStreamLine(message, context))
+        {
+            context.stats.contentEvents++;
+            if (!context.contentDelivered)
+            {
+                context.contentDelivered = true;
+                context.firstContentAt = std::chrono::steady_clock::now();
+            }
+            return false;
+        }
+
+        // Only the end of a response and errors need a closer look
+        if (message.find("response.done") == std::string::npos && message.find("\"error\"") == std::string::npos)
+        {
+            return false;
+        }
+        json body = json::parse(message, nullptr, false);
+        std::string type = (body.is_object() && body.contains("type") && body["type"].is_string()) ? body["type"].get<std::string>() : "";
+        if (type == "error")
         {
-            ::TranslateMessage(&msg);
-            ::DispatchMessage(&msg);
+            errorBody = json{{"error", body["error"]}}.dump();
+            return true;
         }
-        ::Sleep(10);
+        if (type != "response.done")
+        {
+            return false;
+        }
+        const json &done = body["response"];
+        std::string status = (done.is_object() && done.contains("status") && done["status"].is_string()) ? done["status"].get<std::string>() : "completed";
+        if (status == "failed" || status == "cancelled")
+        {
+            json error = {{"message", "Realtime response " + status}};
+            if (done.contains("status_details") && done["status_details"].is_object() && done["status_details"].contains("error"))
+            {
+                error = done["status_details"]["error"];
+            }
+            errorBody = json{{"error", error}}.dump();
+        }
+        return true;
+    };
+
+    host.showDebugStatus(L"Sending over the realtime session...");
+    host.beginStream();
+    RealtimeSession::Exchange exchange;
+    runWithMessagePump([&]()
+                       {
+        exchange = RealtimeSession::instance().exchange(url, secretKey, *config, event, onEvent, [&host]()
+                                                        { return host.isCancelled(); });
+        return 0; });
+    host.endStream();
+
+    if (exchange.outcome == RealtimeSession::Outcome::Failed)
+    {
+        errorBody = json{{"error", {{"message", exchange.error}}}}.dump();
+    }
+    bool ok = (exchange.outcome == RealtimeSession::Outcome::Done && errorBody.empty());
+    response = errorBody;
+
+    if (transferInfo)
+    {
+        transferInfo->curlCode = (exchange.outcome == RealtimeSession::Outcome::Aborted)  ? CURLE_ABORTED_BY_CALLBACK
+                                 : (exchange.outcome == RealtimeSession::Outcome::Failed) ? CURLE_COULDNT_CONNECT
+                                                                                          : CURLE_OK;
+        transferInfo->httpStatus = exchange.httpStatus ? exchange.httpStatus : (exchange.outcome == RealtimeSession::Outcome::Failed ? 0 : 101);
+        transferInfo->ttfbMs = ttfbMs;
+        transferInfo->attempts = 1;
+        transferInfo->contentDelivered = context.contentDelivered;
+        transferInfo->stats = context.stats;
+        transferInfo->finalPayload = context.finalPayload;
+        transferInfo->usage = context.usage;
+        transferInfo->sessionOpened = exchange.connected;
+    }
+
+    if (exchange.outcome == RealtimeSession::Outcome::Failed && !exchange.connected)
+    {
+        host.showDebugStatus(L"Realtime session could not be opened");
+    }
+    else
+    {
+        host.showDebugStatus(std::wstring(L"Realtime session ") + (exchange.connected ? L"opened" : L"reused") +
+                             (ok ? L", response complete" : L", response failed"));
     }
-    res = futureRes.get(); // Get HTTP status code
-    long http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    return ok;
+}
+
+/**
+ * Replays a recorded response through the transfer callbacks
+ *
+ * Streaming fixtures go through streamCallback (content reaches the TransferHost
+ * exactly as during the recorded transfer, including the original chunk
+ * boundaries), the others through writeCallback. No network access is made.
+ *
+ * @param fixture The recorded response
+ * @param speed Timing scale (1 = recorded pace, 2 = twice as fast, 0 = no delays)
+ * @param response Receives the body (non-streaming) or the error body (streaming)
+ * @param transferInfo Optional transfer measurements, filled in like for a live request
+ * @return true if the recorded transfer succeeded and was replayed completely
+ */
+bool HTTPClient::replay(const StreamFixture &fixture, double speed, std::string &response, TransferInfo *transferInfo)
+{
+    TransferHost &host = TransferHost::current();
+    response.clear();
 
-	// End undo action in Scintilla editor
-    ::SendMessage(curScintilla, SCI_ENDUNDOACTION, 0, 0);
+    StreamContext context;
+    context.apiType = fixture.apiType;
+    context.headers.statusCode = fixture.httpStatus;
+    ResponseBody body;
+    body.data = &response;
 
-    // Add debugging for the HTTP response
-    if (debugMode)
+    if (fixture.streaming)
     {
-        std::wstring statusMsg = L"HTTP " + std::to_wstring(http_code) + L", cURL: " + std::to_wstring(res);
-        ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, (LPARAM)statusMsg.c_str());
+        host.beginStream();
     }
 
-    curl_easy_cleanup(curl);
-    curl_slist_free_all(headers);
+    bool aborted = false;
+    double ttfbMs = -1;
+    auto start = std::chrono::steady_clock::now();
+    auto due = start;
+    for (const StreamFixture::Chunk &chunk : fixture.chunks)
+    {
+        if (speed > 0)
+        {
+            due += std::chrono::microseconds(static_cast<int64_t>(chunk.delayUs / speed));
+            for (auto now = std::chrono::steady_clock::now(); now < due; now = std::chrono::steady_clock::now())
+            {
+                host.idle();
+                std::this_thread::sleep_for((std::min)(std::chrono::duration_cast<std::chrono::microseconds>(due - now),
+                                                       std::chrono::microseconds(10000)));
+            }
+        }
+        if (ttfbMs < 0)
+        {
+            ttfbMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        void *data = const_cast<char *>(chunk.data.data());
+        size_t handled = fixture.streaming ? streamCallback(data, 1, chunk.data.size(), &context)
+                                           : writeCallback(data, 1, chunk.data.size(), &body);
+        if (handled != chunk.data.size())
+        {
+            aborted = true;
+            break;
+        }
+    }
+
+    if (fixture.streaming)
+    {
+        flushStreamContext(context);
+        response = context.errorBody;
+        host.endStream();
+    }
 
-    // Return true only if both curl succeeded and HTTP status is 2xx
-    return (res == CURLE_OK && (http_code >= 200 && http_code < 300));
+    int curlCode = aborted ? CURLE_WRITE_ERROR : fixture.curlCode;
+    if (transferInfo)
+    {
+        transferInfo->curlCode = curlCode;
+        transferInfo->httpStatus = fixture.httpStatus;
+        transferInfo->attempts = 1;
+        transferInfo->ttfbMs = ttfbMs;
+        transferInfo->contentDelivered = context.contentDelivered;
+        transferInfo->stats = fixture.streaming ? context.stats : body.stats;
+        transferInfo->finalPayload = context.finalPayload;
+        transferInfo->usage = context.usage;
+    }
+    return curlCode == CURLE_OK && context.headers.isSuccess();
 }
@@ -1,6 +1,122 @@
 #pragma once
+#include <atomic>
 #include <string>
 #include <functional>
+#include <chrono>
+#include <memory>
+#include "ResponseHeaders.h"
+#include "RetryPolicy.h"
+#include "RateLimiter.h"
+#include "TokenUsage.h"
+
+struct curl_slist;
+struct ConfigSnapshot;
+struct ProviderOps;
+struct StreamFixture;
+class StreamBuffer;
+class StreamRecorder;
+
+/**
+ * Volume and buffer counters of one request (all attempts), kept in every build
+ *
+ * Cheap enough for release builds: a few additions per write callback. The
+ * exact allocation counts come from the counting allocator of the tools
+ * (tools/common/AllocationCounter), which the plugin does not use.
+ */
+struct TransferStats
+{
+    size_t bytesReceived = 0;   // Response body bytes handed to the write callbacks
+    size_t chunks = 0;          // Write callback invocations
+    size_t contentEvents = 0;   // Stream lines that delivered content (about one per token)
+    size_t peakBufferBytes = 0; // Largest capacity of the body or partial-line buffers
+    size_t peakQueuedBytes = 0; // Most streamed text waiting for the front-end at once (see StreamBuffer)
+    size_t pauses = 0;          // Times the transfer was paused because the front-end fell behind
+    double pausedMs = 0;        // Total time the transfer spent paused
+};
+
+/**
+ * Per-request state handed to the streaming write callback
+ *
+ * Chunk boundaries depend on the transport (HTTP/1.1 chunked encoding, HTTP/2
+ * DATA frames, proxies), so a single SSE or NDJSON line may arrive split across
+ * several callbacks. The callback keeps the unfinished tail in 'pending' and only
+ * parses complete lines.
+ *
+ * When a request is hedged, the primary and the duplicate share 'raceWinner':
+ * the first context to parse content from its stream claims it, and the other
+ * one's callback aborts its transfer. Metadata events (Claude's message_start,
+ * an OpenAI role delta) do not count, so an endpoint that answers the headers
+ * at once but queues the generation does not win the race.
+ *
+ * With a 'buffer', content is queued for the requesting thread instead of being
+ * delivered from the callback; a full buffer pauses the transfer until the
+ * transfer loop sees it drained.
+ */
+struct StreamContext
+{
+    std::string apiType;           // Response type of the endpoint being streamed from
+    const ProviderOps *provider = nullptr; // Wire format of apiType, resolved once (see ProviderTraits)
+    std::string pending;           // Incomplete line carried over from the previous chunk
+    ResponseHeaders headers;       // Status and headers of the current attempt
+    std::string errorBody;         // Body of a non-2xx response (not inserted into the editor)
+    std::string finalPayload;      // Payload of the last line without content (Ollama's done line carries the context array)
+    TokenUsage usage;              // Usage reported by the lines without content
+    std::string *collected = nullptr; // Receives the content instead of the TransferHost (see TransferInfo::collect)
+    StreamBuffer *buffer = nullptr;   // Queue to the TransferHost (null = deliver from the write callback)
+    bool paused = false;              // The write callback paused the transfer because 'buffer' was full
+    std::chrono::steady_clock::time_point pausedAt; // When 'paused' was set
+    bool contentDelivered = false; // Set once any content arrived; unless collected, the request is no longer retryable
+    std::chrono::steady_clock::time_point firstContentAt; // When contentDelivered was first set
+    StreamContext **raceWinner = nullptr; // Shared by hedged transfers (null when not hedged)
+    StreamRecorder *recorder = nullptr;   // Captures the raw body when capture_dir is set
+    TransferStats stats;                  // Counters of this context's transfers
+};
+
+/**
+ * Destination of a non-streaming response body
+ */
+struct ResponseBody
+{
+    std::string *data = nullptr;        // Receives the body
+    StreamRecorder *recorder = nullptr; // Captures the raw body when capture_dir is set
+    TransferStats stats;                // Counters of the transfer
+};
+
+/**
+ * Where a hedged duplicate of a streaming request is sent
+ */
+struct HedgeTarget
+{
+    std::string url;       // Full API URL
+    std::string request;   // JSON body (formatted for the target's response type)
+    std::string apiType;   // Response type of the target
+    std::string secretKey; // API key of the target
+};
+
+/**
+ * Optional per-request failover control and transfer measurements
+ *
+ * Filled in by HTTPClient so the caller can update endpoint health
+ * (see EndpointRouter) and decide whether to try the next endpoint.
+ */
+struct TransferInfo
+{
+    std::shared_ptr<const ConfigSnapshot> config; // In: configuration of the request (null = the current one)
+    bool failoverAvailable = false; // In: another endpoint can take over, so failures are not retried against this one
+    int curlCode = 0;               // Out: CURLcode of the last attempt
+    long httpStatus = 0;            // Out: HTTP status of the last attempt (0 if no response)
+    double ttfbMs = -1;             // Out: time to first response byte of the last attempt, -1 if none arrived
+    int attempts = 0;               // Out: number of attempts made
+    bool contentDelivered = false;  // Out: streamed content reached the editor, so the request must not be repeated elsewhere
+    const HedgeTarget *hedgeTarget = nullptr; // In: alternate target for a hedged duplicate (null = same endpoint)
+    bool hedged = false;            // Out: a duplicate request was sent
+    bool hedgeWon = false;          // Out: the duplicate delivered the response
+    TransferStats stats;            // Out: counters of the transfer that delivered the response
+    std::string finalPayload;       // Out (streaming): payload of the last stream line that carried no content
+    TokenUsage usage;               // Out (streaming): token usage reported by the stream
+    bool sessionOpened = false;     // Out (realtime): a new WebSocket session was opened for the request
+    std::string *collect = nullptr; // In (streaming): append the streamed content here instead of delivering it to the TransferHost
+};
 
 /**
  * HTTPClient - A module for handling HTTP requests to different LLM APIs
@@ -8,6 +124,16 @@
  * This class encapsulates all HTTP communication functionality, handling
  * both regular and streaming API requests. It provides a clean interface
  * that abstracts away the details of cURL usage.
+ *
+ * User interaction (message pump, cancellation, status messages, the destination
+ * of streamed text) goes through the installed TransferHost, so the class has
+ * no dependency on Notepad++ or Win32 and also runs in the command-line client.
+ *
+ * All requests of a profile share one connection cache, DNS cache and TLS
+ * session cache, so successive asks reuse warm idle connections. Transfers run
+ * on the shared multi handle of the TransferDriver, so those in flight at the
+ * same time (concurrent asks, a hedged request and its duplicate) share an
+ * HTTP/2 connection as separate streams.
  */
 class HTTPClient
 {
@@ -19,19 +145,85 @@ public:
         std::string &response,
         const std::string &apiType,
         const std::string &secretKey,
-        const std::string &proxy = "");
+        const std::string &proxy = "",
+        TransferInfo *transferInfo = nullptr);
 
     // For streaming requests
     static bool performStreamingRequest(
         const std::string &url,
         const std::string &request,
+        std::string &response,
+        const std::string &apiType,
+        const std::string &secretKey,
+        const std::string &proxy = "",
+        TransferInfo *transferInfo = nullptr);
+
+    // Send a "response.create" event over the persistent Realtime API session (see RealtimeSession) and stream the
+    // answer like performStreamingRequest. Fails without delivering anything if no session can be opened.
+    static bool performRealtimeRequest(
+        const std::string &url,
+        const std::string &event,
+        std::string &response,
+        const std::string &secretKey,
+        TransferInfo *transferInfo = nullptr);
+
+    // Feed a recorded response through the same callbacks as a live transfer (no network).
+    // 'speed' scales the recorded timing: 1 = original, 10 = ten times faster, 0 = no delays.
+    static bool replay(const StreamFixture &fixture, double speed, std::string &response, TransferInfo *transferInfo = nullptr);
+
+    // Request made on a background thread without a TransferHost (no retries, status messages or editor output).
+    // An empty 'request' sends a GET. Uses the profile's connection cache. Returns the HTTP status, 0 if no response arrived.
+    static long performBackgroundRequest(
+        const std::string &url,
+        const std::string &request,
+        std::string &response,
         const std::string &apiType,
         const std::string &secretKey,
-        void *targetWindow,
-        unsigned int streamMessageType,
-        const std::string &proxy = "");
+        const ConfigSnapshot &config,
+        long timeoutMs,
+        const std::atomic<bool> *abort = nullptr);
+
+    // Open (or find) a pooled connection to the host of 'url' with a HEAD request, so the next request skips DNS,
+    // TCP and TLS. 'reused' tells whether a warm connection already existed. False if the host could not be reached.
+    static bool preconnect(
+        const std::string &url,
+        const std::string &apiType,
+        const std::string &secretKey,
+        const ConfigSnapshot &config,
+        long timeoutMs,
+        bool &reused);
+
+    // Map the http_version setting ("auto", "1.1", "2", "2-prior-knowledge") to a cURL constant
+    static long resolveHttpVersion(const std::string &httpVersion);
+
+    // Release the shared connection caches (called on plugin shutdown)
+    static void shutdown();
+
+    // cURL write callbacks (userp: ResponseBody for performRequest, StreamContext for streaming)
+    static size_t writeCallback(void *contents, size_t size, size_t nmemb, void *userp);
+    static size_t streamCallback(void *contents, size_t size, size_t nmemb, void *userp);
 
 private:
-    static void setupCommonOptions(void *curl, const std::string &apiType, const std::string &secretKey);
-    static void setupStreamingOptions(void *curl, const std::string &apiType);
+    static bool processStreamLine(const std::string &line, StreamContext &context);
+    static void flushStreamContext(StreamContext &context);
+    static int performWithMessagePump(void *curl);
+    static int runWithMessagePump(const std::function<int()> &work, StreamBuffer *buffer = nullptr);
+    static int performBuffered(void *curl, StreamContext &context);
+    static int performHedged(void *primary, StreamContext &primaryContext, void *hedge, StreamContext &hedgeContext, int hedgeDelayMs, bool &hedgeStarted, bool &hedgeWon);
+    static void resumeIfDrained(void *curl, StreamContext &context);
+    static void endPause(StreamContext &context);
+    static void deliverQueued(StreamBuffer &buffer);
+    static curl_slist *setupStreamingHandle(void *curl, const std::string &url, const std::string &request, const std::string &apiType,
+                                            const std::string &secretKey, const std::string &proxy, const ConfigSnapshot &config,
+                                            StreamContext &context);
+    static bool waitBeforeRetry(int delayMs, int attempt, int maxAttempts, const ResponseHeaders &headers);
+    static bool waitForRateLimit(int64_t delayMs);
+    static bool waitWithMessagePump(int64_t delayMs);
+    static RateLimiter &rateLimiterFor(const std::string &apiType, const std::string &secretKey, const ConfigSnapshot &config);
+    static RetryPolicy retryPolicyFromConfig(const ConfigSnapshot &config);
+    static void saveCapture(StreamRecorder *recorder, const ConfigSnapshot &config, long httpStatus, int curlCode);
+    static void recordTransfer(void *curl, int curlCode, long httpStatus, int attempts, TransferInfo *transferInfo);
+    static curl_slist *setupCommonOptions(void *curl, const std::string &apiType, const std::string &secretKey, const std::string &proxy,
+                                          const ConfigSnapshot &config);
+    static curl_slist *setupStreamingOptions(void *curl, curl_slist *headers, const std::string &apiType);
 };
@@ -0,0 +1,61 @@
+/**
+ * HedgePolicy.cpp - Hedge delay and duplicate-request budget
+ */
+
+#include "HedgePolicy.h"
+#include <algorithm>
+
+namespace
+{
+    // Unused budget is capped so a long quiet period cannot fund a burst of duplicates
+    const double kMaxCredits = 2.0;
+}
+
+HedgePolicy &HedgePolicy::instance()
+{
+    static HedgePolicy policy;
+    return policy;
+}
+
+void HedgePolicy::configure(bool enabled, double percentile, int minDelayMs, double budgetPercent)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _enabled = enabled;
+    _percentile = std::min(99.9, std::max(50.0, percentile));
+    _minDelayMs = std::max(0, minDelayMs);
+    _budgetPercent = std::min(100.0, std::max(0.0, budgetPercent));
+}
+
+bool HedgePolicy::isEnabled() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _enabled;
+}
+
+int HedgePolicy::hedgeDelayMs() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_enabled || _budgetPercent <= 0 || _timeToFirstToken.count() < kMinSamples)
+    {
+        return -1;
+    }
+    return std::max(_minDelayMs, static_cast<int>(_timeToFirstToken.percentile(_percentile)));
+}
+
+bool HedgePolicy::tryAcquireHedge()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_credits < 1.0)
+    {
+        return false;
+    }
+    _credits -= 1.0;
+    return true;
+}
+
+void HedgePolicy::recordTimeToFirstToken(double ms)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _timeToFirstToken.add(ms);
+    _credits = std::min(kMaxCredits, _credits + _budgetPercent / 100.0);
+}
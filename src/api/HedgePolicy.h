@@ -0,0 +1,53 @@
+#pragma once
+#include <mutex>
+#include "LatencyTracker.h"
+
+/**
+ * HedgePolicy - Decides when a slow streaming request gets a duplicate ("hedge")
+ *
+ * Time to first token of recent streaming requests is collected in a
+ * LatencyTracker. When hedging is enabled and a request has not produced
+ * content after the configured percentile of that distribution (but at least
+ * the minimum delay), HTTPClient sends one duplicate request - to the next
+ * failover endpoint if there is one, otherwise to the same endpoint - and keeps
+ * whichever starts streaming first.
+ *
+ * Duplicates cost tokens, so they are capped twice: at most one hedge per
+ * request, and a budget that lets only 'budgetPercent' of all requests be
+ * hedged on average (each request earns budgetPercent/100 credits, each hedge
+ * spends one). The budget starts with one credit.
+ */
+class HedgePolicy
+{
+public:
+    static HedgePolicy &instance();
+
+    // Apply the hedge_* settings
+    void configure(bool enabled, double percentile, int minDelayMs, double budgetPercent);
+
+    bool isEnabled() const;
+
+    // Milliseconds without content after which a request is hedged, or -1 if hedging is
+    // disabled or too few samples were collected yet
+    int hedgeDelayMs() const;
+
+    // Spend one budget credit for a hedge; false if the budget is exhausted
+    bool tryAcquireHedge();
+
+    // Record the time to first token of a completed streaming request and earn budget
+    void recordTimeToFirstToken(double ms);
+
+    // Minimum samples before hedging starts
+    static const size_t kMinSamples = 20;
+
+private:
+    HedgePolicy() = default;
+
+    mutable std::mutex _mutex;
+    LatencyTracker _timeToFirstToken;
+    bool _enabled = false;
+    double _percentile = 95;
+    int _minDelayMs = 250;
+    double _budgetPercent = 10;
+    double _credits = 1; // A slow request can be hedged before the first requests have earned budget
+};
@@ -0,0 +1,59 @@
+/**
+ * LatencyTracker.cpp - Ring buffer of latency samples with percentile queries
+ */
+
+#include "LatencyTracker.h"
+#include <algorithm>
+#include <cmath>
+
+LatencyTracker::LatencyTracker(size_t capacity)
+    : _capacity(std::max<size_t>(1, capacity))
+{
+    _samples.reserve(_capacity);
+}
+
+void LatencyTracker::add(double ms)
+{
+    if (ms < 0)
+    {
+        return;
+    }
+
+    if (_samples.size() < _capacity)
+    {
+        _samples.push_back(ms);
+    }
+    else
+    {
+        _samples[_next] = ms;
+    }
+    _next = (_next + 1) % _capacity;
+}
+
+/**
+ * Get a percentile of the current window
+ *
+ * @param p Percentile between 0 and 100 (e.g. 95 for p95)
+ * @return The nearest-rank percentile value, or -1 if there are no samples
+ */
+double LatencyTracker::percentile(double p) const
+{
+    if (_samples.empty())
+    {
+        return -1;
+    }
+
+    p = std::min(100.0, std::max(0.0, p));
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * _samples.size()));
+    size_t index = (rank > 0) ? rank - 1 : 0;
+
+    std::vector<double> sorted(_samples);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+void LatencyTracker::clear()
+{
+    _samples.clear();
+    _next = 0;
+}
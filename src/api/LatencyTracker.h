@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+/**
+ * LatencyTracker - Sliding window of recent latency samples
+ *
+ * Keeps the last N samples in a ring buffer and answers percentile queries
+ * over them (nearest-rank). Not thread-safe; owners lock around it.
+ */
+class LatencyTracker
+{
+public:
+    explicit LatencyTracker(size_t capacity = 200);
+
+    // Add a sample in milliseconds (negative values are ignored)
+    void add(double ms);
+
+    // Number of samples currently in the window
+    size_t count() const { return _samples.size(); }
+
+    // Value at the given percentile (0-100) of the window, or -1 if empty
+    double percentile(double p) const;
+
+    // Forget all samples
+    void clear();
+
+private:
+    size_t _capacity;
+    size_t _next = 0;
+    std::vector<double> _samples;
+};
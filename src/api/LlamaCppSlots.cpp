@@ -0,0 +1,49 @@
+/**
+ * LlamaCppSlots.cpp - Least recently used assignment of llama-server slots to documents
+ */
+
+#include "LlamaCppSlots.h"
+
+LlamaCppSlots &LlamaCppSlots::instance()
+{
+    static LlamaCppSlots slots;
+    return slots;
+}
+
+int LlamaCppSlots::slotFor(const std::wstring &conversation, int slots)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Assignments from a configuration with more slots are no longer valid
+    _assignments.remove_if([slots](const Assignment &assignment)
+                           { return assignment.slot >= slots; });
+
+    for (auto it = _assignments.begin(); it != _assignments.end(); ++it)
+    {
+        if (it->conversation == conversation)
+        {
+            _assignments.splice(_assignments.begin(), _assignments, it);
+            return it->slot;
+        }
+    }
+
+    // A free slot, or the one of the conversation used longest ago
+    int slot = static_cast<int>(_assignments.size());
+    if (slot >= slots)
+    {
+        slot = _assignments.back().slot;
+        _assignments.pop_back();
+    }
+    _assignments.push_front(Assignment{conversation, slot});
+    return slot;
+}
+
+void LlamaCppSlots::addToRequest(std::string &request, int slot)
+{
+    // Same approach as the "stream" flag in APIUtils::prepareApiRequest
+    size_t pos = request.rfind('}');
+    if (pos != std::string::npos)
+    {
+        request.insert(pos, ",\"id_slot\":" + std::to_string(slot));
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <list>
+#include <mutex>
+#include <string>
+
+/**
+ * LlamaCppSlots - Pins each document to one llama-server slot
+ *
+ * llama-server runs a fixed number of slots (-np), each with its own KV cache.
+ * With "cache_prompt" a request only evaluates what follows the longest prefix
+ * it shares with its slot's previous prompt, so sending a document's asks to
+ * the same slot ("id_slot") keeps the system prompt and the document context
+ * cached between them, where the server's own slot choice could hand the slot
+ * to another document in between.
+ *
+ * Slots are handed out to conversations least recently used first: with more
+ * documents than slots, the document that was asked about longest ago loses
+ * its slot. The slot count must not exceed the server's (llamacpp_slots).
+ */
+class LlamaCppSlots
+{
+public:
+    static LlamaCppSlots &instance();
+
+    // Slot for 'conversation' out of 'slots' (the same one as last time while it was not reassigned)
+    int slotFor(const std::wstring &conversation, int slots);
+
+    // Add "id_slot": 'slot' to a JSON request object
+    static void addToRequest(std::string &request, int slot);
+
+private:
+    struct Assignment
+    {
+        std::wstring conversation;
+        int slot;
+    };
+
+    LlamaCppSlots() = default;
+
+    std::mutex _mutex;
+    std::list<Assignment> _assignments; // Most recently used first
+};
@@ -0,0 +1,314 @@
+/**
+ * ModelWarmup.cpp - Background loading and keep_alive refresh of Ollama models
+ */
+
+#include "ModelWarmup.h"
+#include "HTTPClient.h"
+#include "config/ConfigSnapshot.h"
+#include "EncodingUtils.h" // for toUTF8
+#include "Trace.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cwchar>
+#include <cwctype>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace
+{
+    // Loading a large model from a slow disk can take minutes
+    const long kLoadTimeoutMs = 300000;
+    const long kStatusTimeoutMs = 10000;
+
+    // Refresh at half of keep_alive, but not more often than this
+    const int64_t kMinRefreshIntervalMs = 10000;
+
+    // Longest keep_alive Ollama can hold (a Go duration counts nanoseconds in an int64)
+    const int64_t kMaxKeepAliveSeconds = INT64_MAX / 1000000000;
+
+    int64_t steadyNowMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // keep_alive as Ollama expects it: a number of seconds or a duration string ("5m")
+    json keepAliveJson(const std::wstring &keepAlive)
+    {
+        bool numeric = !keepAlive.empty();
+        for (size_t i = 0; i < keepAlive.size(); ++i)
+        {
+            if (!std::iswdigit(keepAlive[i]) && !(i == 0 && keepAlive[i] == L'-'))
+            {
+                numeric = false;
+            }
+        }
+        if (numeric && keepAlive != L"-")
+        {
+            errno = 0;
+            long long seconds = std::wcstoll(keepAlive.c_str(), nullptr, 10);
+            if (errno == ERANGE || seconds > kMaxKeepAliveSeconds)
+            {
+                // Any negative number still means forever; one too large gets the default
+                return (seconds < 0) ? json(-1) : json(ModelWarmup::keepAliveSeconds(L""));
+            }
+            return seconds;
+        }
+        return toUTF8(keepAlive);
+    }
+}
+
+ModelWarmup &ModelWarmup::instance()
+{
+    static ModelWarmup warmup;
+    return warmup;
+}
+
+ModelWarmup::~ModelWarmup()
+{
+    shutdown();
+}
+
+void ModelWarmup::warmUp(const std::shared_ptr<const ConfigSnapshot> &config)
+{
+    bool enabled = config && config->provider == Provider::Ollama && config->ollamaWarmup && !config->model.empty();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_stopping)
+    {
+        return;
+    }
+    _refreshDueMs.store(INT64_MAX);
+    _status.resident = false;
+    if (!enabled)
+    {
+        _config.reset();
+        _loadQueued = false;
+        _status.active = false;
+        return;
+    }
+
+    _config = config;
+    _loadQueued = true;
+    _status.active = true;
+    if (!_worker.joinable())
+    {
+        _worker = std::thread(&ModelWarmup::run, this);
+    }
+    _wake.notify_one();
+}
+
+void ModelWarmup::noteActivity()
+{
+    // Called for every editor notification: a single atomic load until a refresh is due
+    if (steadyNowMs() < _refreshDueMs.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _refreshDueMs.store(INT64_MAX); // Rescheduled when the refresh finishes
+    if (_config && !_stopping)
+    {
+        _loadQueued = true;
+        _wake.notify_one();
+    }
+}
+
+ModelWarmup::Status ModelWarmup::status() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _status;
+}
+
+bool ModelWarmup::waitIdle(int timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _idle.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this]
+                          { return !_loadQueued && !_status.loading; });
+}
+
+void ModelWarmup::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+        _abort.store(true);
+        _wake.notify_all();
+    }
+    if (_worker.joinable())
+    {
+        _worker.join();
+    }
+}
+
+int64_t ModelWarmup::keepAliveSeconds(const std::wstring &keepAlive)
+{
+    // Same defaults as Ollama: unset means 5 minutes, any negative value means forever
+    const int64_t kDefault = 300;
+    if (keepAlive.empty())
+    {
+        return kDefault;
+    }
+    if (keepAlive[0] == L'-')
+    {
+        return -1;
+    }
+
+    // A plain number is seconds; otherwise a Go duration such as "10m", "1h30m" or "90s"
+    double total = 0;
+    size_t pos = 0;
+    while (pos < keepAlive.size())
+    {
+        size_t numberEnd = pos;
+        while (numberEnd < keepAlive.size() && (std::iswdigit(keepAlive[numberEnd]) || keepAlive[numberEnd] == L'.'))
+        {
+            numberEnd++;
+        }
+        if (numberEnd == pos)
+        {
+            return kDefault;
+        }
+        double value = std::wcstod(keepAlive.substr(pos, numberEnd - pos).c_str(), nullptr);
+
+        size_t unitEnd = numberEnd;
+        while (unitEnd < keepAlive.size() && std::iswalpha(keepAlive[unitEnd]))
+        {
+            unitEnd++;
+        }
+        std::wstring unit = keepAlive.substr(numberEnd, unitEnd - numberEnd);
+        if (unit.empty() || unit == L"s")
+            total += value;
+        else if (unit == L"ms")
+            total += value / 1000;
+        else if (unit == L"m")
+            total += value * 60;
+        else if (unit == L"h")
+            total += value * 3600;
+        else
+            return kDefault;
+        pos = unitEnd;
+    }
+    return (total > static_cast<double>(kMaxKeepAliveSeconds)) ? kDefault : static_cast<int64_t>(total);
+}
+
+std::string ModelWarmup::serverRoot(const std::string &baseUrl)
+{
+    std::string root = baseUrl;
+    size_t api = root.find("/api/");
+    if (api != std::string::npos)
+    {
+        root.erase(api + 1);
+    }
+    else if (!root.empty() && root.back() != '/')
+    {
+        root += '/';
+    }
+    return root;
+}
+
+void ModelWarmup::run()
+{
+    Trace::setThreadName("model warmup");
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;)
+    {
+        _wake.wait(lock, [this]
+                   { return _stopping || _loadQueued; });
+        if (_stopping)
+        {
+            break;
+        }
+        _loadQueued = false;
+        std::shared_ptr<const ConfigSnapshot> config = _config;
+        _status.loading = true;
+        lock.unlock();
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool loaded = loadModel(*config);
+        double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        bool resident = loaded && isResident(*config);
+
+        lock.lock();
+        _status.loading = false;
+        _status.loads++;
+        if (config == _config)
+        {
+            _status.lastLoadMs = loaded ? loadMs : -1;
+            _status.resident = resident;
+
+            // Ollama's unload timer restarted with this request; renew it once half of it has passed
+            // (a failed load is retried after the same interval, on the next editor activity)
+            int64_t keepAliveMs = keepAliveSeconds(config->keepAlive) * 1000;
+            if (keepAliveMs > 0)
+            {
+                _refreshDueMs.store(steadyNowMs() + (std::max)(keepAliveMs / 2, kMinRefreshIntervalMs));
+            }
+        }
+        _idle.notify_all();
+    }
+    _idle.notify_all();
+}
+
+/**
+ * Send the empty-prompt request that makes Ollama load a model without generating
+ *
+ * @param config Configuration naming the server, model and keep_alive
+ * @return true if the server answered with a 2xx status
+ */
+bool ModelWarmup::loadModel(const ConfigSnapshot &config)
+{
+    TraceSpan span("model load", "warmup");
+    json request;
+    request["model"] = toUTF8(config.model);
+    request["prompt"] = "";
+    request["stream"] = false;
+    if (!config.keepAlive.empty())
+    {
+        request["keep_alive"] = keepAliveJson(config.keepAlive);
+    }
+
+    std::string response;
+    long status = HTTPClient::performBackgroundRequest(serverRoot(config.baseUrl) + "api/generate", request.dump(), response,
+                                                       config.responseType, config.secretKey, config, kLoadTimeoutMs, &_abort);
+    return status >= 200 && status < 300;
+}
+
+/**
+ * Check /api/ps for the model (Ollama lists "name:latest" for models configured without a tag)
+ *
+ * @param config Configuration naming the server and model
+ * @return true if the model is loaded
+ */
+bool ModelWarmup::isResident(const ConfigSnapshot &config)
+{
+    std::string response;
+    long status = HTTPClient::performBackgroundRequest(serverRoot(config.baseUrl) + "api/ps", "", response,
+                                                       config.responseType, config.secretKey, config, kStatusTimeoutMs, &_abort);
+    if (status < 200 || status >= 300)
+    {
+        return false;
+    }
+
+    std::string model = toUTF8(config.model);
+    try
+    {
+        json ps = json::parse(response);
+        for (const json &entry : ps.value("models", json::array()))
+        {
+            for (const char *field : {"name", "model"})
+            {
+                std::string name = entry.value(field, "");
+                if (name == model || name == model + ":latest")
+                {
+                    return true;
+                }
+            }
+        }
+    }
+    catch (const json::exception &)
+    {
+    }
+    return false;
+}
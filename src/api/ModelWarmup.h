@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct ConfigSnapshot;
+
+/**
+ * ModelWarmup - Keeps the configured Ollama model loaded
+ *
+ * Ollama loads a model from disk on the first request after startup or after
+ * its keep_alive expired, which can take many seconds. warmUp() sends the
+ * empty-prompt load request ("prompt": "" to /api/generate) for the model of a
+ * configuration on a background thread, so the load happens while the user is
+ * still editing; /api/ps then confirms that the model is resident.
+ *
+ * While the editor is in use (noteActivity), the load request is repeated
+ * once half of keep_alive has passed, which resets Ollama's unload timer
+ * without generating anything. With keep_alive -1 (never unload) or 0 (unload
+ * immediately) there is nothing to refresh.
+ *
+ * Only configurations with response_type=ollama and ollama_warmup=1 are warmed.
+ * All network access happens on the worker thread; the methods only queue work.
+ */
+class ModelWarmup
+{
+public:
+    struct Status
+    {
+        bool active = false;    // A model is being kept warm
+        bool loading = false;   // A load request is in flight
+        bool resident = false;  // /api/ps listed the model after the last load
+        double lastLoadMs = -1; // Duration of the last load request (-1 if none finished)
+        int loads = 0;          // Load and refresh requests sent
+    };
+
+    static ModelWarmup &instance();
+
+    // Load the model of 'config' and keep it warm (replaces the previous one; other providers stop the warming)
+    void warmUp(const std::shared_ptr<const ConfigSnapshot> &config);
+
+    // The editor is in use: refresh keep_alive if it is due (cheap, call on every notification)
+    void noteActivity();
+
+    // Current state, for status messages and the command-line client
+    Status status() const;
+
+    // Wait until no load is queued or running; false on timeout
+    bool waitIdle(int timeoutMs);
+
+    // Abort a running load and stop the worker thread (before HTTPClient::shutdown)
+    void shutdown();
+
+    // keep_alive value in seconds: "5m" -> 300, "3600" -> 3600, "24h"; -1 = forever, 0 = unload at once
+    // (invalid values and ones too large for Ollama give its default, 300)
+    static int64_t keepAliveSeconds(const std::wstring &keepAlive);
+
+    // Root of the Ollama server for an api_url ("http://host:11434/api/generate" -> "http://host:11434/")
+    static std::string serverRoot(const std::string &baseUrl);
+
+private:
+    ModelWarmup() = default;
+    ~ModelWarmup();
+    ModelWarmup(const ModelWarmup &) = delete;
+    ModelWarmup &operator=(const ModelWarmup &) = delete;
+
+    void run();
+    bool loadModel(const ConfigSnapshot &config);
+    bool isResident(const ConfigSnapshot &config);
+
+    mutable std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _idle;
+    std::thread _worker;
+    std::shared_ptr<const ConfigSnapshot> _config; // Model kept warm (null = none)
+    bool _loadQueued = false;
+    bool _stopping = false;
+    std::atomic<bool> _abort{false};
+    std::atomic<int64_t> _refreshDueMs{INT64_MAX}; // Steady-clock time of the next keep_alive refresh (read without the lock)
+    Status _status;
+};
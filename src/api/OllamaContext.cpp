@@ -0,0 +1,112 @@
+/**
+ * OllamaContext.cpp - Per-conversation store of Ollama generate contexts
+ */
+
+#include "OllamaContext.h"
+#include <algorithm>
+#include <functional>
+
+OllamaContext &OllamaContext::instance()
+{
+    static OllamaContext store;
+    return store;
+}
+
+std::string OllamaContext::lookup(const std::wstring &conversation, size_t fingerprint)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto it = _entries.begin(); it != _entries.end(); ++it)
+    {
+        if (it->conversation != conversation)
+        {
+            continue;
+        }
+        if (it->fingerprint != fingerprint)
+        {
+            // Model, system prompt or endpoint changed: the tokens mean something else now
+            _entries.erase(it);
+            return "";
+        }
+        _entries.splice(_entries.begin(), _entries, it);
+        return it->context;
+    }
+    return "";
+}
+
+void OllamaContext::store(const std::wstring &conversation, size_t fingerprint, std::string context, size_t maxTokens)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.remove_if([&](const Entry &entry)
+                       { return entry.conversation == conversation; });
+
+    // A conversation that outgrew the cap starts over rather than being cut (a truncated context is not valid)
+    if (context.empty() || tokenCount(context) > maxTokens)
+    {
+        return;
+    }
+    _entries.push_front(Entry{conversation, fingerprint, std::move(context)});
+    if (_entries.size() > kMaxConversations)
+    {
+        _entries.pop_back();
+    }
+}
+
+void OllamaContext::forget(const std::wstring &conversation)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.remove_if([&](const Entry &entry)
+                       { return entry.conversation == conversation; });
+}
+
+size_t OllamaContext::fingerprint(const std::string &url, const std::wstring &model, const std::wstring &systemPrompt)
+{
+    size_t hash = std::hash<std::string>()(url);
+    hash = hash * 31 + std::hash<std::wstring>()(model);
+    hash = hash * 31 + std::hash<std::wstring>()(systemPrompt);
+    return hash;
+}
+
+std::string OllamaContext::extract(const std::string &payload)
+{
+    // The array is at the end of the done line; search from there instead of parsing the whole object
+    size_t key = payload.rfind("\"context\"");
+    if (key == std::string::npos)
+    {
+        return "";
+    }
+    size_t open = payload.find_first_not_of(" \t\r\n:", key + 9);
+    if (open == std::string::npos || payload[open] != '[')
+    {
+        return "";
+    }
+    size_t close = payload.find(']', open);
+    if (close == std::string::npos)
+    {
+        return "";
+    }
+
+    // Token ids only; anything else means this was not Ollama's context array
+    std::string context = payload.substr(open, close - open + 1);
+    bool valid = std::all_of(context.begin() + 1, context.end() - 1, [](char c)
+                             { return (c >= '0' && c <= '9') || c == ',' || c == ' ' || c == '-'; });
+    return (valid && tokenCount(context) > 0) ? context : "";
+}
+
+size_t OllamaContext::tokenCount(const std::string &context)
+{
+    if (context.find_first_of("0123456789") == std::string::npos)
+    {
+        return 0;
+    }
+    return static_cast<size_t>(std::count(context.begin(), context.end(), ',')) + 1;
+}
+
+void OllamaContext::addToRequest(std::string &request, const std::string &context)
+{
+    // Same approach as the "stream" flag in APIUtils::prepareApiRequest
+    size_t pos = request.rfind('}');
+    if (pos != std::string::npos && !context.empty())
+    {
+        request.insert(pos, ",\"context\":" + context);
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+
+/**
+ * OllamaContext - Reuses the "context" of Ollama's /api/generate across asks on the same document
+ *
+ * Every /api/generate response ends with a "context" array: the token ids of
+ * the whole exchange. Sending it back with the next request lets Ollama
+ * continue from it instead of evaluating the conversation again, which
+ * dominates the latency on CPU-only servers. It also means the model sees the
+ * earlier questions and answers, like in a chat.
+ *
+ * Contexts are kept per conversation (the plugin uses one per document), as
+ * the raw JSON array text so nothing is parsed or re-serialized. A context
+ * only matches while model, system prompt and endpoint stay the same (the
+ * fingerprint); any change drops it. Contexts longer than the configured cap
+ * are not kept (the next ask starts a fresh conversation), and at most
+ * kMaxConversations are kept, least recently used first out.
+ *
+ * Enabled by ollama_context=1; only used for /api/generate (/api/chat has no context).
+ */
+class OllamaContext
+{
+public:
+    static const size_t kMaxConversations = 32;
+
+    static OllamaContext &instance();
+
+    // Stored context for 'conversation' as a JSON array ("" if none or the fingerprint changed)
+    std::string lookup(const std::wstring &conversation, size_t fingerprint);
+
+    // Keep the context of a response; 'maxTokens' caps its length (longer ones are dropped)
+    void store(const std::wstring &conversation, size_t fingerprint, std::string context, size_t maxTokens);
+
+    // Forget the context of a conversation (e.g. after a failed request)
+    void forget(const std::wstring &conversation);
+
+    // Fingerprint of what a context is valid for
+    static size_t fingerprint(const std::string &url, const std::wstring &model, const std::wstring &systemPrompt);
+
+    // The "context" array of an Ollama response or done line, as JSON text ("" if there is none)
+    static std::string extract(const std::string &payload);
+
+    // Number of token ids in a context array
+    static size_t tokenCount(const std::string &context);
+
+    // Add "context": 'context' to a JSON request object
+    static void addToRequest(std::string &request, const std::string &context);
+
+private:
+    struct Entry
+    {
+        std::wstring conversation;
+        size_t fingerprint;
+        std::string context;
+    };
+
+    OllamaContext() = default;
+
+    std::mutex _mutex;
+    std::list<Entry> _entries; // Most recently used first
+};
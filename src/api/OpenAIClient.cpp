@@ -12,7 +12,6 @@
 #include "OpenAIClient.h"
 #include "core/external_globals.h"
 #include "EncodingUtils.h" // for toUTF8
-#include <curl/curl.h>
 #include "Sci_Position.h"
 #include "Scintilla.h"
 #include "config/PromptManager.h" // for Prompt struct and related functions
@@ -20,12 +19,17 @@
 #include "RequestFormatters.h"    // for different API request formatters
 #include <chrono>                 // For timing API calls
 #include <future>                 // for async spinner responsiveness
+#include <mutex>
 #include <sstream>                // For string stream processing
 
 // New modular components
-#include "HTTPClient.h"
-#include "StreamParser.h"
 #include "APIUtils.h"
+#include "ChatPipeline.h"
+#include "Preconnector.h"
+#include "TransferHost.h"
+#include "Trace.h"
+#include "config/ConfigSnapshot.h"
+#include "config/RequestRouter.h"
 #include "editor/EditorInterface.h"
 
 /**
@@ -35,107 +39,149 @@
  * rather than all at once. This provides a more interactive experience as the user can
  * see the response being generated in real-time.
  *
- * Streaming implementation uses Windows messages to safely communicate between the
- * background network thread and the UI thread. Each chunk of text is processed and
- * sent via the WM_OPENAI_STREAM_CHUNK message.
+ * HTTPClient hands each piece of streamed text to the installed TransferHost; the
+ * Notepad++ host below inserts it at the caret of the editor the request came from.
  */
 
-// define custom message for streaming chunks
-#define WM_OPENAI_STREAM_CHUNK (WM_APP + 100)
-
 // Global handle to direct streaming chunks (defined in external_globals.h)
 HWND s_streamTargetScintilla = nullptr;
 
-/**
- * Callback function for cURL to write response data
- *
- * This function is called by cURL when response data is received.
- * It appends the received data to the std::string pointer passed as userp.
- *
- * @param contents The received data buffer
- * @param size Always 1
- * @param nmemb The size of the data received
- * @param userp User-provided pointer (std::string for response data)
- * @return The number of bytes processed (should match nmemb on success)
- */
-size_t OpenAIcURLCallback(void *contents, size_t size, size_t nmemb, void *userp)
+namespace
 {
-    size_t totalSize = size * nmemb;
-    std::string *pResponse = static_cast<std::string *>(userp);
-    pResponse->append(static_cast<char *>(contents), totalSize);
-    return _loaderDlg.isCancelled() ? CURL_READFUNC_ABORT : totalSize;
-}
-
-/**
- * CURL write callback for streaming: posts each chunk to the main thread
- *
- * @param contents The received data buffer
- * @param size Always 1
- * @param nmemb The size of the data received
- * @param userp User-provided pointer (window handle)
- * @return The number of bytes processed (should match nmemb on success)
- */
-size_t OpenAIStreamCallback(void *contents, size_t size, size_t nmemb, void *userp)
-{
-    // We need to use userp to know where to send messages
-    HWND targetWindow = static_cast<HWND>(userp);
-    if (!targetWindow)
+    /**
+     * TransferHost of the Notepad++ plugin: message pump, loader dialog, status bar, editor
+     */
+    class NppTransferHost : public TransferHost
     {
-        targetWindow = nppData._nppHandle; // Fallback to main Notepad++ window
-    }
+    public:
+        void idle() override
+        {
+            MSG msg;
+            while (::PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+            {
+                ::TranslateMessage(&msg);
+                ::DispatchMessage(&msg);
+            }
+        }
 
-    size_t totalSize = size * nmemb;
-    std::string chunk(static_cast<char *>(contents), totalSize);
-    std::string content;
+        bool isCancelled() const override
+        {
+            return _loaderDlg.isCancelled();
+        }
 
-    try
-    {
-        // Handle streaming responses for different API formats
-        if (!chunk.empty())
+        void showStatus(const std::wstring &message) override
+        {
+            ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, (LPARAM)message.c_str());
+        }
+
+        void showDebugStatus(const std::wstring &message) override
         {
-            std::string apiType = toUTF8(configAPIValue_responseType);
-            content = StreamParser::extractContent(chunk, apiType);
+            if (debugMode)
+            {
+                showStatus(message);
+            }
         }
 
-        // If we have content to display or this might be plain text (and short)
-        if (!content.empty() || (chunk.size() < 100 && !StreamParser::isCompletionMarker(chunk)))
+        bool deliverContent(const std::string &content) override
         {
-            // If we couldn't extract content but have a small chunk, use the raw chunk
-            if (content.empty() && chunk.size() < 100 && !StreamParser::isCompletionMarker(chunk))
+            TraceSpan span("editor insert", "editor");
+            span.setArg("bytes", static_cast<int64_t>(content.size()));
+
+            // Use SCI_REPLACESEL to insert the content at the current position
+            if (s_streamTargetScintilla && IsWindow(s_streamTargetScintilla))
             {
-                content = chunk;
+                prepareEditor();
+                ::SendMessage(s_streamTargetScintilla, SCI_REPLACESEL, 0, reinterpret_cast<LPARAM>(content.c_str()));
+                return true;
             }
+            return false;
+        }
 
-            // Only send non-empty content
-            if (!content.empty())
+        // The selection is replaced (or the question kept) when the first text arrives, with the spacing of
+        // the endpoint that answers; until then a failed or cancelled ask leaves the document untouched
+        void expectAnswer(bool keepQuestion)
+        {
+            std::lock_guard<std::mutex> lock(_answerMutex);
+            _answerPending = true;
+            _keepQuestion = keepQuestion;
+            _answerType.clear();
+        }
+
+        void endAnswer()
+        {
+            std::lock_guard<std::mutex> lock(_answerMutex);
+            _answerPending = false;
+        }
+
+        void beginAnswer(const std::string &responseType) override
+        {
+            std::lock_guard<std::mutex> lock(_answerMutex);
+            _answerType = stringToWstring(responseType);
+        }
+
+        // Begin/end undo action so the streamed response is undone in one step
+        void beginStream() override
+        {
+            ::SendMessage(EditorInterface::getCurrentScintilla(), SCI_BEGINUNDOACTION, 0, 0);
+        }
+
+        void endStream() override
+        {
+            ::SendMessage(EditorInterface::getCurrentScintilla(), SCI_ENDUNDOACTION, 0, 0);
+        }
+
+    private:
+        void prepareEditor()
+        {
+            bool keepQuestion;
+            std::wstring responseType;
             {
-                // Send content directly to the Scintilla editor
-                // This bypasses the problematic PostMessage approach
-                if (s_streamTargetScintilla && IsWindow(s_streamTargetScintilla))
+                std::lock_guard<std::mutex> lock(_answerMutex);
+                if (!_answerPending)
                 {
-                    // Use SCI_REPLACESEL to insert the content at the current position
-                    ::SendMessage(s_streamTargetScintilla, SCI_REPLACESEL, 0, reinterpret_cast<LPARAM>(content.c_str()));
+                    return;
                 }
+                _answerPending = false;
+                keepQuestion = _keepQuestion;
+                responseType = _answerType;
             }
+            EditorInterface::prepareForStreamingResponse(s_streamTargetScintilla, std::string(), keepQuestion, responseType);
         }
-    }
-    catch (...)
+
+        std::mutex _answerMutex;
+        bool _answerPending = false;
+        bool _keepQuestion = false;
+        std::wstring _answerType; // response_type of the endpoint that answers (see beginAnswer)
+    };
+
+    NppTransferHost g_nppTransferHost;
+
+    /**
+     * Turns tracing on or off for an ask and writes the trace file when the ask ends, whichever way
+     */
+    class AskTrace
     {
-        // Fallback for any unexpected errors - just send the raw chunk
-        // But first check if it's a completion marker
-        if (StreamParser::isCompletionMarker(chunk))
+    public:
+        explicit AskTrace(const std::string &path) : _path(path)
         {
-            return totalSize;
+            Trace::setEnabled(!_path.empty());
+            if (!_path.empty())
+            {
+                Trace::setThreadName("Notepad++ UI");
+            }
         }
 
-        // Send content directly to the Scintilla editor (fallback path)
-        if (s_streamTargetScintilla && IsWindow(s_streamTargetScintilla))
+        ~AskTrace()
         {
-            ::SendMessage(s_streamTargetScintilla, SCI_REPLACESEL, 0, reinterpret_cast<LPARAM>(chunk.c_str()));
+            if (!_path.empty())
+            {
+                Trace::exportJson(_path);
+            }
         }
-    }
 
-    return _loaderDlg.isCancelled() ? CURL_READFUNC_ABORT : totalSize;
+    private:
+        std::string _path;
+    };
 }
 
 /**
@@ -172,7 +218,7 @@ namespace OpenAIClientImpl
                 if (errorJson["error"].contains("message"))
                 {
                     std::string errorDetails = errorJson["error"]["message"].get<std::string>();
-                    std::wstring wideError = multiByteToWideChar(errorDetails.c_str());
+                    std::wstring wideError = multiByteToWstring(errorDetails);
                     errorMsg = L"API Error: " + wideError;
                 }
             }
@@ -190,6 +236,13 @@ namespace OpenAIClientImpl
         // Record start time for elapsed time calculation
         auto startTime = std::chrono::high_resolution_clock::now();
 
+        // Use one configuration for the whole request, even if the INI file is reloaded meanwhile
+        std::shared_ptr<const ConfigSnapshot> config = ConfigSnapshot::current();
+
+        // Timeline of the ask (trace_file), written when this function returns
+        AskTrace askTrace(config->traceFile);
+        TraceSpan askSpan("ask", "ui");
+
         // Get current editor
         HWND curScintilla = EditorInterface::getCurrentScintilla();
         if (!curScintilla)
@@ -206,18 +259,23 @@ namespace OpenAIClientImpl
         } // Get system prompt - handle multiple prompts case BEFORE showing loader
         std::wstring systemPrompt = APIUtils::getSystemPrompt();
 
+        // Prompts as parsed when the configuration was loaded (kept alive for this request)
+        std::shared_ptr<const std::vector<Prompt>> catalog = promptCatalog();
+        const std::vector<Prompt> &prompts = *catalog;
+        const Prompt *selectedPrompt = (prompts.size() == 1) ? &prompts[0] : nullptr;
+
         // If multiple prompts are available, show selection dialog
         if (systemPrompt == L"MULTIPLE_PROMPTS_AVAILABLE")
         {
-            // Parse prompts from instructions file
-            std::vector<Prompt> prompts;
-            parseInstructionsFile(instructionsFilePath, prompts);
-
             if (prompts.size() > 1)
             {
                 // Show prompt selection dialog
                 static int lastUsedPromptIndex = -1; // Local static variable to remember last choice
-                int selectedPromptIndex = choosePrompt(nppData._nppHandle, prompts, lastUsedPromptIndex);
+                int selectedPromptIndex;
+                {
+                    TraceSpan span("prompt selection", "ui");
+                    selectedPromptIndex = choosePrompt(nppData._nppHandle, prompts, lastUsedPromptIndex);
+                }
 
                 if (selectedPromptIndex == -1)
                 {
@@ -227,118 +285,96 @@ namespace OpenAIClientImpl
 
                 // Remember the user's choice for next time
                 lastUsedPromptIndex = selectedPromptIndex;
-                systemPrompt = prompts[selectedPromptIndex].content;
+                selectedPrompt = &prompts[selectedPromptIndex];
+                systemPrompt = selectedPrompt->content;
             }
             else
             {
                 // Fallback to default if something went wrong
-                systemPrompt = configAPIValue_instructions;
+                systemPrompt = config->instructions;
             }
         }
 
-        // NOW show the loader dialog after prompt selection is complete
-        _loaderDlg.setModelName(configAPIValue_model);
-        _loaderDlg.doDialog();
-        _loaderDlg.resetDialog();
-        ::UpdateWindow(_loaderDlg.getHSelf());
-
-        // Process pending messages to make dialog visible
-        MSG msg;
-        while (::PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+        // A prompt that names a profile goes there; otherwise the first matching routing rule
+        // picks the profile. The prompt's other overrides apply on top.
+        if (!selectedPrompt || !selectedPrompt->config)
         {
-            ::TranslateMessage(&msg);
-            ::DispatchMessage(&msg);
+            wchar_t extension[MAX_PATH] = {0};
+            ::SendMessage(nppData._nppHandle, NPPM_GETEXTPART, MAX_PATH, (LPARAM)extension);
+            std::shared_ptr<const ConfigSnapshot> routed = RequestRouter::instance().route(RequestRouter::countChars(selectedText), extension);
+            if (routed)
+            {
+                config = routed;
+            }
         }
-        ::Sleep(10);
+        config = resolvePromptConfig(selectedPrompt, config);
 
-        // Check if streaming is enabled
-        bool streaming = (configAPIValue_streaming == L"1"); // Prepare API request with all necessary parameters
-        std::string request = APIUtils::prepareApiRequest(
-             selectedText,
-             systemPrompt,
-             configAPIValue_model,
-             configAPIValue_responseType,
-             std::stof(toUTF8(configAPIValue_temperature)),
-             std::stoi(toUTF8(configAPIValue_maxTokens)),
-             std::stof(toUTF8(configAPIValue_topP)),
-             std::stof(toUTF8(configAPIValue_frequencyPenalty)),
-             std::stof(toUTF8(configAPIValue_presencePenalty)), configAPIValue_keepAlive, streaming);
-
-        // Build API URL with base URL and chat route
-        std::string baseUrl = toUTF8(configAPIValue_baseURL);
-        std::string chatRoute = toUTF8(configAPIValue_chatRoute);
-        std::string url = APIUtils::buildApiUrl(baseUrl, chatRoute);
-        std::string proxy = toUTF8(configAPIValue_proxyURL);
-        std::string apiType = toUTF8(configAPIValue_responseType);
-        std::string secretKey = toUTF8(configAPIValue_secretKey);
-
-        std::string response;
-        bool ok = true;
-        if (streaming)
-        { // Debug streaming request details
-            if (debugMode)
+        // NOW show the loader dialog after prompt selection is complete
+        {
+            TraceSpan span("loader display", "ui");
+            _loaderDlg.setModelName(config->model);
+            _loaderDlg.doDialog();
+            _loaderDlg.resetDialog();
+            ::UpdateWindow(_loaderDlg.getHSelf());
+
+            // Process pending messages to make dialog visible
+            MSG msg;
+            while (::PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
             {
-                std::wstring debugMsg = L"Streaming enabled, URL: ";
-                debugMsg += multiByteToWideChar(url.c_str());
-                ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, (LPARAM)debugMsg.c_str());
+                ::TranslateMessage(&msg);
+                ::DispatchMessage(&msg);
             }
+            ::Sleep(10);
+        }
 
-            // We no longer need to set s_streamTargetScintilla, the message handler gets the current Scintilla            // Prepare editor for streaming response using the proper interface
-            EditorInterface::prepareForStreamingResponse(curScintilla, selectedText, isKeepQuestion, configAPIValue_responseType);
+        // Check if streaming is enabled
+        bool streaming = config->streaming;
+
+        // Candidate endpoints, best first; the others are tried in order if it is unavailable
+        std::vector<Endpoint> endpoints = ChatPipeline::candidateEndpoints(*config);
+
+        if (streaming)
+        {
+            // The editor is prepared for the answer when its first text arrives, for the endpoint that sent it
+            g_nppTransferHost.expectAnswer(isKeepQuestion);
 
             // Store the current Scintilla handle for the streaming process
-            s_streamTargetScintilla = curScintilla; // Perform streaming request with the correct message type
-            ok = HTTPClient::performStreamingRequest(url, request, apiType, secretKey,
-                                                     nppData._nppHandle, // Use nppData._nppHandle as target for messages
-                                                     WM_OPENAI_STREAM_CHUNK, proxy);
+            s_streamTargetScintilla = curScintilla;
         }
-        else
+
+        // Send with failover; transfers report to Notepad++ through the plugin's TransferHost
+        TransferHost::install(&g_nppTransferHost);
+        ChatResult result;
         {
-            // For non-streaming mode, perform regular request
-            ok = HTTPClient::performRequest(url, request, response, apiType, secretKey, proxy);
+            // Asks on the same document form one conversation (Ollama context reuse)
+            LRESULT bufferId = ::SendMessage(nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0);
+            TraceSpan span("send", "request");
+            result = ChatPipeline::send(selectedText, systemPrompt, config, endpoints, L"buffer:" + std::to_wstring(bufferId));
         }
-        if (!ok)
+        g_nppTransferHost.endAnswer();
+        const std::wstring &responseType = result.responseType;
+
+        // A collected answer cancelled midway is kept like a cancelled stream
+        bool keepPartial = !result.ok && result.collected && _loaderDlg.isCancelled() && !result.answer.empty();
+        if (!result.ok && !keepPartial)
         {
             _loaderDlg.display(false);
 
-            // Parse and display API error
-            std::wstring errorMsg = multiByteToWideChar(url.c_str());
-            errorMsg += L": Request failed";
-            try
-            {
-                if (!response.empty())
-                {
-                    nlohmann::json errorJson = nlohmann::json::parse(response);
-                    if (errorJson.contains("error"))
-                    {
-                        if (errorJson["error"].contains("message"))
-                        {
-                            std::string errorDetails = errorJson["error"]["message"].get<std::string>();
-                            std::wstring wideError = multiByteToWideChar(errorDetails.c_str());
-                            errorMsg = L"API Error: " + wideError;
-                        }
-                    }
-                }
-            }
-            catch (...)
-            {
-                // Error parsing response - use default error message
-            }
-
 			// Display error message if a non-user cancellation occurred
             if (!_loaderDlg.isCancelled())
             {
-                instructionsFileError(errorMsg.c_str(), L"NppOpenAI Error");
+                instructionsFileError(ChatPipeline::errorMessage(result).c_str(), L"NppOpenAI Error");
             }
             return;
         } // Handle non-streaming response
         if (!streaming)
         {
-            // Parse response and extract content using the correct parser
-            auto parser = ResponseParsers::getParserForEndpoint(configAPIValue_responseType);
-            std::string extractedContent = parser(response);
+            // Collected stream or response body, parsed with the endpoint's parser
+            std::string extractedContent = ChatPipeline::answerText(result, config->showReasoning);
             if (!extractedContent.empty())
             {
+                TraceSpan span("editor insert", "editor");
+                span.setArg("bytes", static_cast<int64_t>(extractedContent.size()));
                 // For non-streaming with keepQuestion, mimic streaming behavior:
                 // Keep the question in place and append the response after it
                 if (isKeepQuestion)
@@ -349,7 +385,7 @@ namespace OpenAIClientImpl
 
                     // Add appropriate spacing and the response after the question
                     std::string responseText;
-                    if (configAPIValue_responseType == L"ollama")
+                    if (responseType == L"ollama")
                     {
                         responseText = "\n" + extractedContent;
                     }
@@ -381,15 +417,71 @@ namespace OpenAIClientImpl
                 return;
             }
         }
+        if (keepPartial)
+        {
+            _loaderDlg.display(false);
+            return;
+        }
         // For streaming mode, the text is already in the editor through the callback        // Calculate and display elapsed time
+        TraceSpan completionSpan("completion", "ui");
         auto endTime = std::chrono::high_resolution_clock::now();
         auto elapsedMilliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
         double elapsedSeconds = elapsedMilliseconds / 1000.0;
 
         // Show timing in status bar
         TCHAR timeMsg[128];
-        swprintf(timeMsg, 128, TEXT("API call completed in %.1f seconds"), elapsedSeconds);
-        ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, (LPARAM)timeMsg);
+        if (endpoints.size() > 1)
+        {
+            swprintf(timeMsg, 128, TEXT("API call completed in %.1f seconds (%ls)"), elapsedSeconds, result.endpointName.c_str());
+        }
+        else
+        {
+            swprintf(timeMsg, 128, TEXT("API call completed in %.1f seconds"), elapsedSeconds);
+        }
+        if (debugMode)
+        {
+            // Per-request counters, to spot responses that churn memory during long streams
+            std::wstring statsMsg = std::wstring(timeMsg) + L" - " + std::to_wstring(result.stats.bytesReceived) + L" bytes in " +
+                                    std::to_wstring(result.stats.chunks) + L" chunks, " + std::to_wstring(result.stats.contentEvents) +
+                                    L" tokens, peak buffer " + std::to_wstring(result.stats.peakBufferBytes) + L" bytes";
+            if (result.stats.pauses > 0)
+            {
+                // The editor fell behind and the download waited for it (see StreamBuffer)
+                statsMsg += L", paused " + std::to_wstring(result.stats.pauses) + L" times for " +
+                            std::to_wstring(static_cast<long long>(result.stats.pausedMs)) + L" ms";
+            }
+            if (Preconnector::instance().isEnabled())
+            {
+                Preconnector::Stats preconnectStats = Preconnector::instance().stats();
+                statsMsg += (result.preconnected ? L", pre-connected (" : L", not pre-connected (") + std::to_wstring(preconnectStats.hits) +
+                            L"/" + std::to_wstring(preconnectStats.preconnects) + L" pre-connects used)";
+            }
+            if (result.realtime)
+            {
+                statsMsg += result.sessionOpened ? L", realtime session opened" : L", realtime session reused";
+            }
+            if (result.usage.promptTokens >= 0)
+            {
+                statsMsg += L", prompt " + std::to_wstring(result.usage.promptTokens) + L" tokens (" +
+                            std::to_wstring(result.usage.cachedTokens) + L" cached)";
+            }
+            if (result.usage.serverPromptMs >= 0)
+            {
+                wchar_t serverMsg[96];
+                swprintf(serverMsg, 96, L", server prompt %.0f ms, %.1f tokens/s", result.usage.serverPromptMs, result.usage.tokensPerSecond);
+                statsMsg += serverMsg;
+            }
+            if (config->ollamaContext)
+            {
+                statsMsg += L", context " + std::to_wstring(result.contextTokensSent) + L" -> " +
+                            std::to_wstring(result.contextTokensReceived) + L" tokens";
+            }
+            ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, (LPARAM)statsMsg.c_str());
+        }
+        else
+        {
+            ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, (LPARAM)timeMsg);
+        }
 
         _loaderDlg.display(false);
     }
@@ -3,8 +3,8 @@
  *
  * This file declares functions for sending requests to various LLM APIs (OpenAI, Claude, Ollama),
  * processing responses, and updating the editor with the generated content.
- * It provides high-level functions for plugin commands and callback functions
- * for the HTTP client module.
+ * It provides the high-level functions for plugin commands; the transfer itself
+ * is done by ChatPipeline and HTTPClient.
  */
 
 #pragma once
@@ -39,28 +39,6 @@ namespace OpenAIClientImpl
     void displayApiError(const std::string &errorResponse);
 }
 
-/**
- * Callback function used by cURL to receive HTTP response data
- *
- * @param contents Pointer to the response data buffer
- * @param size Always 1
- * @param nmemb Number of bytes in the data buffer
- * @param userp User-provided pointer (used for the response string)
- * @return Number of bytes processed
- */
-size_t OpenAIcURLCallback(void *contents, size_t size, size_t nmemb, void *userp);
-
-/**
- * Callback function for streaming responses
- *
- * @param contents Pointer to the response data buffer
- * @param size Always 1
- * @param nmemb Number of bytes in the data buffer
- * @param userp User-provided pointer (window handle)
- * @return Number of bytes processed
- */
-size_t OpenAIStreamCallback(void *contents, size_t size, size_t nmemb, void *userp);
-
 /**
  * Shows an error message when the instructions file cannot be accessed
  *
@@ -0,0 +1,225 @@
+/**
+ * Preconnector.cpp - Speculative connection warm-up while a selection is made
+ */
+
+#include "Preconnector.h"
+#include "APIUtils.h"
+#include "ChatPipeline.h"
+#include "EncodingUtils.h" // for toUTF8
+#include "HTTPClient.h"
+#include "Trace.h"
+#include "config/ConfigSnapshot.h"
+#include <chrono>
+
+namespace
+{
+    // A pre-connect that takes longer than this would not be finished before the ask anyway
+    const long kPreconnectTimeoutMs = 15000;
+
+    int64_t steadyNowMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+Preconnector &Preconnector::instance()
+{
+    static Preconnector preconnector;
+    return preconnector;
+}
+
+Preconnector::~Preconnector()
+{
+    shutdown();
+}
+
+void Preconnector::configure(const std::shared_ptr<const ConfigSnapshot> &config)
+{
+    bool enabled = config && config->preconnect;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_stopping)
+    {
+        return;
+    }
+    _config = enabled ? config : nullptr;
+    _enabled.store(enabled);
+    if (enabled && !_worker.joinable())
+    {
+        _worker = std::thread(&Preconnector::run, this);
+    }
+}
+
+void Preconnector::noteSelection(size_t chars)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Caret moves without a selection are the common case: nothing to do unless they end a pending dwell
+    if (chars < kMinSelectionChars && _selectionChars < kMinSelectionChars)
+    {
+        return;
+    }
+    _selectionChars = chars;
+    _generation++;
+    _wake.notify_one();
+}
+
+bool Preconnector::noteAsk(const std::string &url)
+{
+    std::string askOrigin = origin(url);
+    int64_t now = steadyNowMs();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _lastAskOrigin = askOrigin;
+    _lastAskMs = now;
+
+    // Asked while the connection is being opened: with HTTP/2 the request waits for it (PIPEWAIT)
+    if (_busy && _inflightOrigin == askOrigin && !_inflightUsed)
+    {
+        _inflightUsed = true;
+        _stats.hits++;
+        Trace::instant("preconnect hit", "preconnect");
+        return true;
+    }
+    if (_pendingOrigin.empty())
+    {
+        return false;
+    }
+
+    bool hit = (_pendingOrigin == askOrigin && now - _pendingAtMs <= kWarmWindowMs);
+    if (hit)
+    {
+        _stats.hits++;
+        Trace::instant("preconnect hit", "preconnect");
+    }
+    else
+    {
+        _stats.wasted++;
+    }
+    _pendingOrigin.clear();
+    return hit;
+}
+
+Preconnector::Stats Preconnector::stats() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+bool Preconnector::waitIdle(int timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _idle.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this]
+                          { return _handledGeneration == _generation && !_busy; });
+}
+
+void Preconnector::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+        _enabled.store(false);
+        _wake.notify_all();
+    }
+    if (_worker.joinable())
+    {
+        _worker.join();
+    }
+}
+
+std::string Preconnector::origin(const std::string &url)
+{
+    size_t scheme = url.find("://");
+    size_t hostStart = (scheme == std::string::npos) ? 0 : scheme + 3;
+    size_t pathStart = url.find('/', hostStart);
+    return url.substr(0, pathStart);
+}
+
+void Preconnector::run()
+{
+    Trace::setThreadName("preconnect");
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;)
+    {
+        _wake.wait(lock, [this]
+                   { return _stopping || _generation != _handledGeneration; });
+        if (_stopping)
+        {
+            break;
+        }
+
+        // Dwell: only a selection that stays unchanged for the dwell time counts
+        uint64_t generation = _generation;
+        int dwellMs = _config ? _config->preconnectDwellMs : 0;
+        if (_wake.wait_for(lock, std::chrono::milliseconds(dwellMs), [this, generation]
+                           { return _stopping || _generation != generation; }))
+        {
+            continue;
+        }
+        _handledGeneration = generation;
+        if (_config && _selectionChars >= kMinSelectionChars)
+        {
+            preconnect(lock);
+        }
+        _idle.notify_all();
+    }
+    _idle.notify_all();
+}
+
+/**
+ * Pre-connect to the best endpoint of the configuration unless the rate limit or a warm connection rules it out
+ *
+ * @param lock The worker's lock on _mutex; released while the connection is made
+ */
+void Preconnector::preconnect(std::unique_lock<std::mutex> &lock)
+{
+    std::shared_ptr<const ConfigSnapshot> config = _config;
+    std::vector<Endpoint> endpoints = ChatPipeline::candidateEndpoints(*config);
+    std::string url = APIUtils::buildApiUrl(toUTF8(endpoints.front().baseUrl), toUTF8(endpoints.front().chatRoute));
+    std::string urlOrigin = origin(url);
+
+    int64_t now = steadyNowMs();
+    bool rateLimited = (now - _lastPreconnectMs < kMinIntervalMs);
+    bool stillWarm = (urlOrigin == _lastAskOrigin && now - _lastAskMs < kWarmWindowMs) ||
+                     (urlOrigin == _pendingOrigin && now - _pendingAtMs < kWarmWindowMs);
+    if (rateLimited || stillWarm)
+    {
+        _stats.skipped++;
+        return;
+    }
+    _lastPreconnectMs = now;
+    _busy = true;
+    _inflightOrigin = urlOrigin;
+    _inflightUsed = false;
+    lock.unlock();
+
+    bool reused = false;
+    bool ok = HTTPClient::preconnect(url, toUTF8(endpoints.front().responseType), toUTF8(endpoints.front().secretKey),
+                                     *config, kPreconnectTimeoutMs, reused);
+
+    lock.lock();
+    _busy = false;
+    if (!ok)
+    {
+        _stats.failures++;
+        if (_inflightUsed)
+        {
+            _stats.hits--; // The ask found nothing to reuse after all
+        }
+        return;
+    }
+    if (!_pendingOrigin.empty())
+    {
+        _stats.wasted++; // Replaced before any ask used it
+    }
+    _stats.preconnects++;
+    if (!reused)
+    {
+        _stats.newConnections++;
+    }
+    if (!_inflightUsed)
+    {
+        _pendingOrigin = urlOrigin;
+        _pendingAtMs = steadyNowMs();
+    }
+}
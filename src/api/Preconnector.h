@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct ConfigSnapshot;
+
+/**
+ * Preconnector - Opens the connection to the endpoint while the user selects text
+ *
+ * Pooled connections make repeated asks cheap, but the first ask after an idle
+ * period still pays DNS, TCP and TLS before the request is sent. When a
+ * selection of at least kMinSelectionChars stays unchanged for
+ * preconnect_dwell_ms, it is likely to be sent next, so a worker thread opens a
+ * connection to the active profile's best endpoint (see HTTPClient::preconnect)
+ * and the ask finds it warm.
+ *
+ * To never cause request storms, at most one pre-connect runs at a time, at
+ * most one is made per kMinIntervalMs, and none is made while the endpoint was
+ * used within kWarmWindowMs (its connection is still pooled).
+ *
+ * A pre-connect counts as a hit if an ask to the same host starts within
+ * kWarmWindowMs after it, and as wasted otherwise.
+ *
+ * Opt-in with preconnect=1. All network access happens on the worker thread.
+ */
+class Preconnector
+{
+public:
+    static const size_t kMinSelectionChars = 16; // Shorter selections (or a caret move) are not worth a pre-connect
+    static const int64_t kMinIntervalMs = 30000; // At most one pre-connect per interval
+    static const int64_t kWarmWindowMs = 60000;  // Below cURL's 118 s limit for reusing an idle connection
+
+    struct Stats
+    {
+        int preconnects = 0;    // Pre-connects that reached the server
+        int newConnections = 0; // ... of which opened a connection (the others found one still open)
+        int hits = 0;           // Asks that started on a pre-connected host
+        int wasted = 0;         // Pre-connects no ask used in time
+        int skipped = 0;        // Dwells without a pre-connect (rate limit, endpoint still warm)
+        int failures = 0;       // Pre-connects that could not reach the server
+
+        // Share of pre-connects an ask used (0 if none yet)
+        double hitRate() const { return preconnects > 0 ? static_cast<double>(hits) / preconnects : 0; }
+    };
+
+    static Preconnector &instance();
+
+    // Use the settings and endpoint of 'config' (called when the configuration or profile changes)
+    void configure(const std::shared_ptr<const ConfigSnapshot> &config);
+
+    // True when preconnect=1 (a relaxed load; checked before measuring the selection)
+    bool isEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+    // The selection changed to 'chars' characters (UI thread, on every selection update)
+    void noteSelection(size_t chars);
+
+    // An ask is sent to 'url'; true if it was pre-connected
+    bool noteAsk(const std::string &url);
+
+    Stats stats() const;
+
+    // Wait until no dwell or pre-connect is pending; false on timeout
+    bool waitIdle(int timeoutMs);
+
+    // Stop the worker thread (before HTTPClient::shutdown)
+    void shutdown();
+
+    // "scheme://host:port" part of a URL, which identifies a pooled connection
+    static std::string origin(const std::string &url);
+
+private:
+    Preconnector() = default;
+    ~Preconnector();
+    Preconnector(const Preconnector &) = delete;
+    Preconnector &operator=(const Preconnector &) = delete;
+
+    void run();
+    void preconnect(std::unique_lock<std::mutex> &lock);
+
+    mutable std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _idle;
+    std::thread _worker;
+    std::atomic<bool> _enabled{false};
+    std::shared_ptr<const ConfigSnapshot> _config;
+    size_t _selectionChars = 0;
+    uint64_t _generation = 0;        // Incremented on every relevant selection change
+    uint64_t _handledGeneration = 0; // Selection the worker has dwelt on
+    bool _busy = false;
+    bool _stopping = false;
+
+    std::string _inflightOrigin;  // Host of the running pre-connect
+    bool _inflightUsed = false;   // An ask to that host started before it finished
+    std::string _pendingOrigin;   // Host of the last pre-connect no ask has used yet ("" = none)
+    int64_t _pendingAtMs = 0;     // When it finished
+    int64_t _lastPreconnectMs = INT64_MIN / 2;
+    std::string _lastAskOrigin;
+    int64_t _lastAskMs = INT64_MIN / 2;
+    Stats _stats;
+};
@@ -0,0 +1,35 @@
+/**
+ * ProviderTraits.cpp - Lookup of the provider table for a response type
+ */
+
+#include "ProviderTraits.h"
+#include "EncodingUtils.h" // for stringToWstring
+
+const ProviderOps &ProviderOps::forType(const std::string &responseType)
+{
+    // The Realtime API sends the same text delta events as the Responses API
+    if (responseType == "realtime")
+    {
+        return of<Provider::Responses>();
+    }
+
+    switch (ConfigSnapshot::providerFromString(stringToWstring(responseType)))
+    {
+    case Provider::OpenAI:
+        return of<Provider::OpenAI>();
+    case Provider::Claude:
+        return of<Provider::Claude>();
+    case Provider::Ollama:
+        return of<Provider::Ollama>();
+    case Provider::LlamaCpp:
+        return of<Provider::LlamaCpp>();
+    case Provider::Responses:
+        return of<Provider::Responses>();
+    case Provider::Gemini:
+        return of<Provider::Gemini>();
+    case Provider::Simple:
+        return of<Provider::Simple>();
+    default:
+        return of<Provider::Other>();
+    }
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <string>
+#include "StreamParser.h"
+#include "config/ConfigSnapshot.h"
+
+/**
+ * ProviderTraits - Compile-time description of one response type's wire format
+ *
+ * Each specialization binds what differs between the APIs: the authentication
+ * header, whether answers can be requested as a stream, the streaming framing,
+ * how the text of a stream payload is extracted (delta) and which payloads can
+ * carry usage (reportsUsage, a substring check that spares parsing the others).
+ *
+ * ProviderOps turns a specialization into a table of plain function pointers.
+ * The table is looked up by response type once per request (the only string
+ * comparison), so the stream callback's work per line is one indirect call
+ * into the parser of that format, without trying the other formats first.
+ */
+template <Provider P>
+struct ProviderTraits;
+
+template <>
+struct ProviderTraits<Provider::OpenAI>
+{
+    static constexpr const char *authHeader = "Authorization: Bearer ";
+    static constexpr const char *extraHeader = nullptr;
+    static constexpr bool streams = true;
+    static constexpr bool acceptEventStream = true;
+    static constexpr bool plainTextLines = false;
+    static std::string delta(const std::string &payload) { return StreamParser::parseOpenAIPayload(payload); }
+    // llama-server (also behind response_type=openai) adds its "timings" to the last chunk
+    static bool reportsUsage(const std::string &payload)
+    {
+        return payload.find("\"usage\"") != std::string::npos || payload.find("\"timings\"") != std::string::npos;
+    }
+};
+
+// Same wire format; llama-server's own options are in the request (see RequestFormatters)
+template <>
+struct ProviderTraits<Provider::LlamaCpp> : ProviderTraits<Provider::OpenAI>
+{
+};
+
+template <>
+struct ProviderTraits<Provider::Responses> : ProviderTraits<Provider::OpenAI>
+{
+    static std::string delta(const std::string &payload) { return StreamParser::parseResponsesPayload(payload); }
+    // response.created carries the (still empty) usage too; only the final event counts
+    static bool reportsUsage(const std::string &payload)
+    {
+        return payload.find("response.completed") != std::string::npos || payload.find("response.done") != std::string::npos ||
+               payload.find("response.incomplete") != std::string::npos;
+    }
+};
+
+template <>
+struct ProviderTraits<Provider::Gemini>
+{
+    static constexpr const char *authHeader = "x-goog-api-key: ";
+    static constexpr const char *extraHeader = nullptr;
+    static constexpr bool streams = true;
+    static constexpr bool acceptEventStream = true;
+    static constexpr bool plainTextLines = false;
+    static std::string delta(const std::string &payload) { return StreamParser::parseGeminiPayload(payload); }
+    static bool reportsUsage(const std::string &payload) { return payload.find("\"usageMetadata\"") != std::string::npos; }
+};
+
+template <>
+struct ProviderTraits<Provider::Claude>
+{
+    static constexpr const char *authHeader = "x-api-key: ";
+    static constexpr const char *extraHeader = "anthropic-version: 2023-06-01";
+    static constexpr bool streams = true;
+    static constexpr bool acceptEventStream = false;
+    static constexpr bool plainTextLines = false;
+    static std::string delta(const std::string &payload) { return StreamParser::parseClaudePayload(payload); }
+    static bool reportsUsage(const std::string &payload) { return payload.find("\"usage\"") != std::string::npos; }
+};
+
+template <>
+struct ProviderTraits<Provider::Ollama>
+{
+    static constexpr const char *authHeader = "Authorization: Bearer ";
+    static constexpr const char *extraHeader = nullptr;
+    static constexpr bool streams = true;
+    static constexpr bool acceptEventStream = true;
+    static constexpr bool plainTextLines = false;
+    static std::string delta(const std::string &payload) { return StreamParser::parseOllamaPayload(payload); }
+    static bool reportsUsage(const std::string &payload) { return payload.find("eval_count\"") != std::string::npos; }
+};
+
+template <>
+struct ProviderTraits<Provider::Simple>
+{
+    static constexpr const char *authHeader = "Authorization: Bearer ";
+    static constexpr const char *extraHeader = nullptr;
+    static constexpr bool streams = false;
+    static constexpr bool acceptEventStream = false;
+    static constexpr bool plainTextLines = true; // Lines that are not JSON objects are text
+    static std::string delta(const std::string &payload) { return StreamParser::extractContent(payload, "simple"); }
+    static bool reportsUsage(const std::string &) { return true; }
+};
+
+template <>
+struct ProviderTraits<Provider::Other>
+{
+    // Unknown types are requested like openai; their stream lines may be in any of the known formats
+    static constexpr const char *authHeader = "Authorization: Bearer ";
+    static constexpr const char *extraHeader = nullptr;
+    static constexpr bool streams = false;
+    static constexpr bool acceptEventStream = false;
+    static constexpr bool plainTextLines = false;
+    static std::string delta(const std::string &payload) { return StreamParser::extractContent(payload, "openai"); }
+    static bool reportsUsage(const std::string &) { return true; }
+};
+
+/**
+ * ProviderOps - The traits of one response type as a table, resolved once per request
+ */
+struct ProviderOps
+{
+    const char *authHeader;  // Header line the API key is appended to
+    const char *extraHeader; // Additional fixed header line (nullptr if none)
+    bool streams;            // Answers can be requested as a stream (see stream_transport)
+    bool acceptEventStream;  // Streaming requests send "Accept: text/event-stream"
+    bool plainTextLines;     // Stream lines that are not JSON objects are content (simple)
+    std::string (*delta)(const std::string &payload); // Text of one stream payload (empty for metadata)
+    bool (*reportsUsage)(const std::string &payload); // false if the payload cannot carry usage
+
+    // Table of a specialization of ProviderTraits
+    template <Provider P>
+    static const ProviderOps &of()
+    {
+        using Traits = ProviderTraits<P>;
+        static const ProviderOps ops = {Traits::authHeader, Traits::extraHeader, Traits::streams,
+                                        Traits::acceptEventStream, Traits::plainTextLines, &Traits::delta,
+                                        &Traits::reportsUsage};
+        return ops;
+    }
+
+    // Table of a response type ("realtime" for the Realtime API's events)
+    static const ProviderOps &forType(const std::string &responseType);
+};
@@ -0,0 +1,203 @@
+/**
+ * RateLimiter.cpp - Token buckets seeded from configuration and provider quota headers
+ */
+
+#include "RateLimiter.h"
+#include "RetryPolicy.h" // for reset duration / timestamp parsing
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <memory>
+
+namespace
+{
+    const double kMinuteMs = 60000.0;
+
+    double parseNumber(const std::string &value)
+    {
+        if (value.empty())
+            return -1;
+        char *end = nullptr;
+        double number = std::strtod(value.c_str(), &end);
+        return (end != value.c_str()) ? number : -1;
+    }
+}
+
+RateLimiter::RateLimiter(Clock clock)
+    : _clock(clock ? clock : Clock(RetryPolicy::nowEpochMs))
+{
+    _lastRefillMs = _clock();
+}
+
+RateLimiter &RateLimiter::forKey(const std::string &key)
+{
+    static std::mutex registryMutex;
+    static std::map<std::string, std::unique_ptr<RateLimiter>> registry;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::unique_ptr<RateLimiter> &limiter = registry[key];
+    if (!limiter)
+    {
+        limiter.reset(new RateLimiter());
+    }
+    return *limiter;
+}
+
+void RateLimiter::configure(double requestsPerMinute, double tokensPerMinute)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (requestsPerMinute == _configuredRpm && tokensPerMinute == _configuredTpm)
+    {
+        return;
+    }
+    _configuredRpm = requestsPerMinute;
+    _configuredTpm = tokensPerMinute;
+    refill();
+
+    // Configured limits start with a full bucket; server-provided ones take precedence
+    if (!_requests.fromHeaders)
+    {
+        _requests.capacity = _requests.available = std::max(0.0, requestsPerMinute);
+        _requests.refillPerMs = std::max(0.0, requestsPerMinute) / kMinuteMs;
+    }
+    if (!_tokens.fromHeaders)
+    {
+        _tokens.capacity = _tokens.available = std::max(0.0, tokensPerMinute);
+        _tokens.refillPerMs = std::max(0.0, tokensPerMinute) / kMinuteMs;
+    }
+}
+
+int64_t RateLimiter::reserve(double tokens)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    refill();
+    int64_t requestWait = _requests.reserve(1);
+    int64_t tokenWait = _tokens.reserve(tokens);
+    return std::max(requestWait, tokenWait);
+}
+
+void RateLimiter::updateFromHeaders(const ResponseHeaders &headers)
+{
+    static const char *const anthropicRequests[] = {"requests"};
+    static const char *const anthropicTokens[] = {"tokens", "input-tokens"};
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    refill();
+    syncBucket(_requests, headers, "requests", anthropicRequests, 1);
+    syncBucket(_tokens, headers, "tokens", anthropicTokens, 2);
+}
+
+double RateLimiter::availableRequests()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    refill();
+    return _requests.isActive() ? _requests.available : -1;
+}
+
+double RateLimiter::availableTokens()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    refill();
+    return _tokens.isActive() ? _tokens.available : -1;
+}
+
+double RateLimiter::estimateTokens(const std::string &requestBody)
+{
+    return std::ceil(requestBody.size() / 4.0);
+}
+
+void RateLimiter::refill()
+{
+    int64_t now = _clock();
+    double elapsedMs = static_cast<double>(now - _lastRefillMs);
+    _lastRefillMs = now;
+    if (elapsedMs > 0)
+    {
+        _requests.refill(elapsedMs);
+        _tokens.refill(elapsedMs);
+    }
+}
+
+/**
+ * Read one bucket's limit, remaining and reset values from the response headers
+ *
+ * @param bucket The bucket to update
+ * @param headers The response headers
+ * @param openAIName Suffix of the x-ratelimit-*-<name> headers
+ * @param anthropicNames Infixes of the anthropic-ratelimit-<name>-* headers, first match wins
+ * @param anthropicCount Number of entries in anthropicNames
+ */
+void RateLimiter::syncBucket(Bucket &bucket, const ResponseHeaders &headers, const std::string &openAIName,
+                             const char *const anthropicNames[], size_t anthropicCount)
+{
+    double limit = parseNumber(headers.get("x-ratelimit-limit-" + openAIName));
+    double remaining = parseNumber(headers.get("x-ratelimit-remaining-" + openAIName));
+    if (limit > 0 && remaining >= 0)
+    {
+        bucket.sync(limit, remaining, RetryPolicy::parseResetDurationMs(headers.get("x-ratelimit-reset-" + openAIName)));
+        return;
+    }
+
+    for (size_t i = 0; i < anthropicCount; ++i)
+    {
+        std::string prefix = std::string("anthropic-ratelimit-") + anthropicNames[i];
+        limit = parseNumber(headers.get(prefix + "-limit"));
+        remaining = parseNumber(headers.get(prefix + "-remaining"));
+        if (limit > 0 && remaining >= 0)
+        {
+            int64_t resetAt = RetryPolicy::parseTimestampMs(headers.get(prefix + "-reset"));
+            bucket.sync(limit, remaining, (resetAt >= 0) ? std::max<int64_t>(0, resetAt - _lastRefillMs) : -1);
+            return;
+        }
+    }
+}
+
+void RateLimiter::Bucket::refill(double elapsedMs)
+{
+    if (isActive())
+    {
+        available = std::min(capacity, available + elapsedMs * refillPerMs);
+    }
+}
+
+int64_t RateLimiter::Bucket::reserve(double cost)
+{
+    if (!isActive())
+    {
+        return 0;
+    }
+
+    // A single request larger than the bucket would wait forever; let it through once the bucket is full
+    available -= std::min(cost, capacity);
+    if (available >= 0)
+    {
+        return 0;
+    }
+    return static_cast<int64_t>(std::ceil(-available / refillPerMs));
+}
+
+/**
+ * Merge the server's view of the bucket into the local estimate
+ *
+ * The server has not yet seen the requests still in flight (or queued) whose
+ * cost was reserved here, so a known bucket keeps the lower of both values;
+ * a higher 'remaining' only shows up through the refill. The refill rate
+ * follows from the reset time (the bucket is full again after resetMs);
+ * without one the limit is assumed to be per minute.
+ */
+void RateLimiter::Bucket::sync(double limit, double remaining, int64_t resetMs)
+{
+    double serverAvailable = std::min(limit, remaining);
+    available = isActive() ? std::min(available, serverAvailable) : serverAvailable;
+    capacity = limit;
+    if (resetMs > 0 && remaining < limit)
+    {
+        refillPerMs = (limit - remaining) / static_cast<double>(resetMs);
+    }
+    else if (refillPerMs <= 0 || !fromHeaders)
+    {
+        refillPerMs = limit / kMinuteMs;
+    }
+    fromHeaders = true;
+}
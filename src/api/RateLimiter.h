@@ -0,0 +1,83 @@
+#pragma once
+#include <string>
+#include <functional>
+#include <mutex>
+#include <cstdint>
+#include "ResponseHeaders.h"
+
+/**
+ * RateLimiter - Client-side token buckets for requests and tokens per API key
+ *
+ * Several users or features sharing one key can exceed the provider's quota
+ * in a burst; every request beyond it costs a round trip and a 429. The limiter
+ * keeps a local estimate of the provider's buckets and delays requests that
+ * would not fit instead of sending them.
+ *
+ * Buckets are seeded in two ways:
+ * - rate_limit_rpm / rate_limit_tpm configuration values (per minute)
+ * - the provider's own view after every response: x-ratelimit-limit-* /
+ *   x-ratelimit-remaining-* / x-ratelimit-reset-* (OpenAI, Azure, most gateways)
+ *   and anthropic-ratelimit-*-limit / -remaining / -reset (Anthropic)
+ *
+ * reserve() works as a queue: each request takes its cost from the bucket
+ * (which may go negative) and is told how long to wait, so concurrent requests
+ * are spaced out in arrival order. The clock is injectable, so the behaviour
+ * can be reproduced exactly with a virtual clock.
+ */
+class RateLimiter
+{
+public:
+    // Milliseconds since an arbitrary epoch; must be the Unix epoch for Anthropic reset timestamps
+    typedef std::function<int64_t()> Clock;
+
+    explicit RateLimiter(Clock clock = Clock());
+
+    // Shared limiter for one API key (created on first use)
+    static RateLimiter &forKey(const std::string &key);
+
+    // Apply configured per-minute limits (0 = only learn from response headers)
+    void configure(double requestsPerMinute, double tokensPerMinute);
+
+    /**
+     * Reserve capacity for one request
+     *
+     * @param tokens Estimated tokens the request will consume
+     * @return Milliseconds to wait before sending (0 = send now)
+     */
+    int64_t reserve(double tokens);
+
+    // Synchronize the buckets with the rate-limit headers of a response
+    void updateFromHeaders(const ResponseHeaders &headers);
+
+    // Currently available capacity (negative while requests are queued), -1 if the bucket is unknown
+    double availableRequests();
+    double availableTokens();
+
+    // Rough token estimate for a JSON request body (about 4 bytes per token)
+    static double estimateTokens(const std::string &requestBody);
+
+private:
+    struct Bucket
+    {
+        double capacity = 0;
+        double available = 0;
+        double refillPerMs = 0;
+        bool fromHeaders = false; // Seeded by the server; configured limits no longer apply
+
+        bool isActive() const { return capacity > 0 && refillPerMs > 0; }
+        void refill(double elapsedMs);
+        int64_t reserve(double cost);
+        void sync(double limit, double remaining, int64_t resetMs);
+    };
+
+    void refill();
+    void syncBucket(Bucket &bucket, const ResponseHeaders &headers, const std::string &openAIName, const char *const anthropicNames[], size_t anthropicCount);
+
+    Clock _clock;
+    std::mutex _mutex;
+    Bucket _requests;
+    Bucket _tokens;
+    int64_t _lastRefillMs = 0;
+    double _configuredRpm = 0;
+    double _configuredTpm = 0;
+};
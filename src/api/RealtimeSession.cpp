@@ -0,0 +1,204 @@
+/**
+ * RealtimeSession.cpp - Persistent Realtime API session with idle reconnects
+ */
+
+#include "RealtimeSession.h"
+#include "APIUtils.h"
+#include "EncodingUtils.h" // for toUTF8
+#include "Trace.h"
+#include "config/ConfigSnapshot.h"
+#include <nlohmann/json.hpp>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace
+{
+    const int kPollMs = 50; // How often 'cancelled' is checked while waiting for events
+}
+
+RealtimeSession &RealtimeSession::instance()
+{
+    static RealtimeSession session;
+    return session;
+}
+
+/**
+ * Send one event and receive the events of its response
+ *
+ * @param url ws(s):// URL of the session (see buildUrl)
+ * @param secretKey API key
+ * @param config Configuration of the request (proxy, timeouts)
+ * @param event The client event to send (see responseEvent)
+ * @param onEvent Receives every server event; returns true once the response is complete
+ * @param cancelled Polled while waiting; true stops the exchange
+ * @return Outcome and connection details
+ */
+RealtimeSession::Exchange RealtimeSession::exchange(const std::string &url,
+                                                    const std::string &secretKey,
+                                                    const ConfigSnapshot &config,
+                                                    const std::string &event,
+                                                    const std::function<bool(const std::string &)> &onEvent,
+                                                    const std::function<bool()> &cancelled)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Exchange exchange;
+
+    // Another endpoint or key, or idle for so long that a server or proxy has probably dropped it
+    auto now = std::chrono::steady_clock::now();
+    std::string sessionKey = url + '\n' + secretKey + '\n' + config.proxy;
+    if (_socket.isOpen() &&
+        (sessionKey != _sessionKey || (config.realtimeIdleS > 0 && now - _lastUsed > std::chrono::seconds(config.realtimeIdleS))))
+    {
+        _socket.close();
+    }
+
+    // Events that arrived while idle belong to no ask; a close frame among them closes the socket
+    std::string stale;
+    while (_socket.isOpen() && _socket.read(stale, 0) == WebSocket::ReadResult::Message)
+    {
+    }
+
+    long silenceLimitMs = config.connectTimeoutMs > 0 ? config.connectTimeoutMs : 10000;
+    for (int attempt = 1;; ++attempt)
+    {
+        bool reused = _socket.isOpen();
+        if (!reused && !connect(url, secretKey, config, exchange))
+        {
+            return exchange;
+        }
+        _sessionKey = sessionKey;
+
+        bool anyEvent = false;
+        auto sentAt = std::chrono::steady_clock::now();
+        if (_socket.sendText(event))
+        {
+            for (;;)
+            {
+                if (cancelled())
+                {
+                    // Closing stops the generation; the next ask opens a new session
+                    _socket.close();
+                    exchange.outcome = Outcome::Aborted;
+                    return exchange;
+                }
+
+                std::string message;
+                WebSocket::ReadResult read = _socket.read(message, kPollMs);
+                if (read == WebSocket::ReadResult::Message)
+                {
+                    anyEvent = true;
+                    _lastUsed = std::chrono::steady_clock::now();
+                    if (onEvent(message))
+                    {
+                        exchange.outcome = Outcome::Done;
+                        return exchange;
+                    }
+                    continue;
+                }
+                if (read == WebSocket::ReadResult::Closed)
+                {
+                    break;
+                }
+                if (!anyEvent && reused && std::chrono::steady_clock::now() - sentAt > std::chrono::milliseconds(silenceLimitMs))
+                {
+                    _socket.close(); // Silently dropped by the network
+                    break;
+                }
+            }
+        }
+
+        // A reused session that broke before answering is replaced once; nothing of the answer was lost
+        bool retry = reused && !anyEvent && attempt == 1;
+        if (!retry)
+        {
+            exchange.error = "realtime session closed by the server";
+            return exchange;
+        }
+        Trace::instant("realtime reconnect", "http");
+    }
+}
+
+/**
+ * Open a new session and configure it for text responses
+ *
+ * @return false if the connection or the upgrade failed (exchange.error and httpStatus tell why)
+ */
+bool RealtimeSession::connect(const std::string &url, const std::string &secretKey, const ConfigSnapshot &config, Exchange &exchange)
+{
+    TraceSpan span("realtime connect", "http");
+    std::vector<std::string> headers;
+    headers.push_back("Authorization: Bearer " + secretKey);
+    headers.push_back("OpenAI-Beta: realtime=v1");
+    if (!_socket.open(url, headers, config.proxy, config.connectTimeoutMs, exchange.error, exchange.httpStatus))
+    {
+        return false;
+    }
+    exchange.connected = true;
+    _connects++;
+    _lastUsed = std::chrono::steady_clock::now();
+
+    // Text only; each ask brings its own instructions (see responseEvent)
+    json update;
+    update["type"] = "session.update";
+    update["session"]["modalities"] = json::array({"text"});
+    if (!_socket.sendText(update.dump()))
+    {
+        exchange.error = "realtime session closed by the server";
+        return false;
+    }
+    return true;
+}
+
+void RealtimeSession::close()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _socket.close();
+}
+
+int RealtimeSession::connects() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _connects;
+}
+
+std::string RealtimeSession::buildUrl(const std::string &baseUrl, const std::string &route, const std::wstring &model)
+{
+    std::string url = APIUtils::buildApiUrl(baseUrl, route);
+    if (url.compare(0, 8, "https://") == 0)
+    {
+        url = "wss://" + url.substr(8);
+    }
+    else if (url.compare(0, 7, "http://") == 0)
+    {
+        url = "ws://" + url.substr(7);
+    }
+    return url + (url.find('?') == std::string::npos ? "?model=" : "&model=") + toUTF8(model);
+}
+
+std::string RealtimeSession::responseEvent(const std::string &text, const std::wstring &systemPrompt, const ConfigSnapshot &config)
+{
+    json content = json::array();
+    content.push_back({{"type", "input_text"}, {"text", text}});
+    json input = json::array();
+    input.push_back({{"type", "message"}, {"role", "user"}, {"content", content}});
+
+    // Out of band: the answer does not become part of the session's conversation
+    json response;
+    response["conversation"] = "none";
+    response["modalities"] = json::array({"text"});
+    response["input"] = input;
+    if (!systemPrompt.empty())
+    {
+        response["instructions"] = toUTF8(systemPrompt);
+    }
+    if (config.maxTokens > 0)
+    {
+        response["max_output_tokens"] = config.maxTokens;
+    }
+
+    json event;
+    event["type"] = "response.create";
+    event["response"] = response;
+    return event.dump();
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include "WebSocket.h"
+
+struct ConfigSnapshot;
+
+/**
+ * RealtimeSession - One persistent WebSocket session to the OpenAI Realtime API
+ *
+ * Every HTTP ask is a new request: headers, authentication and - after an idle
+ * period - a new connection. With realtime=1 the asks of OpenAI endpoints are
+ * sent as "response.create" events over a single authenticated session that is
+ * opened by the first ask and then stays open, so a follow-up costs one frame
+ * in each direction before the first token arrives.
+ *
+ * Each ask is an out-of-band response ("conversation": "none") with its own
+ * instructions and input, so the session's conversation does not grow and
+ * asks stay as independent as over HTTP.
+ *
+ * Servers and proxies drop idle WebSockets, usually without telling the
+ * client. A session that was unused for longer than realtime_idle_s is
+ * replaced before the next ask, and an ask on a reused session that gets no
+ * event back within connect_timeout_ms (or finds it closed) is repeated once on
+ * a new session.
+ *
+ * Thread-safe: one exchange at a time (asks are sequential anyway).
+ */
+class RealtimeSession
+{
+public:
+    enum class Outcome
+    {
+        Done,    // The handler saw the end of the response
+        Failed,  // No session could be opened or it broke ('error' tells why)
+        Aborted  // Cancelled by the caller; the session was closed to stop the response
+    };
+
+    struct Exchange
+    {
+        Outcome outcome = Outcome::Failed;
+        bool connected = false; // A new session was opened for this exchange
+        long httpStatus = 0;    // Status of the upgrade when a new session was rejected or opened (101)
+        std::string error;      // Reason of a failure
+    };
+
+    static RealtimeSession &instance();
+
+    // Send 'event' over the session to 'url' (reconnecting as needed) and hand each server event to 'onEvent'
+    // until it returns true. 'cancelled' is polled while waiting.
+    Exchange exchange(const std::string &url,
+                      const std::string &secretKey,
+                      const ConfigSnapshot &config,
+                      const std::string &event,
+                      const std::function<bool(const std::string &)> &onEvent,
+                      const std::function<bool()> &cancelled);
+
+    // Close the session (plugin shutdown)
+    void close();
+
+    // Sessions opened so far
+    int connects() const;
+
+    // ws(s):// URL of the Realtime API for 'model' (api_url + route_realtime + "?model=")
+    static std::string buildUrl(const std::string &baseUrl, const std::string &route, const std::wstring &model);
+
+    // "response.create" event for one ask
+    static std::string responseEvent(const std::string &text, const std::wstring &systemPrompt, const ConfigSnapshot &config);
+
+private:
+    RealtimeSession() = default;
+    RealtimeSession(const RealtimeSession &) = delete;
+    RealtimeSession &operator=(const RealtimeSession &) = delete;
+
+    bool connect(const std::string &url, const std::string &secretKey, const ConfigSnapshot &config, Exchange &exchange);
+
+    mutable std::mutex _mutex;
+    WebSocket _socket;
+    std::string _sessionKey; // URL, key and proxy the open session was made with
+    std::chrono::steady_clock::time_point _lastUsed;
+    int _connects = 0;
+};
@@ -8,7 +8,15 @@
  * Support for different API formats:
  * - OpenAI format: {"model":"...", "messages":[{"role":"system","content":"..."},{"role":"user","content":"..."}]}
  * - Ollama format: {"model":"...", "prompt":"...", "system":"...", "temperature":...}
- * - Claude format: {"model":"...", "messages":[{"role":"user","content":"..."}], "system":"..."}
+ * - Claude format: {"model":"...", "messages":[{"role":"user","content":"..."}], "system":[{"type":"text","text":"...","cache_control":{...}}]}
+ * - llama.cpp format: OpenAI format plus "cache_prompt":true (and "id_slot", added per document by ChatPipeline)
+ * - OpenAI Responses format: {"model":"...", "instructions":"...", "input":"...", "max_output_tokens":...}
+ * - Gemini format: {"systemInstruction":{"parts":[{"text":"..."}]}, "contents":[{"role":"user","parts":[{"text":"..."}]}], "generationConfig":{...}}
+ *   (the model is part of the URL, see APIUtils::buildRequestUrl)
+ *
+ * Providers cache prompt prefixes: the system prompt always comes first and is
+ * serialized the same way on every request (nlohmann::json writes keys in
+ * sorted order), so repeated asks with the same prompt hit the cache.
  *
  * This design allows users to connect to various language model backends
  * without requiring an OpenAI-compatible adapter or proxy.
@@ -48,7 +56,7 @@ namespace RequestFormatters
         // Build messages array
         json messagesArray = json::array();
 
-        // Add system message if not empty
+        // Add system message if not empty; first, so it is the prefix OpenAI caches automatically
         if (!systemPromptStr.empty())
         {
             messagesArray.push_back({ {"role", "system"},
@@ -91,6 +99,29 @@ namespace RequestFormatters
         return requestJson.dump();
     }
 
+    std::string formatLlamaCppRequest(
+        const std::wstring& model,
+        const std::wstring& prompt,
+        const std::wstring& systemPrompt,
+        float temperature,
+        int maxTokens,
+        float topP,
+        float frequencyPenalty,
+        float presencePenalty,
+        const std::wstring& keepAlive)
+    {
+        // llama-server's chat route takes the OpenAI body (and applies the model's chat template);
+        // cache_prompt keeps the slot's KV cache so only the part after the common prefix is evaluated
+        std::string request = formatOpenAIRequest(model, prompt, systemPrompt, temperature, maxTokens,
+                                                  topP, frequencyPenalty, presencePenalty, keepAlive);
+        auto pos = request.rfind('}');
+        if (pos != std::string::npos)
+        {
+            request.insert(pos, ",\"cache_prompt\":true");
+        }
+        return request;
+    }
+
     std::string formatOllamaRequest(
         const std::wstring& model,
         const std::wstring& prompt,
@@ -192,10 +223,17 @@ namespace RequestFormatters
 
         requestJson["messages"] = messagesArray;
 
-        // Claude uses 'system' field at the top level for system prompt
+        // Claude uses 'system' field at the top level for system prompt. It is marked as a cache
+        // breakpoint so repeated asks read it from Anthropic's prompt cache instead of processing
+        // it again; prompts below the model's minimum cacheable length are simply not cached.
+        // The user message is not marked, however long: it is the selection of this ask and comes
+        // after the system prompt in the cached prefix, so only an ask with the same prompt and the
+        // same selection could read it back, while every new selection would pay the cache write.
         if (!systemPromptStr.empty())
         {
-            requestJson["system"] = systemPromptStr;
+            requestJson["system"] = json::array({ {{"type", "text"},
+                                                   {"text", systemPromptStr},
+                                                   {"cache_control", {{"type", "ephemeral"}}}} });
         }
 
         // Claude supports temperature
@@ -219,6 +257,121 @@ namespace RequestFormatters
         return requestJson.dump();
     }
 
+    std::string formatResponsesRequest(
+        const std::wstring& model,
+        const std::wstring& prompt,
+        const std::wstring& systemPrompt,
+        float temperature,
+        int maxTokens,
+        float topP,
+        float frequencyPenalty,
+        float presencePenalty,
+        const std::wstring& keepAlive)
+    {
+        (void)keepAlive;        // Not used for OpenAI requests
+        (void)frequencyPenalty; // The Responses API has no frequency_penalty
+        (void)presencePenalty;  // The Responses API has no presence_penalty
+
+        json requestJson;
+
+        // Convert wstring to UTF-8 string
+        std::string modelStr = toUTF8(model);
+        std::string promptStr = toUTF8(prompt);
+        std::string systemPromptStr = toUTF8(systemPrompt);
+
+        requestJson["model"] = modelStr;
+        requestJson["input"] = promptStr;
+
+        // Instructions are placed before the input, so they are the prefix OpenAI caches
+        if (!systemPromptStr.empty())
+        {
+            requestJson["instructions"] = systemPromptStr;
+        }
+
+        // Answers are not kept on OpenAI's side; every ask is independent
+        requestJson["store"] = false;
+
+        if (temperature != 1.0f)
+        {
+            requestJson["temperature"] = temperature;
+        }
+
+        if (maxTokens > 0)
+        {
+            requestJson["max_output_tokens"] = maxTokens;
+        }
+
+        if (topP != 1.0f)
+        {
+            requestJson["top_p"] = topP;
+        }
+
+        return requestJson.dump();
+    }
+
+    std::string formatGeminiRequest(
+        const std::wstring& model,
+        const std::wstring& prompt,
+        const std::wstring& systemPrompt,
+        float temperature,
+        int maxTokens,
+        float topP,
+        float frequencyPenalty,
+        float presencePenalty,
+        const std::wstring& keepAlive)
+    {
+        (void)model;     // Gemini takes the model from the URL (models/{model}:generateContent)
+        (void)keepAlive; // Not used for Gemini requests
+
+        json requestJson;
+
+        // Convert wstring to UTF-8 string
+        std::string promptStr = toUTF8(prompt);
+        std::string systemPromptStr = toUTF8(systemPrompt);
+
+        requestJson["contents"] = json::array({ {{"role", "user"},
+                                                 {"parts", json::array({ {{"text", promptStr}} })}} });
+
+        if (!systemPromptStr.empty())
+        {
+            requestJson["systemInstruction"] = { {"parts", json::array({ {{"text", systemPromptStr}} })} };
+        }
+
+        // Gemini takes the sampling parameters in generationConfig, in camelCase
+        json generationConfig = json::object();
+        if (temperature != 1.0f)
+        {
+            generationConfig["temperature"] = temperature;
+        }
+
+        if (maxTokens > 0)
+        {
+            generationConfig["maxOutputTokens"] = maxTokens;
+        }
+
+        if (topP != 1.0f)
+        {
+            generationConfig["topP"] = topP;
+        }
+
+        if (frequencyPenalty != 0.0f)
+        {
+            generationConfig["frequencyPenalty"] = frequencyPenalty;
+        }
+
+        if (presencePenalty != 0.0f)
+        {
+            generationConfig["presencePenalty"] = presencePenalty;
+        }
+
+        if (!generationConfig.empty())
+        {
+            requestJson["generationConfig"] = generationConfig;
+        }
+
+        return requestJson.dump();
+    }
+
     std::string formatSimpleRequest(
         const std::wstring& model,
         const std::wstring& prompt,
@@ -280,10 +433,22 @@ namespace RequestFormatters
         {
             return formatOllamaRequest;
         }
+        else if (type == "llamacpp")
+        {
+            return formatLlamaCppRequest;
+        }
         else if (type == "claude")
         {
             return formatClaudeRequest;
         }
+        else if (type == "openai-responses")
+        {
+            return formatResponsesRequest;
+        }
+        else if (type == "gemini")
+        {
+            return formatGeminiRequest;
+        }
         else if (type == "simple")
         {
             return formatSimpleRequest;
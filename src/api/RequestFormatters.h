@@ -37,6 +37,20 @@ namespace RequestFormatters
         float presencePenalty,
         const std::wstring& keepAlive);
 
+    /**
+     * Format request for llama.cpp's llama-server (OpenAI format with prompt caching)
+     */
+    std::string formatLlamaCppRequest(
+        const std::wstring& model,
+        const std::wstring& prompt,
+        const std::wstring& systemPrompt,
+        float temperature,
+        int maxTokens,
+        float topP,
+        float frequencyPenalty,
+        float presencePenalty,
+        const std::wstring& keepAlive);
+
     /**
      * Format request for Ollama native API
      */
@@ -65,6 +79,34 @@ namespace RequestFormatters
         float presencePenalty,
         const std::wstring& keepAlive);
 
+    /**
+     * Format request for the OpenAI Responses API (/v1/responses)
+     */
+    std::string formatResponsesRequest(
+        const std::wstring& model,
+        const std::wstring& prompt,
+        const std::wstring& systemPrompt,
+        float temperature,
+        int maxTokens,
+        float topP,
+        float frequencyPenalty,
+        float presencePenalty,
+        const std::wstring& keepAlive);
+
+    /**
+     * Format request for the Google Gemini API (generateContent / streamGenerateContent)
+     */
+    std::string formatGeminiRequest(
+        const std::wstring& model,
+        const std::wstring& prompt,
+        const std::wstring& systemPrompt,
+        float temperature,
+        int maxTokens,
+        float topP,
+        float frequencyPenalty,
+        float presencePenalty,
+        const std::wstring& keepAlive);
+
     /**
      * Format request for simple completion API
      */
@@ -0,0 +1,91 @@
+#include "ResponseHeaders.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+/**
+ * Forget the status code and all headers
+ */
+void ResponseHeaders::reset()
+{
+    statusCode = 0;
+    values.clear();
+}
+
+/**
+ * Parse one raw header line
+ *
+ * Status lines ("HTTP/1.1 429 Too Many Requests", "HTTP/2 200") start a new
+ * response; "Name: value" lines are stored with a lower-case name. The blank
+ * line terminating the header block is ignored.
+ *
+ * @param data Pointer to the header line (not NUL-terminated)
+ * @param length Length of the line including its CRLF
+ */
+void ResponseHeaders::parseLine(const char *data, size_t length)
+{
+    std::string line(data, length);
+    while (!line.empty() && (line.back() == '\r' || line.back() == '\n'))
+    {
+        line.pop_back();
+    }
+    if (line.empty())
+    {
+        return;
+    }
+
+    if (line.compare(0, 5, "HTTP/") == 0)
+    {
+        values.clear();
+        size_t space = line.find(' ');
+        statusCode = (space != std::string::npos) ? std::strtol(line.c_str() + space + 1, nullptr, 10) : 0;
+        return;
+    }
+
+    size_t colon = line.find(':');
+    if (colon == std::string::npos || colon == 0)
+    {
+        return;
+    }
+
+    std::string name = line.substr(0, colon);
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c)
+                   { return static_cast<char>(std::tolower(c)); });
+
+    size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+    size_t valueEnd = line.find_last_not_of(" \t");
+    values[name] = (valueStart == std::string::npos) ? "" : line.substr(valueStart, valueEnd - valueStart + 1);
+}
+
+/**
+ * Get a header value
+ *
+ * @param name Lower-case header name
+ * @return The header value, or an empty string if the header was not sent
+ */
+std::string ResponseHeaders::get(const std::string &name) const
+{
+    auto it = values.find(name);
+    return (it != values.end()) ? it->second : std::string();
+}
+
+/**
+ * cURL header callback that feeds a ResponseHeaders instance
+ *
+ * @param buffer The header line
+ * @param size Always 1
+ * @param nitems Length of the header line
+ * @param userp Pointer to the ResponseHeaders to fill
+ * @return The number of bytes processed
+ */
+size_t ResponseHeaders::curlHeaderCallback(char *buffer, size_t size, size_t nitems, void *userp)
+{
+    size_t totalSize = size * nitems;
+    ResponseHeaders *headers = static_cast<ResponseHeaders *>(userp);
+    if (headers)
+    {
+        headers->parseLine(buffer, totalSize);
+    }
+    return totalSize;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <map>
+
+/**
+ * ResponseHeaders - HTTP status and headers of a single response
+ *
+ * Filled line by line from cURL's header callback. Header names are stored
+ * in lower case so lookups are case-insensitive (HTTP/2 sends lower-case names,
+ * HTTP/1.1 servers usually do not). When a new status line arrives (redirects,
+ * "100 Continue"), previously collected headers are discarded so only the final
+ * response's headers remain.
+ */
+struct ResponseHeaders
+{
+    long statusCode = 0;                       // Status code of the last status line (0 until received)
+    std::map<std::string, std::string> values; // Lower-case header name -> trimmed value
+
+    // Forget everything collected so far (before a new attempt)
+    void reset();
+
+    // Feed one raw header line as delivered by CURLOPT_HEADERFUNCTION
+    void parseLine(const char *data, size_t length);
+
+    // Get a header value by lower-case name, or an empty string
+    std::string get(const std::string &name) const;
+
+    // True once a final 2xx status line was received
+    bool isSuccess() const { return statusCode >= 200 && statusCode < 300; }
+
+    // True once a final non-2xx status line was received
+    bool isError() const { return statusCode >= 300; }
+
+    /**
+     * cURL header callback; userp must point to a ResponseHeaders instance
+     */
+    static size_t curlHeaderCallback(char *buffer, size_t size, size_t nitems, void *userp);
+};
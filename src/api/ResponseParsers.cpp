@@ -10,6 +10,8 @@
  * - Ollama format: {"response":"response text"}
  * - Simple format: {"text":"response text"} or {"completion":"response text"}
  * - Anthropic Claude format: {"content":[{"type":"text","text":"response text"}]}
+ * - OpenAI Responses format: {"output":[{"type":"message","content":[{"type":"output_text","text":"response text"}]}]}
+ * - Gemini format: {"candidates":[{"content":{"parts":[{"text":"response text"}]}}]}
  *
  * This design allows users to connect to various language model backends
  * without requiring an OpenAI-compatible adapter or proxy.
@@ -17,13 +19,12 @@
 
 #include "ResponseParsers.h"
 #include "utils/EncodingUtils.h" // for multiByteToWideChar
-#include "external_globals.h"    // for configAPIValue_showReasoning
 #include <string>
 #include <stdexcept>
 
 namespace ResponseParsers
 {
-    std::string parseOpenAIResponse(const std::string &response)
+    std::string parseOpenAIResponse(const std::string &response, bool showReasoning)
     {
         std::string replyText;
         try
@@ -33,7 +34,7 @@ namespace ResponseParsers
             {
                 replyText = respJson["choices"][0]["message"]["content"].get<std::string>();
                 // Process any thinking sections in the response
-                replyText = processThinkingSections(replyText);
+                replyText = processThinkingSections(replyText, showReasoning);
             }
             else
             {
@@ -48,7 +49,7 @@ namespace ResponseParsers
         }
         return replyText;
     }
-    std::string parseOllamaResponse(const std::string &response)
+    std::string parseOllamaResponse(const std::string &response, bool showReasoning)
     {
         std::string replyText;
         try
@@ -76,7 +77,7 @@ namespace ResponseParsers
                     {
                         replyText = respJson["response"].get<std::string>();
                         // Process any thinking sections in the response
-                        replyText = processThinkingSections(replyText);
+                        replyText = processThinkingSections(replyText, showReasoning);
                     }
                 }
                 else
@@ -91,7 +92,7 @@ namespace ResponseParsers
                 {
                     replyText = respJson["response"].get<std::string>();
                     // Process any thinking sections in the response
-                    replyText = processThinkingSections(replyText);
+                    replyText = processThinkingSections(replyText, showReasoning);
                 }
                 else if (respJson.contains("error"))
                 {
@@ -119,7 +120,7 @@ namespace ResponseParsers
         return replyText;
     }
 
-    std::string parseClaudeResponse(const std::string &response)
+    std::string parseClaudeResponse(const std::string &response, bool showReasoning)
     {
         std::string replyText;
         try
@@ -143,7 +144,7 @@ namespace ResponseParsers
                 else
                 {
                     // Process any thinking sections in the response
-                    replyText = processThinkingSections(replyText);
+                    replyText = processThinkingSections(replyText, showReasoning);
                 }
             }
             else
@@ -160,7 +161,110 @@ namespace ResponseParsers
         return replyText;
     }
 
-    std::string parseSimpleResponse(const std::string &response)
+    std::string parseResponsesResponse(const std::string &response, bool showReasoning)
+    {
+        std::string replyText;
+        try
+        {
+            auto respJson = json::parse(response);
+            // The output array also holds reasoning and tool call items; only messages carry the answer
+            if (respJson.contains("output") && respJson["output"].is_array())
+            {
+                for (const auto &item : respJson["output"])
+                {
+                    if (!item.contains("type") || item["type"] != "message" || !item.contains("content") || !item["content"].is_array())
+                    {
+                        continue;
+                    }
+                    for (const auto &part : item["content"])
+                    {
+                        if (part.contains("type") && part["type"] == "output_text" && part.contains("text"))
+                        {
+                            replyText += part["text"].get<std::string>();
+                        }
+                    }
+                }
+                if (replyText.empty())
+                {
+                    replyText = "[Error: No output_text found in Responses API response]";
+                }
+                else
+                {
+                    // Process any thinking sections in the response
+                    replyText = processThinkingSections(replyText, showReasoning);
+                }
+            }
+            else if (respJson.contains("error") && respJson["error"].is_object() && respJson["error"].contains("message"))
+            {
+                replyText = "[Error from OpenAI: ";
+                replyText += respJson["error"]["message"].get<std::string>();
+                replyText += "]";
+            }
+            else
+            {
+                replyText = "[Error: No valid 'output' array found in Responses API format response]";
+            }
+        }
+        catch (const std::exception &e)
+        {
+            replyText = "[Failed to parse Responses API response: ";
+            replyText += e.what();
+            replyText += ". Please check if response_type=openai-responses is the correct format for this endpoint.]";
+        }
+        return replyText;
+    }
+
+    std::string parseGeminiResponse(const std::string &response, bool showReasoning)
+    {
+        std::string replyText;
+        try
+        {
+            auto respJson = json::parse(response);
+            if (respJson.contains("candidates") && respJson["candidates"].is_array() && !respJson["candidates"].empty())
+            {
+                // Combine the text parts of the first candidate; thought summaries are not part of the answer
+                const auto &candidate = respJson["candidates"][0];
+                if (candidate.contains("content") && candidate["content"].contains("parts") && candidate["content"]["parts"].is_array())
+                {
+                    for (const auto &part : candidate["content"]["parts"])
+                    {
+                        bool thought = part.contains("thought") && part["thought"].is_boolean() && part["thought"].get<bool>();
+                        if (!thought && part.contains("text"))
+                        {
+                            replyText += part["text"].get<std::string>();
+                        }
+                    }
+                }
+                if (replyText.empty())
+                {
+                    replyText = "[Error: No text content found in Gemini response";
+                    if (candidate.contains("finishReason") && candidate["finishReason"].is_string())
+                    {
+                        replyText += " (finishReason " + candidate["finishReason"].get<std::string>() + ")";
+                    }
+                    replyText += "]";
+                }
+                else
+                {
+                    // Process any thinking sections in the response
+                    replyText = processThinkingSections(replyText, showReasoning);
+                }
+            }
+            else
+            {
+                replyText = "[Error: No valid 'candidates' array found in Gemini format response]";
+            }
+        }
+        catch (const std::exception &e)
+        {
+            replyText = "[Failed to parse Gemini response: ";
+            replyText += e.what();
+            replyText += ". Please check if response_type=gemini is the correct format for this endpoint.]";
+        }
+        return replyText;
+    }
+
+    std::string parseSimpleResponse(const std::string &response, bool showReasoning)
     {
         std::string replyText;
         try
@@ -190,7 +294,7 @@ namespace ResponseParsers
             }
 
             // Process any thinking sections in the response
-            replyText = processThinkingSections(replyText);
+            replyText = processThinkingSections(replyText, showReasoning);
         }
         catch (const std::exception &e)
         {
@@ -205,7 +309,7 @@ namespace ResponseParsers
         // Convert wstring to string for comparison
         std::string type = toUTF8(endpointType);
 
-        if (type == "openai" || type == "") // Default to OpenAI format
+        if (type == "openai" || type == "llamacpp" || type == "") // Default to OpenAI format (llama-server's chat route uses it)
         {
             return parseOpenAIResponse;
         }
@@ -221,6 +325,14 @@ namespace ResponseParsers
         {
             return parseClaudeResponse;
         }
+        else if (type == "openai-responses")
+        {
+            return parseResponsesResponse;
+        }
+        else if (type == "gemini")
+        {
+            return parseGeminiResponse;
+        }
         else
         {
             // Default to OpenAI for unknown types
@@ -232,20 +344,18 @@ namespace ResponseParsers
        * Some LLMs provide their reasoning within <think>...</think> tags before giving the
        * final answer. This function handles these reasoning sections based on user preference.
        *
-       * If show_reasoning=1 is set in the INI file, these sections are preserved.
-       * If show_reasoning=0 (default), these sections are removed from the final output.
+       * With show_reasoning=1 in the request's configuration these sections are preserved,
+       * with show_reasoning=0 (default) they are removed from the final output.
        *
        * For streaming responses, this is applied to each chunk as it arrives, which means that
        * thinking sections split across multiple chunks might only be partially removed.
        *
        * @param text The input text potentially containing thinking sections
+       * @param showReasoning show_reasoning of the request's ConfigSnapshot
        * @return The text with thinking sections either preserved or removed
        */
-    std::string processThinkingSections(const std::string &text)
+    std::string processThinkingSections(const std::string &text, bool showReasoning)
     {
-        // Check if we should show reasoning sections
-        bool showReasoning = (configAPIValue_showReasoning == L"1");
-
         if (showReasoning)
         {
             // Return the text as-is if we're showing reasoning
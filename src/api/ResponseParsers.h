@@ -14,32 +14,44 @@ using json = nlohmann::json;
 
 namespace ResponseParsers
 {
-    // Parser function type definition
-    using ParserFunction = std::function<std::string(const std::string &)>;
+    // Parser function type definition: response body and show_reasoning of the request
+    using ParserFunction = std::function<std::string(const std::string &, bool)>;
 
     /**
      * Parse response from standard OpenAI-compatible API
      * Format: {"choices": [{"message": {"content": "generated text"}}]}
      */
-    std::string parseOpenAIResponse(const std::string &response);
+    std::string parseOpenAIResponse(const std::string &response, bool showReasoning);
 
     /**
      * Parse response from Ollama native API
      * Format: {"response": "generated text"}
      */
-    std::string parseOllamaResponse(const std::string &response);
+    std::string parseOllamaResponse(const std::string &response, bool showReasoning);
 
     /**
      * Parse response from Anthropic Claude API
      * Format: {"content": [{"type": "text", "text": "generated text"}]}
      */
-    std::string parseClaudeResponse(const std::string &response);
+    std::string parseClaudeResponse(const std::string &response, bool showReasoning);
+
+    /**
+     * Parse response from the OpenAI Responses API
+     * Format: {"output": [{"type": "message", "content": [{"type": "output_text", "text": "generated text"}]}]}
+     */
+    std::string parseResponsesResponse(const std::string &response, bool showReasoning);
+
+    /**
+     * Parse response from the Google Gemini API
+     * Format: {"candidates": [{"content": {"parts": [{"text": "generated text"}]}}]}
+     */
+    std::string parseGeminiResponse(const std::string &response, bool showReasoning);
 
     /**
      * Parse response from simple completion API
      * Format: {"text": "generated text"} or {"completion": "generated text"}
      */
-    std::string parseSimpleResponse(const std::string &response); /**
+    std::string parseSimpleResponse(const std::string &response, bool showReasoning); /**
                                                                    * Get the appropriate parser function for an endpoint
                                                                    * @param endpointType The endpoint type identifier from config
                                                                    * @return The parser function to use
@@ -50,9 +62,10 @@ namespace ResponseParsers
      * Process thinking sections in the response text
      * Removes <think>...</think> sections if show_reasoning is disabled
      * @param text The text to process
-     * @return The processed text with thinking sections handled according to config
+     * @param showReasoning show_reasoning of the request's configuration
+     * @return The processed text with thinking sections handled accordingly
      */
-    std::string processThinkingSections(const std::string &text);
+    std::string processThinkingSections(const std::string &text, bool showReasoning);
 }
 
 #endif // RESPONSE_PARSERS_H
@@ -0,0 +1,306 @@
+/**
+ * RetryPolicy.cpp - Backoff and server-hint handling for failed API requests
+ *
+ * Implements the retry decision used by HTTPClient: which failures are
+ * transient, how long to back off, and how to read the wait hints that
+ * OpenAI, Anthropic, Azure and most gateways attach to 429/503 responses.
+ */
+
+#include "RetryPolicy.h"
+#include <curl/curl.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <random>
+
+namespace
+{
+    /**
+     * Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's algorithm)
+     */
+    int64_t daysFromCivil(int year, int month, int day)
+    {
+        year -= month <= 2 ? 1 : 0;
+        const int64_t era = (year >= 0 ? year : year - 399) / 400;
+        const int64_t yearOfEra = year - era * 400;
+        const int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        const int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + dayOfEra - 719468;
+    }
+
+    int64_t toEpochMs(int year, int month, int day, int hour, int minute, int second)
+    {
+        return ((daysFromCivil(year, month, day) * 24 + hour) * 60 + minute) * 60000LL + second * 1000LL;
+    }
+
+    int monthFromName(const char *name)
+    {
+        static const char *const months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                             "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+        for (int i = 0; i < 12; ++i)
+        {
+            if (std::string(name) == months[i])
+                return i + 1;
+        }
+        return 0;
+    }
+
+    bool isAllDigits(const std::string &value)
+    {
+        return !value.empty() && std::all_of(value.begin(), value.end(), [](unsigned char c)
+                                             { return std::isdigit(c) != 0; });
+    }
+}
+
+RetryPolicy::RetryPolicy(int maxAttempts, int baseDelayMs, int maxDelayMs)
+    : _maxAttempts((std::max)(1, maxAttempts)),
+      _baseDelayMs((std::max)(1, baseDelayMs)),
+      _maxDelayMs((std::max)(1, maxDelayMs))
+{
+}
+
+/**
+ * Get the delay before the next attempt
+ *
+ * @param attempt The attempt that just failed (1 = first request)
+ * @param curlCode The CURLcode returned by curl_easy_perform
+ * @param headers Status code and headers of the failed response (if any)
+ * @return Milliseconds to wait before retrying, or -1 if the request must not be retried
+ */
+int RetryPolicy::nextDelayMs(int attempt, int curlCode, const ResponseHeaders &headers) const
+{
+    if (attempt >= _maxAttempts)
+    {
+        return -1;
+    }
+
+    bool retryable = false;
+    if (headers.isError())
+    {
+        retryable = isRetryableStatus(headers.statusCode);
+    }
+    else if (curlCode != CURLE_OK)
+    {
+        retryable = isRetryableTransportError(curlCode);
+    }
+    if (!retryable)
+    {
+        return -1;
+    }
+
+    int64_t hintMs = serverDelayHintMs(headers, nowEpochMs());
+    if (hintMs >= 0)
+    {
+        // Retrying before the server's reset time is pointless; give up if it is too far away
+        return (hintMs > _maxDelayMs) ? -1 : static_cast<int>(hintMs);
+    }
+
+    return backoffMs(attempt);
+}
+
+/**
+ * Capped exponential backoff with full jitter
+ */
+int RetryPolicy::backoffMs(int attempt) const
+{
+    int exponent = (std::min)((std::max)(attempt - 1, 0), 20);
+    int64_t cap = (std::min)(static_cast<int64_t>(_maxDelayMs), static_cast<int64_t>(_baseDelayMs) << exponent);
+
+    thread_local std::mt19937 generator(std::random_device{}());
+    std::uniform_int_distribution<int> distribution(0, static_cast<int>(cap));
+    return distribution(generator);
+}
+
+bool RetryPolicy::isRetryableStatus(long httpStatus)
+{
+    switch (httpStatus)
+    {
+    case 408: // Request Timeout
+    case 409: // Conflict (OpenAI: "request was interrupted")
+    case 425: // Too Early
+    case 429: // Too Many Requests
+    case 500: // Internal Server Error
+    case 502: // Bad Gateway
+    case 503: // Service Unavailable
+    case 504: // Gateway Timeout
+    case 529: // Anthropic: Overloaded
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool RetryPolicy::isRetryableTransportError(int curlCode)
+{
+    switch (curlCode)
+    {
+    case CURLE_COULDNT_RESOLVE_HOST:
+    case CURLE_COULDNT_CONNECT:
+    case CURLE_OPERATION_TIMEDOUT:
+    case CURLE_SEND_ERROR:
+    case CURLE_RECV_ERROR:
+    case CURLE_GOT_NOTHING:
+    case CURLE_PARTIAL_FILE:
+    case CURLE_HTTP2:
+    case CURLE_HTTP2_STREAM:
+        return true;
+    default:
+        // Cancellation (write callback abort), TLS/certificate and configuration errors are final
+        return false;
+    }
+}
+
+/**
+ * Get the server's wait hint from the response headers
+ *
+ * Checked in order of precision:
+ * 1. retry-after-ms (OpenAI / Azure)
+ * 2. Retry-After (seconds or HTTP-date)
+ * 3. Reset headers of exhausted rate-limit buckets:
+ *    x-ratelimit-reset-requests / -tokens (durations, OpenAI) and
+ *    anthropic-ratelimit-*-reset (RFC 3339 timestamps)
+ *
+ * @param headers Headers of the failed response
+ * @param nowEpochMs Current time, used to convert absolute dates
+ * @return The wait time in milliseconds, or -1 if the server gave no hint
+ */
+int64_t RetryPolicy::serverDelayHintMs(const ResponseHeaders &headers, int64_t nowEpochMs)
+{
+    std::string retryAfterMs = headers.get("retry-after-ms");
+    if (!retryAfterMs.empty())
+    {
+        char *end = nullptr;
+        double ms = std::strtod(retryAfterMs.c_str(), &end);
+        if (end != retryAfterMs.c_str() && ms >= 0)
+            return static_cast<int64_t>(ms);
+    }
+
+    int64_t retryAfter = parseRetryAfterMs(headers.get("retry-after"), nowEpochMs);
+    if (retryAfter >= 0)
+    {
+        return retryAfter;
+    }
+
+    // Only buckets that are actually exhausted tell us when a retry can succeed
+    int64_t hint = -1;
+    static const char *const openAIBuckets[] = {"requests", "tokens"};
+    for (const char *bucket : openAIBuckets)
+    {
+        if (headers.get(std::string("x-ratelimit-remaining-") + bucket) == "0")
+        {
+            hint = (std::max)(hint, parseResetDurationMs(headers.get(std::string("x-ratelimit-reset-") + bucket)));
+        }
+    }
+
+    static const char *const anthropicBuckets[] = {"requests", "tokens", "input-tokens", "output-tokens"};
+    for (const char *bucket : anthropicBuckets)
+    {
+        std::string prefix = std::string("anthropic-ratelimit-") + bucket;
+        if (headers.get(prefix + "-remaining") == "0")
+        {
+            int64_t resetAt = parseTimestampMs(headers.get(prefix + "-reset"));
+            if (resetAt >= 0)
+                hint = (std::max)(hint, (std::max)(static_cast<int64_t>(0), resetAt - nowEpochMs));
+        }
+    }
+
+    return hint;
+}
+
+int64_t RetryPolicy::parseRetryAfterMs(const std::string &value, int64_t nowEpochMs)
+{
+    if (value.empty())
+    {
+        return -1;
+    }
+    if (isAllDigits(value))
+    {
+        return std::strtoll(value.c_str(), nullptr, 10) * 1000;
+    }
+
+    int64_t at = parseTimestampMs(value);
+    return (at >= 0) ? (std::max)(static_cast<int64_t>(0), at - nowEpochMs) : -1;
+}
+
+int64_t RetryPolicy::parseResetDurationMs(const std::string &value)
+{
+    if (value.empty())
+    {
+        return -1;
+    }
+
+    double totalMs = 0;
+    const char *cursor = value.c_str();
+    bool parsedAny = false;
+    while (*cursor)
+    {
+        char *end = nullptr;
+        double amount = std::strtod(cursor, &end);
+        if (end == cursor)
+        {
+            return -1;
+        }
+        cursor = end;
+
+        if (cursor[0] == 'm' && cursor[1] == 's')
+        {
+            totalMs += amount;
+            cursor += 2;
+        }
+        else if (cursor[0] == 's' || cursor[0] == '\0')
+        {
+            totalMs += amount * 1000;
+            cursor += (cursor[0] == 's') ? 1 : 0;
+        }
+        else if (cursor[0] == 'm')
+        {
+            totalMs += amount * 60000;
+            ++cursor;
+        }
+        else if (cursor[0] == 'h')
+        {
+            totalMs += amount * 3600000;
+            ++cursor;
+        }
+        else
+        {
+            return -1;
+        }
+        parsedAny = true;
+    }
+
+    return parsedAny ? static_cast<int64_t>(totalMs) : -1;
+}
+
+int64_t RetryPolicy::parseTimestampMs(const std::string &value)
+{
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+
+    // RFC 3339: 2024-05-01T12:00:00Z (fraction and numeric offset ignored; providers send UTC)
+    if (std::sscanf(value.c_str(), "%4d-%2d-%2dT%2d:%2d:%2d", &year, &month, &day, &hour, &minute, &second) == 6)
+    {
+        return toEpochMs(year, month, day, hour, minute, second);
+    }
+
+    // HTTP-date (IMF-fixdate): Wed, 21 Oct 2015 07:28:00 GMT
+    char monthName[4] = {0};
+    size_t comma = value.find(',');
+    if (comma != std::string::npos &&
+        std::sscanf(value.c_str() + comma + 1, " %2d %3s %4d %2d:%2d:%2d", &day, monthName, &year, &hour, &minute, &second) == 6)
+    {
+        month = monthFromName(monthName);
+        if (month > 0)
+            return toEpochMs(year, month, day, hour, minute, second);
+    }
+
+    return -1;
+}
+
+int64_t RetryPolicy::nowEpochMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include "ResponseHeaders.h"
+
+/**
+ * RetryPolicy - Decides whether and when a failed API request is retried
+ *
+ * Transient failures (rate limits, overloaded or restarting backends, dropped
+ * connections) are retried with capped exponential backoff and full jitter:
+ * the delay before attempt n+1 is a random value in [0, min(maxDelay, base * 2^(n-1))].
+ * When the server says how long to wait (Retry-After, retry-after-ms,
+ * x-ratelimit-reset-*, anthropic-ratelimit-*-reset), that hint is used instead,
+ * and if it exceeds the maximum delay the request is not retried at all.
+ *
+ * The policy only answers "may this failure be retried"; callers are responsible
+ * for idempotency, e.g. a stream must never be retried once content has been
+ * inserted into the document.
+ */
+class RetryPolicy
+{
+public:
+    RetryPolicy(int maxAttempts, int baseDelayMs, int maxDelayMs);
+
+    int maxAttempts() const { return _maxAttempts; }
+
+    /**
+     * Get the delay before the next attempt
+     *
+     * @param attempt The attempt that just failed (1 = first request)
+     * @param curlCode The CURLcode returned by curl_easy_perform
+     * @param headers Status code and headers of the failed response (if any)
+     * @return Milliseconds to wait before retrying, or -1 if the request must not be retried
+     */
+    int nextDelayMs(int attempt, int curlCode, const ResponseHeaders &headers) const;
+
+    // HTTP status codes worth retrying (408, 409, 425, 429, 500, 502, 503, 504, 529)
+    static bool isRetryableStatus(long httpStatus);
+
+    // Transport errors worth retrying (connect failures, timeouts, resets, empty replies)
+    static bool isRetryableTransportError(int curlCode);
+
+    // Server-provided wait time in milliseconds from the response headers, or -1 if none
+    static int64_t serverDelayHintMs(const ResponseHeaders &headers, int64_t nowEpochMs);
+
+    // Parse "Retry-After" (delta-seconds or HTTP-date), returns milliseconds or -1
+    static int64_t parseRetryAfterMs(const std::string &value, int64_t nowEpochMs);
+
+    // Parse an OpenAI-style reset duration ("20ms", "1.5s", "6m0s", "1h2m3s"), returns milliseconds or -1
+    static int64_t parseResetDurationMs(const std::string &value);
+
+    // Parse an RFC 3339 timestamp ("2024-05-01T12:00:00Z") or HTTP-date to epoch milliseconds, or -1
+    static int64_t parseTimestampMs(const std::string &value);
+
+    // Current wall-clock time in epoch milliseconds
+    static int64_t nowEpochMs();
+
+private:
+    int backoffMs(int attempt) const;
+
+    int _maxAttempts;
+    int _baseDelayMs;
+    int _maxDelayMs;
+};
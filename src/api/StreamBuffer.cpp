@@ -0,0 +1,54 @@
+/**
+ * StreamBuffer.cpp - Bounded queue of streamed text between transfer and front-end
+ */
+
+#include "StreamBuffer.h"
+#include <algorithm>
+
+StreamBuffer::StreamBuffer(size_t highWatermark, size_t lowWatermark)
+    : _highWatermark(highWatermark), _lowWatermark((std::min)(lowWatermark, highWatermark))
+{
+}
+
+void StreamBuffer::push(const std::string &content)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queued += content;
+        _peakBytes = (std::max)(_peakBytes, _queued.size());
+    }
+    _arrived.notify_one();
+}
+
+bool StreamBuffer::isFull() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _queued.size() >= _highWatermark;
+}
+
+bool StreamBuffer::hasRoom() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _queued.size() <= _lowWatermark;
+}
+
+void StreamBuffer::waitForContent(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _arrived.wait_for(lock, timeout, [this]()
+                      { return !_queued.empty(); });
+}
+
+std::string StreamBuffer::take()
+{
+    std::string content;
+    std::lock_guard<std::mutex> lock(_mutex);
+    content.swap(_queued);
+    return content;
+}
+
+size_t StreamBuffer::peakBytes() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _peakBytes;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+/**
+ * StreamBuffer - Bounded queue of streamed text between the transfer and the front-end
+ *
+ * The transfer's worker thread appends the content of each stream line; the
+ * requesting thread takes it out between message pump iterations and hands it
+ * to the TransferHost. So a busy UI thread (a restyle, a modal dialog) no longer
+ * blocks the transfer inside the editor call, and text that arrives meanwhile
+ * is inserted in one piece once the UI is back.
+ *
+ * The queue is bounded by two watermarks: once it holds 'highWatermark' bytes
+ * the write callback pauses the transfer (CURL_WRITEFUNC_PAUSE), and the
+ * transfer loop resumes it when the front-end has drained it to
+ * 'lowWatermark' bytes or less. A chunk that arrives below the high watermark
+ * is always taken whole, so the queue can exceed it by one chunk's content.
+ */
+class StreamBuffer
+{
+public:
+    StreamBuffer(size_t highWatermark, size_t lowWatermark);
+
+    // Append text (transfer thread)
+    void push(const std::string &content);
+
+    // The transfer should pause before taking the next chunk
+    bool isFull() const;
+
+    // A paused transfer may resume
+    bool hasRoom() const;
+
+    // Wait up to 'timeout' for text to arrive (requesting thread)
+    void waitForContent(std::chrono::milliseconds timeout);
+
+    // Take all queued text (empty if none)
+    std::string take();
+
+    // Largest number of bytes queued at once
+    size_t peakBytes() const;
+
+private:
+    mutable std::mutex _mutex;
+    std::condition_variable _arrived;
+    std::string _queued;
+    size_t _highWatermark;
+    size_t _lowWatermark;
+    size_t _peakBytes = 0;
+};
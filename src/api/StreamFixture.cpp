@@ -0,0 +1,197 @@
+/**
+ * StreamFixture.cpp - Recording, reading and writing of response fixtures
+ */
+
+#include "StreamFixture.h"
+#include "EncodingUtils.h" // for stringToWstring
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    const char kMagic[] = "NPPOPENAI-FIXTURE 1";
+
+    FILE *openFile(const std::string &path, const char *mode)
+    {
+#ifdef _WIN32
+        return _wfopen(stringToWstring(path).c_str(), stringToWstring(mode).c_str());
+#else
+        return std::fopen(path.c_str(), mode);
+#endif
+    }
+
+    // Header line "key: value" -> value, for the given key
+    bool headerValue(const std::string &line, const char *key, std::string &value)
+    {
+        std::string prefix = std::string(key) + ": ";
+        if (line.compare(0, prefix.size(), prefix) != 0)
+            return false;
+        value = line.substr(prefix.size());
+        return true;
+    }
+}
+
+size_t StreamFixture::totalBytes() const
+{
+    size_t total = 0;
+    for (const Chunk &chunk : chunks)
+        total += chunk.data.size();
+    return total;
+}
+
+int64_t StreamFixture::durationUs() const
+{
+    int64_t total = 0;
+    for (const Chunk &chunk : chunks)
+        total += chunk.delayUs;
+    return total;
+}
+
+std::string StreamFixture::serialize() const
+{
+    std::string text = kMagic;
+    text += "\napi_type: " + apiType;
+    text += "\nstreaming: " + std::string(streaming ? "1" : "0");
+    text += "\nhttp_status: " + std::to_string(httpStatus);
+    text += "\ncurl_code: " + std::to_string(curlCode);
+    text += "\n\n";
+    for (const Chunk &chunk : chunks)
+    {
+        text += "+" + std::to_string(chunk.delayUs) + " " + std::to_string(chunk.data.size()) + "\n";
+        text += chunk.data;
+        text += "\n";
+    }
+    return text;
+}
+
+bool StreamFixture::parse(const std::string &text)
+{
+    *this = StreamFixture();
+
+    size_t position = 0;
+    auto nextLine = [&](std::string &line)
+    {
+        if (position >= text.size())
+            return false;
+        size_t end = text.find('\n', position);
+        if (end == std::string::npos)
+            end = text.size();
+        line = text.substr(position, end - position);
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        position = end + 1;
+        return true;
+    };
+
+    std::string line;
+    if (!nextLine(line) || line != kMagic)
+        return false;
+
+    // Header up to the first empty line
+    while (nextLine(line) && !line.empty())
+    {
+        std::string value;
+        if (headerValue(line, "api_type", value))
+            apiType = value;
+        else if (headerValue(line, "streaming", value))
+            streaming = (value == "1");
+        else if (headerValue(line, "http_status", value))
+            httpStatus = std::strtol(value.c_str(), nullptr, 10);
+        else if (headerValue(line, "curl_code", value))
+            curlCode = static_cast<int>(std::strtol(value.c_str(), nullptr, 10));
+        // Unknown keys are ignored, so newer fixtures stay readable
+    }
+
+    while (nextLine(line))
+    {
+        if (line.empty())
+            continue;
+        if (line[0] != '+')
+            return false;
+
+        char *end = nullptr;
+        Chunk chunk;
+        chunk.delayUs = std::strtoll(line.c_str() + 1, &end, 10);
+        size_t size = static_cast<size_t>(std::strtoull(end, nullptr, 10));
+        if (position + size > text.size())
+            return false;
+        chunk.data = text.substr(position, size);
+        position += size + 1; // Skip the separating newline
+        chunks.push_back(std::move(chunk));
+    }
+    return true;
+}
+
+bool StreamFixture::load(const std::string &path)
+{
+    FILE *file = openFile(path, "rb");
+    if (!file)
+        return false;
+
+    std::string text;
+    char buffer[65536];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        text.append(buffer, read);
+    std::fclose(file);
+    return parse(text);
+}
+
+bool StreamFixture::save(const std::string &path) const
+{
+    FILE *file = openFile(path, "wb");
+    if (!file)
+        return false;
+
+    std::string text = serialize();
+    bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    return (std::fclose(file) == 0) && ok;
+}
+
+StreamRecorder::StreamRecorder(const std::string &apiType, bool streaming)
+{
+    _fixture.apiType = apiType;
+    _fixture.streaming = streaming;
+    restart();
+}
+
+void StreamRecorder::restart()
+{
+    _fixture.chunks.clear();
+    _fixture.httpStatus = 0;
+    _fixture.curlCode = 0;
+    _last = std::chrono::steady_clock::now();
+}
+
+void StreamRecorder::record(const char *data, size_t size)
+{
+    auto now = std::chrono::steady_clock::now();
+    StreamFixture::Chunk chunk;
+    chunk.delayUs = std::chrono::duration_cast<std::chrono::microseconds>(now - _last).count();
+    chunk.data.assign(data, size);
+    _fixture.chunks.push_back(std::move(chunk));
+    _last = now;
+}
+
+void StreamRecorder::finish(long httpStatus, int curlCode)
+{
+    _fixture.httpStatus = httpStatus;
+    _fixture.curlCode = curlCode;
+}
+
+std::string StreamRecorder::saveTo(const std::string &directory) const
+{
+    // <api type>-<milliseconds since epoch>-<sequence>.fixture keeps names unique and sortable
+    static std::atomic<int> sequence(0);
+    long long stamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::system_clock::now().time_since_epoch())
+                          .count();
+
+    std::string path = directory;
+    if (!path.empty() && path.back() != '/' && path.back() != '\\')
+        path += '/';
+    path += (_fixture.apiType.empty() ? std::string("response") : _fixture.apiType) + "-" +
+            std::to_string(stamp) + "-" + std::to_string(++sequence) + ".fixture";
+    return _fixture.save(path) ? path : std::string();
+}
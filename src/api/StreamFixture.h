@@ -0,0 +1,88 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * StreamFixture - Raw bytes of one HTTP response body with their arrival times
+ *
+ * Recorded from real provider responses (capture_dir setting, or the CLI's
+ * --capture-dir) and fed back through HTTPClient's callbacks by
+ * HTTPClient::replay, so parsers can be checked for correctness and throughput
+ * without network access.
+ *
+ * File format (text header, length-prefixed binary chunks):
+ *
+ *   NPPOPENAI-FIXTURE 1
+ *   api_type: openai
+ *   streaming: 1
+ *   http_status: 200
+ *   curl_code: 0
+ *
+ *   +1532 57
+ *   <57 raw bytes>
+ *   +12 120
+ *   <120 raw bytes>
+ *
+ * Each chunk line is "+<microseconds since the previous chunk> <byte count>";
+ * the first chunk's delay is measured from the start of the request (TTFB).
+ * The raw bytes are followed by a newline that is not part of the data.
+ */
+struct StreamFixture
+{
+    struct Chunk
+    {
+        int64_t delayUs = 0; // Time since the previous chunk (or the request start)
+        std::string data;    // Bytes as handed to the cURL write callback
+    };
+
+    std::string apiType;    // Response type the body is in (openai, claude, ollama, simple)
+    bool streaming = true;  // Recorded from a streaming request
+    long httpStatus = 0;    // HTTP status of the response
+    int curlCode = 0;       // CURLcode the transfer ended with (non-zero: broken stream)
+    std::vector<Chunk> chunks;
+
+    // Total body size in bytes
+    size_t totalBytes() const;
+
+    // Duration of the recorded transfer in microseconds
+    int64_t durationUs() const;
+
+    // Text form as described above
+    std::string serialize() const;
+
+    // Parse the text form; false if it is not a fixture
+    bool parse(const std::string &text);
+
+    // Read or write a fixture file (UTF-8 path)
+    bool load(const std::string &path);
+    bool save(const std::string &path) const;
+};
+
+/**
+ * StreamRecorder - Collects a StreamFixture while a response arrives
+ */
+class StreamRecorder
+{
+public:
+    StreamRecorder(const std::string &apiType, bool streaming);
+
+    // Start over for a new attempt; delays are measured from now
+    void restart();
+
+    // Append bytes received by a write callback
+    void record(const char *data, size_t size);
+
+    // Complete the fixture with the transfer's outcome
+    void finish(long httpStatus, int curlCode);
+
+    const StreamFixture &fixture() const { return _fixture; }
+
+    // Save to a new file in 'directory' (UTF-8); returns the file path, or empty on failure
+    std::string saveTo(const std::string &directory) const;
+
+private:
+    StreamFixture _fixture;
+    std::chrono::steady_clock::time_point _last;
+};
@@ -1,7 +1,9 @@
 #include "StreamParser.h"
 #include <sstream>
 #include <fstream>
-#include "core/external_globals.h"
+
+// Debug switch of the front-end (the plugin's "Toggle Debug Mode", off in the command-line client)
+extern bool debugMode;
 
 /**
  * Extract content from a streaming chunk based on API type
@@ -59,8 +61,15 @@ std::string StreamParser::extractContent(const std::string &chunk, const std::st
             }
         }
 
-        // Try Ollama format
-        if (j.contains("response"))
+        // Try Realtime API format (text deltas of the WebSocket session)
+        if (j.contains("type") && (j["type"] == "response.text.delta" || j["type"] == "response.output_text.delta") &&
+            j.contains("delta") && j["delta"].is_string())
+        {
+            return j["delta"].get<std::string>();
+        }
+
+        // Try Ollama format (the Realtime API's response events carry a "response" object instead)
+        if (j.contains("response") && j["response"].is_string())
         {
             std::string extracted = j["response"].get<std::string>();
             if (debugMode)
@@ -121,7 +130,7 @@ std::string StreamParser::extractContent(const std::string &chunk, const std::st
         }
         // Not valid JSON, continue with type-specific parsing
     } // Type-specific parsing as fallback
-    if (apiType == "openai")
+    if (apiType == "openai" || apiType == "llamacpp")
     {
         std::string result = parseOpenAIChunk(chunk);
         if (debugMode)
@@ -208,6 +217,169 @@ bool StreamParser::isCompletionMarker(const std::string &chunk)
             chunk.find("data: [DONE]") == 0);
 }
 
+/**
+ * Get the payload of a single line of a streamed response body
+ *
+ * Handles both framings used by the supported APIs:
+ * - Server-Sent Events (OpenAI, Claude): "data: {...}" carries the payload,
+ *   "event:", "id:", "retry:" and ":" comment lines are metadata
+ * - NDJSON (Ollama): every line is a JSON object
+ *
+ * @param line One line of the response body, with or without a trailing '\r'
+ * @return The payload, or an empty string if the line carries no content
+ */
+std::string StreamParser::extractLinePayload(const std::string &line)
+{
+    size_t end = line.find_last_not_of(" \t\r");
+    if (end == std::string::npos)
+    {
+        return ""; // Blank line (SSE event separator)
+    }
+    std::string trimmed = line.substr(0, end + 1);
+
+    if (trimmed[0] == ':' || trimmed.compare(0, 6, "event:") == 0 ||
+        trimmed.compare(0, 3, "id:") == 0 || trimmed.compare(0, 6, "retry:") == 0)
+    {
+        return "";
+    }
+
+    if (trimmed.compare(0, 5, "data:") == 0)
+    {
+        size_t start = trimmed.find_first_not_of(" \t", 5);
+        if (start == std::string::npos)
+        {
+            return "";
+        }
+        trimmed = trimmed.substr(start);
+    }
+
+    if (trimmed == "[DONE]")
+    {
+        return "";
+    }
+
+    return trimmed;
+}
+
+namespace
+{
+    // String member of a JSON object (empty if it is missing or not a string)
+    std::string stringMember(const json &object, const char *key)
+    {
+        auto it = object.find(key);
+        return (it != object.end() && it->is_string()) ? it->get<std::string>() : std::string();
+    }
+}
+
+/**
+ * Parse a Chat Completions stream payload: {"choices":[{"delta":{"content":"..."}}]}
+ */
+std::string StreamParser::parseOpenAIPayload(const std::string &payload)
+{
+    json j = json::parse(payload, nullptr, false);
+    auto choices = j.find("choices");
+    if (choices == j.end() || !choices->is_array() || choices->empty())
+    {
+        return ""; // Usage chunk or not JSON
+    }
+    auto delta = (*choices)[0].find("delta");
+    return (delta != (*choices)[0].end()) ? stringMember(*delta, "content") : "";
+}
+
+/**
+ * Parse a Responses API or Realtime API event: {"type":"response.output_text.delta","delta":"..."}
+ *
+ * The other events (response.created, response.completed, ...) carry the whole
+ * response object and are skipped without being parsed.
+ */
+std::string StreamParser::parseResponsesPayload(const std::string &payload)
+{
+    if (payload.find("text.delta") == std::string::npos)
+    {
+        return "";
+    }
+    json j = json::parse(payload, nullptr, false);
+    std::string type = stringMember(j, "type");
+    if (type != "response.output_text.delta" && type != "response.text.delta")
+    {
+        return "";
+    }
+    return stringMember(j, "delta");
+}
+
+/**
+ * Parse a Gemini streamGenerateContent payload: {"candidates":[{"content":{"parts":[{"text":"..."}]}}]}
+ *
+ * Thought summaries (parts with "thought": true) are left out like hidden reasoning.
+ */
+std::string StreamParser::parseGeminiPayload(const std::string &payload)
+{
+    json j = json::parse(payload, nullptr, false);
+    auto candidates = j.find("candidates");
+    if (candidates == j.end() || !candidates->is_array() || candidates->empty())
+    {
+        return "";
+    }
+    auto content = (*candidates)[0].find("content");
+    if (content == (*candidates)[0].end())
+    {
+        return "";
+    }
+    auto parts = content->find("parts");
+    if (parts == content->end() || !parts->is_array())
+    {
+        return "";
+    }
+
+    std::string text;
+    for (const json &part : *parts)
+    {
+        auto thought = part.find("thought");
+        if (thought != part.end() && thought->is_boolean() && thought->get<bool>())
+        {
+            continue;
+        }
+        text += stringMember(part, "text");
+    }
+    return text;
+}
+
+/**
+ * Parse an Ollama NDJSON line: {"response":"..."} from /api/generate, {"message":{"content":"..."}} from /api/chat
+ */
+std::string StreamParser::parseOllamaPayload(const std::string &payload)
+{
+    json j = json::parse(payload, nullptr, false);
+    std::string text = stringMember(j, "response");
+    if (text.empty())
+    {
+        auto message = j.find("message");
+        if (message != j.end())
+        {
+            text = stringMember(*message, "content");
+        }
+    }
+    return text;
+}
+
+/**
+ * Parse a Claude event: {"type":"content_block_delta","delta":{"text":"..."}}
+ */
+std::string StreamParser::parseClaudePayload(const std::string &payload)
+{
+    if (payload.find("content_block_delta") == std::string::npos)
+    {
+        return "";
+    }
+    json j = json::parse(payload, nullptr, false);
+    auto delta = j.find("delta");
+    if (stringMember(j, "type") != "content_block_delta" || delta == j.end())
+    {
+        return "";
+    }
+    return stringMember(*delta, "text");
+}
+
 /**
  * Parse a streaming chunk from OpenAI
  *
@@ -9,13 +9,20 @@ using json = nlohmann::json;
  * StreamParser - A module for handling streaming responses from different LLM APIs
  *
  * This namespace contains functions for parsing different streaming formats
- * from various LLM providers like OpenAI, Claude, and Ollama. It handles
+ * from various LLM providers like OpenAI, Claude, Gemini, and Ollama. It handles
  * the extraction of content from streaming chunks and detection of
  * stream completion markers.
  */
 namespace StreamParser
 {
-    // Function to extract content from streaming chunks based on API type
+    // Payload parsers of the response types (see ProviderTraits; return an empty string for payloads without content)
+    std::string parseOpenAIPayload(const std::string &payload);    // openai, llamacpp: choices[0].delta.content
+    std::string parseResponsesPayload(const std::string &payload); // openai-responses and the Realtime API: text delta events
+    std::string parseGeminiPayload(const std::string &payload);    // gemini: candidates[0].content.parts[].text
+    std::string parseOllamaPayload(const std::string &payload);    // ollama: response (/api/generate) or message.content (/api/chat)
+    std::string parseClaudePayload(const std::string &payload);    // claude: content_block_delta events
+
+    // Function to extract content from streaming chunks based on API type (detects the format; used for unknown types)
     std::string extractContent(const std::string &chunk, const std::string &apiType);
 
     // Specific parsers for each API type
@@ -25,4 +32,7 @@ namespace StreamParser
 
     // Helper function to check if chunk is a completion marker
     bool isCompletionMarker(const std::string &chunk);
+
+    // Get the JSON/text payload of one SSE or NDJSON line (empty for metadata and [DONE] lines)
+    std::string extractLinePayload(const std::string &line);
 }
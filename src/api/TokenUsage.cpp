@@ -0,0 +1,123 @@
+/**
+ * TokenUsage.cpp - Usage parsing for the OpenAI, Claude, Gemini and Ollama response formats
+ */
+
+#include "TokenUsage.h"
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace
+{
+    int64_t number(const json &object, const char *key, int64_t fallback)
+    {
+        auto it = object.find(key);
+        return (it != object.end() && it->is_number_integer()) ? it->get<int64_t>() : fallback;
+    }
+}
+
+void TokenUsage::update(const std::string &payload)
+{
+    // Most stream lines carry only content; parse just the ones that can report usage
+    if (payload.find("usage") == std::string::npos && payload.find("eval_count") == std::string::npos &&
+        payload.find("timings") == std::string::npos)
+    {
+        return;
+    }
+
+    json body = json::parse(payload, nullptr, false);
+    if (!body.is_object())
+    {
+        return;
+    }
+
+    // llama-server: timings of the slot (cache_n = prompt tokens reused from its KV cache)
+    if (body.contains("timings") && body["timings"].is_object())
+    {
+        const json &timings = body["timings"];
+        auto it = timings.find("prompt_ms");
+        if (it != timings.end() && it->is_number())
+            serverPromptMs = it->get<double>();
+        it = timings.find("predicted_per_second");
+        if (it != timings.end() && it->is_number())
+            tokensPerSecond = it->get<double>();
+        int64_t cached = number(timings, "cache_n", -1);
+        if (cached >= 0)
+        {
+            cachedTokens = cached;
+            promptTokens = number(timings, "prompt_n", 0) + cached;
+        }
+        completionTokens = number(timings, "predicted_n", completionTokens);
+    }
+
+    // Ollama: counts on the done line
+    if (body.contains("prompt_eval_count") || body.contains("eval_count"))
+    {
+        promptTokens = number(body, "prompt_eval_count", promptTokens);
+        completionTokens = number(body, "eval_count", completionTokens);
+        return;
+    }
+
+    // Gemini: usageMetadata on the response and on every stream chunk (the counts so far)
+    if (body.contains("usageMetadata") && body["usageMetadata"].is_object())
+    {
+        const json &metadata = body["usageMetadata"];
+        promptTokens = number(metadata, "promptTokenCount", promptTokens);
+        cachedTokens = number(metadata, "cachedContentTokenCount", cachedTokens);
+        completionTokens = number(metadata, "candidatesTokenCount", completionTokens);
+        return;
+    }
+
+    // Claude's message_start wraps the message (and its usage) in "message", the Realtime API's response.done and the
+    // Responses API's response.completed in "response"
+    const json *usage = nullptr;
+    if (body.contains("usage") && body["usage"].is_object())
+    {
+        usage = &body["usage"];
+    }
+    else if (body.contains("response") && body["response"].is_object() &&
+             body["response"].contains("usage") && body["response"]["usage"].is_object())
+    {
+        usage = &body["response"]["usage"];
+    }
+    else if (body.contains("message") && body["message"].is_object() &&
+             body["message"].contains("usage") && body["message"]["usage"].is_object())
+    {
+        usage = &body["message"]["usage"];
+    }
+    if (!usage)
+    {
+        return;
+    }
+
+    if (usage->contains("prompt_tokens"))
+    {
+        // OpenAI
+        promptTokens = number(*usage, "prompt_tokens", promptTokens);
+        completionTokens = number(*usage, "completion_tokens", completionTokens);
+        if (usage->contains("prompt_tokens_details") && (*usage)["prompt_tokens_details"].is_object())
+        {
+            cachedTokens = number((*usage)["prompt_tokens_details"], "cached_tokens", cachedTokens);
+        }
+        return;
+    }
+
+    // Realtime API (input_token_details) and Responses API (input_tokens_details): input_tokens includes the cached part
+    const char *details = usage->contains("input_tokens_details") ? "input_tokens_details" : "input_token_details";
+    if (usage->contains(details) && (*usage)[details].is_object())
+    {
+        promptTokens = number(*usage, "input_tokens", promptTokens);
+        cachedTokens = number((*usage)[details], "cached_tokens", 0);
+        completionTokens = number(*usage, "output_tokens", completionTokens);
+        return;
+    }
+
+    // Claude: message_delta usually only updates output_tokens, so keep what message_start reported
+    if (usage->contains("input_tokens"))
+    {
+        cachedTokens = number(*usage, "cache_read_input_tokens", 0);
+        cacheWriteTokens = number(*usage, "cache_creation_input_tokens", 0);
+        promptTokens = number(*usage, "input_tokens", 0) + cachedTokens + cacheWriteTokens;
+    }
+    completionTokens = number(*usage, "output_tokens", completionTokens);
+}
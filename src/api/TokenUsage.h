@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/**
+ * TokenUsage - Token counts a provider reports for one request, including prompt caching
+ *
+ * Providers report usage in different places: OpenAI in "usage" (cached
+ * prefix tokens in prompt_tokens_details.cached_tokens), Claude in "usage" of
+ * the response or of the message_start/message_delta events (with
+ * cache_read_input_tokens and cache_creation_input_tokens), the Realtime API
+ * in the response of its response.done event (the Responses API likewise in
+ * response.completed), Gemini in "usageMetadata" (cachedContentTokenCount for
+ * the cached part), Ollama as prompt_eval_count/eval_count on the done line,
+ * llama-server additionally in "timings" (with the server's own prompt
+ * processing time and generation speed). update() merges whatever a payload
+ * carries, so the stream events can be fed one by one.
+ *
+ * promptTokens is the whole prompt, cached part included (Claude's
+ * input_tokens only counts the part after the last cache breakpoint).
+ */
+struct TokenUsage
+{
+    int64_t promptTokens = -1;     // Prompt tokens (-1 = not reported)
+    int64_t cachedTokens = 0;      // ... of which were read from the provider's prompt cache
+    int64_t cacheWriteTokens = 0;  // ... of which were written to the cache (Claude)
+    int64_t completionTokens = -1; // Generated tokens (-1 = not reported)
+    double serverPromptMs = -1;    // Server-side prompt processing time (llama-server timings.prompt_ms)
+    double tokensPerSecond = -1;   // Server-side generation speed (llama-server timings.predicted_per_second)
+
+    bool known() const { return promptTokens >= 0 || completionTokens >= 0; }
+
+    // Merge the usage a response body or stream payload reports (no-op if it has none)
+    void update(const std::string &payload);
+};
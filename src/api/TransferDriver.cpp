@@ -0,0 +1,162 @@
+/**
+ * TransferDriver.cpp - Shared multi handle for all requests, so concurrent transfers multiplex
+ */
+
+#include "TransferDriver.h"
+#include <curl/curl.h>
+
+namespace
+{
+    // Poll interval while a transfer has a tick (resume and cancel latency) and while none has
+    const int kTickPollMs = 10;
+    const int kIdlePollMs = 1000;
+}
+
+TransferDriver &TransferDriver::instance()
+{
+    static TransferDriver driver;
+    return driver;
+}
+
+TransferDriver::~TransferDriver()
+{
+    shutdown();
+}
+
+/**
+ * Add a transfer to the shared multi handle (starting the driver thread if needed)
+ *
+ * @param curl The configured easy handle; it must stay untouched until the future is ready
+ * @param tick Optional check run on the driver thread between iterations
+ * @return The transfer's CURLcode, once curl has finished it or the tick stopped it
+ */
+std::future<int> TransferDriver::start(void *curl, const Tick &tick)
+{
+    std::shared_ptr<Transfer> transfer = std::make_shared<Transfer>();
+    transfer->curl = curl;
+    transfer->tick = tick;
+    std::future<int> done = transfer->done.get_future();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_multi)
+    {
+        _multi = curl_multi_init();
+        if (!_multi)
+        {
+            transfer->done.set_value(static_cast<int>(curl_easy_perform(static_cast<CURL *>(curl))));
+            return done;
+        }
+        _stopping = false;
+        _thread = std::thread(&TransferDriver::run, this);
+    }
+    _added.push_back(transfer);
+    curl_multi_wakeup(static_cast<CURLM *>(_multi));
+    return done;
+}
+
+void TransferDriver::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_multi)
+        {
+            return;
+        }
+        _stopping = true;
+        curl_multi_wakeup(static_cast<CURLM *>(_multi));
+    }
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    curl_multi_cleanup(static_cast<CURLM *>(_multi));
+    _multi = nullptr;
+}
+
+/**
+ * The driver thread: runs the multi handle until shutdown
+ */
+void TransferDriver::run()
+{
+    CURLM *multi = static_cast<CURLM *>(_multi);
+    for (;;)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (std::shared_ptr<Transfer> &transfer : _added)
+            {
+                if (_stopping || curl_multi_add_handle(multi, transfer->curl) != CURLM_OK)
+                {
+                    transfer->done.set_value(CURLE_ABORTED_BY_CALLBACK);
+                    continue;
+                }
+                _running[transfer->curl] = transfer;
+            }
+            _added.clear();
+            if (_stopping)
+            {
+                break;
+            }
+        }
+
+        int stillRunning = 0;
+        curl_multi_perform(multi, &stillRunning);
+        int queued = 0;
+        while (CURLMsg *message = curl_multi_info_read(multi, &queued))
+        {
+            if (message->msg == CURLMSG_DONE)
+            {
+                finish(message->easy_handle, message->data.result);
+            }
+        }
+
+        // A tick may stop its transfer, which removes it from the map
+        bool ticking = false;
+        std::vector<std::shared_ptr<Transfer>> running;
+        for (auto &entry : _running)
+        {
+            running.push_back(entry.second);
+        }
+        for (std::shared_ptr<Transfer> &transfer : running)
+        {
+            if (!transfer->tick)
+            {
+                continue;
+            }
+            if (!transfer->tick())
+            {
+                finish(transfer->curl, CURLE_ABORTED_BY_CALLBACK);
+                continue;
+            }
+            ticking = true;
+        }
+
+        curl_multi_poll(multi, nullptr, 0, ticking ? kTickPollMs : kIdlePollMs, nullptr);
+    }
+
+    while (!_running.empty())
+    {
+        finish(_running.begin()->first, CURLE_ABORTED_BY_CALLBACK);
+    }
+}
+
+/**
+ * Remove a transfer from the multi handle and hand its result to the waiting request
+ *
+ * @param curl The easy handle
+ * @param result Its CURLcode
+ */
+void TransferDriver::finish(void *curl, int result)
+{
+    auto found = _running.find(curl);
+    if (found == _running.end())
+    {
+        return;
+    }
+    std::shared_ptr<Transfer> transfer = found->second;
+    _running.erase(found);
+    curl_multi_remove_handle(static_cast<CURLM *>(_multi), curl);
+    transfer->done.set_value(result);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * TransferDriver - One multi handle that drives the transfers of all requests
+ *
+ * curl_easy_perform runs each transfer on a multi handle of its own, so two
+ * asks in flight at the same time cannot share a connection: the second opens
+ * one of its own even to an HTTP/2 server. Here every transfer is added to a
+ * single multi handle run by one worker thread. With CURLOPT_PIPEWAIT a
+ * transfer that starts while another one to the same host is connecting waits
+ * for that connection and, over HTTP/2, becomes one more stream on it.
+ *
+ * Callbacks of all transfers run on the driver thread, so they must not block
+ * (streamed text goes through a StreamBuffer; see HTTPClient). Work that has to
+ * happen on the thread owning the handles - resuming a paused transfer,
+ * stopping a cancelled one - goes into the transfer's tick.
+ *
+ * Thread-safe; start() may be called from any thread.
+ */
+class TransferDriver
+{
+public:
+    // Called on the driver thread between iterations while the transfer runs; false stops it (CURLE_ABORTED_BY_CALLBACK)
+    using Tick = std::function<bool()>;
+
+    static TransferDriver &instance();
+
+    // Add a configured easy handle; the future gets its CURLcode once it is done and removed again
+    std::future<int> start(void *curl, const Tick &tick = Tick());
+
+    // Stop the driver thread, aborting running transfers (HTTPClient::shutdown); the next start() restarts it
+    void shutdown();
+
+private:
+    struct Transfer
+    {
+        void *curl = nullptr;
+        Tick tick;
+        std::promise<int> done;
+    };
+
+    TransferDriver() = default;
+    ~TransferDriver();
+    TransferDriver(const TransferDriver &) = delete;
+    TransferDriver &operator=(const TransferDriver &) = delete;
+
+    void run();
+    void finish(void *curl, int result);
+
+    std::mutex _mutex;
+    void *_multi = nullptr;
+    std::thread _thread;
+    bool _stopping = false;
+    std::vector<std::shared_ptr<Transfer>> _added;        // Waiting to be added to the multi handle
+    std::map<void *, std::shared_ptr<Transfer>> _running; // On the multi handle (driver thread only)
+};
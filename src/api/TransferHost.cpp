@@ -0,0 +1,21 @@
+/**
+ * TransferHost.cpp - Default (headless) front-end for requests
+ */
+
+#include "TransferHost.h"
+
+namespace
+{
+    TransferHost g_defaultHost;
+    TransferHost *g_host = &g_defaultHost;
+}
+
+TransferHost &TransferHost::current()
+{
+    return *g_host;
+}
+
+void TransferHost::install(TransferHost *host)
+{
+    g_host = host ? host : &g_defaultHost;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+
+/**
+ * TransferHost - Front-end services used while a request is running
+ *
+ * HTTPClient and ChatPipeline do not know whether they run inside Notepad++ or
+ * in a console program. Everything that touches the user interface goes through
+ * the installed host: keeping the UI responsive during blocking waits,
+ * cancellation, status messages and the destination of streamed text. The
+ * default host does nothing and never cancels, so the transport can run headless.
+ */
+class TransferHost
+{
+public:
+    virtual ~TransferHost() = default;
+
+    // Called on the requesting thread about every 10 ms while it waits (UI message pump)
+    virtual void idle() {}
+
+    // True once the user asked to stop the request
+    virtual bool isCancelled() const { return false; }
+
+    // Show a progress message (retries, failover, rate limiting)
+    virtual void showStatus(const std::wstring &message) { (void)message; }
+
+    // Show a diagnostic message (only shown in debug mode)
+    virtual void showDebugStatus(const std::wstring &message) { (void)message; }
+
+    // Output streamed text (UTF-8). Called on the requesting thread between idle() calls; on the transfer's worker
+    // thread for Realtime sessions and replays, on the TransferDriver thread with stream_buffer_kb=0. Returns false if it was dropped.
+    virtual bool deliverContent(const std::string &content) { (void)content; return false; }
+
+    // A streaming request starts / ends (e.g. to group the inserted text into one undo step)
+    virtual void beginStream() {}
+    virtual void endStream() {}
+
+    // The first streamed text of the answer follows; 'responseType' is that of the endpoint that sends it,
+    // which after a failover or a won hedge is not the first endpoint tried. Called on the thread that
+    // parses the stream, before the text reaches deliverContent.
+    virtual void beginAnswer(const std::string &responseType) { (void)responseType; }
+
+    // Host used by new requests (never null)
+    static TransferHost &current();
+
+    // Replace the host; null restores the default one. Not thread-safe: install before sending requests.
+    static void install(TransferHost *host);
+};
@@ -0,0 +1,449 @@
+/**
+ * WebSocket.cpp - Upgrade handshake and RFC 6455 framing over a cURL connection
+ */
+
+#include "WebSocket.h"
+#include <curl/curl.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib") // select()
+#endif
+
+namespace
+{
+    const size_t kMaxMessageBytes = 64 * 1024 * 1024; // Larger frames are treated as a protocol violation
+    const int kSendTimeoutMs = 30000;
+
+    enum Opcode
+    {
+        kContinuation = 0x0,
+        kText = 0x1,
+        kBinary = 0x2,
+        kClose = 0x8,
+        kPing = 0x9,
+        kPong = 0xA
+    };
+
+    std::string base64(const unsigned char *data, size_t size)
+    {
+        static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string encoded;
+        for (size_t i = 0; i < size; i += 3)
+        {
+            uint32_t block = static_cast<uint32_t>(data[i]) << 16;
+            if (i + 1 < size)
+                block |= static_cast<uint32_t>(data[i + 1]) << 8;
+            if (i + 2 < size)
+                block |= data[i + 2];
+            encoded += alphabet[(block >> 18) & 0x3F];
+            encoded += alphabet[(block >> 12) & 0x3F];
+            encoded += (i + 1 < size) ? alphabet[(block >> 6) & 0x3F] : '=';
+            encoded += (i + 2 < size) ? alphabet[block & 0x3F] : '=';
+        }
+        return encoded;
+    }
+
+    std::string lowercase(std::string text)
+    {
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+        return text;
+    }
+}
+
+WebSocket::~WebSocket()
+{
+    drop();
+}
+
+/**
+ * Connect and perform the HTTP/1.1 upgrade handshake
+ *
+ * cURL connects to the http(s) equivalent of the URL with CONNECT_ONLY (through
+ * a CONNECT tunnel when a proxy is set), then the upgrade request is written
+ * on the raw connection. Frames the server sends right after the 101 response
+ * stay buffered for read().
+ *
+ * @param url ws:// or wss:// URL
+ * @param headers Additional request header lines (authentication)
+ * @param proxy Proxy server (empty or "0" for none)
+ * @param connectTimeoutMs Limit for connecting and for the handshake (0 = 30 s)
+ * @param error Receives the reason of a failure
+ * @param httpStatus Receives the status of a rejected upgrade (0 if no response arrived)
+ * @return true if the connection was upgraded
+ */
+bool WebSocket::open(const std::string &url, const std::vector<std::string> &headers, const std::string &proxy, long connectTimeoutMs,
+                     std::string &error, long &httpStatus)
+{
+    drop();
+    httpStatus = 0;
+
+    size_t schemeEnd = url.find("://");
+    if (schemeEnd == std::string::npos)
+    {
+        error = "invalid WebSocket URL: " + url;
+        return false;
+    }
+    std::string scheme = lowercase(url.substr(0, schemeEnd));
+    std::string httpScheme = (scheme == "wss" || scheme == "https") ? "https" : "http";
+    size_t pathStart = url.find('/', schemeEnd + 3);
+    std::string host = url.substr(schemeEnd + 3, pathStart == std::string::npos ? std::string::npos : pathStart - schemeEnd - 3);
+    std::string path = (pathStart == std::string::npos) ? "/" : url.substr(pathStart);
+
+    CURL *curl = curl_easy_init();
+    if (!curl)
+    {
+        error = "cURL initialization failed";
+        return false;
+    }
+    long timeoutMs = connectTimeoutMs > 0 ? connectTimeoutMs : 30000;
+    std::string connectUrl = httpScheme + "://" + host + "/";
+    curl_easy_setopt(curl, CURLOPT_URL, connectUrl.c_str());
+    curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, timeoutMs);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    if (!proxy.empty() && proxy != "0")
+    {
+        curl_easy_setopt(curl, CURLOPT_PROXY, proxy.c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPPROXYTUNNEL, 1L);
+    }
+    CURLcode res = curl_easy_perform(curl);
+    if (res != CURLE_OK)
+    {
+        error = curl_easy_strerror(res);
+        curl_easy_cleanup(curl);
+        return false;
+    }
+    _curl = curl;
+
+    unsigned char nonce[16];
+    for (unsigned char &byte : nonce)
+    {
+        byte = static_cast<unsigned char>(_random() & 0xFF);
+    }
+    std::string upgrade = "GET " + path + " HTTP/1.1\r\n"
+                          "Host: " + host + "\r\n"
+                          "Upgrade: websocket\r\n"
+                          "Connection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: " + base64(nonce, sizeof(nonce)) + "\r\n"
+                          "Sec-WebSocket-Version: 13\r\n";
+    for (const std::string &header : headers)
+    {
+        upgrade += header + "\r\n";
+    }
+    upgrade += "\r\n";
+    if (!sendAll(upgrade))
+    {
+        error = "connection lost during the WebSocket handshake";
+        drop();
+        return false;
+    }
+
+    // Response headers; anything after them already belongs to the WebSocket stream
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    size_t headerEnd;
+    while ((headerEnd = _received.find("\r\n\r\n")) == std::string::npos)
+    {
+        if (!receiveMore(deadline))
+        {
+            error = isOpen() ? "no WebSocket handshake response" : "connection closed during the WebSocket handshake";
+            drop();
+            return false;
+        }
+    }
+    std::string response = _received.substr(0, headerEnd);
+    _received.erase(0, headerEnd + 4);
+
+    std::string statusLine = response.substr(0, response.find("\r\n"));
+    size_t statusStart = statusLine.find(' ');
+    if (statusStart != std::string::npos)
+    {
+        httpStatus = std::strtol(statusLine.c_str() + statusStart + 1, nullptr, 10);
+    }
+    std::string lowered = lowercase(response);
+    if (httpStatus != 101 || lowered.find("\r\nupgrade: websocket") == std::string::npos)
+    {
+        error = "WebSocket upgrade rejected: " + statusLine;
+        drop();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Send one text message as a single masked frame
+ *
+ * @param text UTF-8 message
+ * @return false if the connection broke
+ */
+bool WebSocket::sendText(const std::string &text)
+{
+    return sendFrame(kText, text);
+}
+
+/**
+ * Receive the next complete message
+ *
+ * Control frames are handled on the way: pings are answered with pongs,
+ * pongs ignored, and a close frame is answered and closes the connection.
+ *
+ * @param message Receives the message
+ * @param timeoutMs How long to wait (0 = only parse what has already arrived)
+ * @return Message, Timeout, or Closed once the connection is gone
+ */
+WebSocket::ReadResult WebSocket::read(std::string &message, int timeoutMs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (isOpen())
+    {
+        // Frame header: FIN/opcode, mask bit/length, extended length, masking key
+        size_t headerSize = 2;
+        uint64_t length = 0;
+        bool complete = false;
+        if (_received.size() >= 2)
+        {
+            length = static_cast<unsigned char>(_received[1]) & 0x7F;
+            size_t extended = (length == 126) ? 2 : (length == 127) ? 8 : 0;
+            bool masked = (static_cast<unsigned char>(_received[1]) & 0x80) != 0;
+            headerSize += extended + (masked ? 4 : 0);
+            if (_received.size() >= headerSize)
+            {
+                if (extended)
+                {
+                    length = 0;
+                    for (size_t i = 0; i < extended; ++i)
+                    {
+                        length = (length << 8) | static_cast<unsigned char>(_received[2 + i]);
+                    }
+                }
+                if (length > kMaxMessageBytes || _fragments.size() + length > kMaxMessageBytes)
+                {
+                    drop();
+                    return ReadResult::Closed;
+                }
+                complete = (_received.size() - headerSize >= length);
+            }
+        }
+
+        if (!complete)
+        {
+            if (!receiveMore(deadline))
+            {
+                return isOpen() ? ReadResult::Timeout : ReadResult::Closed;
+            }
+            continue;
+        }
+
+        bool fin = (static_cast<unsigned char>(_received[0]) & 0x80) != 0;
+        int opcode = static_cast<unsigned char>(_received[0]) & 0x0F;
+        std::string payload = _received.substr(headerSize, static_cast<size_t>(length));
+        if (static_cast<unsigned char>(_received[1]) & 0x80)
+        {
+            // Servers must not mask, but unmasking costs nothing
+            const char *mask = _received.data() + headerSize - 4;
+            for (size_t i = 0; i < payload.size(); ++i)
+            {
+                payload[i] = static_cast<char>(payload[i] ^ mask[i % 4]);
+            }
+        }
+        _received.erase(0, headerSize + static_cast<size_t>(length));
+
+        switch (opcode)
+        {
+        case kText:
+        case kBinary:
+        case kContinuation:
+            _fragments += payload;
+            if (fin)
+            {
+                message = std::move(_fragments);
+                _fragments.clear();
+                return ReadResult::Message;
+            }
+            break;
+        case kPing:
+            sendFrame(kPong, payload);
+            break;
+        case kClose:
+            sendFrame(kClose, payload.substr(0, 2));
+            drop();
+            return ReadResult::Closed;
+        default:
+            break; // Pong or unknown control frame
+        }
+    }
+    return ReadResult::Closed;
+}
+
+/**
+ * Close the connection politely (status 1000) and release it
+ */
+void WebSocket::close()
+{
+    if (isOpen())
+    {
+        sendFrame(kClose, std::string("\x03\xE8", 2));
+    }
+    drop();
+}
+
+/**
+ * Send one masked frame
+ *
+ * @param opcode Frame opcode
+ * @param payload Frame payload
+ * @return false if the connection broke (it is dropped then)
+ */
+bool WebSocket::sendFrame(int opcode, const std::string &payload)
+{
+    if (!isOpen())
+    {
+        return false;
+    }
+
+    std::string frame;
+    frame.reserve(payload.size() + 14);
+    frame += static_cast<char>(0x80 | opcode);
+    uint64_t length = payload.size();
+    if (length < 126)
+    {
+        frame += static_cast<char>(0x80 | length);
+    }
+    else if (length <= 0xFFFF)
+    {
+        frame += static_cast<char>(0x80 | 126);
+        frame += static_cast<char>((length >> 8) & 0xFF);
+        frame += static_cast<char>(length & 0xFF);
+    }
+    else
+    {
+        frame += static_cast<char>(0x80 | 127);
+        for (int shift = 56; shift >= 0; shift -= 8)
+        {
+            frame += static_cast<char>((length >> shift) & 0xFF);
+        }
+    }
+
+    char mask[4];
+    for (char &byte : mask)
+    {
+        byte = static_cast<char>(_random() & 0xFF);
+    }
+    frame.append(mask, 4);
+    for (size_t i = 0; i < payload.size(); ++i)
+    {
+        frame += static_cast<char>(payload[i] ^ mask[i % 4]);
+    }
+
+    if (!sendAll(frame))
+    {
+        drop();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Write all of 'data' to the connection, waiting while the socket buffer is full
+ */
+bool WebSocket::sendAll(const std::string &data)
+{
+    size_t offset = 0;
+    while (offset < data.size())
+    {
+        size_t sent = 0;
+        CURLcode res = curl_easy_send(static_cast<CURL *>(_curl), data.data() + offset, data.size() - offset, &sent);
+        if (res == CURLE_AGAIN)
+        {
+            if (!waitForSocket(true, kSendTimeoutMs))
+                return false;
+            continue;
+        }
+        if (res != CURLE_OK)
+            return false;
+        offset += sent;
+    }
+    return true;
+}
+
+/**
+ * Append whatever the connection delivers to the receive buffer
+ *
+ * Reads before waiting: with TLS, decrypted data can be buffered by cURL while
+ * the socket itself has nothing to read.
+ *
+ * @param deadline Give up waiting at this time
+ * @return true if data was received; false on timeout or when the connection closed (it is dropped then)
+ */
+bool WebSocket::receiveMore(std::chrono::steady_clock::time_point deadline)
+{
+    for (;;)
+    {
+        char buffer[16384];
+        size_t received = 0;
+        CURLcode res = curl_easy_recv(static_cast<CURL *>(_curl), buffer, sizeof(buffer), &received);
+        if (res == CURLE_OK)
+        {
+            if (received == 0)
+            {
+                drop();
+                return false;
+            }
+            _received.append(buffer, received);
+            return true;
+        }
+        if (res != CURLE_AGAIN)
+        {
+            drop();
+            return false;
+        }
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0 || !waitForSocket(false, static_cast<int>(remaining)))
+        {
+            return false;
+        }
+    }
+}
+
+/**
+ * Wait until the connection's socket is readable or writable
+ *
+ * @return true if it is, false on timeout or error
+ */
+bool WebSocket::waitForSocket(bool forWrite, int timeoutMs)
+{
+    curl_socket_t socket = CURL_SOCKET_BAD;
+    if (curl_easy_getinfo(static_cast<CURL *>(_curl), CURLINFO_ACTIVESOCKET, &socket) != CURLE_OK || socket == CURL_SOCKET_BAD)
+    {
+        return false;
+    }
+
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(socket, &set);
+    timeval timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+    int ready = select(static_cast<int>(socket) + 1, forWrite ? nullptr : &set, forWrite ? &set : nullptr, nullptr, &timeout);
+    return ready > 0;
+}
+
+/**
+ * Release the connection without a close frame
+ */
+void WebSocket::drop()
+{
+    if (_curl)
+    {
+        curl_easy_cleanup(static_cast<CURL *>(_curl));
+        _curl = nullptr;
+    }
+    _received.clear();
+    _fragments.clear();
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * WebSocket - Minimal RFC 6455 client over a cURL CONNECT_ONLY connection
+ *
+ * cURL only speaks WebSocket from 7.86 on, and only when built with it (an
+ * experimental feature until 8.11). Here cURL opens the connection - proxy
+ * tunnel and TLS included, with the same options as the HTTP requests - and
+ * this class does the upgrade handshake and the framing itself on top of
+ * curl_easy_send/curl_easy_recv, so any cURL build works.
+ *
+ * Text messages only: frames are masked as RFC 6455 requires from clients,
+ * fragmented messages are reassembled, pings are answered, and a close frame
+ * from the server closes the connection. Sec-WebSocket-Accept is not verified
+ * (the connection is authenticated by TLS and the API key, not the handshake).
+ *
+ * Not thread-safe; one thread at a time (see RealtimeSession).
+ */
+class WebSocket
+{
+public:
+    enum class ReadResult
+    {
+        Message, // A complete message was received
+        Timeout, // Nothing complete arrived in time; the connection is still open
+        Closed   // The connection was closed (by the server, a network error or a protocol violation)
+    };
+
+    WebSocket() = default;
+    ~WebSocket();
+    WebSocket(const WebSocket &) = delete;
+    WebSocket &operator=(const WebSocket &) = delete;
+
+    // Connect to a ws:// or wss:// URL and upgrade; 'headers' are complete header lines ("Name: value").
+    // On failure 'error' tells why and 'httpStatus' is the status of a rejected upgrade (0 if none arrived).
+    bool open(const std::string &url, const std::vector<std::string> &headers, const std::string &proxy, long connectTimeoutMs,
+              std::string &error, long &httpStatus);
+
+    // Send one text message; false if the connection broke (it is closed then)
+    bool sendText(const std::string &text);
+
+    // Wait up to 'timeoutMs' for the next message (0 = only take what has already arrived)
+    ReadResult read(std::string &message, int timeoutMs);
+
+    // Send a close frame and drop the connection
+    void close();
+
+    bool isOpen() const { return _curl != nullptr; }
+
+private:
+    bool sendFrame(int opcode, const std::string &payload);
+    bool sendAll(const std::string &data);
+    bool receiveMore(std::chrono::steady_clock::time_point deadline);
+    bool waitForSocket(bool forWrite, int timeoutMs);
+    void drop();
+
+    void *_curl = nullptr;
+    std::string _received; // Bytes received but not yet parsed into frames
+    std::string _fragments; // Message being reassembled from continuation frames
+    std::mt19937 _random{std::random_device{}()};
+};
@@ -13,6 +13,15 @@
 #include "core/external_globals.h" // for global variables and functions
 #include "EncodingUtils.h"         // for UTF-8 conversions
 #include "PromptManager.h"         // for parsing instructions file
+#include "EndpointRouter.h"        // for the failover endpoint list
+#include "HedgePolicy.h"           // for request hedging settings
+#include "ProfileManager.h"        // for named backend profiles
+#include "RequestRouter.h"         // for routing rules
+#include "ConfigSnapshot.h"        // for publishing the parsed configuration
+#include "ModelWarmup.h"           // for loading the Ollama model ahead of the first ask
+#include "Preconnector.h"          // for connecting while a selection is made
+#include "IniFile.h"               // for single-pass INI reading and writing
+#include <climits>
 #include <cstdio>
 #include <vector>
 #include <algorithm> // for std::transform
@@ -25,59 +34,104 @@
  */
 void writeDefaultConfig()
 {
+    // Collect everything in memory and write the file once
+    IniFile ini;
+
     // Basic info header
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; NppOpenAI Configuration File"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; Supports OpenAI, Claude, and Ollama API connections"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; Enter your API key below (OpenAI: sk-xxx, Claude: sk-ant-xxx, Ollama: blank)"), TEXT(""), iniFilePath);
-
-    // API configurations    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; === OpenAI configuration ==="), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; api_url = https://api.openai.com/v1/"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; response_type = openai"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; route_chat_completions = chat/completions  # New naming convention"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; route_realtime_sessions = realtime/sessions  # Future support"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; route_audio_speech = audio/speech  # Future support"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; route_images_generations = images/generations  # Future support"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; model = gpt-4o-mini"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; streaming = 1 (enabled) or 0 (disabled)"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; show_reasoning = 1 (show AI reasoning sections) or 0 (hide reasoning)"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; "), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; === Claude configuration ==="), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; api_url = https://api.anthropic.com/v1/"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; response_type = claude"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; route_chat_completions = messages  # New naming convention"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; model = claude-3-haiku-20240307"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; streaming = 1 (enabled) or 0 (disabled)"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; show_reasoning = 1 (show AI reasoning sections) or 0 (hide reasoning)"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; "), TEXT(""), iniFilePath);
-
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; === Ollama configuration ==="), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; api_url = http://localhost:11434/"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; response_type = ollama"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; route_chat_completions = api/generate  # New naming convention"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; model = qwen3:1.7b"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; streaming = 1 (enabled) or 0 (disabled)"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("INFO"), TEXT("; keep_alive = 5m (keep model in memory for 5 minutes after each request; set to -1 to keep indefinitely, 0 to unload immediately, or use suffixes like 10m for 10 minutes, 24h for 24 hours)"), TEXT(""), iniFilePath);
-    ::WritePrivateProfileString(TEXT("API"), TEXT("secret_key"), TEXT("ENTER_YOUR_API_KEY_HERE"), iniFilePath);
-    ::WritePrivateProfileString(TEXT("API"), TEXT("api_url"), TEXT("https://api.openai.com/v1/"), iniFilePath); // New route naming convention (recommended)
-    ::WritePrivateProfileString(TEXT("API"), TEXT("route_chat_completions"), TEXT("chat/completions"), iniFilePath);
-    ::WritePrivateProfileString(TEXT("API"), TEXT("response_type"), TEXT("openai"), iniFilePath);
-    ::WritePrivateProfileString(TEXT("API"), TEXT("model"), TEXT("gpt-4o-mini"), iniFilePath);
-    ::WritePrivateProfileString(TEXT("API"), TEXT("temperature"), TEXT("0.7"), iniFilePath);
-    ::WritePrivateProfileString(TEXT("API"), TEXT("max_tokens"), TEXT("0"), iniFilePath);
-    ::WritePrivateProfileString(TEXT("API"), TEXT("top_p"), TEXT("0.8"), iniFilePath);
-    ::WritePrivateProfileString(TEXT("API"), TEXT("frequency_penalty"), TEXT("0"), iniFilePath);
-    ::WritePrivateProfileString(TEXT("API"), TEXT("presence_penalty"), TEXT("0"), iniFilePath); // Add streaming option (0=disabled, 1=enabled)
-    ::WritePrivateProfileString(TEXT("API"), TEXT("streaming"), TEXT("1"), iniFilePath);
-    ::WritePrivateProfileString(TEXT("API"), TEXT("keep_alive"), TEXT("5m"), iniFilePath);
+    ini.set(L"INFO", L"; NppOpenAI Configuration File", L"");
+    ini.set(L"INFO", L"; Supports OpenAI, Claude, Gemini, and Ollama API connections", L"");
+    ini.set(L"INFO", L"; Enter your API key below (OpenAI: sk-xxx, Claude: sk-ant-xxx, Gemini: AIza-xxx, Ollama: blank)", L"");
+
+    // API configurations
+    ini.set(L"INFO", L"; === OpenAI configuration ===", L"");
+    ini.set(L"INFO", L"; api_url = https://api.openai.com/v1/", L"");
+    ini.set(L"INFO", L"; response_type = openai", L"");
+    ini.set(L"INFO", L"; route_chat_completions = chat/completions  # New naming convention", L"");
+    ini.set(L"INFO", L"; realtime = 0 (1: send asks over one persistent WebSocket session to the Realtime API at api_url + route_realtime, e.g. model = gpt-4o-mini-realtime-preview; streaming only, falls back to HTTP if the session cannot be opened)", L"");
+    ini.set(L"INFO", L"; route_realtime = realtime, realtime_idle_s = 120 (a session unused for longer is replaced before the next ask; 0 = keep it)", L"");
+    ini.set(L"INFO", L"; route_audio_speech = audio/speech  # Future support", L"");
+    ini.set(L"INFO", L"; route_images_generations = images/generations  # Future support", L"");
+    ini.set(L"INFO", L"; model = gpt-4o-mini", L"");
+    ini.set(L"INFO", L"; streaming = 1 (enabled) or 0 (disabled)", L"");
+    ini.set(L"INFO", L"; stream_transport = 1 (with streaming = 0, still receive the answer as a stream and insert it once complete: time to first token, early errors, partial answer on cancel; 0 = plain request)", L"");
+    ini.set(L"INFO", L"; stream_buffer_kb = 64, stream_resume_kb = 16 (streamed text waiting for a busy editor; the download pauses when the queue reaches stream_buffer_kb and resumes at stream_resume_kb; 0 = no queue)", L"");
+    ini.set(L"INFO", L"; show_reasoning = 1 (show AI reasoning sections) or 0 (hide reasoning)", L"");
+    ini.set(L"INFO", L"; http_version = auto (HTTP/2 via ALPN, falls back to 1.1), 2-prior-knowledge (h2c, e.g. local gateways) or 1.1", L"");
+    ini.set(L"INFO", L"; retry_max_attempts = 3 (retries 429/5xx and dropped connections with exponential backoff; 1 disables retries)", L"");
+    ini.set(L"INFO", L"; endpoints = gw1,gw2,cloud (optional failover list; each name refers to an [Endpoint:name] section with its own api_url, secret_key, response_type, route_chat_completions and model)", L"");
+    ini.set(L"INFO", L"; connect_timeout_ms = 10000 (an endpoint that does not accept the connection in time is skipped for the next one)", L"");
+    ini.set(L"INFO", L"; rate_limit_rpm / rate_limit_tpm = 0 (client-side requests / tokens per minute for a shared key; 0 = follow the provider's rate-limit headers only)", L"");
+    ini.set(L"INFO", L"; [Profile:name] sections = complete alternative backends (api_url, route_chat_completions, response_type, secret_key, model, temperature, ...; unset keys come from [API]); switch with Plugins > NppOpenAI > Switch Profile", L"");
+    ini.set(L"INFO", L"; [Route:name] sections = send requests to a profile by selection size or file type (min_chars, max_chars, extensions=txt,md, profiles=local,mini, prefer=fastest)", L"");
+    ini.set(L"INFO", L"; hedging = 0 (1: if a streaming answer is slower than hedge_percentile of recent ones, send a duplicate and keep the faster; costs extra tokens, capped by hedge_budget_percent)", L"");
+    ini.set(L"INFO", L"; ", L"");
+    ini.set(L"INFO", L"; === Claude configuration ===", L"");
+    ini.set(L"INFO", L"; api_url = https://api.anthropic.com/v1/", L"");
+    ini.set(L"INFO", L"; response_type = claude", L"");
+    ini.set(L"INFO", L"; route_chat_completions = messages  # New naming convention", L"");
+    ini.set(L"INFO", L"; model = claude-3-haiku-20240307", L"");
+    ini.set(L"INFO", L"; streaming = 1 (enabled) or 0 (disabled)", L"");
+    ini.set(L"INFO", L"; show_reasoning = 1 (show AI reasoning sections) or 0 (hide reasoning)", L"");
+    ini.set(L"INFO", L"; ", L"");
+
+    ini.set(L"INFO", L"; === Ollama configuration ===", L"");
+    ini.set(L"INFO", L"; api_url = http://localhost:11434/", L"");
+    ini.set(L"INFO", L"; response_type = ollama", L"");
+    ini.set(L"INFO", L"; route_chat_completions = api/generate  # New naming convention", L"");
+    ini.set(L"INFO", L"; model = qwen3:1.7b", L"");
+    ini.set(L"INFO", L"; streaming = 1 (enabled) or 0 (disabled)", L"");
+    ini.set(L"INFO", L"; keep_alive = 5m (keep model in memory for 5 minutes after each request; set to -1 to keep indefinitely, 0 to unload immediately, or use suffixes like 10m for 10 minutes, 24h for 24 hours)", L"");
+    ini.set(L"INFO", L"; ollama_warmup = 1 (load the model in the background on startup and profile switch, and renew keep_alive while you edit) or 0 (load on the first ask)", L"");
+    ini.set(L"INFO", L"; ", L"");
+    ini.set(L"INFO", L"; === llama.cpp (llama-server) configuration ===", L"");
+    ini.set(L"INFO", L"; api_url = http://localhost:8080/v1/", L"");
+    ini.set(L"INFO", L"; response_type = llamacpp", L"");
+    ini.set(L"INFO", L"; route_chat_completions = chat/completions", L"");
+    ini.set(L"INFO", L"; llamacpp_slots = 1 (number of server slots, llama-server -np; each document keeps its own slot and KV cache; 0 = let the server pick)", L"");
+    ini.set(L"INFO", L"; ", L"");
+    ini.set(L"INFO", L"; === OpenAI Responses API configuration ===", L"");
+    ini.set(L"INFO", L"; response_type = openai-responses (api_url as for OpenAI, route_chat_completions = responses; streams response.output_text.delta events)", L"");
+    ini.set(L"INFO", L"; ", L"");
+    ini.set(L"INFO", L"; === Google Gemini configuration ===", L"");
+    ini.set(L"INFO", L"; api_url = https://generativelanguage.googleapis.com/v1beta/", L"");
+    ini.set(L"INFO", L"; response_type = gemini", L"");
+    ini.set(L"INFO", L"; route_chat_completions = models/{model}:generateContent ({model} is replaced by the model; streaming uses :streamGenerateContent?alt=sse)", L"");
+    ini.set(L"INFO", L"; model = gemini-2.5-flash", L"");
+    ini.set(L"API", L"secret_key", L"ENTER_YOUR_API_KEY_HERE");
+    ini.set(L"API", L"api_url", L"https://api.openai.com/v1/"); // New route naming convention (recommended)
+    ini.set(L"API", L"route_chat_completions", L"chat/completions");
+    ini.set(L"API", L"response_type", L"openai");
+    ini.set(L"API", L"model", L"gpt-4o-mini");
+    ini.set(L"API", L"temperature", L"0.7");
+    ini.set(L"API", L"max_tokens", L"0");
+    ini.set(L"API", L"top_p", L"0.8");
+    ini.set(L"API", L"frequency_penalty", L"0");
+    ini.set(L"API", L"presence_penalty", L"0"); // Add streaming option (0=disabled, 1=enabled)
+    ini.set(L"API", L"streaming", L"1");
+    ini.set(L"API", L"keep_alive", L"5m");
+    ini.set(L"API", L"http_version", L"auto");
+    ini.set(L"API", L"retry_max_attempts", L"3");
+    ini.set(L"API", L"retry_base_delay_ms", L"500");
+    ini.set(L"API", L"retry_max_delay_ms", L"20000");
+    ini.set(L"API", L"endpoints", L"");
+    ini.set(L"API", L"connect_timeout_ms", L"10000");
+    ini.set(L"API", L"rate_limit_rpm", L"0");
+    ini.set(L"API", L"rate_limit_tpm", L"0");
+    ini.set(L"API", L"hedging", L"0");
+    ini.set(L"API", L"hedge_percentile", L"95");
+    ini.set(L"API", L"hedge_min_delay_ms", L"250");
+    ini.set(L"API", L"hedge_budget_percent", L"10");
 
     // Show reasoning (thinking) sections (0=hidden, 1=shown)
-    ::WritePrivateProfileString(TEXT("API"), TEXT("show_reasoning"), TEXT("0"), iniFilePath);
+    ini.set(L"API", L"show_reasoning", L"0");
 
     // Create plugin section with default values
-    ::WritePrivateProfileString(TEXT("PLUGIN"), TEXT("total_tokens_used"), TEXT("0"), iniFilePath);
-    ::WritePrivateProfileString(TEXT("PLUGIN"), TEXT("keep_question"), TEXT("1"), iniFilePath);
-    ::WritePrivateProfileString(TEXT("PLUGIN"), TEXT("is_chat"), TEXT("0"), iniFilePath);
-    ::WritePrivateProfileString(TEXT("PLUGIN"), TEXT("chat_limit"), TEXT("10"), iniFilePath);
+    ini.set(L"PLUGIN", L"total_tokens_used", L"0");
+    ini.set(L"PLUGIN", L"keep_question", L"1");
+    ini.set(L"PLUGIN", L"is_chat", L"0");
+    ini.set(L"PLUGIN", L"chat_limit", L"10");
+
+    ini.save(iniFilePath);
 }
 
 // Implementation of the loadConfig function declared in ConfigManager.h
@@ -85,6 +139,113 @@ void writeDefaultConfig()
 
 namespace ConfigManagerImpl
 {
+    /**
+     * Builds the endpoint list used for failover and load balancing
+     *
+     * 'endpoints' in [API] is a comma-separated list of [Endpoint:name] sections, in
+     * order of preference. Each section may set api_url, secret_key, response_type,
+     * route_chat_completions and model; missing values are taken from [API].
+     * Without an 'endpoints' list the [API] values form the only endpoint.
+     */
+    static std::vector<std::wstring> splitList(const std::wstring &list)
+    {
+        std::vector<std::wstring> items;
+        size_t start = 0;
+        while (start <= list.size())
+        {
+            size_t comma = list.find(L',', start);
+            if (comma == std::wstring::npos)
+            {
+                comma = list.size();
+            }
+
+            std::wstring item = list.substr(start, comma - start);
+            item.erase(0, item.find_first_not_of(L" \t"));
+            item.erase(item.find_last_not_of(L" \t") + 1);
+            start = comma + 1;
+            if (!item.empty())
+            {
+                items.push_back(item);
+            }
+        }
+        return items;
+    }
+
+    static void loadEndpoints(const IniFile &ini)
+    {
+        Endpoint defaults;
+        defaults.name = L"default";
+        defaults.baseUrl = configAPIValue_baseURL;
+        defaults.chatRoute = configAPIValue_chatRoute;
+        defaults.responseType = configAPIValue_responseType;
+        defaults.secretKey = configAPIValue_secretKey;
+        defaults.model = configAPIValue_model;
+
+        std::vector<Endpoint> endpoints;
+        for (const std::wstring &name : splitList(configAPIValue_endpoints))
+        {
+            std::wstring section = L"Endpoint:" + name;
+            Endpoint endpoint;
+            endpoint.name = name;
+            endpoint.baseUrl = ini.get(section, L"api_url", defaults.baseUrl);
+            endpoint.chatRoute = ini.get(section, L"route_chat_completions", defaults.chatRoute);
+            endpoint.responseType = ini.get(section, L"response_type", defaults.responseType);
+            endpoint.secretKey = ini.get(section, L"secret_key", defaults.secretKey);
+            endpoint.model = ini.get(section, L"model", defaults.model);
+            endpoints.push_back(endpoint);
+        }
+
+        if (endpoints.empty())
+        {
+            endpoints.push_back(defaults);
+        }
+        EndpointRouter::instance().setEndpoints(endpoints);
+    }
+
+    /**
+     * Builds the routing rules from the [Route:name] sections
+     *
+     * Each section may set min_chars and max_chars (selection length), extensions
+     * (comma-separated, e.g. "txt,md") and lists its target profiles in 'profiles',
+     * cheapest first. prefer=fastest picks the profile with the lowest measured
+     * latency instead of the first one. Must run after the profiles are loaded.
+     */
+    static void loadRoutingRules(const IniFile &ini)
+    {
+        std::vector<RoutingRule> rules;
+        for (const std::wstring &section : ini.sections())
+        {
+            if (section.size() <= 6 || _wcsnicmp(section.c_str(), L"Route:", 6) != 0)
+            {
+                continue;
+            }
+
+            RoutingRule rule;
+            rule.name = section.substr(6);
+            // Negative lengths are clamped to 0 (cast to size_t they would match nothing or everything)
+            rule.minChars = static_cast<size_t>(ConfigSnapshot::parseInt(ini.get(section, L"min_chars"), 0, 0, INT_MAX));
+            if (ini.has(section, L"max_chars"))
+            {
+                rule.maxChars = static_cast<size_t>(ConfigSnapshot::parseInt(ini.get(section, L"max_chars"), INT_MAX, 0, INT_MAX));
+            }
+            for (const std::wstring &extension : splitList(ini.get(section, L"extensions")))
+            {
+                rule.extensions.push_back(RequestRouter::normalizeExtension(extension));
+            }
+            rule.preferFastest = (ini.get(section, L"prefer") == L"fastest");
+            for (const std::wstring &profile : splitList(ini.get(section, L"profiles")))
+            {
+                std::shared_ptr<const ConfigSnapshot> snapshot = ProfileManager::instance().snapshot(profile);
+                if (snapshot)
+                {
+                    rule.candidates.push_back(snapshot);
+                }
+            }
+            rules.push_back(rule);
+        }
+        RequestRouter::instance().setRules(rules);
+    }
+
     /**
      * Loads configuration from the INI file
      *
@@ -100,9 +261,12 @@ namespace ConfigManagerImpl
         }
 
         // Read values from the config file
-        TCHAR buffer[1024]; // Read API Key
-        ::GetPrivateProfileString(TEXT("API"), TEXT("secret_key"), configAPIValue_secretKey.c_str(), buffer, 1024, iniFilePath);
-        configAPIValue_secretKey = buffer;
+        // Read the whole file once; all lookups below are served from memory
+        IniFile ini;
+        ini.load(iniFilePath);
+
+        // Read API Key
+        configAPIValue_secretKey = ini.get(L"API", L"secret_key", configAPIValue_secretKey);
 
         // Debug check for API key
         if (configAPIValue_secretKey == TEXT("ENTER_YOUR_OPENAI_API_KEY_HERE") || configAPIValue_secretKey.empty())
@@ -112,8 +276,7 @@ namespace ConfigManagerImpl
                          TEXT("NppOpenAI Configuration Error"),
                          MB_ICONWARNING);
         } // Read other API settings
-        ::GetPrivateProfileString(TEXT("API"), TEXT("api_url"), configAPIValue_baseURL.c_str(), buffer, 1024, iniFilePath);
-        configAPIValue_baseURL = buffer; // Auto-correct common OpenAI-compatible server URLs that are missing /v1
+        configAPIValue_baseURL = ini.get(L"API", L"api_url", configAPIValue_baseURL); // Auto-correct common OpenAI-compatible server URLs that are missing /v1
         std::wstring baseUrlLower = configAPIValue_baseURL;
         std::transform(baseUrlLower.begin(), baseUrlLower.end(), baseUrlLower.begin(),
                        [](wchar_t c)
@@ -133,9 +296,7 @@ namespace ConfigManagerImpl
 		bool needsV1 = (baseUrlLower.find(L"/v1") == std::wstring::npos); // We only examine the '/v1' ending, as unexpected cases may occur (e.g. remote Ollama, using 127.0.0.1 instead of localhost, etc. etc.)
         if (needsV1)
         {
-            TCHAR getConfirmedTrailingV1[2];
-            ::GetPrivateProfileString(TEXT("PLUGIN"), TEXT("is_confirmed_trailing_v1"), TEXT("0"), getConfirmedTrailingV1, 2, iniFilePath);
-            if (getConfirmedTrailingV1[0] != '1')
+            if (ini.get(L"PLUGIN", L"is_confirmed_trailing_v1", L"0") != L"1")
             {
 				// Show confirmation dialog to user to update API URL
                 int result = ::MessageBox(nppData._nppHandle, (L"The " + configAPIValue_baseURL + L" API URL does not end with /v1/.\n\nDo you want to append it?\n(Recommended for remote access)").c_str(), L"NppOpenAI: Confirm", MB_YESNO | MB_ICONQUESTION);
@@ -149,10 +310,11 @@ namespace ConfigManagerImpl
                     configAPIValue_baseURL += L"/v1/";
 
                     // Save confirmation and updated URL to INI file
-                    ::WritePrivateProfileString(TEXT("API"), TEXT("api_url"), configAPIValue_baseURL.c_str(), iniFilePath);
+                    ini.set(L"API", L"api_url", configAPIValue_baseURL);
 
                 }
-                ::WritePrivateProfileString(TEXT("PLUGIN"), TEXT("is_confirmed_trailing_v1"), TEXT("1"), iniFilePath); // Don't bother user again
+                ini.set(L"PLUGIN", L"is_confirmed_trailing_v1", L"1"); // Don't bother user again
+                ini.save(iniFilePath);
             }
 
 			/* Not necessary if we request confirmation from user
@@ -175,75 +337,99 @@ namespace ConfigManagerImpl
             }
         } // Try new route naming convention first, then fall back to legacy
 
-        ::GetPrivateProfileString(TEXT("API"), TEXT("route_chat_completions"), L"", buffer, 1024, iniFilePath);
-        if (wcslen(buffer) > 0)
+        std::wstring chatRoute = ini.get(L"API", L"route_chat_completions");
+        if (!chatRoute.empty())
         {
-            configAPIValue_chatRoute = buffer;
+            configAPIValue_chatRoute = chatRoute;
         }
         else
         {
             // Fall back to legacy naming for backward compatibility
-            ::GetPrivateProfileString(TEXT("API"), TEXT("chat_completions_route"), configAPIValue_chatRoute.c_str(), buffer, 1024, iniFilePath);
-            configAPIValue_chatRoute = buffer;
+            configAPIValue_chatRoute = ini.get(L"API", L"chat_completions_route", configAPIValue_chatRoute);
         }
 
-        ::GetPrivateProfileString(TEXT("API"), TEXT("response_type"), configAPIValue_responseType.c_str(), buffer, 1024, iniFilePath);
-        configAPIValue_responseType = buffer;
+        configAPIValue_responseType = ini.get(L"API", L"response_type", configAPIValue_responseType);
 
-        ::GetPrivateProfileString(TEXT("API"), TEXT("proxy_url"), configAPIValue_proxyURL.c_str(), buffer, 1024, iniFilePath);
-        configAPIValue_proxyURL = buffer;
+        configAPIValue_proxyURL = ini.get(L"API", L"proxy_url", configAPIValue_proxyURL);
 
-        ::GetPrivateProfileString(TEXT("API"), TEXT("model"), configAPIValue_model.c_str(), buffer, 1024, iniFilePath);
-        configAPIValue_model = buffer;
+        configAPIValue_httpVersion = ini.get(L"API", L"http_version", configAPIValue_httpVersion);
 
-        ::GetPrivateProfileString(TEXT("API"), TEXT("temperature"), configAPIValue_temperature.c_str(), buffer, 1024, iniFilePath);
-        configAPIValue_temperature = buffer;
+        // Retry policy for rate limits and transient server errors
+        configAPIValue_retryMaxAttempts = ini.get(L"API", L"retry_max_attempts", configAPIValue_retryMaxAttempts);
+        configAPIValue_retryBaseDelayMs = ini.get(L"API", L"retry_base_delay_ms", configAPIValue_retryBaseDelayMs);
+        configAPIValue_retryMaxDelayMs = ini.get(L"API", L"retry_max_delay_ms", configAPIValue_retryMaxDelayMs);
 
-        ::GetPrivateProfileString(TEXT("API"), TEXT("max_tokens"), configAPIValue_maxTokens.c_str(), buffer, 1024, iniFilePath);
-        configAPIValue_maxTokens = buffer;
+        // Failover endpoints (resolved by loadEndpoints once all [API] defaults are known)
+        configAPIValue_endpoints = ini.get(L"API", L"endpoints", configAPIValue_endpoints);
+        configAPIValue_connectTimeoutMs = ini.get(L"API", L"connect_timeout_ms", configAPIValue_connectTimeoutMs);
 
-        ::GetPrivateProfileString(TEXT("API"), TEXT("top_p"), configAPIValue_topP.c_str(), buffer, 1024, iniFilePath);
-        configAPIValue_topP = buffer;
+        // Client-side rate limits (applied per API key by HTTPClient)
+        configAPIValue_rateLimitRpm = ini.get(L"API", L"rate_limit_rpm", configAPIValue_rateLimitRpm);
+        configAPIValue_rateLimitTpm = ini.get(L"API", L"rate_limit_tpm", configAPIValue_rateLimitTpm);
 
-        ::GetPrivateProfileString(TEXT("API"), TEXT("keep_alive"), configAPIValue_keepAlive.c_str(), buffer, 1024, iniFilePath);
-        configAPIValue_keepAlive = buffer;
+        // Raw response capture for replay fixtures (optional, not written to new INI files)
+        configAPIValue_captureDir = ini.get(L"API", L"capture_dir", L"");
+        configAPIValue_traceFile = ini.get(L"API", L"trace_file", L"");
+        configAPIValue_ollamaWarmup = ini.get(L"API", L"ollama_warmup", L"1");
+        configAPIValue_preconnect = ini.get(L"API", L"preconnect", L"0");
+        configAPIValue_preconnectDwellMs = ini.get(L"API", L"preconnect_dwell_ms", L"500");
+        configAPIValue_ollamaContext = ini.get(L"API", L"ollama_context", L"0");
+        configAPIValue_ollamaContextMaxTokens = ini.get(L"API", L"ollama_context_max_tokens", L"32768");
+        configAPIValue_llamacppSlots = ini.get(L"API", L"llamacpp_slots", L"1");
+        configAPIValue_realtime = ini.get(L"API", L"realtime", L"0");
+        configAPIValue_realtimeRoute = ini.get(L"API", L"route_realtime", L"realtime");
+        configAPIValue_realtimeIdleS = ini.get(L"API", L"realtime_idle_s", L"120");
+
+        // Request hedging (duplicates for slow streaming requests)
+        configAPIValue_hedging = ini.get(L"API", L"hedging", configAPIValue_hedging);
+        configAPIValue_hedgePercentile = ini.get(L"API", L"hedge_percentile", configAPIValue_hedgePercentile);
+        configAPIValue_hedgeMinDelayMs = ini.get(L"API", L"hedge_min_delay_ms", configAPIValue_hedgeMinDelayMs);
+        configAPIValue_hedgeBudgetPercent = ini.get(L"API", L"hedge_budget_percent", configAPIValue_hedgeBudgetPercent);
+
+        configAPIValue_model = ini.get(L"API", L"model", configAPIValue_model);
+
+        configAPIValue_temperature = ini.get(L"API", L"temperature", configAPIValue_temperature);
+
+        configAPIValue_maxTokens = ini.get(L"API", L"max_tokens", configAPIValue_maxTokens);
+
+        configAPIValue_topP = ini.get(L"API", L"top_p", configAPIValue_topP);
+
+        configAPIValue_keepAlive = ini.get(L"API", L"keep_alive", configAPIValue_keepAlive);
  
-        ::GetPrivateProfileString(TEXT("API"), TEXT("frequency_penalty"), configAPIValue_frequencyPenalty.c_str(), buffer, 1024, iniFilePath);
-        configAPIValue_frequencyPenalty = buffer;
+        configAPIValue_frequencyPenalty = ini.get(L"API", L"frequency_penalty", configAPIValue_frequencyPenalty);
 
-        ::GetPrivateProfileString(TEXT("API"), TEXT("presence_penalty"), configAPIValue_presencePenalty.c_str(), buffer, 1024, iniFilePath);
-        configAPIValue_presencePenalty = buffer; // Load streaming option
-        ::GetPrivateProfileString(TEXT("API"), TEXT("streaming"), configAPIValue_streaming.c_str(), buffer, 1024, iniFilePath);
-        configAPIValue_streaming = buffer;
+        configAPIValue_presencePenalty = ini.get(L"API", L"presence_penalty", configAPIValue_presencePenalty); // Load streaming option
+        configAPIValue_streaming = ini.get(L"API", L"streaming", configAPIValue_streaming);
+        configAPIValue_streamTransport = ini.get(L"API", L"stream_transport", L"1");
+        configAPIValue_streamBufferKb = ini.get(L"API", L"stream_buffer_kb", L"64");
+        configAPIValue_streamResumeKb = ini.get(L"API", L"stream_resume_kb", L"16");
 
         // Load show_reasoning option
-        ::GetPrivateProfileString(TEXT("API"), TEXT("show_reasoning"), configAPIValue_showReasoning.c_str(), buffer, 1024, iniFilePath);
-        configAPIValue_showReasoning = buffer;
+        configAPIValue_showReasoning = ini.get(L"API", L"show_reasoning", configAPIValue_showReasoning);
+
+        loadEndpoints(ini);
+
+        // Active profile: the saved one on startup, otherwise keep the current one
+        std::wstring activeProfile = loadPluginSettings ? ini.get(L"PLUGIN", L"active_profile") : ProfileManager::instance().activeName();
 
         // Read plugin settings if requested
         if (loadPluginSettings)
         {
             // Read chat settings
-            TCHAR keepQuestionBuffer[2];
-            ::GetPrivateProfileString(TEXT("PLUGIN"), TEXT("keep_question"), isKeepQuestion ? TEXT("1") : TEXT("0"), keepQuestionBuffer, 2, iniFilePath);
-            isKeepQuestion = (keepQuestionBuffer[0] == '1');
+            isKeepQuestion = (ini.get(L"PLUGIN", L"keep_question", isKeepQuestion ? L"1" : L"0") == L"1");
 
             // Read chat mode settings
-            TCHAR isChatBuffer[2];
-            ::GetPrivateProfileString(TEXT("PLUGIN"), TEXT("is_chat"), TEXT("0"), isChatBuffer, 2, iniFilePath);
-            _chatSettingsDlg.chatSetting_isChat = (isChatBuffer[0] == '1');
+            _chatSettingsDlg.chatSetting_isChat = (ini.get(L"PLUGIN", L"is_chat", L"0") == L"1");
 
             // Read chat limit
-            TCHAR chatLimitBuffer[6];
-            ::GetPrivateProfileString(TEXT("PLUGIN"), TEXT("chat_limit"), TEXT("10"), chatLimitBuffer, 6, iniFilePath);
-            _chatSettingsDlg.chatSetting_chatLimit = _wtoi(chatLimitBuffer);
+            _chatSettingsDlg.chatSetting_chatLimit = _wtoi(ini.get(L"PLUGIN", L"chat_limit", L"10").c_str());
         }
 
         // Read system instructions from file if it exists
+        std::vector<Prompt> prompts;
         if (PathFileExists(instructionsFilePath))
         {
             // Parse any instructions/prompts from the instructions file
-            std::vector<Prompt> prompts;
             parseInstructionsFile(instructionsFilePath, prompts);
 
             // If no named prompts, just read the whole file
@@ -264,7 +450,7 @@ namespace ConfigManagerImpl
                         fileContent[readSize] = 0;
 
                         // Convert to wide string
-                        std::wstring wideContent = multiByteToWideChar(fileContent);
+                        std::wstring wideContent = multiByteToWstring(fileContent);
                         configAPIValue_instructions = wideContent;
 
                         delete[] fileContent;
@@ -273,6 +459,26 @@ namespace ConfigManagerImpl
                 }
             }
         }
+
+        // Requests started from now on use the new values; running ones keep their snapshot.
+        // All profiles are parsed here, so switching later only swaps snapshots.
+        std::shared_ptr<const ConfigSnapshot> base = ConfigSnapshot::fromGlobals();
+        std::vector<std::shared_ptr<const ConfigSnapshot>> profiles;
+        for (const std::wstring &section : ini.sections())
+        {
+            if (section.size() > 8 && _wcsnicmp(section.c_str(), L"Profile:", 8) == 0)
+            {
+                profiles.push_back(ConfigSnapshot::forProfile(*base, ini, section.substr(8)));
+            }
+        }
+        ProfileManager::instance().setProfiles(base, profiles, activeProfile);
+        HedgePolicy::instance().configure(base->hedging, base->hedgePercentile, base->hedgeMinDelayMs, base->hedgeBudgetPercent);
+        ModelWarmup::instance().warmUp(ConfigSnapshot::current());
+        Preconnector::instance().configure(ConfigSnapshot::current());
+
+        // Prompt overrides and routing rules refer to profiles, so they are resolved last
+        setPromptCatalog(std::move(prompts));
+        loadRoutingRules(ini);
     }
 }
 
@@ -0,0 +1,185 @@
+/**
+ * ConfigSnapshot.cpp - Parsing and atomic publication of the API configuration
+ */
+
+#include "ConfigSnapshot.h"
+#include "IniFile.h"
+#include "EncodingUtils.h" // for toUTF8
+#include <algorithm>
+#include <atomic>
+#include <cwchar>
+
+namespace
+{
+    // Accessed only through std::atomic_load / std::atomic_store
+    std::shared_ptr<const ConfigSnapshot> g_current = std::make_shared<const ConfigSnapshot>();
+}
+
+/**
+ * Parse a floating-point setting, falling back to a default for empty or invalid values
+ *
+ * @param value The raw INI value
+ * @param fallback Value used when 'value' is not a number
+ * @param minValue Lower bound
+ * @param maxValue Upper bound
+ */
+double ConfigSnapshot::parseNumber(const std::wstring &value, double fallback, double minValue, double maxValue)
+{
+    const wchar_t *begin = value.c_str();
+    wchar_t *end = nullptr;
+    double number = std::wcstod(begin, &end);
+    if (end == begin)
+    {
+        number = fallback;
+    }
+    return (std::min)(maxValue, (std::max)(minValue, number));
+}
+
+int ConfigSnapshot::parseInt(const std::wstring &value, int fallback, int minValue, int maxValue)
+{
+    return static_cast<int>(parseNumber(value, fallback, minValue, maxValue));
+}
+
+std::shared_ptr<const ConfigSnapshot> ConfigSnapshot::forProfile(const ConfigSnapshot &base, const IniFile &ini, const std::wstring &name)
+{
+    std::shared_ptr<ConfigSnapshot> snapshot = fromSection(base, ini, L"Profile:" + name);
+    snapshot->profile = name;
+    return snapshot;
+}
+
+std::shared_ptr<ConfigSnapshot> ConfigSnapshot::fromSection(const ConfigSnapshot &base, const IniFile &ini, const std::wstring &section)
+{
+    std::shared_ptr<ConfigSnapshot> snapshot = std::make_shared<ConfigSnapshot>(base);
+
+    // Only keys present in the section override the values of 'base'
+    auto has = [&](const wchar_t *key)
+    { return ini.has(section, key); };
+    auto get = [&](const wchar_t *key)
+    { return ini.get(section, key); };
+
+    if (has(L"api_url"))
+    {
+        std::wstring baseUrl = get(L"api_url");
+        if (!baseUrl.empty() && baseUrl.back() != L'/')
+        {
+            baseUrl.push_back(L'/');
+        }
+        snapshot->baseUrl = toUTF8(baseUrl);
+    }
+    if (has(L"route_chat_completions"))
+        snapshot->chatRoute = toUTF8(get(L"route_chat_completions"));
+    if (has(L"secret_key"))
+        snapshot->secretKey = toUTF8(get(L"secret_key"));
+    if (has(L"proxy_url"))
+        snapshot->proxy = (get(L"proxy_url") == L"0") ? std::string() : toUTF8(get(L"proxy_url"));
+    if (has(L"response_type"))
+    {
+        snapshot->responseTypeW = get(L"response_type");
+        snapshot->responseType = toUTF8(snapshot->responseTypeW);
+        snapshot->provider = providerFromString(snapshot->responseTypeW);
+    }
+
+    if (has(L"model"))
+        snapshot->model = get(L"model");
+    if (has(L"keep_alive"))
+        snapshot->keepAlive = get(L"keep_alive");
+    if (has(L"temperature"))
+        snapshot->temperature = static_cast<float>(parseNumber(get(L"temperature"), base.temperature, 0.0, 2.0));
+    if (has(L"max_tokens"))
+        snapshot->maxTokens = parseInt(get(L"max_tokens"), base.maxTokens, 0, 10000000);
+    if (has(L"top_p"))
+        snapshot->topP = static_cast<float>(parseNumber(get(L"top_p"), base.topP, 0.0, 1.0));
+    if (has(L"frequency_penalty"))
+        snapshot->frequencyPenalty = static_cast<float>(parseNumber(get(L"frequency_penalty"), base.frequencyPenalty, -2.0, 2.0));
+    if (has(L"presence_penalty"))
+        snapshot->presencePenalty = static_cast<float>(parseNumber(get(L"presence_penalty"), base.presencePenalty, -2.0, 2.0));
+    if (has(L"streaming"))
+        snapshot->streaming = (get(L"streaming") == L"1");
+    if (has(L"stream_transport"))
+        snapshot->streamTransport = (get(L"stream_transport") == L"1");
+    if (has(L"stream_buffer_kb"))
+        snapshot->streamBufferKb = parseInt(get(L"stream_buffer_kb"), 64, 0, 1048576);
+    if (has(L"stream_resume_kb"))
+        snapshot->streamResumeKb = parseInt(get(L"stream_resume_kb"), 16, 0, 1048576);
+    if (has(L"show_reasoning"))
+        snapshot->showReasoning = (get(L"show_reasoning") == L"1");
+
+    if (has(L"http_version"))
+        snapshot->httpVersion = toUTF8(get(L"http_version"));
+    if (has(L"connect_timeout_ms"))
+        snapshot->connectTimeoutMs = parseInt(get(L"connect_timeout_ms"), 10000, 0, 600000);
+    if (has(L"retry_max_attempts"))
+        snapshot->retryMaxAttempts = parseInt(get(L"retry_max_attempts"), 3, 1, 20);
+    if (has(L"retry_base_delay_ms"))
+        snapshot->retryBaseDelayMs = parseInt(get(L"retry_base_delay_ms"), 500, 1, 600000);
+    if (has(L"retry_max_delay_ms"))
+        snapshot->retryMaxDelayMs = parseInt(get(L"retry_max_delay_ms"), 20000, 1, 3600000);
+    if (has(L"rate_limit_rpm"))
+        snapshot->rateLimitRpm = parseNumber(get(L"rate_limit_rpm"), 0, 0, 1e9);
+    if (has(L"rate_limit_tpm"))
+        snapshot->rateLimitTpm = parseNumber(get(L"rate_limit_tpm"), 0, 0, 1e12);
+    if (has(L"ollama_warmup"))
+        snapshot->ollamaWarmup = (get(L"ollama_warmup") == L"1");
+    if (has(L"preconnect"))
+        snapshot->preconnect = (get(L"preconnect") == L"1");
+    if (has(L"preconnect_dwell_ms"))
+        snapshot->preconnectDwellMs = parseInt(get(L"preconnect_dwell_ms"), 500, 0, 60000);
+    if (has(L"ollama_context"))
+        snapshot->ollamaContext = (get(L"ollama_context") == L"1");
+    if (has(L"ollama_context_max_tokens"))
+        snapshot->ollamaContextMaxTokens = parseInt(get(L"ollama_context_max_tokens"), 32768, 0, 1048576);
+    if (has(L"llamacpp_slots"))
+        snapshot->llamacppSlots = parseInt(get(L"llamacpp_slots"), 1, 0, 256);
+    if (has(L"realtime"))
+        snapshot->realtime = (get(L"realtime") == L"1");
+    if (has(L"route_realtime"))
+        snapshot->realtimeRoute = toUTF8(get(L"route_realtime"));
+    if (has(L"realtime_idle_s"))
+        snapshot->realtimeIdleS = parseInt(get(L"realtime_idle_s"), 120, 0, 86400);
+    if (has(L"hedging"))
+        snapshot->hedging = (get(L"hedging") == L"1");
+    if (has(L"hedge_percentile"))
+        snapshot->hedgePercentile = parseNumber(get(L"hedge_percentile"), 95, 50, 99.9);
+    if (has(L"hedge_min_delay_ms"))
+        snapshot->hedgeMinDelayMs = parseInt(get(L"hedge_min_delay_ms"), 250, 0, 600000);
+    if (has(L"hedge_budget_percent"))
+        snapshot->hedgeBudgetPercent = parseNumber(get(L"hedge_budget_percent"), 10, 0, 100);
+    if (has(L"capture_dir"))
+        snapshot->captureDir = toUTF8(get(L"capture_dir"));
+    if (has(L"trace_file"))
+        snapshot->traceFile = toUTF8(get(L"trace_file"));
+
+    return snapshot;
+}
+
+Provider ConfigSnapshot::providerFromString(const std::wstring &responseType)
+{
+    if (responseType == L"openai")
+        return Provider::OpenAI;
+    if (responseType == L"claude")
+        return Provider::Claude;
+    if (responseType == L"ollama")
+        return Provider::Ollama;
+    if (responseType == L"llamacpp")
+        return Provider::LlamaCpp;
+    if (responseType == L"openai-responses")
+        return Provider::Responses;
+    if (responseType == L"gemini")
+        return Provider::Gemini;
+    if (responseType == L"simple")
+        return Provider::Simple;
+    return Provider::Other;
+}
+
+std::shared_ptr<const ConfigSnapshot> ConfigSnapshot::current()
+{
+    return std::atomic_load(&g_current);
+}
+
+void ConfigSnapshot::publish(std::shared_ptr<const ConfigSnapshot> snapshot)
+{
+    if (snapshot)
+    {
+        std::atomic_store(&g_current, std::move(snapshot));
+    }
+}
@@ -0,0 +1,111 @@
+/**
+ * ConfigSnapshot.h - Immutable, typed view of the API configuration
+ *
+ * The configAPIValue_* globals hold the raw INI strings and are rewritten on
+ * the UI thread whenever the configuration is reloaded (e.g. on saving the INI
+ * file). Request code must not read them while a transfer runs on a worker
+ * thread. Instead, loadConfig parses them once into a ConfigSnapshot - numbers
+ * validated, strings pre-encoded as UTF-8 - and publishes it atomically. Each
+ * request takes the current snapshot at its start and keeps using it, even if
+ * a newer one is published meanwhile.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+class IniFile;
+
+/**
+ * API flavour selected by response_type
+ */
+enum class Provider
+{
+    OpenAI,    // openai (and OpenAI-compatible servers)
+    Claude,    // claude (Anthropic Messages API)
+    Ollama,    // ollama (native /api/generate or /api/chat)
+    LlamaCpp,  // llamacpp (llama-server's chat route with prompt cache and slots)
+    Responses, // openai-responses (OpenAI Responses API)
+    Gemini,    // gemini (Google Gemini generateContent API)
+    Simple,    // simple (plain-text responses)
+    Other      // Any other value (handled like openai)
+};
+
+struct ConfigSnapshot
+{
+    // Profile these values belong to (empty for the plain [API] configuration)
+    std::wstring profile;
+
+    // Endpoint (UTF-8); defaults match the plugin's built-in configuration
+    std::string baseUrl = "https://api.openai.com/v1/";
+    std::string chatRoute = "chat/completions";
+    std::string secretKey;
+    std::string proxy;         // Empty when no proxy is configured ("0")
+    std::string responseType = "openai";
+    Provider provider = Provider::OpenAI;
+
+    // Model and sampling parameters (validated and clamped)
+    std::wstring model = L"gpt-4o-mini";
+    std::wstring responseTypeW = L"openai";
+    std::wstring keepAlive = L"5m";
+    std::wstring instructions;
+    float temperature = 0.7f;
+    int maxTokens = 0;
+    float topP = 0.8f;
+    float frequencyPenalty = 0.0f;
+    float presencePenalty = 0.0f;
+    bool streaming = true;
+    bool streamTransport = true; // With streaming off, receive a stream anyway and insert the answer once complete
+    int streamBufferKb = 64;     // Streamed text queued for the front-end before the transfer pauses (see StreamBuffer; 0 = no queue)
+    int streamResumeKb = 16;     // ... and the queue size at which it resumes
+    bool showReasoning = false;
+
+    // Transport
+    std::string httpVersion = "auto";
+    long connectTimeoutMs = 10000;
+    int retryMaxAttempts = 3;
+    int retryBaseDelayMs = 500;
+    int retryMaxDelayMs = 20000;
+    double rateLimitRpm = 0;
+    double rateLimitTpm = 0;
+    bool ollamaWarmup = true;  // Load the Ollama model ahead of the first ask (see ModelWarmup)
+    bool preconnect = false;   // Connect while a selection is made (see Preconnector)
+    int preconnectDwellMs = 500;
+    bool ollamaContext = false; // Reuse /api/generate contexts per document (see OllamaContext)
+    int ollamaContextMaxTokens = 32768;
+    int llamacppSlots = 1; // llama-server slots documents are pinned to (see LlamaCppSlots; 0 = server picks)
+    bool realtime = false; // Send OpenAI asks over a persistent Realtime API session (see RealtimeSession)
+    std::string realtimeRoute = "realtime";
+    int realtimeIdleS = 120;
+    bool hedging = false; // Duplicate slow streaming requests (see HedgePolicy; [API] only)
+    double hedgePercentile = 95;
+    int hedgeMinDelayMs = 250;
+    double hedgeBudgetPercent = 10;
+
+    // Diagnostics
+    std::string captureDir;    // Directory for response fixtures (empty = capturing off)
+    std::string traceFile;     // Chrome trace written after each ask (empty = tracing off)
+
+    // Parse the configAPIValue_* globals (UI thread only, right after loading them; plugin only)
+    static std::shared_ptr<const ConfigSnapshot> fromGlobals();
+
+    // Copy of 'base' with the values set in the [Profile:name] section of 'ini'
+    static std::shared_ptr<const ConfigSnapshot> forProfile(const ConfigSnapshot &base, const IniFile &ini, const std::wstring &name);
+
+    // Copy of 'base' with the values set in 'section' of 'ini' (e.g. L"API" for front-ends without the plugin globals)
+    static std::shared_ptr<ConfigSnapshot> fromSection(const ConfigSnapshot &base, const IniFile &ini, const std::wstring &section);
+
+    // Parse a number setting; empty or invalid values give 'fallback', the result is clamped to [minValue, maxValue]
+    static double parseNumber(const std::wstring &value, double fallback, double minValue, double maxValue);
+    static int parseInt(const std::wstring &value, int fallback, int minValue, int maxValue);
+
+    // Map a response_type value to a Provider
+    static Provider providerFromString(const std::wstring &responseType);
+
+    // Snapshot in effect for new requests (never null)
+    static std::shared_ptr<const ConfigSnapshot> current();
+
+    // Make 'snapshot' the one returned by current()
+    static void publish(std::shared_ptr<const ConfigSnapshot> snapshot);
+};
@@ -0,0 +1,83 @@
+/**
+ * ConfigSnapshotGlobals.cpp - Building a ConfigSnapshot from the plugin's configuration globals
+ *
+ * Kept apart from ConfigSnapshot.cpp so the portable core does not depend on the
+ * Notepad++ plugin globals.
+ */
+
+#include "ConfigSnapshot.h"
+#include "IniFile.h"
+#include "core/external_globals.h"
+
+namespace
+{
+    // [API] keys of the settings a snapshot holds and the globals loadConfig read them into
+    struct GlobalKey
+    {
+        const wchar_t *key;
+        const std::wstring *value;
+    };
+
+    const GlobalKey kGlobalKeys[] = {
+        {L"api_url", &configAPIValue_baseURL},
+        {L"route_chat_completions", &configAPIValue_chatRoute},
+        {L"secret_key", &configAPIValue_secretKey},
+        {L"proxy_url", &configAPIValue_proxyURL},
+        {L"response_type", &configAPIValue_responseType},
+        {L"model", &configAPIValue_model},
+        {L"keep_alive", &configAPIValue_keepAlive},
+        {L"temperature", &configAPIValue_temperature},
+        {L"max_tokens", &configAPIValue_maxTokens},
+        {L"top_p", &configAPIValue_topP},
+        {L"frequency_penalty", &configAPIValue_frequencyPenalty},
+        {L"presence_penalty", &configAPIValue_presencePenalty},
+        {L"streaming", &configAPIValue_streaming},
+        {L"stream_transport", &configAPIValue_streamTransport},
+        {L"stream_buffer_kb", &configAPIValue_streamBufferKb},
+        {L"stream_resume_kb", &configAPIValue_streamResumeKb},
+        {L"show_reasoning", &configAPIValue_showReasoning},
+        {L"http_version", &configAPIValue_httpVersion},
+        {L"connect_timeout_ms", &configAPIValue_connectTimeoutMs},
+        {L"retry_max_attempts", &configAPIValue_retryMaxAttempts},
+        {L"retry_base_delay_ms", &configAPIValue_retryBaseDelayMs},
+        {L"retry_max_delay_ms", &configAPIValue_retryMaxDelayMs},
+        {L"rate_limit_rpm", &configAPIValue_rateLimitRpm},
+        {L"rate_limit_tpm", &configAPIValue_rateLimitTpm},
+        {L"ollama_warmup", &configAPIValue_ollamaWarmup},
+        {L"preconnect", &configAPIValue_preconnect},
+        {L"preconnect_dwell_ms", &configAPIValue_preconnectDwellMs},
+        {L"ollama_context", &configAPIValue_ollamaContext},
+        {L"ollama_context_max_tokens", &configAPIValue_ollamaContextMaxTokens},
+        {L"llamacpp_slots", &configAPIValue_llamacppSlots},
+        {L"realtime", &configAPIValue_realtime},
+        {L"route_realtime", &configAPIValue_realtimeRoute},
+        {L"realtime_idle_s", &configAPIValue_realtimeIdleS},
+        {L"hedging", &configAPIValue_hedging},
+        {L"hedge_percentile", &configAPIValue_hedgePercentile},
+        {L"hedge_min_delay_ms", &configAPIValue_hedgeMinDelayMs},
+        {L"hedge_budget_percent", &configAPIValue_hedgeBudgetPercent},
+        {L"capture_dir", &configAPIValue_captureDir},
+        {L"trace_file", &configAPIValue_traceFile},
+    };
+}
+
+/**
+ * Parse the globals with the same rules as a profile section
+ *
+ * The values loadConfig settled on (defaults, corrected URL) are put back into
+ * an in-memory [API] section and parsed by fromSection, so the [API] values and
+ * profile overrides cannot drift apart. Each value is quoted, which IniFile
+ * removes again, so surrounding whitespace or quotes survive the round trip.
+ */
+std::shared_ptr<const ConfigSnapshot> ConfigSnapshot::fromGlobals()
+{
+    IniFile ini;
+    for (const GlobalKey &entry : kGlobalKeys)
+    {
+        ini.set(L"API", entry.key, L"\"" + *entry.value + L"\"");
+    }
+
+    std::shared_ptr<ConfigSnapshot> snapshot = fromSection(ConfigSnapshot(), ini, L"API");
+    snapshot->instructions = configAPIValue_instructions; // Read from its own file, not from [API]
+    return snapshot;
+}
@@ -0,0 +1,452 @@
+/**
+ * IniFile.cpp - Single-pass INI file reader/writer with atomic save
+ */
+
+#include "IniFile.h"
+#include <cstddef>
+#include <cstdio>
+#include <cwctype>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace
+{
+    bool isValidUtf8(const std::string &bytes, bool &hasMultiByte)
+    {
+        hasMultiByte = false;
+        size_t i = 0;
+        while (i < bytes.size())
+        {
+            unsigned char c = static_cast<unsigned char>(bytes[i]);
+            size_t length = (c < 0x80) ? 1 : ((c >> 5) == 0x6) ? 2 : ((c >> 4) == 0xE) ? 3 : ((c >> 3) == 0x1E) ? 4 : 0;
+            if (length == 0 || i + length > bytes.size())
+                return false;
+            for (size_t k = 1; k < length; ++k)
+            {
+                if ((static_cast<unsigned char>(bytes[i + k]) & 0xC0) != 0x80)
+                    return false;
+            }
+            hasMultiByte = hasMultiByte || length > 1;
+            i += length;
+        }
+        return true;
+    }
+
+    void appendCodePoint(std::wstring &out, unsigned long codePoint)
+    {
+        if (sizeof(wchar_t) == 2 && codePoint > 0xFFFF)
+        {
+            codePoint -= 0x10000;
+            out.push_back(static_cast<wchar_t>(0xD800 + (codePoint >> 10)));
+            out.push_back(static_cast<wchar_t>(0xDC00 + (codePoint & 0x3FF)));
+        }
+        else
+        {
+            out.push_back(static_cast<wchar_t>(codePoint));
+        }
+    }
+
+    std::wstring fromUtf8(const std::string &bytes)
+    {
+        std::wstring out;
+        out.reserve(bytes.size());
+        size_t i = 0;
+        while (i < bytes.size())
+        {
+            unsigned char c = static_cast<unsigned char>(bytes[i]);
+            size_t length = (c < 0x80) ? 1 : ((c >> 5) == 0x6) ? 2 : ((c >> 4) == 0xE) ? 3 : 4;
+            unsigned long codePoint = (length == 1) ? c : (length == 2) ? (c & 0x1F) : (length == 3) ? (c & 0x0F) : (c & 0x07);
+            for (size_t k = 1; k < length && i + k < bytes.size(); ++k)
+            {
+                codePoint = (codePoint << 6) | (static_cast<unsigned char>(bytes[i + k]) & 0x3F);
+            }
+            appendCodePoint(out, codePoint);
+            i += length;
+        }
+        return out;
+    }
+
+    std::string toUtf8(const std::wstring &text)
+    {
+        std::string out;
+        out.reserve(text.size());
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            unsigned long codePoint = static_cast<unsigned long>(text[i]);
+            if (sizeof(wchar_t) == 2 && codePoint >= 0xD800 && codePoint <= 0xDBFF && i + 1 < text.size())
+            {
+                codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (static_cast<unsigned long>(text[++i]) - 0xDC00);
+            }
+
+            if (codePoint < 0x80)
+            {
+                out.push_back(static_cast<char>(codePoint));
+            }
+            else if (codePoint < 0x800)
+            {
+                out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+                out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+            else if (codePoint < 0x10000)
+            {
+                out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+            else
+            {
+                out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+        }
+        return out;
+    }
+
+    FILE *openFile(const std::wstring &path, const wchar_t *mode)
+    {
+#ifdef _WIN32
+        return _wfopen(path.c_str(), mode);
+#else
+        return std::fopen(toUtf8(path).c_str(), toUtf8(mode).c_str());
+#endif
+    }
+
+    bool replaceFile(const std::wstring &from, const std::wstring &to)
+    {
+#ifdef _WIN32
+        return ::MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+#else
+        return std::rename(toUtf8(from).c_str(), toUtf8(to).c_str()) == 0;
+#endif
+    }
+
+    void removeFile(const std::wstring &path)
+    {
+#ifdef _WIN32
+        _wremove(path.c_str());
+#else
+        std::remove(toUtf8(path).c_str());
+#endif
+    }
+}
+
+bool IniFile::load(const std::wstring &path)
+{
+    FILE *file = openFile(path, L"rb");
+    if (!file)
+    {
+        parse(L"");
+        return false;
+    }
+
+    std::string bytes;
+    char chunk[16384];
+    size_t readSize;
+    while ((readSize = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        bytes.append(chunk, readSize);
+    }
+    std::fclose(file);
+
+    parse(decode(bytes, _encoding));
+    return true;
+}
+
+void IniFile::parse(const std::wstring &content)
+{
+    _lines.clear();
+    size_t start = 0;
+    while (start < content.size())
+    {
+        size_t newline = content.find(L'\n', start);
+        size_t end = (newline == std::wstring::npos) ? content.size() : newline;
+        size_t length = end - start;
+        if (length > 0 && content[end - 1] == L'\r')
+        {
+            --length;
+        }
+        _lines.push_back(content.substr(start, length));
+        start = end + 1;
+    }
+    rebuildIndex();
+}
+
+bool IniFile::save(const std::wstring &path) const
+{
+    std::wstring tempPath = path + L".tmp";
+    FILE *file = openFile(tempPath, L"wb");
+    if (!file)
+    {
+        return false;
+    }
+
+    std::string bytes = encode(toString(), _encoding);
+    bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    written = (std::fflush(file) == 0) && written;
+    std::fclose(file);
+
+    if (!written || !replaceFile(tempPath, path))
+    {
+        removeFile(tempPath);
+        return false;
+    }
+    return true;
+}
+
+std::wstring IniFile::toString() const
+{
+    std::wstring content;
+    for (const std::wstring &line : _lines)
+    {
+        content += line;
+        content += L"\r\n";
+    }
+    return content;
+}
+
+std::wstring IniFile::get(const std::wstring &section, const std::wstring &key, const std::wstring &defaultValue) const
+{
+    const Section *found = findSection(section);
+    if (!found)
+    {
+        return defaultValue;
+    }
+    auto entry = found->keys.find(lower(trim(key)));
+    if (entry == found->keys.end())
+    {
+        return defaultValue;
+    }
+
+    const std::wstring &line = _lines[entry->second];
+    std::wstring value = trim(line.substr(line.find(L'=') + 1));
+
+    // Like GetPrivateProfileString, remove one pair of matching quotes
+    if (value.size() >= 2 && (value.front() == L'"' || value.front() == L'\'') && value.back() == value.front())
+    {
+        value = value.substr(1, value.size() - 2);
+    }
+    return value;
+}
+
+bool IniFile::has(const std::wstring &section, const std::wstring &key) const
+{
+    const Section *found = findSection(section);
+    return found && found->keys.count(lower(trim(key))) > 0;
+}
+
+void IniFile::set(const std::wstring &section, const std::wstring &key, const std::wstring &value)
+{
+    const Section *found = findSection(section);
+    if (found)
+    {
+        auto entry = found->keys.find(lower(trim(key)));
+        if (entry != found->keys.end())
+        {
+            // Keep the key as it is written in the file
+            std::wstring &line = _lines[entry->second];
+            line = line.substr(0, line.find(L'=')) + L"=" + value;
+            return;
+        }
+        _lines.insert(_lines.begin() + static_cast<std::ptrdiff_t>(found->lastEntryLine + 1), key + L"=" + value);
+    }
+    else
+    {
+        _lines.push_back(L"[" + section + L"]");
+        _lines.push_back(key + L"=" + value);
+    }
+    rebuildIndex();
+}
+
+std::vector<std::wstring> IniFile::sections() const
+{
+    std::vector<std::wstring> names;
+    for (const Section &section : _sections)
+    {
+        names.push_back(section.name);
+    }
+    return names;
+}
+
+/**
+ * Index sections and keys; the first occurrence of a duplicate section or key wins
+ */
+void IniFile::rebuildIndex()
+{
+    _sections.clear();
+    _sectionIndex.clear();
+
+    Section *current = nullptr;
+    for (size_t i = 0; i < _lines.size(); ++i)
+    {
+        std::wstring line = trim(_lines[i]);
+        if (line.empty())
+        {
+            continue;
+        }
+
+        if (line.front() == L'[')
+        {
+            size_t close = line.find(L']');
+            std::wstring name = trim(line.substr(1, (close == std::wstring::npos) ? std::wstring::npos : close - 1));
+            std::wstring lowerName = lower(name);
+
+            auto existing = _sectionIndex.find(lowerName);
+            if (existing != _sectionIndex.end())
+            {
+                current = &_sections[existing->second];
+                continue;
+            }
+
+            Section section;
+            section.name = name;
+            section.headerLine = i;
+            section.lastEntryLine = i;
+            _sectionIndex[lowerName] = _sections.size();
+            _sections.push_back(section);
+            current = &_sections.back();
+            continue;
+        }
+
+        if (!current)
+        {
+            continue;
+        }
+        current->lastEntryLine = i;
+
+        size_t equals = line.find(L'=');
+        if (line.front() == L';' || equals == std::wstring::npos)
+        {
+            continue;
+        }
+        std::wstring keyName = lower(trim(line.substr(0, equals)));
+        if (!keyName.empty() && current->keys.count(keyName) == 0)
+        {
+            current->keys[keyName] = i;
+        }
+    }
+}
+
+const IniFile::Section *IniFile::findSection(const std::wstring &section) const
+{
+    auto found = _sectionIndex.find(lower(trim(section)));
+    return (found != _sectionIndex.end()) ? &_sections[found->second] : nullptr;
+}
+
+std::wstring IniFile::lower(const std::wstring &text)
+{
+    std::wstring result(text);
+    for (wchar_t &c : result)
+    {
+        c = static_cast<wchar_t>(std::towlower(c));
+    }
+    return result;
+}
+
+std::wstring IniFile::trim(const std::wstring &text)
+{
+    size_t first = text.find_first_not_of(L" \t\r\n");
+    if (first == std::wstring::npos)
+    {
+        return L"";
+    }
+    size_t last = text.find_last_not_of(L" \t\r\n");
+    return text.substr(first, last - first + 1);
+}
+
+/**
+ * Convert file bytes to text, detecting the encoding
+ *
+ * UTF-16LE and UTF-8 are recognized by their BOM; BOM-less files are UTF-8 if
+ * they decode as such, otherwise ANSI (the Win32 profile API's default).
+ */
+std::wstring IniFile::decode(const std::string &bytes, Encoding &encoding)
+{
+    if (bytes.size() >= 2 && static_cast<unsigned char>(bytes[0]) == 0xFF && static_cast<unsigned char>(bytes[1]) == 0xFE)
+    {
+        encoding = Encoding::Utf16Le;
+        std::wstring text;
+        for (size_t i = 2; i + 1 < bytes.size(); i += 2)
+        {
+            text.push_back(static_cast<wchar_t>(static_cast<unsigned char>(bytes[i]) | (static_cast<unsigned char>(bytes[i + 1]) << 8)));
+        }
+        return text;
+    }
+    if (bytes.size() >= 3 && bytes.compare(0, 3, "\xEF\xBB\xBF") == 0)
+    {
+        encoding = Encoding::Utf8Bom;
+        return fromUtf8(bytes.substr(3));
+    }
+
+    bool hasMultiByte = false;
+    if (isValidUtf8(bytes, hasMultiByte) && hasMultiByte)
+    {
+        encoding = Encoding::Utf8;
+        return fromUtf8(bytes);
+    }
+
+    encoding = Encoding::Ansi;
+#ifdef _WIN32
+    int length = ::MultiByteToWideChar(CP_ACP, 0, bytes.data(), static_cast<int>(bytes.size()), nullptr, 0);
+    std::wstring text(static_cast<size_t>(length), L'\0');
+    if (length > 0)
+    {
+        ::MultiByteToWideChar(CP_ACP, 0, bytes.data(), static_cast<int>(bytes.size()), &text[0], length);
+    }
+    return text;
+#else
+    // Latin-1 outside Windows
+    std::wstring text;
+    text.reserve(bytes.size());
+    for (char c : bytes)
+    {
+        text.push_back(static_cast<wchar_t>(static_cast<unsigned char>(c)));
+    }
+    return text;
+#endif
+}
+
+std::string IniFile::encode(const std::wstring &text, Encoding encoding)
+{
+    switch (encoding)
+    {
+    case Encoding::Utf16Le:
+    {
+        std::string bytes("\xFF\xFE", 2);
+        for (wchar_t c : text)
+        {
+            bytes.push_back(static_cast<char>(c & 0xFF));
+            bytes.push_back(static_cast<char>((c >> 8) & 0xFF));
+        }
+        return bytes;
+    }
+    case Encoding::Utf8Bom:
+        return "\xEF\xBB\xBF" + toUtf8(text);
+    case Encoding::Utf8:
+        return toUtf8(text);
+    case Encoding::Ansi:
+    default:
+    {
+#ifdef _WIN32
+        int length = ::WideCharToMultiByte(CP_ACP, 0, text.data(), static_cast<int>(text.size()), nullptr, 0, nullptr, nullptr);
+        std::string bytes(static_cast<size_t>(length), '\0');
+        if (length > 0)
+        {
+            ::WideCharToMultiByte(CP_ACP, 0, text.data(), static_cast<int>(text.size()), &bytes[0], length, nullptr, nullptr);
+        }
+        return bytes;
+#else
+        std::string bytes;
+        bytes.reserve(text.size());
+        for (wchar_t c : text)
+        {
+            bytes.push_back((c < 0x100) ? static_cast<char>(c) : '?');
+        }
+        return bytes;
+#endif
+    }
+    }
+}
@@ -0,0 +1,81 @@
+/**
+ * IniFile.h - Single-pass INI file reader/writer
+ *
+ * Every GetPrivateProfileString call reopens and rescans the INI file and
+ * truncates values to the caller's buffer. IniFile reads the file once into a
+ * line list with a section/key index, answers lookups from memory and writes
+ * all changes back in one atomic replace.
+ *
+ * Lookups follow the Win32 profile API semantics so existing INI files behave
+ * the same: section and key names are case-insensitive, whitespace around keys
+ * and values is trimmed, one pair of surrounding quotes is removed and lines
+ * starting with ';' are comments. Comments, blank lines and the order of
+ * entries are preserved on save, as is the file encoding (ANSI, UTF-8 or
+ * UTF-16LE with BOM). Values have no length limit.
+ *
+ * The implementation only uses the C++ standard library (plus the Win32 code
+ * page conversion for ANSI files on Windows), so it also builds on other platforms.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+class IniFile
+{
+public:
+    // Read a file; returns false (and leaves an empty document) if it cannot be opened
+    bool load(const std::wstring &path);
+
+    // Parse INI text that is already in memory
+    void parse(const std::wstring &content);
+
+    // Write the document to 'path' via a temporary file and an atomic rename
+    bool save(const std::wstring &path) const;
+
+    // Serialize the document (lines separated by CRLF, like the Win32 API writes them)
+    std::wstring toString() const;
+
+    // Value of 'key' in 'section', or 'defaultValue' if it does not exist
+    std::wstring get(const std::wstring &section, const std::wstring &key, const std::wstring &defaultValue = L"") const;
+
+    // True if 'key' exists in 'section'
+    bool has(const std::wstring &section, const std::wstring &key) const;
+
+    // Set a value; an existing entry is rewritten in place, a new one is appended to its section
+    void set(const std::wstring &section, const std::wstring &key, const std::wstring &value);
+
+    // Names of all sections in file order
+    std::vector<std::wstring> sections() const;
+
+private:
+    enum class Encoding
+    {
+        Ansi,
+        Utf8,
+        Utf8Bom,
+        Utf16Le
+    };
+
+    struct Section
+    {
+        std::wstring name;
+        size_t headerLine = 0;    // Index of the "[name]" line
+        size_t lastEntryLine = 0; // Index after which new keys are inserted
+        std::map<std::wstring, size_t> keys; // Lower-case key -> line index
+    };
+
+    void rebuildIndex();
+    const Section *findSection(const std::wstring &section) const;
+    static std::wstring lower(const std::wstring &text);
+    static std::wstring trim(const std::wstring &text);
+    static std::wstring decode(const std::string &bytes, Encoding &encoding);
+    static std::string encode(const std::wstring &text, Encoding encoding);
+
+    std::vector<std::wstring> _lines;
+    std::vector<Section> _sections;
+    std::map<std::wstring, size_t> _sectionIndex; // Lower-case section name -> index in _sections
+    Encoding _encoding = Encoding::Ansi;
+};
@@ -0,0 +1,127 @@
+/**
+ * ProfileManager.cpp - Named backend profiles and instant switching between them
+ */
+
+#include "ProfileManager.h"
+#include <algorithm>
+
+namespace
+{
+    const double kEwmaAlpha = 0.3; // Weight of the newest time-to-first-byte sample
+}
+
+ProfileManager &ProfileManager::instance()
+{
+    static ProfileManager manager;
+    return manager;
+}
+
+void ProfileManager::setProfiles(std::shared_ptr<const ConfigSnapshot> base,
+                                 const std::vector<std::shared_ptr<const ConfigSnapshot>> &profiles,
+                                 const std::wstring &active)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _snapshots.clear();
+    _index.clear();
+    _snapshots.push_back(base ? base : std::make_shared<const ConfigSnapshot>());
+    for (const std::shared_ptr<const ConfigSnapshot> &profile : profiles)
+    {
+        if (profile && !profile->profile.empty() && _index.find(profile->profile) == _index.end())
+        {
+            _index[profile->profile] = _snapshots.size();
+            _snapshots.push_back(profile);
+        }
+    }
+
+    auto it = _index.find(active);
+    publishLocked(it != _index.end() ? it->second : 0);
+}
+
+bool ProfileManager::activate(const std::wstring &name)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (name.empty() && !_snapshots.empty())
+    {
+        publishLocked(0);
+        return true;
+    }
+
+    auto it = _index.find(name);
+    if (it == _index.end())
+        return false;
+    publishLocked(it->second);
+    return true;
+}
+
+std::wstring ProfileManager::activateNext()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_snapshots.empty())
+        return std::wstring();
+
+    publishLocked((_active + 1) % _snapshots.size());
+    return _snapshots[_active]->profile;
+}
+
+std::wstring ProfileManager::activeName() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _snapshots.empty() ? std::wstring() : _snapshots[_active]->profile;
+}
+
+size_t ProfileManager::size() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _index.size();
+}
+
+std::shared_ptr<const ConfigSnapshot> ProfileManager::snapshot(const std::wstring &name) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (name.empty() || name == L"default")
+        return _snapshots.empty() ? nullptr : _snapshots[0];
+
+    auto it = _index.find(name);
+    return (it != _index.end()) ? _snapshots[it->second] : nullptr;
+}
+
+void ProfileManager::recordRequest(const std::wstring &name, bool ok, size_t bytesReceived, double ttfbMs)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    ProfileUsage &usage = _usage[name];
+    ++usage.requests;
+    if (!ok)
+        ++usage.failures;
+    usage.bytesReceived += bytesReceived;
+    if (ok && ttfbMs > 0)
+    {
+        usage.ewmaTtfbMs = (usage.ewmaTtfbMs > 0) ? kEwmaAlpha * ttfbMs + (1 - kEwmaAlpha) * usage.ewmaTtfbMs : ttfbMs;
+    }
+}
+
+void ProfileManager::recordPromptTokens(const std::wstring &name, int64_t promptTokens, int64_t cachedTokens)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    ProfileUsage &usage = _usage[name];
+    usage.promptTokens += static_cast<uint64_t>((std::max)(promptTokens, int64_t(0)));
+    usage.cachedTokens += static_cast<uint64_t>((std::max)(cachedTokens, int64_t(0)));
+}
+
+ProfileUsage ProfileManager::usage(const std::wstring &name) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _usage.find(name);
+    return (it != _usage.end()) ? it->second : ProfileUsage();
+}
+
+std::wstring ProfileManager::displayName(const std::wstring &name)
+{
+    return name.empty() ? std::wstring(L"default") : name;
+}
+
+void ProfileManager::publishLocked(size_t index)
+{
+    _active = index;
+    ConfigSnapshot::publish(_snapshots[index]);
+}
@@ -0,0 +1,83 @@
+/**
+ * ProfileManager.h - Named backend profiles and instant switching between them
+ *
+ * Every [Profile:name] section of the INI file describes a complete backend
+ * (URL, route, response_type, model, sampling parameters, key); keys it does
+ * not set are inherited from [API]. loadConfig parses all profiles into
+ * ConfigSnapshots up front, so switching only publishes a prebuilt snapshot -
+ * nothing is re-read or re-parsed. HTTPClient keeps a separate connection cache
+ * per profile, so connections of inactive profiles stay warm.
+ */
+
+#pragma once
+
+#include "ConfigSnapshot.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Requests sent with one profile since the plugin was loaded
+ */
+struct ProfileUsage
+{
+    int requests = 0;           // Asks sent with the profile
+    int failures = 0;           // Asks that ended with an error
+    uint64_t bytesReceived = 0; // Size of the responses received
+    double ewmaTtfbMs = 0;      // Smoothed time to first byte of successful asks (0 = not measured yet)
+    uint64_t promptTokens = 0;  // Prompt tokens the provider reported
+    uint64_t cachedTokens = 0;  // ... of which it read from its prompt cache
+};
+
+class ProfileManager
+{
+public:
+    static ProfileManager &instance();
+
+    // Replace the profiles ('base' is the plain [API] configuration) and publish 'active',
+    // or 'base' if no such profile exists any more
+    void setProfiles(std::shared_ptr<const ConfigSnapshot> base,
+                     const std::vector<std::shared_ptr<const ConfigSnapshot>> &profiles,
+                     const std::wstring &active);
+
+    // Publish the named profile (empty name: [API]); false if it does not exist
+    bool activate(const std::wstring &name);
+
+    // Publish the profile after the active one, wrapping around to [API]; returns its name
+    std::wstring activateNext();
+
+    // Name of the active profile (empty for [API])
+    std::wstring activeName() const;
+
+    // Number of profiles, not counting [API]
+    size_t size() const;
+
+    // Parsed configuration of a profile ("" or "default": [API]); null if it does not exist
+    std::shared_ptr<const ConfigSnapshot> snapshot(const std::wstring &name) const;
+
+    // Count a finished request of a profile (ttfbMs < 0: no response arrived)
+    void recordRequest(const std::wstring &name, bool ok, size_t bytesReceived, double ttfbMs);
+
+    // Count the prompt tokens the provider reported for a request of a profile
+    void recordPromptTokens(const std::wstring &name, int64_t promptTokens, int64_t cachedTokens);
+
+    // Counters of a profile (zero if nothing was sent yet)
+    ProfileUsage usage(const std::wstring &name) const;
+
+    // Name shown to the user ("default" for [API])
+    static std::wstring displayName(const std::wstring &name);
+
+private:
+    ProfileManager() = default;
+
+    void publishLocked(size_t index);
+
+    mutable std::mutex _mutex;
+    std::vector<std::shared_ptr<const ConfigSnapshot>> _snapshots; // [0] is [API]
+    std::map<std::wstring, size_t> _index;                         // Profile name -> index in _snapshots
+    size_t _active = 0;
+    std::map<std::wstring, ProfileUsage> _usage; // Kept across reloads
+};
@@ -6,14 +6,164 @@
  * INI-style format and provides a UI for users to select which prompt to use.
  */
 
+#ifdef _WIN32
 #include <windows.h>
 #include <commctrl.h> // for TASKDIALOG_BUTTON, TaskDialogIndirect
 #pragma comment(lib, "comctl32.lib")
+#endif
 
 #include "PromptManager.h"
+#include "ConfigSnapshot.h"
+#include "ProfileManager.h"
+#include "EncodingUtils.h"
+#include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <iterator>
 #include <regex>
 #include <cstdio>
+#include <cwchar>
+
+namespace
+{
+    // Accessed only through std::atomic_load / std::atomic_store
+    std::shared_ptr<const std::vector<Prompt>> g_catalog = std::make_shared<const std::vector<Prompt>>();
+
+    std::wstring trim(const std::wstring &text)
+    {
+        size_t begin = text.find_first_not_of(L" \t");
+        if (begin == std::wstring::npos)
+            return std::wstring();
+        return text.substr(begin, text.find_last_not_of(L" \t") - begin + 1);
+    }
+
+    /**
+     * Split a prompt header into the name and its parameter overrides
+     *
+     * @param header Text between "[Prompt:" and "]", e.g. "Fix typo; profile=local; max_tokens=200"
+     * @param prompt Receives the name and the overrides
+     */
+    void parsePromptHeader(const std::wstring &header, Prompt &prompt)
+    {
+        size_t start = header.find(L';');
+        prompt.name = trim(header.substr(0, start));
+
+        while (start != std::wstring::npos)
+        {
+            size_t end = header.find(L';', start + 1);
+            std::wstring item = header.substr(start + 1, (end == std::wstring::npos) ? std::wstring::npos : end - start - 1);
+            start = end;
+
+            size_t equals = item.find(L'=');
+            if (equals == std::wstring::npos)
+                continue;
+            std::wstring key = trim(item.substr(0, equals));
+            std::wstring value = trim(item.substr(equals + 1));
+            if (value.empty())
+                continue;
+
+            PromptOverrides &overrides = prompt.overrides;
+            if (key == L"profile")
+                overrides.profile = value;
+            else if (key == L"model")
+                overrides.model = value;
+            else if (key == L"temperature")
+                overrides.temperature = static_cast<float>((std::min)(2.0, (std::max)(0.0, std::wcstod(value.c_str(), nullptr))));
+            else if (key == L"max_tokens")
+                overrides.maxTokens = (std::max)(0, static_cast<int>(std::wcstol(value.c_str(), nullptr, 10)));
+            else if (key == L"streaming")
+                overrides.streaming = (value == L"1") ? 1 : 0;
+        }
+    }
+
+    /**
+     * Copy of 'base' with the set overrides applied
+     */
+    std::shared_ptr<const ConfigSnapshot> applyOverrides(const ConfigSnapshot &base, const PromptOverrides &overrides)
+    {
+        std::shared_ptr<ConfigSnapshot> config = std::make_shared<ConfigSnapshot>(base);
+        if (!overrides.model.empty())
+            config->model = overrides.model;
+        if (overrides.temperature >= 0)
+            config->temperature = overrides.temperature;
+        if (overrides.maxTokens >= 0)
+            config->maxTokens = overrides.maxTokens;
+        if (overrides.streaming >= 0)
+            config->streaming = (overrides.streaming == 1);
+        return config;
+    }
+}
+
+bool PromptOverrides::empty() const
+{
+    return profile.empty() && model.empty() && temperature < 0 && maxTokens < 0 && streaming < 0;
+}
+
+/**
+ * Reads the lines of the instructions file without their line terminators
+ *
+ * UTF-16 (with BOM) and UTF-8 files are accepted. A file that is empty or holds
+ * only a byte order mark yields no lines.
+ *
+ * @param filePath Path to the instructions/prompts file
+ * @param lines Output vector of lines
+ * @return false if the file could not be opened
+ */
+static bool readInstructionLines(const wchar_t *filePath, std::vector<std::wstring> &lines)
+{
+#ifdef _WIN32
+    FILE *file = _wfopen(filePath, L"r, ccs=UNICODE");
+    if (!file)
+        return false;
+
+    WCHAR buffer[4096];
+    std::wstring line;
+    while (fgetws(buffer, _countof(buffer), file))
+    {
+        line += buffer;
+        // fgetws stops at the buffer size too; only a line terminator ends the line
+        if (line.empty() || line.back() != L'\n')
+        {
+            if (!feof(file))
+                continue;
+        }
+        line.erase(line.find_last_not_of(L"\r\n") + 1);
+        lines.push_back(line);
+        line.clear();
+    }
+    fclose(file);
+    return true;
+#else
+    std::ifstream file(toUTF8(filePath), std::ios::binary);
+    if (!file)
+        return false;
+
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::wstring text;
+    if (bytes.size() >= 2 && static_cast<unsigned char>(bytes[0]) == 0xFF && static_cast<unsigned char>(bytes[1]) == 0xFE)
+    {
+        for (size_t i = 2; i + 1 < bytes.size(); i += 2)
+            text += static_cast<wchar_t>(static_cast<unsigned char>(bytes[i]) | (static_cast<unsigned char>(bytes[i + 1]) << 8));
+    }
+    else
+    {
+        if (bytes.compare(0, 3, "\xEF\xBB\xBF") == 0)
+            bytes.erase(0, 3);
+        text = stringToWstring(bytes);
+    }
+
+    size_t start = 0;
+    while (start < text.size())
+    {
+        size_t newline = text.find(L'\n', start);
+        std::wstring line = text.substr(start, (newline == std::wstring::npos) ? std::wstring::npos : newline - start);
+        line.erase(line.find_last_not_of(L"\r\n") + 1);
+        lines.push_back(line);
+        start = (newline == std::wstring::npos) ? text.size() : newline + 1;
+    }
+    return true;
+#endif
+}
 
 /**
  * Parses the instructions file containing system prompts
@@ -22,51 +172,32 @@
  * [Prompt:name]
  * Prompt content here...
  *
+ * The header may also carry request parameters: [Prompt:name; model=...; max_tokens=200]
  * If no section headers are found, the entire file content is treated as a single prompt.
  *
  * @param filePath Path to the instructions/prompts file
  * @param prompts Output vector that will be filled with parsed prompts
  */
-void parseInstructionsFile(const WCHAR *filePath, std::vector<Prompt> &prompts)
+void parseInstructionsFile(const wchar_t *filePath, std::vector<Prompt> &prompts)
 {
-    FILE *file = _wfopen(filePath, L"r, ccs=UNICODE");
-    if (!file)
+    std::vector<std::wstring> lines;
+    if (!readInstructionLines(filePath, lines))
         return;
 
-    std::wstring line;
-    WCHAR buffer[4096];
     std::wregex headerPattern(LR"(^\[Prompt:([^\]]+)\])");
     std::wsmatch match;
     Prompt current;
     bool hasHeader = false;
 
-	// Check if the file is empty or contains only BOM characters
-    fseek(file, 0, SEEK_END);  
-    std::streamsize fileSize = ftell(file);
-    rewind(file);
-    fseek(file, 0, SEEK_SET);
-    if (fileSize == 0) {
+    // An empty file (or one holding only a BOM) still yields the empty default prompt
+    if (lines.empty())
+    {
         prompts.push_back(current);
-        fclose(file);
         return;
     }
-    if (fileSize == 2) {  
-        std::vector<uint8_t> tmp_buffer(2);  
-        if (fread(tmp_buffer.data(), 1, 2, file) == 2) {
-            if (tmp_buffer[0] == 0xFF && tmp_buffer[1] == 0xFE) {
-                prompts.push_back(current);
-                fclose(file);  
-                return;  
-            }  
-        }  
-    }
 
-    while (fgetws(buffer, _countof(buffer), file))
+    for (const std::wstring &line : lines)
     {
-        line = buffer;
-        if (!line.empty())
-            line.erase(line.find_last_not_of(L"\r\n") + 1);
-
         if (std::regex_match(line, match, headerPattern))
         {
             // If we found a new header and already have a prompt in progress,
@@ -74,7 +205,7 @@ void parseInstructionsFile(const WCHAR *filePath, std::vector<Prompt> &prompts)
             if (hasHeader)
                 prompts.push_back(current);
             current = Prompt();
-            current.name = match[1].str();
+            parsePromptHeader(match[1].str(), current);
             hasHeader = true;
         }
         else if (hasHeader)
@@ -88,12 +219,48 @@ void parseInstructionsFile(const WCHAR *filePath, std::vector<Prompt> &prompts)
             current.content += line + L"\n";
         }
     }
-    fclose(file);
     // Save the final prompt
     if (hasHeader || !current.content.empty())
         prompts.push_back(current);
 }
 
+/**
+ * Replaces the prompt catalog used by requests
+ *
+ * @param prompts Prompts parsed from the instructions file
+ */
+void setPromptCatalog(std::vector<Prompt> prompts)
+{
+    for (Prompt &prompt : prompts)
+    {
+        if (prompt.overrides.profile.empty())
+            continue;
+
+        // An unknown profile is ignored, so the prompt still works with the active one
+        std::shared_ptr<const ConfigSnapshot> profile = ProfileManager::instance().snapshot(prompt.overrides.profile);
+        if (profile)
+            prompt.config = applyOverrides(*profile, prompt.overrides);
+    }
+    std::atomic_store(&g_catalog, std::shared_ptr<const std::vector<Prompt>>(std::make_shared<std::vector<Prompt>>(std::move(prompts))));
+}
+
+std::shared_ptr<const std::vector<Prompt>> promptCatalog()
+{
+    return std::atomic_load(&g_catalog);
+}
+
+std::shared_ptr<const ConfigSnapshot> resolvePromptConfig(const Prompt *prompt, const std::shared_ptr<const ConfigSnapshot> &base)
+{
+    if (!prompt)
+        return base;
+    if (prompt->config)
+        return prompt->config;
+    if (prompt->overrides.empty())
+        return base;
+    return applyOverrides(*base, prompt->overrides);
+}
+
+#ifdef _WIN32
 /**
  * Displays a dialog for the user to choose a system prompt
  *
@@ -136,3 +303,4 @@ int choosePrompt(HWND owner, const std::vector<Prompt> &prompts, int lastUsedInd
         return -1;
     return pressed - 1000;
 }
+#endif
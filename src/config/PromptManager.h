@@ -10,7 +10,31 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <memory>
+
+#ifdef _WIN32
 #include <windows.h>
+#endif
+
+struct ConfigSnapshot;
+
+/**
+ * Request parameters a prompt overrides
+ *
+ * Listed in the prompt header after the name, separated by semicolons:
+ * [Prompt:Fix typo; profile=local; max_tokens=200; temperature=0.1]
+ * Unset values (empty strings, negative numbers) keep the active setting.
+ */
+struct PromptOverrides
+{
+    std::wstring profile;     // Profile to send the prompt to ("default" for [API])
+    std::wstring model;       // Model name
+    float temperature = -1.0f;
+    int maxTokens = -1;
+    int streaming = -1;       // 0 or 1
+
+    bool empty() const;
+};
 
 /**
  * Represents a named system prompt
@@ -22,6 +46,12 @@ struct Prompt
 {
     std::wstring name;    // Display name of the prompt
     std::wstring content; // Full text content of the prompt
+    PromptOverrides overrides;
+
+    // Configuration with the overrides applied, resolved when the catalog is loaded.
+    // Only set for prompts that name a profile; the others follow routing rules
+    // and the active profile, see resolvePromptConfig.
+    std::shared_ptr<const ConfigSnapshot> config;
 };
 
 /**
@@ -36,8 +66,34 @@ struct Prompt
  * @param filePath Path to the instructions/prompts file
  * @param prompts Output vector that will be filled with parsed prompts
  */
-void parseInstructionsFile(const WCHAR *filePath, std::vector<Prompt> &prompts);
+void parseInstructionsFile(const wchar_t *filePath, std::vector<Prompt> &prompts);
+
+/**
+ * Replaces the prompt catalog used by requests
+ *
+ * Called by loadConfig after the profiles are loaded: prompts that name a
+ * profile get their configuration resolved here, once, instead of per request.
+ *
+ * @param prompts Prompts parsed from the instructions file
+ */
+void setPromptCatalog(std::vector<Prompt> prompts);
+
+/**
+ * Returns the prompts of the instructions file as of the last configuration load (never null)
+ */
+std::shared_ptr<const std::vector<Prompt>> promptCatalog();
+
+/**
+ * Returns the configuration a prompt is sent with
+ *
+ * @param prompt The chosen prompt (may be null)
+ * @param base Configuration chosen by routing rules or the active profile
+ * @return The prompt's pre-resolved configuration if it names a profile,
+ *         otherwise 'base' with the prompt's overrides applied
+ */
+std::shared_ptr<const ConfigSnapshot> resolvePromptConfig(const Prompt *prompt, const std::shared_ptr<const ConfigSnapshot> &base);
 
+#ifdef _WIN32
 /**
  * Displays a dialog for the user to select one of the available prompts
  *
@@ -47,3 +103,4 @@ void parseInstructionsFile(const WCHAR *filePath, std::vector<Prompt> &prompts);
  * @return Index of the selected prompt, or -1 if canceled or no selection
  */
 int choosePrompt(HWND owner, const std::vector<Prompt> &prompts, int lastUsedIndex);
+#endif
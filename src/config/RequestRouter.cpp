@@ -0,0 +1,82 @@
+/**
+ * RequestRouter.cpp - Rule-based choice of the backend profile for a request
+ */
+
+#include "RequestRouter.h"
+#include "ProfileManager.h"
+#include <algorithm>
+#include <cwctype>
+
+RequestRouter &RequestRouter::instance()
+{
+    static RequestRouter router;
+    return router;
+}
+
+void RequestRouter::setRules(std::vector<RoutingRule> rules)
+{
+    rules.erase(std::remove_if(rules.begin(), rules.end(), [](const RoutingRule &rule)
+                               { return rule.candidates.empty(); }),
+                rules.end());
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _rules.swap(rules);
+}
+
+size_t RequestRouter::size() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _rules.size();
+}
+
+std::shared_ptr<const ConfigSnapshot> RequestRouter::route(size_t selectionChars, const std::wstring &extension) const
+{
+    std::wstring ext = normalizeExtension(extension);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const RoutingRule &rule : _rules)
+    {
+        if (selectionChars < rule.minChars || selectionChars > rule.maxChars)
+            continue;
+        if (!rule.extensions.empty() && std::find(rule.extensions.begin(), rule.extensions.end(), ext) == rule.extensions.end())
+            continue;
+
+        if (!rule.preferFastest || rule.candidates.size() == 1)
+            return rule.candidates.front();
+
+        // Unmeasured profiles are tried first, so every candidate gets a latency estimate
+        std::shared_ptr<const ConfigSnapshot> best;
+        double bestTtfb = 0;
+        for (const std::shared_ptr<const ConfigSnapshot> &candidate : rule.candidates)
+        {
+            double ttfb = ProfileManager::instance().usage(candidate->profile).ewmaTtfbMs;
+            if (!best || ttfb < bestTtfb)
+            {
+                best = candidate;
+                bestTtfb = ttfb;
+            }
+        }
+        return best;
+    }
+    return nullptr;
+}
+
+size_t RequestRouter::countChars(const std::string &utf8)
+{
+    // Count every byte except UTF-8 continuation bytes (10xxxxxx)
+    size_t count = 0;
+    for (unsigned char c : utf8)
+    {
+        if ((c & 0xC0) != 0x80)
+            ++count;
+    }
+    return count;
+}
+
+std::wstring RequestRouter::normalizeExtension(const std::wstring &extension)
+{
+    std::wstring ext = (!extension.empty() && extension[0] == L'.') ? extension.substr(1) : extension;
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](wchar_t c)
+                   { return static_cast<wchar_t>(std::towlower(c)); });
+    return ext;
+}
@@ -0,0 +1,61 @@
+/**
+ * RequestRouter.h - Rule-based choice of the backend profile for a request
+ *
+ * [Route:name] sections of the INI file send requests to a profile depending on
+ * the size of the selection and the extension of the edited file, e.g. short
+ * selections in .txt files to a fast local model and everything else to the
+ * active profile. Rules are checked in file order and the first match wins.
+ * The profiles of each rule are resolved to their ConfigSnapshots when the
+ * configuration is loaded, so routing a request is only a few comparisons.
+ */
+
+#pragma once
+
+#include "ConfigSnapshot.h"
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct RoutingRule
+{
+    std::wstring name;                    // Section name after "Route:"
+    size_t minChars = 0;                  // Smallest matching selection (characters)
+    size_t maxChars = static_cast<size_t>(-1); // Largest matching selection (characters)
+    std::vector<std::wstring> extensions; // Lower-case file extensions without the dot; empty matches any file
+    bool preferFastest = false;           // Pick the candidate with the lowest measured latency instead of the first one
+    std::vector<std::shared_ptr<const ConfigSnapshot>> candidates; // Profiles in order of preference (cheapest first)
+};
+
+class RequestRouter
+{
+public:
+    static RequestRouter &instance();
+
+    // Replace the rules (rules without candidates are dropped)
+    void setRules(std::vector<RoutingRule> rules);
+
+    // Number of active rules
+    size_t size() const;
+
+    /**
+     * Configuration for a request, or null if no rule matches
+     *
+     * @param selectionChars Length of the selected text in characters
+     * @param extension Extension of the current file (with or without the dot, any case)
+     */
+    std::shared_ptr<const ConfigSnapshot> route(size_t selectionChars, const std::wstring &extension) const;
+
+    // Number of characters in UTF-8 text
+    static size_t countChars(const std::string &utf8);
+
+    // Lower-case an extension and strip a leading dot
+    static std::wstring normalizeExtension(const std::wstring &extension);
+
+private:
+    RequestRouter() = default;
+
+    mutable std::mutex _mutex;
+    std::vector<RoutingRule> _rules;
+};
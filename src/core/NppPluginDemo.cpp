@@ -15,6 +15,9 @@
 #include "Scintilla.h"
 #include "core/external_globals.h"
 #include "utils/EncodingUtils.h"
+#include "api/ModelWarmup.h"
+#include "api/OllamaContext.h"
+#include "api/Preconnector.h"
 #include <fstream>
 
 // Define streaming message used in OpenAIClient.cpp
@@ -131,6 +134,29 @@ extern "C" __declspec(dllexport) void beNotified(SCNotification *notifyCode)
 	}
 	break;
 
+	case NPPN_FILECLOSED:
+	{
+		// The document's conversation ends with it
+		OllamaContext::instance().forget(L"buffer:" + std::to_wstring(notifyCode->nmhdr.idFrom));
+	}
+	break;
+
+	case SCN_UPDATEUI:
+	{
+		// The user is working in the editor: keep the Ollama model loaded
+		ModelWarmup::instance().noteActivity();
+
+		// A selection that is kept for a moment is likely to be sent: connect ahead of the ask
+		if ((notifyCode->updated & SC_UPDATE_SELECTION) && Preconnector::instance().isEnabled())
+		{
+			HWND scintilla = static_cast<HWND>(notifyCode->nmhdr.hwndFrom);
+			LRESULT selectionStart = ::SendMessage(scintilla, SCI_GETSELECTIONSTART, 0, 0);
+			LRESULT selectionEnd = ::SendMessage(scintilla, SCI_GETSELECTIONEND, 0, 0);
+			Preconnector::instance().noteSelection(static_cast<size_t>(selectionEnd - selectionStart));
+		}
+	}
+	break;
+
 	case NPPN_SHUTDOWN:
 	{
 		// Clean up resources when Notepad++ is shutting down
@@ -172,7 +198,7 @@ extern "C" __declspec(dllexport) LRESULT messageProc(UINT Message, WPARAM wParam
 					static int receivedCount = 0;
 					receivedCount++;
 					std::wstring status = L"Stream chunk #" + std::to_wstring(receivedCount) + L" received: [" +
-										  multiByteToWideChar(pChunk->substr(0, 10).c_str()) + L"...]";
+										  multiByteToWstring(pChunk->substr(0, 10)) + L"...]";
 					::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, (LPARAM)status.c_str());
 
 					// Also log to file
@@ -6,9 +6,14 @@
 #include "menuCmdID.h"
 #include "config/ConfigManager.h" // Configuration management functions
 #include "config/PromptManager.h" // System prompts management
+#include "config/IniFile.h"		  // Single-pass INI reading and writing
+#include "config/ProfileManager.h"	  // Active backend profile
 #include "EncodingUtils.h"		  // UTF-8 / wide-char conversion utilities
 #include "DebugUtils.h"			  // Debug logging functions
 #include "OpenAIClient.h"		  // API client wrapper for OpenAI integration
+#include "HTTPClient.h"			  // Shared connection pool cleanup
+#include "ModelWarmup.h"		  // Background model loading (stopped on shutdown)
+#include "Preconnector.h"		  // Speculative connections (stopped on shutdown)
 #include "ui/UIHelpers.h"		  // UI-related functions for menus and dialogs
 
 // Libraries for file operations, cURL, and JSON handling
@@ -61,6 +66,7 @@ std::wstring configAPIValue_baseURL = TEXT("https://api.openai.com/v1/");		// AP
 std::wstring configAPIValue_chatRoute = TEXT("chat/completions");				// Chat completions route path
 std::wstring configAPIValue_responseType = TEXT("openai");						// Response format type
 std::wstring configAPIValue_proxyURL = TEXT("0");								// Proxy URL (0 = no proxy)
+std::wstring configAPIValue_httpVersion = TEXT("auto");							// HTTP version: auto/2 (ALPN h2 with 1.1 fallback), 2-prior-knowledge, 1.1
 std::wstring configAPIValue_model = TEXT("gpt-4o-mini");						// Default LLM model
 std::wstring configAPIValue_instructions = TEXT("");							// System message for API requests
 std::wstring configAPIValue_temperature = TEXT("0.7");							// Randomness parameter
@@ -71,6 +77,31 @@ std::wstring configAPIValue_presencePenalty = TEXT("0");						// Topic repetitio
 std::wstring configAPIValue_streaming = TEXT("1");								// Add streaming flag ("1" to enable streaming responses from OpenAI)
 std::wstring configAPIValue_showReasoning = TEXT("0");							// Show reasoning sections ("1" to show, "0" to hide)
 std::wstring configAPIValue_keepAlive = TEXT("5m");								// Ollama: keep model in memory (seconds or suffix like 10m, 24h). "-1" to keep indefinitely, "0" to unload immediately. Default to 5 minutes to balance performance and resource usage.
+std::wstring configAPIValue_retryMaxAttempts = TEXT("3");						// Attempts per request including the first one ("1" disables retries)
+std::wstring configAPIValue_retryBaseDelayMs = TEXT("500");						// Exponential backoff base delay (ms)
+std::wstring configAPIValue_retryMaxDelayMs = TEXT("20000");					// Exponential backoff cap (ms); longer Retry-After hints are not retried
+std::wstring configAPIValue_endpoints = TEXT("");							// Comma-separated [Endpoint:name] sections for failover (empty = [API] values only)
+std::wstring configAPIValue_connectTimeoutMs = TEXT("10000");				// Connect timeout (ms) before failing over to the next endpoint
+std::wstring configAPIValue_hedging = TEXT("0");							// Send a duplicate of slow streaming requests ("1" to enable)
+std::wstring configAPIValue_hedgePercentile = TEXT("95");					// Hedge once time to first token exceeds this percentile of recent requests
+std::wstring configAPIValue_hedgeMinDelayMs = TEXT("250");					// Never hedge earlier than this (ms)
+std::wstring configAPIValue_hedgeBudgetPercent = TEXT("10");				// At most this share of requests (%) may be duplicated
+std::wstring configAPIValue_rateLimitRpm = TEXT("0");						// Client-side requests per minute per key (0 = learn from response headers)
+std::wstring configAPIValue_rateLimitTpm = TEXT("0");						// Client-side tokens per minute per key (0 = learn from response headers)
+std::wstring configAPIValue_captureDir = TEXT("");							// Directory for raw response fixtures (empty = off)
+std::wstring configAPIValue_traceFile = TEXT("");							// Chrome trace file of the asks (empty = off)
+std::wstring configAPIValue_ollamaWarmup = TEXT("1");						// Load the Ollama model in the background ("1" = on)
+std::wstring configAPIValue_preconnect = TEXT("0");							// Connect while a selection is made ("1" = on)
+std::wstring configAPIValue_preconnectDwellMs = TEXT("500");				// How long a selection must stay unchanged before connecting
+std::wstring configAPIValue_ollamaContext = TEXT("0");						// Send the previous Ollama context with follow-up asks ("1" = on)
+std::wstring configAPIValue_ollamaContextMaxTokens = TEXT("32768");		// Longest context kept per document, in tokens
+std::wstring configAPIValue_llamacppSlots = TEXT("1");						// llama-server slots to spread documents over ("0" = server picks)
+std::wstring configAPIValue_realtime = TEXT("0");							// Send OpenAI asks over a persistent Realtime API WebSocket ("1" = on)
+std::wstring configAPIValue_realtimeRoute = TEXT("realtime");				// Realtime API route below api_url
+std::wstring configAPIValue_realtimeIdleS = TEXT("120");					// Replace a realtime session unused for this long (seconds)
+std::wstring configAPIValue_streamTransport = TEXT("1");					// With streaming off, still receive the answer as a stream ("0" = plain request)
+std::wstring configAPIValue_streamBufferKb = TEXT("64");					// Streamed text queued for the editor before the transfer pauses ("0" = unbuffered)
+std::wstring configAPIValue_streamResumeKb = TEXT("16");					// A paused transfer resumes once the queue is down to this size
 bool isKeepQuestion = true;														// Keep original question in response
 std::vector<std::wstring> chatHistory = {};										// Chat history for context
 bool isLoadConfigAlertShown = false;											// Show alert only once for loading config
@@ -102,11 +133,14 @@ void pluginInit(HANDLE hModule)
 // Clean up resources and save settings on plugin unload
 void pluginCleanUp()
 {
-	wchar_t chatLimitBuffer[6];
-	wsprintfW(chatLimitBuffer, L"%d", _chatSettingsDlg.chatSetting_chatLimit);
-	::WritePrivateProfileString(TEXT("PLUGIN"), TEXT("keep_question"), isKeepQuestion ? TEXT("1") : TEXT("0"), iniFilePath);
-	::WritePrivateProfileString(TEXT("PLUGIN"), TEXT("is_chat"), _chatSettingsDlg.chatSetting_isChat ? TEXT("1") : TEXT("0"), iniFilePath);
-	::WritePrivateProfileString(TEXT("PLUGIN"), TEXT("chat_limit"), chatLimitBuffer, iniFilePath); // Convert int to LPCWSTR
+	// Update the settings in memory and rewrite the file once
+	IniFile ini;
+	ini.load(iniFilePath);
+	ini.set(L"PLUGIN", L"keep_question", isKeepQuestion ? L"1" : L"0");
+	ini.set(L"PLUGIN", L"is_chat", _chatSettingsDlg.chatSetting_isChat ? L"1" : L"0");
+	ini.set(L"PLUGIN", L"chat_limit", std::to_wstring(_chatSettingsDlg.chatSetting_chatLimit));
+	ini.set(L"PLUGIN", L"active_profile", ProfileManager::instance().activeName());
+	ini.save(iniFilePath);
 }
 
 // Initialize plugin menus and config paths
@@ -157,9 +191,10 @@ void commandMenuInit()
 	setCommand(5, TEXT("---"), NULL, NULL, false); // Separator
 	setCommand(6, TEXT("&Keep my question"), keepQuestionToggler, NULL, isKeepQuestion);
 	setCommand(7, TEXT("NppOpenAI &Chat Settings"), openChatSettingsDlg, NULL, false); // Text will be updated by updateToolbarIcons
-	setCommand(8, TEXT("---"), NULL, NULL, false);									   // Separator
-	setCommand(9, TEXT("&About"), openAboutDlg, NULL, false);
-	setCommand(10, TEXT("&Toggle Debug Mode"), toggleDebugMode, NULL, debugMode);
+	setCommand(8, TEXT("Switch &Profile"), switchProfile, NULL, false);				   // Text will be updated by updateToolbarIcons
+	setCommand(9, TEXT("---"), NULL, NULL, false);									   // Separator
+	setCommand(10, TEXT("&About"), openAboutDlg, NULL, false);
+	setCommand(11, TEXT("&Toggle Debug Mode"), toggleDebugMode, NULL, debugMode);
 }
 
 // Add and update toolbar icons in Notepad++
@@ -177,6 +212,11 @@ void commandMenuCleanUp()
 	// Destroy dialog resources
 	_loaderDlg.destroy();
 	_chatSettingsDlg.destroy();
+
+	// Stop the background work, then close pooled connections
+	ModelWarmup::instance().shutdown();
+	Preconnector::instance().shutdown();
+	HTTPClient::shutdown();
 }
 
 // Load instructions and config files when the files are saved
@@ -190,6 +230,7 @@ void loadConfigAndInstructionsOnSave(uptr_t fileIDFrom)
 	if (_wcsicmp(instructionsFilePath, fileName) == 0 || _wcsicmp(iniFilePath, fileName) == 0)
 	{
 		loadConfig(false);
+		UIHelpers::updateProfileMenu();
 	}
 }
 
@@ -227,6 +268,7 @@ void loadConfigWithoutPluginSettings()
 		isLoadConfigAlertShown = true;
 	}
 	loadConfig(false);
+	UIHelpers::updateProfileMenu();
 }
 
 // Open the plugin configuration INI file
@@ -267,6 +309,12 @@ void updateChatSettings(bool isWriteToFile)
 	UIHelpers::updateChatSettings(isWriteToFile);
 }
 
+// Activate the next backend profile
+void switchProfile()
+{
+	UIHelpers::switchProfile();
+}
+
 // Show the About dialog with version information
 void openAboutDlg()
 {
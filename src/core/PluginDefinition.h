@@ -56,7 +56,7 @@ const TCHAR NPP_PLUGIN_NAME[] = TEXT("NppOpenAI");
 //
 // Here define the number of your plugin commands
 //
-const int nbFunc = 10;
+const int nbFunc = 11;
 
 // Config vars: API
 #include "../config/ConfigManager.h"
@@ -129,6 +129,8 @@ void keepQuestionToggler();
 void openChatSettingsDlg();
 // Updates chat settings menu text and optionally saves to INI
 void updateChatSettings(bool isWriteToFile = false);
+// Activates the next backend profile
+void switchProfile();
 // Shows the About dialog
 void openAboutDlg();
 
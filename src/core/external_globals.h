@@ -71,6 +71,7 @@ extern std::wstring configAPIValue_baseURL;          // Base URL for API request
 extern std::wstring configAPIValue_chatRoute;        // Chat completions route path (e.g., "chat/completions") - corresponds to route_chat_completions
 extern std::wstring configAPIValue_responseType;     // Response format type (openai, ollama, claude, simple)
 extern std::wstring configAPIValue_proxyURL;         // Proxy URL for API requests (e.g., "http://proxy:8080" or "0" for none)
+extern std::wstring configAPIValue_httpVersion;      // HTTP version negotiation: "auto"/"2" (ALPN h2, fallback 1.1), "2-prior-knowledge" (h2c), "1.1"
 extern std::wstring configAPIValue_model;            // Model name for API requests
 extern std::wstring configAPIValue_instructions;     // Instructions for API requests
 extern std::wstring configAPIValue_temperature;      // Temperature setting for API requests
@@ -80,6 +81,31 @@ extern std::wstring configAPIValue_frequencyPenalty; // Frequency penalty for AP
 extern std::wstring configAPIValue_presencePenalty;  // Presence penalty for API requests
 extern std::wstring configAPIValue_streaming;        // Add streaming flag ("1" for enabled, "0" for disabled)
 extern std::wstring configAPIValue_showReasoning;    // Show reasoning sections ("1" to show <think></think> sections, "0" to remove them)
+extern std::wstring configAPIValue_retryMaxAttempts; // Maximum attempts per request including the first one (e.g. "3"; "1" disables retries)
+extern std::wstring configAPIValue_retryBaseDelayMs; // Base delay of the exponential backoff in milliseconds (e.g. "500")
+extern std::wstring configAPIValue_retryMaxDelayMs;  // Backoff cap in milliseconds; longer server wait hints are not retried (e.g. "20000")
+extern std::wstring configAPIValue_endpoints;       // Comma-separated list of [Endpoint:name] sections used for failover and load balancing (empty = [API] only)
+extern std::wstring configAPIValue_connectTimeoutMs; // Connect timeout in milliseconds (e.g. "10000")
+extern std::wstring configAPIValue_hedging;         // Hedge slow streaming requests with a duplicate ("1" for enabled, "0" for disabled)
+extern std::wstring configAPIValue_hedgePercentile; // Time-to-first-token percentile after which a request is hedged (e.g. "95")
+extern std::wstring configAPIValue_hedgeMinDelayMs; // Minimum hedge delay in milliseconds (e.g. "250")
+extern std::wstring configAPIValue_hedgeBudgetPercent; // Maximum share of requests that may be hedged, in percent (e.g. "10")
+extern std::wstring configAPIValue_rateLimitRpm;    // Client-side request limit per minute and key ("0" = only use the provider's rate-limit headers)
+extern std::wstring configAPIValue_rateLimitTpm;    // Client-side token limit per minute and key ("0" = only use the provider's rate-limit headers)
+extern std::wstring configAPIValue_captureDir;      // Directory where raw responses are saved as replay fixtures ("" = off)
+extern std::wstring configAPIValue_traceFile;       // File the request timeline is written to in Chrome trace format ("" = off)
+extern std::wstring configAPIValue_preconnect;      // Open the connection when a selection stays unchanged for a while ("1" for enabled, "0" for disabled)
+extern std::wstring configAPIValue_preconnectDwellMs; // How long the selection must stay unchanged before connecting, in milliseconds (e.g. "500")
+extern std::wstring configAPIValue_ollamaContext;          // Continue from the previous Ollama /api/generate context on the same document ("1" for enabled, "0" for disabled)
+extern std::wstring configAPIValue_ollamaContextMaxTokens; // Longest context kept per document, in tokens (e.g. "32768")
+extern std::wstring configAPIValue_llamacppSlots;          // llama-server slots each document is pinned to one of (e.g. "4"; "0" lets the server pick)
+extern std::wstring configAPIValue_realtime;               // Send asks to OpenAI endpoints over one persistent Realtime API WebSocket ("1" for enabled, "0" for disabled)
+extern std::wstring configAPIValue_realtimeRoute;          // Realtime API route path (e.g., "realtime") - corresponds to route_realtime
+extern std::wstring configAPIValue_realtimeIdleS;          // Seconds a realtime session may stay unused before it is replaced (e.g. "120"; "0" = never)
+extern std::wstring configAPIValue_streamTransport;        // With streaming disabled, still request a stream and insert the answer once complete ("1" for enabled, "0" for disabled)
+extern std::wstring configAPIValue_streamBufferKb;         // Streamed text (KiB) queued for the editor before the transfer is paused (e.g. "64"; "0" = insert from the transfer thread)
+extern std::wstring configAPIValue_streamResumeKb;         // Queue size (KiB) at which a paused transfer resumes (e.g. "16")
+extern std::wstring configAPIValue_ollamaWarmup;    // Load the Ollama model on startup and profile switch, refresh keep_alive while editing ("1" for enabled, "0" for disabled)
 extern std::wstring configAPIValue_keepAlive;        // Keep model loaded in memory (Ollama): e.g. "-1" (keep indefinitely), "0" (unload immediately), "10m" (keep for 10 minutes), "24h" (keep for 24 hours))
 extern HWND s_streamTargetScintilla;                 // Global handle to the Scintilla editor used for streaming responses
 
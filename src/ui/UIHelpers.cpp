@@ -21,7 +21,11 @@
 #include "PluginDefinition.h" // For toolbar icon definitions
 #include <curl/curl.h>        // For LIBCURL_VERSION
 #include <nlohmann/json.hpp>  // For JSON version constants
-#include "EncodingUtils.h"    // For myMultiByteToWideChar
+#include "EncodingUtils.h"    // For multiByteToWstring
+#include "config/IniFile.h"        // For saving the chat settings
+#include "config/ProfileManager.h" // For switching backend profiles
+#include "ModelWarmup.h"      // For loading the model of the new profile
+#include "Preconnector.h"     // For pre-connecting to the new profile
 #include "interfaces/IUIService.h"
 #include "interfaces/IConfigurationService.h"
 #include "interfaces/IMenuService.h"
@@ -118,14 +122,54 @@ void UIHelpers::updateChatSettings(bool isWriteToFile)
 
         if (isWriteToFile)
         {
-            wchar_t chatLimitBuffer[6];
-            wsprintfW(chatLimitBuffer, L"%d", _chatSettingsDlg.chatSetting_chatLimit);
-            ::WritePrivateProfileString(TEXT("PLUGIN"), TEXT("is_chat"), _chatSettingsDlg.chatSetting_isChat ? TEXT("1") : TEXT("0"), iniFilePath);
-            ::WritePrivateProfileString(TEXT("PLUGIN"), TEXT("chat_limit"), chatLimitBuffer, iniFilePath);
+            IniFile ini;
+            ini.load(iniFilePath);
+            ini.set(L"PLUGIN", L"is_chat", _chatSettingsDlg.chatSetting_isChat ? L"1" : L"0");
+            ini.set(L"PLUGIN", L"chat_limit", std::to_wstring(_chatSettingsDlg.chatSetting_chatLimit));
+            ini.save(iniFilePath);
         }
     }
 }
 
+/**
+ * Activates the next backend profile
+ *
+ * The profiles are parsed when the configuration is loaded, so switching only
+ * publishes another snapshot; the profile's pooled connections stay open.
+ */
+void UIHelpers::switchProfile()
+{
+    std::wstring name = ProfileManager::instance().activateNext();
+    updateProfileMenu();
+
+    std::shared_ptr<const ConfigSnapshot> config = ConfigSnapshot::current();
+    ModelWarmup::instance().warmUp(config);
+    Preconnector::instance().configure(config);
+    ProfileUsage usage = ProfileManager::instance().usage(name);
+    std::wstring statusMsg = L"NppOpenAI: profile " + ProfileManager::displayName(name) + L" (" + config->model + L", " +
+                             std::to_wstring(usage.requests) + L" requests, " + std::to_wstring(usage.failures) + L" failed";
+    if (usage.promptTokens > 0)
+    {
+        statusMsg += L", " + std::to_wstring(usage.cachedTokens * 100 / usage.promptTokens) + L"% of prompt tokens cached";
+    }
+    statusMsg += L")";
+    ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, (LPARAM)statusMsg.c_str());
+}
+
+/**
+ * Updates the Switch Profile menu label to show the active profile
+ */
+void UIHelpers::updateProfileMenu()
+{
+    std::wstring menuText = L"Switch &Profile: " + ProfileManager::displayName(ProfileManager::instance().activeName());
+
+    MENUITEMINFOW menuItemInfo{};
+    menuItemInfo.cbSize = sizeof(MENUITEMINFOW);
+    menuItemInfo.fMask = MIIM_TYPE | MIIM_DATA;
+    menuItemInfo.dwTypeData = const_cast<LPWSTR>(menuText.c_str());
+    SetMenuItemInfoW(::GetMenu(nppData._nppHandle), funcItem[8]._cmdID, MF_STRING, &menuItemInfo);
+}
+
 /**
  * Adds or updates toolbar icons
  *
@@ -143,6 +187,7 @@ void UIHelpers::updateToolbarIcons()
         g_menuService->updateToolbarIcons();
         // Also update the chat settings menu
         updateChatSettings();
+        updateProfileMenu();
     }
     else
     {
@@ -169,6 +214,7 @@ void UIHelpers::updateToolbarIcons()
 
         // Update chat settings menu label
         UIHelpers::updateChatSettings();
+        UIHelpers::updateProfileMenu();
     }
 }
 
@@ -201,7 +247,7 @@ Thank you to the contributors for their support!\n\
     else
     {
         // Legacy global-based approach (backward compatibility)
-        ::MessageBox(nppData._nppHandle, myMultiByteToWideChar(about), TEXT("About"), MB_OK);
+        ::MessageBox(nppData._nppHandle, multiByteToWstring(about).c_str(), TEXT("About"), MB_OK);
     }
 }
 
@@ -94,6 +94,19 @@ namespace UIHelpers
      */
     void openChatSettingsDlg();
 
+    /**
+     * Activates the next backend profile
+     *
+     * Cycles through [API] and the [Profile:name] sections and shows the new
+     * profile with its usage counters in the status bar.
+     */
+    void switchProfile();
+
+    /**
+     * Updates the Switch Profile menu label to show the active profile
+     */
+    void updateProfileMenu();
+
     /**
      * Displays the About dialog with version information
      *
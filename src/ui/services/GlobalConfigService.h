@@ -3,7 +3,7 @@
  *
  * SEPARATION PLAN: Phase 2 - Implementation Wrappers
  * This class implements IConfigurationService using the current global
- * iniFilePath variable and Win32 INI file APIs. It serves as a bridge
+ * iniFilePath variable and IniFile. It serves as a bridge
  * during the transition period, allowing UI components to use the service
  * interface while maintaining backward compatibility.
  *
@@ -20,7 +20,7 @@ namespace UIServices
      * Global implementation of IConfigurationService
      *
      * This implementation wraps the current global iniFilePath access
-     * and Win32 INI file APIs to provide the IConfigurationService interface
+     * and IniFile to provide the IConfigurationService interface
      * while maintaining compatibility with existing code during transition.
      */
     class GlobalConfigService : public IConfigurationService
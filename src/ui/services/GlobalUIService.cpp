@@ -19,7 +19,7 @@ namespace UIServices
     void GlobalUIService::showAboutDialog(const std::string &aboutText)
     {
         // Use existing global state and Win32 API
-        ::MessageBox(nppData._nppHandle, myMultiByteToWideChar(aboutText.c_str()), TEXT("About"), MB_OK);
+        ::MessageBox(nppData._nppHandle, multiByteToWstring(aboutText).c_str(), TEXT("About"), MB_OK);
     }
 
     void GlobalUIService::setKeepQuestionState(bool enabled)
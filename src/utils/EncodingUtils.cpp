@@ -9,8 +9,13 @@
 
 #include "EncodingUtils.h"
 #include <codecvt>
+#include <cstring>
 #include <locale>
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
 /**
  * Converts a UTF-8 encoded std::string to a UTF-16 (wide) std::wstring
  *
@@ -24,7 +29,7 @@ std::wstring stringToWstring(const std::string &str)
 {
     try
     {
-        static std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
+        thread_local std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
         return conv.from_bytes(str);
     }
     catch (...)
@@ -52,7 +57,7 @@ std::string toUTF8(const std::wstring &wide)
 {
     try
     {
-        static std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
+        thread_local std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
         return conv.to_bytes(wide);
     }
     catch (...)
@@ -90,17 +95,45 @@ std::string toUTF8(const std::wstring &wide)
 }
 
 /**
- * Converts a UTF-8 encoded char array to a wide character (UTF-16) TCHAR array
+ * Converts a UTF-8 encoded char array to a wide character array
  *
- * Uses the Windows API's MultiByteToWideChar function to perform the conversion.
+ * Uses the Windows API's MultiByteToWideChar function to perform the conversion;
+ * other platforms use stringToWstring.
  *
  * @param utf8 UTF-8 encoded char array to convert
- * @return Pointer to a newly allocated TCHAR array containing the wide character string
+ * @return Pointer to a newly allocated wchar_t array containing the wide character string
  */
-TCHAR *multiByteToWideChar(const char *utf8)
+wchar_t *multiByteToWideChar(const char *utf8)
 {
+#ifdef _WIN32
     int len = MultiByteToWideChar(CP_UTF8, 0, utf8, -1, nullptr, 0);
     wchar_t *wide = new wchar_t[len];
     MultiByteToWideChar(CP_UTF8, 0, utf8, -1, wide, len);
-    return reinterpret_cast<TCHAR *>(wide);
+    return wide;
+#else
+    std::wstring converted = stringToWstring(utf8);
+    wchar_t *wide = new wchar_t[converted.size() + 1];
+    std::memcpy(wide, converted.c_str(), (converted.size() + 1) * sizeof(wchar_t));
+    return wide;
+#endif
+}
+
+/**
+ * Convert multi-byte UTF-8 string to wide string
+ *
+ * @param utf8 UTF-8 encoded string to convert
+ * @return Wide string
+ */
+std::wstring multiByteToWstring(const std::string &utf8)
+{
+#ifdef _WIN32
+    if (utf8.empty())
+        return std::wstring();
+    int len = MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), nullptr, 0);
+    std::wstring wide(static_cast<size_t>(len), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), &wide[0], len);
+    return wide;
+#else
+    return stringToWstring(utf8);
+#endif
 }
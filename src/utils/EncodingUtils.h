@@ -8,7 +8,6 @@
 
 #pragma once
 #include <string>
-#include <windows.h>
 
 /**
  * Converts a UTF-8 encoded std::string to a UTF-16 (wide) std::wstring
@@ -53,12 +52,26 @@ void safeFree(void *str);
 inline std::string toUTF8(const wchar_t *w) { return toUTF8(std::wstring(w)); }
 
 /**
- * Convert multi-byte UTF-8 string to wide string (allocate new TCHAR[])
+ * Convert multi-byte UTF-8 string to wide string (allocate new wchar_t[])
+ *
+ * The caller owns the result and must delete[] it; use multiByteToWstring
+ * unless a raw buffer is really needed.
  *
  * @param utf8 UTF-8 encoded string to convert
  * @return Wide character string
  */
-TCHAR *multiByteToWideChar(const char *utf8);
+wchar_t *multiByteToWideChar(const char *utf8);
+
+/**
+ * Convert multi-byte UTF-8 string to wide string, same conversion as multiByteToWideChar
+ *
+ * Unlike stringToWstring, characters outside the BMP become surrogate pairs on
+ * Windows instead of triggering the byte-wise fallback.
+ *
+ * @param utf8 UTF-8 encoded string to convert
+ * @return Wide string
+ */
+std::wstring multiByteToWstring(const std::string &utf8);
 
 /**
  * Map legacy calls if needed
@@ -0,0 +1,228 @@
+/**
+ * Trace.cpp - Per-thread trace buffers and Chrome Trace Event export
+ */
+
+#include "Trace.h"
+#include "EncodingUtils.h" // for stringToWstring
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> Trace::Detail::enabled(false);
+
+namespace
+{
+    struct TraceEvent
+    {
+        const char *name;
+        const char *category;
+        char phase; // 'X' complete, 'i' instant
+        double startUs;
+        double durationUs;
+        const char *argName;
+        int64_t argValue;
+    };
+
+    /**
+     * Events of one thread; the lock is only contended while exporting
+     */
+    struct ThreadBuffer
+    {
+        std::mutex mutex;
+        std::vector<TraceEvent> events;
+        size_t dropped = 0;
+        int threadId = 0;
+        const char *threadName = nullptr;
+    };
+
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers; // Outlive their threads, so late exports still see them
+        std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    };
+
+    Registry &registry()
+    {
+        static Registry instance;
+        return instance;
+    }
+
+    ThreadBuffer &threadBuffer()
+    {
+        thread_local ThreadBuffer *buffer = nullptr;
+        if (!buffer)
+        {
+            Registry &reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            reg.buffers.emplace_back(new ThreadBuffer());
+            buffer = reg.buffers.back().get();
+            buffer->threadId = static_cast<int>(reg.buffers.size());
+        }
+        return *buffer;
+    }
+
+    void record(const TraceEvent &event)
+    {
+        ThreadBuffer &buffer = threadBuffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        if (buffer.events.size() >= Trace::kMaxEventsPerThread)
+        {
+            buffer.dropped++;
+            return;
+        }
+        buffer.events.push_back(event);
+    }
+
+    // Names are literals from the code, but keep the output valid JSON regardless
+    void appendEscaped(std::string &out, const char *text)
+    {
+        for (const char *c = text; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+                out += '\\';
+            if (static_cast<unsigned char>(*c) >= 0x20)
+                out += *c;
+        }
+    }
+}
+
+void Trace::setEnabled(bool enabled)
+{
+    registry(); // Start the clock before the first event
+    Detail::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+double Trace::nowUs()
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - registry().epoch).count();
+}
+
+void Trace::complete(const char *name, const char *category, double startUs, double durationUs,
+                     const char *argName, int64_t argValue)
+{
+    if (!isEnabled())
+        return;
+    record(TraceEvent{name, category, 'X', startUs, durationUs, argName, argValue});
+}
+
+void Trace::instant(const char *name, const char *category, const char *argName, int64_t argValue)
+{
+    if (!isEnabled())
+        return;
+    record(TraceEvent{name, category, 'i', nowUs(), 0, argName, argValue});
+}
+
+void Trace::setThreadName(const char *name)
+{
+    ThreadBuffer &buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.threadName = name;
+}
+
+size_t Trace::eventCount()
+{
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    size_t count = 0;
+    for (const auto &buffer : reg.buffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        count += buffer->events.size();
+    }
+    return count;
+}
+
+size_t Trace::droppedCount()
+{
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    size_t count = 0;
+    for (const auto &buffer : reg.buffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        count += buffer->dropped;
+    }
+    return count;
+}
+
+void Trace::clear()
+{
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto &buffer : reg.buffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->events.clear();
+        buffer->dropped = 0;
+    }
+}
+
+std::string Trace::toJson()
+{
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    char number[128];
+    for (const auto &buffer : reg.buffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        if (buffer->threadName)
+        {
+            out += first ? "\n" : ",\n";
+            first = false;
+            std::snprintf(number, sizeof(number), "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"", buffer->threadId);
+            out += number;
+            appendEscaped(out, buffer->threadName);
+            out += "\"}}";
+        }
+        for (const TraceEvent &event : buffer->events)
+        {
+            out += first ? "\n" : ",\n";
+            first = false;
+            out += "{\"name\":\"";
+            appendEscaped(out, event.name);
+            out += "\",\"cat\":\"";
+            appendEscaped(out, event.category);
+            if (event.phase == 'X')
+            {
+                std::snprintf(number, sizeof(number), "\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                              buffer->threadId, event.startUs, event.durationUs);
+            }
+            else
+            {
+                std::snprintf(number, sizeof(number), "\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%.3f",
+                              buffer->threadId, event.startUs);
+            }
+            out += number;
+            if (event.argName)
+            {
+                out += ",\"args\":{\"";
+                appendEscaped(out, event.argName);
+                std::snprintf(number, sizeof(number), "\":%lld}", static_cast<long long>(event.argValue));
+                out += number;
+            }
+            out += "}";
+        }
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+bool Trace::exportJson(const std::string &path)
+{
+    std::string text = toJson();
+#ifdef _WIN32
+    FILE *file = _wfopen(stringToWstring(path).c_str(), L"wb");
+#else
+    FILE *file = std::fopen(path.c_str(), "wb");
+#endif
+    if (!file)
+        return false;
+    bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    return (std::fclose(file) == 0) && ok;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * Trace - Timeline of a request's stages in Chrome Trace Event format
+ *
+ * Spans (TraceSpan) and instants are recorded into a buffer per thread and
+ * written on demand as Chrome Trace Event JSON, which chrome://tracing and
+ * https://ui.perfetto.dev open directly. Names and categories must be string
+ * literals (only the pointer is stored).
+ *
+ * Tracing is off by default. While it is off a span costs one relaxed atomic
+ * load; while it is on, two clock reads and an append to the thread's buffer.
+ * Each thread keeps at most kMaxEventsPerThread events, later ones are dropped.
+ *
+ * Enabled by the trace_file setting in the plugin and --trace in the CLI.
+ */
+namespace Trace
+{
+    const size_t kMaxEventsPerThread = 200000;
+
+    namespace Detail
+    {
+        extern std::atomic<bool> enabled;
+    }
+
+    inline bool isEnabled()
+    {
+        return Detail::enabled.load(std::memory_order_relaxed);
+    }
+
+    // Start or stop recording (recorded events are kept)
+    void setEnabled(bool enabled);
+
+    // Microseconds since the trace clock started
+    double nowUs();
+
+    // Record a finished span that began at startUs (optionally with one numeric argument)
+    void complete(const char *name, const char *category, double startUs, double durationUs,
+                  const char *argName = nullptr, int64_t argValue = 0);
+
+    // Record a point in time
+    void instant(const char *name, const char *category, const char *argName = nullptr, int64_t argValue = 0);
+
+    // Label the calling thread in the exported trace
+    void setThreadName(const char *name);
+
+    // Number of events recorded and dropped (buffer full) so far
+    size_t eventCount();
+    size_t droppedCount();
+
+    // Discard all recorded events
+    void clear();
+
+    // All events as Chrome Trace Event JSON ({"traceEvents": [...]})
+    std::string toJson();
+
+    // Write toJson() to 'path' (UTF-8); false if the file cannot be written
+    bool exportJson(const std::string &path);
+}
+
+/**
+ * TraceSpan - Records the lifetime of a scope as a complete ("X") event
+ *
+ *   TraceSpan span("build request", "request");
+ *   span.setArg("bytes", request.size());
+ */
+class TraceSpan
+{
+public:
+    TraceSpan(const char *name, const char *category)
+        : _name(name), _category(category), _startUs(Trace::isEnabled() ? Trace::nowUs() : -1)
+    {
+    }
+
+    ~TraceSpan()
+    {
+        if (_startUs >= 0)
+        {
+            Trace::complete(_name, _category, _startUs, Trace::nowUs() - _startUs, _argName, _argValue);
+        }
+    }
+
+    // Attach a numeric argument shown with the event (last call wins)
+    void setArg(const char *name, int64_t value)
+    {
+        _argName = name;
+        _argValue = value;
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *_name;
+    const char *_category;
+    double _startUs;
+    const char *_argName = nullptr;
+    int64_t _argValue = 0;
+};
@@ -0,0 +1,141 @@
+/**
+ * ConfigReloadTest.cpp - Configuration reloads while requests read it (also built with ThreadSanitizer)
+ *
+ * A reload parses the INI file, publishes a new ConfigSnapshot and hands the
+ * endpoint list and hedge settings to the router and the hedge policy, while
+ * transfers on worker threads keep reading the snapshot they started with and
+ * report their results to the same objects.
+ */
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TestSupport.h"
+#include "api/EndpointRouter.h"
+#include "api/HedgePolicy.h"
+#include "config/ConfigSnapshot.h"
+#include "config/IniFile.h"
+
+using namespace TestSupport;
+
+namespace
+{
+    const int kReloads = 2000;
+    const int kReaders = 4;
+
+    // Generation 'n' of the INI file: every value that changes encodes n, so readers can spot a torn snapshot
+    std::wstring iniText(int n)
+    {
+        std::wstring id = std::to_wstring(n);
+        return L"[API]\r\n"
+               L"api_url=http://127.0.0.1:" + std::to_wstring(10000 + n) + L"\r\n"
+               L"model=model-" + id + L"\r\n"
+               L"max_tokens=" + id + L"\r\n"
+               L"temperature=" + std::wstring(n % 2 ? L"0.5" : L"1.5") + L"\r\n"
+               L"hedging=" + std::wstring(n % 2 ? L"0" : L"1") + L"\r\n"
+               L"hedge_percentile=" + std::to_wstring(90 + n % 10) + L"\r\n";
+    }
+
+    // Hedge settings are clamped like the other numbers; invalid values keep the default
+    void parsesHedgeSettings()
+    {
+        IniFile ini;
+        ini.parse(L"[API]\r\nhedging=1\r\nhedge_percentile=120\r\nhedge_min_delay_ms=-5\r\nhedge_budget_percent=lots\r\n");
+        std::shared_ptr<ConfigSnapshot> snapshot = ConfigSnapshot::fromSection(ConfigSnapshot(), ini, L"API");
+        CHECK(snapshot->hedging);
+        CHECK_EQ(snapshot->hedgePercentile, 99.9);
+        CHECK_EQ(snapshot->hedgeMinDelayMs, 0);
+        CHECK_EQ(snapshot->hedgeBudgetPercent, 10.0);
+    }
+
+    std::vector<Endpoint> endpointsFor(int n)
+    {
+        std::vector<Endpoint> endpoints(2);
+        endpoints[0].name = L"primary-" + std::to_wstring(n % 3);
+        endpoints[1].name = L"backup-" + std::to_wstring(n % 5);
+        return endpoints;
+    }
+
+    bool consistent(const ConfigSnapshot &snapshot)
+    {
+        if (snapshot.maxTokens == 0)
+        {
+            return snapshot.model == ConfigSnapshot().model; // The initial snapshot
+        }
+        return snapshot.model == L"model-" + std::to_wstring(snapshot.maxTokens) &&
+               snapshot.baseUrl == "http://127.0.0.1:" + std::to_string(10000 + snapshot.maxTokens) + "/" &&
+               snapshot.temperature == (snapshot.maxTokens % 2 ? 0.5f : 1.5f);
+    }
+}
+
+int main()
+{
+    parsesHedgeSettings();
+
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+    std::atomic<long> reads(0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < kReaders; ++r)
+    {
+        readers.emplace_back([&]()
+                             {
+            IniFile profiles;
+            profiles.parse(L"[Profile:fast]\r\nmodel=fast\r\nstreaming=0\r\n");
+            while (!done)
+            {
+                // A request keeps the snapshot it started with, however many reloads happen meanwhile
+                std::shared_ptr<const ConfigSnapshot> snapshot = ConfigSnapshot::current();
+                std::shared_ptr<const ConfigSnapshot> profile = ConfigSnapshot::forProfile(*snapshot, profiles, L"fast");
+                if (!consistent(*snapshot) || profile->maxTokens != snapshot->maxTokens || profile->model != L"fast")
+                {
+                    ++torn;
+                }
+
+                // ... and reports to the router and the hedge policy the reload reconfigures
+                std::vector<Endpoint> ranked = EndpointRouter::instance().rankedEndpoints();
+                if (!ranked.empty())
+                {
+                    EndpointRouter::instance().recordSuccess(ranked.front().name, 5 + static_cast<double>(reads % 50));
+                    EndpointRouter::instance().recordFailure(ranked.back().name);
+                }
+                HedgePolicy::instance().hedgeDelayMs();
+                HedgePolicy::instance().tryAcquireHedge();
+                HedgePolicy::instance().recordTimeToFirstToken(static_cast<double>(reads % 100));
+                ++reads;
+            } });
+    }
+
+    while (reads == 0)
+    {
+        std::this_thread::yield();
+    }
+    for (int n = 1; n <= kReloads; ++n)
+    {
+        IniFile ini;
+        ini.parse(iniText(n));
+        std::shared_ptr<const ConfigSnapshot> snapshot = ConfigSnapshot::fromSection(ConfigSnapshot(), ini, L"API");
+        ConfigSnapshot::publish(snapshot);
+        EndpointRouter::instance().setEndpoints(endpointsFor(n));
+        HedgePolicy::instance().configure(snapshot->hedging, snapshot->hedgePercentile, snapshot->hedgeMinDelayMs, snapshot->hedgeBudgetPercent);
+        if (n % 100 == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    done = true;
+    for (std::thread &reader : readers)
+    {
+        reader.join();
+    }
+
+    report("%d reloads, %ld reads", kReloads, reads.load());
+    CHECK_EQ(torn.load(), 0);
+    CHECK(reads.load() > 0);
+    CHECK_EQ(ConfigSnapshot::current()->maxTokens, kReloads);
+    CHECK_EQ(EndpointRouter::instance().size(), static_cast<size_t>(2));
+    EndpointRouter::instance().setEndpoints({});
+    return finish();
+}
@@ -0,0 +1,222 @@
+/**
+ * FailoverTest.cpp - Endpoint failover and latency-aware routing across several mock servers
+ */
+
+#include <map>
+#include <thread>
+#include "TestSupport.h"
+#include "MockLlmServer.h"
+#include "api/ChatPipeline.h"
+#include "api/EndpointRouter.h"
+#include "api/HTTPClient.h"
+#include "config/ProfileManager.h"
+#include "config/PromptManager.h"
+#include "utils/EncodingUtils.h"
+
+using namespace TestSupport;
+
+namespace
+{
+    const int kTokens = 12;
+
+    // The [API] values of the endpoints; one attempt each, so failures move on to the next endpoint at once
+    std::shared_ptr<ConfigSnapshot> failoverConfig()
+    {
+        std::shared_ptr<ConfigSnapshot> config = localConfig(1);
+        config->retryMaxAttempts = 1;
+        config->connectTimeoutMs = 500;
+        return config;
+    }
+
+    ChatResult ask(const std::shared_ptr<ConfigSnapshot> &config)
+    {
+        return ChatPipeline::send("Say something", L"", config, ChatPipeline::candidateEndpoints(*config));
+    }
+
+    MockServerOptions answering(int ttfbMs = 0)
+    {
+        MockServerOptions options;
+        options.tokens = kTokens;
+        options.ttfbMs = ttfbMs;
+        return options;
+    }
+
+    // An endpoint that refuses connections is skipped and put in a cooldown
+    void skipsUnreachableEndpoint()
+    {
+        MockLlmServer gone(answering());
+        CHECK(gone.start());
+        int gonePort = gone.port();
+        gone.stop();
+        MockLlmServer backup(answering());
+        CHECK(backup.start());
+        EndpointRouter::instance().setEndpoints({localEndpoint(L"gone", gonePort), localEndpoint(L"backup", backup.port())});
+        CollectingHost host;
+        HostScope scope(host);
+
+        ChatResult result = ask(failoverConfig());
+        CHECK(result.ok);
+        CHECK(result.endpointName == L"backup");
+        CHECK_EQ(host.text(), MockLlmServer::answerText(kTokens));
+        CHECK_EQ(EndpointRouter::instance().health(L"gone").consecutiveFailures, 1);
+
+        // Cooling down: the next ask goes to the backup first
+        CHECK(EndpointRouter::instance().rankedEndpoints().front().name == L"backup");
+        CHECK(ask(failoverConfig()).ok);
+        CHECK_EQ(backup.requestCount(), 2);
+    }
+
+    // A 503 moves the ask to an endpoint of another type; the editor is prepared for the one that answers
+    void failsOverAcrossResponseTypes()
+    {
+        MockServerOptions overloaded = answering();
+        overloaded.errorStatus = 503;
+        MockLlmServer primary(overloaded);
+        MockLlmServer ollama(answering());
+        CHECK(primary.start());
+        CHECK(ollama.start());
+        EndpointRouter::instance().setEndpoints({localEndpoint(L"primary", primary.port()), localEndpoint(L"local", ollama.port(), "ollama")});
+        CollectingHost host;
+        HostScope scope(host);
+        uint64_t bytesBefore = ProfileManager::instance().usage(L"").bytesReceived;
+
+        ChatResult result = ask(failoverConfig());
+        CHECK(result.ok);
+        CHECK(result.responseType == L"ollama");
+        CHECK_EQ(primary.requestCount(), 1);
+        CHECK_EQ(ollama.requestCount(), 1);
+        CHECK_EQ(host.answerTypes().size(), static_cast<size_t>(1));
+        CHECK_EQ(host.answerTypes().empty() ? std::string() : host.answerTypes().front(), std::string("ollama"));
+        CHECK_EQ(host.text(), MockLlmServer::answerText(kTokens));
+
+        // The profile counts the stream's bytes, not the (empty) response text
+        CHECK(result.response.empty());
+        CHECK_EQ(ProfileManager::instance().usage(L"").bytesReceived - bytesBefore, static_cast<uint64_t>(result.stats.bytesReceived));
+        CHECK(result.stats.bytesReceived > MockLlmServer::answerText(kTokens).size());
+    }
+
+    // Errors that another endpoint would repeat (a rejected key) are not failed over
+    void reportsClientErrors()
+    {
+        MockServerOptions rejecting = answering();
+        rejecting.errorStatus = 401;
+        MockLlmServer primary(rejecting);
+        MockLlmServer backup(answering());
+        CHECK(primary.start());
+        CHECK(backup.start());
+        EndpointRouter::instance().setEndpoints({localEndpoint(L"primary", primary.port()), localEndpoint(L"backup", backup.port())});
+        CollectingHost host;
+        HostScope scope(host);
+
+        CHECK(!ask(failoverConfig()).ok);
+        CHECK_EQ(backup.requestCount(), 0);
+        CHECK_EQ(EndpointRouter::instance().health(L"primary").consecutiveFailures, 0);
+    }
+
+    // A stream that dropped after inserting text is not repeated on the next endpoint
+    void keepsDeliveredStream()
+    {
+        MockServerOptions dropping = answering();
+        dropping.disconnectAfterTokens = 3;
+        MockLlmServer primary(dropping);
+        MockLlmServer backup(answering());
+        CHECK(primary.start());
+        CHECK(backup.start());
+        EndpointRouter::instance().setEndpoints({localEndpoint(L"primary", primary.port()), localEndpoint(L"backup", backup.port())});
+        CollectingHost host;
+        HostScope scope(host);
+
+        CHECK(!ask(failoverConfig()).ok);
+        CHECK_EQ(backup.requestCount(), 0);
+        CHECK_EQ(host.text(), MockLlmServer::answerText(3));
+    }
+
+    // Once measured, the faster endpoint is preferred over the configured order and kept after a cooldown ends
+    void routesToFastestEndpoint()
+    {
+        MockServerOptions slowOptions = answering(80);
+        slowOptions.errorStatus = 503;
+        slowOptions.errorCount = 1;
+        MockLlmServer slow(slowOptions);
+        MockLlmServer fast(answering(5));
+        CHECK(slow.start());
+        CHECK(fast.start());
+        EndpointRouter::instance().setEndpoints({localEndpoint(L"slow", slow.port()), localEndpoint(L"fast", fast.port())});
+        CollectingHost host;
+        HostScope scope(host);
+
+        // The first endpoint is overloaded once, so the second one gets measured
+        ChatResult first = ask(failoverConfig());
+        CHECK(first.ok);
+        CHECK(first.endpointName == L"fast");
+        CHECK(EndpointRouter::instance().health(L"fast").ewmaTtfbMs > 0);
+
+        // After the cooldown the recovered endpoint still carries its error rate
+        std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+        const int kAsks = 10;
+        std::map<std::wstring, int> answeredBy;
+        double totalMs = 0;
+        for (int i = 0; i < kAsks; ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            ChatResult result = ask(failoverConfig());
+            totalMs += elapsedMs(start);
+            CHECK(result.ok);
+            answeredBy[result.endpointName]++;
+        }
+        report("slow %d, fast %d of %d asks, %.1f ms on average", answeredBy[L"slow"], answeredBy[L"fast"], kAsks, totalMs / kAsks);
+        CHECK_EQ(answeredBy[L"fast"], kAsks);
+        CHECK_EQ(slow.requestCount(), 1);
+
+        // The fast endpoint goes away: asks move to the slow one and the fast one ranks last
+        fast.stop();
+        ChatResult result = ask(failoverConfig());
+        CHECK(result.ok);
+        CHECK(result.endpointName == L"slow");
+        CHECK(EndpointRouter::instance().rankedEndpoints().back().name == L"fast");
+    }
+
+    // A prompt's model= override reaches every endpoint of the [API] configuration, not only a profile's
+    void sendsPromptModel()
+    {
+        MockLlmServer primary(answering());
+        MockLlmServer backup(answering());
+        CHECK(primary.start());
+        CHECK(backup.start());
+        std::shared_ptr<ConfigSnapshot> config = failoverConfig();
+        ProfileManager::instance().setProfiles(config, {}, L"");
+        EndpointRouter::instance().setEndpoints({localEndpoint(L"primary", primary.port()), localEndpoint(L"backup", backup.port())});
+        CollectingHost host;
+        HostScope scope(host);
+
+        Prompt prompt;
+        prompt.overrides.model = L"prompt-model";
+        std::shared_ptr<const ConfigSnapshot> overridden = resolvePromptConfig(&prompt, config);
+        std::vector<Endpoint> endpoints = ChatPipeline::candidateEndpoints(*overridden);
+        CHECK_EQ(endpoints.size(), static_cast<size_t>(2));
+        CHECK(ChatPipeline::send("Say something", L"", overridden, endpoints).ok);
+        CHECK_EQ(primary.lastModel(), std::string("prompt-model"));
+
+        // ... on the failover endpoint too
+        primary.stop();
+        CHECK(ChatPipeline::send("Say something", L"", overridden, endpoints).ok);
+        CHECK_EQ(backup.lastModel(), std::string("prompt-model"));
+
+        // Without the override the endpoints keep their model
+        CHECK(ask(config).ok);
+        CHECK_EQ(backup.lastModel(), toUTF8(config->model));
+    }
+}
+
+int main()
+{
+    skipsUnreachableEndpoint();
+    failsOverAcrossResponseTypes();
+    reportsClientErrors();
+    keepsDeliveredStream();
+    routesToFastestEndpoint();
+    sendsPromptModel();
+    EndpointRouter::instance().setEndpoints({});
+    HTTPClient::shutdown();
+    return finish();
+}
@@ -0,0 +1,95 @@
+/**
+ * FixtureReplayTest.cpp - Recorded responses of every response type replayed through HTTPClient's callbacks
+ *
+ * The fixtures in tests/fixtures were captured from the mock server with
+ * capture_dir (20 tokens at 100 tokens per second), once streamed and once as
+ * a complete response. Replaying them needs no network, so parser regressions
+ * show up against the exact bytes and chunking a transfer delivered.
+ */
+
+#include "TestSupport.h"
+#include "api/HTTPClient.h"
+#include "api/ResponseParsers.h"
+#include "api/StreamFixture.h"
+#include "utils/EncodingUtils.h"
+
+using namespace TestSupport;
+
+namespace
+{
+    const char *const kResponseTypes[] = {"openai", "claude", "ollama", "openai-responses", "gemini"};
+    const std::string kAnswer = "Lorem ipsum dolor sit amet, consectetur adipiscing elit. Sed do eiusmod tempor incididunt ut labore et dolore magna";
+    const double kSpeed = 10;
+
+    StreamFixture load(const std::string &name)
+    {
+        StreamFixture fixture;
+        CHECK(fixture.load(std::string(NPPOPENAI_FIXTURE_DIR) + "/" + name + ".fixture"));
+        return fixture;
+    }
+
+    // Replays at kSpeed take a tenth of the recorded time, however the delays are spread over the chunks
+    void checkTiming(const StreamFixture &fixture, double ms)
+    {
+        double recordedMs = fixture.durationUs() / 1000.0;
+        report("%zu chunks, recorded %.1f ms, replayed in %.1f ms", fixture.chunks.size(), recordedMs, ms);
+        CHECK(ms >= recordedMs / kSpeed * 0.9);
+        CHECK(ms < recordedMs);
+    }
+
+    // The streamed answer reaches the host whole, with the usage of the final events
+    void replaysStream(const std::string &responseType)
+    {
+        report("%s, streamed", responseType.c_str());
+        StreamFixture fixture = load(responseType + "-stream");
+        CHECK(fixture.streaming);
+        CHECK_EQ(fixture.apiType, responseType);
+        CollectingHost host;
+        HostScope scope(host);
+
+        std::string response;
+        TransferInfo transferInfo;
+        auto start = std::chrono::steady_clock::now();
+        CHECK(HTTPClient::replay(fixture, kSpeed, response, &transferInfo));
+        checkTiming(fixture, elapsedMs(start));
+        CHECK_EQ(host.text(), kAnswer);
+        CHECK(response.empty());
+        CHECK(transferInfo.contentDelivered);
+        CHECK_EQ(transferInfo.stats.bytesReceived, fixture.totalBytes());
+
+        // OpenAI chat streams only carry usage when asked for it with stream_options
+        if (responseType != "openai")
+        {
+            CHECK_EQ(transferInfo.usage.completionTokens, static_cast<int64_t>(20));
+        }
+    }
+
+    // The complete response comes back as the body and the type's response parser finds the answer in it
+    void replaysComplete(const std::string &responseType)
+    {
+        report("%s, complete", responseType.c_str());
+        StreamFixture fixture = load(responseType + "-complete");
+        CHECK(!fixture.streaming);
+        CollectingHost host;
+        HostScope scope(host);
+
+        std::string response;
+        TransferInfo transferInfo;
+        auto start = std::chrono::steady_clock::now();
+        CHECK(HTTPClient::replay(fixture, kSpeed, response, &transferInfo));
+        checkTiming(fixture, elapsedMs(start));
+        CHECK(host.text().empty());
+        CHECK_EQ(response.size(), fixture.totalBytes());
+        CHECK_EQ(ResponseParsers::getParserForEndpoint(stringToWstring(responseType))(response, false), kAnswer);
+    }
+}
+
+int main()
+{
+    for (const char *responseType : kResponseTypes)
+    {
+        replaysStream(responseType);
+        replaysComplete(responseType);
+    }
+    return finish();
+}
@@ -0,0 +1,170 @@
+/**
+ * HedgeTest.cpp - Hedged duplicates of slow streaming requests against the mock server
+ */
+
+#include <algorithm>
+#include "TestSupport.h"
+#include "MockLlmServer.h"
+#include "api/ChatPipeline.h"
+#include "api/HedgePolicy.h"
+#include "api/HTTPClient.h"
+#include "api/LatencyTracker.h"
+
+using namespace TestSupport;
+
+namespace
+{
+    const int kTokens = 12;
+    const int kHedgeDelayMs = 50;
+    const int kStallMs = 1000;
+
+    ChatResult ask(const std::shared_ptr<ConfigSnapshot> &config, const std::vector<Endpoint> &endpoints)
+    {
+        return ChatPipeline::send("Say something", L"", config, endpoints);
+    }
+
+    // Sends the headers and the metadata events at once, the first text after 'stallMs'
+    MockServerOptions queueing(int stallMs)
+    {
+        MockServerOptions options;
+        options.tokens = kTokens;
+        options.stallAfterTokens = 0;
+        options.stallMs = stallMs;
+        return options;
+    }
+
+    MockServerOptions answering()
+    {
+        MockServerOptions options;
+        options.tokens = kTokens;
+        return options;
+    }
+
+    // Nothing is hedged before enough times to first token were seen
+    void collectsSamples()
+    {
+        MockLlmServer server(answering());
+        CHECK(server.start());
+        CollectingHost host;
+        HostScope scope(host);
+        std::shared_ptr<ConfigSnapshot> config = localConfig(server.port());
+
+        for (size_t i = 0; i < HedgePolicy::kMinSamples; ++i)
+        {
+            CHECK_EQ(HedgePolicy::instance().hedgeDelayMs(), -1);
+            CHECK(ask(config, {localEndpoint(L"local", server.port())}).ok);
+        }
+        CHECK_EQ(server.requestCount(), static_cast<int>(HedgePolicy::kMinSamples));
+        CHECK_EQ(HedgePolicy::instance().hedgeDelayMs(), kHedgeDelayMs);
+    }
+
+    // Claude's message_start arrives at once, the text does not: the hedge to the next endpoint wins
+    void hedgeWinsOnContent()
+    {
+        MockLlmServer queued(queueing(1500));
+        MockLlmServer backup(answering());
+        CHECK(queued.start());
+        CHECK(backup.start());
+        CollectingHost host;
+        HostScope scope(host);
+
+        auto start = std::chrono::steady_clock::now();
+        ChatResult result = ask(localConfig(queued.port(), "claude"),
+                                {localEndpoint(L"queued", queued.port(), "claude"), localEndpoint(L"backup", backup.port())});
+        double ms = elapsedMs(start);
+        report("hedged ask answered in %.1f ms", ms);
+        CHECK(result.ok);
+        CHECK(result.endpointName == L"backup");
+        CHECK_EQ(backup.requestCount(), 1);
+        CHECK(ms < 1000);
+        CHECK_EQ(host.text(), MockLlmServer::answerText(kTokens));
+        CHECK_EQ(host.answerTypes().size(), static_cast<size_t>(1));
+        CHECK_EQ(host.answerTypes().empty() ? std::string() : host.answerTypes().front(), std::string("openai"));
+    }
+
+    /**
+     * Time to answer of asks to an endpoint that holds the text back for kStallMs, with every ask hedged and
+     * with the budget capped
+     *
+     * The stall is twenty times the minimum hedge delay, so the checks hold with wide margins on a loaded
+     * machine, where time to first token and with it the hedge delay grow. They do not rely on exact counts:
+     * a hedge can come too late to win.
+     */
+    void cutsTailLatency()
+    {
+        MockLlmServer queued(queueing(kStallMs));
+        MockLlmServer backup(answering());
+        CHECK(queued.start());
+        CHECK(backup.start());
+        CollectingHost host;
+        HostScope scope(host);
+        std::shared_ptr<ConfigSnapshot> config = localConfig(queued.port());
+        std::vector<Endpoint> endpoints = {localEndpoint(L"queued", queued.port()), localEndpoint(L"backup", backup.port())};
+
+        auto run = [&](int asks)
+        {
+            LatencyTracker latency;
+            for (int i = 0; i < asks; ++i)
+            {
+                host.clear();
+                auto start = std::chrono::steady_clock::now();
+                CHECK(ask(config, endpoints).ok);
+                latency.add(elapsedMs(start));
+                CHECK_EQ(host.text(), MockLlmServer::answerText(kTokens));
+            }
+            return latency;
+        };
+
+        // Each request earns a full credit: every ask is hedged, and most are answered well before the stall ends
+        const int kAsks = 20;
+        LatencyTracker hedged = run(kAsks);
+        int hedges = backup.requestCount();
+        report("all hedged: p50 %.1f ms, p99 %.1f ms, %d hedges in %d asks", hedged.percentile(50), hedged.percentile(99), hedges, kAsks);
+        CHECK(hedges >= kAsks / 2);
+        CHECK(hedged.percentile(50) < kStallMs / 2);
+
+        // 10% budget: at most the saved credits and one hedge in ten asks; the saved credit hedges the first ask
+        const int kCappedAsks = 10;
+        HedgePolicy::instance().configure(true, 95, kHedgeDelayMs, 10);
+        LatencyTracker capped = run(kCappedAsks);
+        hedges = backup.requestCount() - hedges;
+        report("10%% budget: p50 %.1f ms, %d hedges in %d asks", capped.percentile(50), hedges, kCappedAsks);
+        CHECK(hedges >= 1);
+        CHECK(hedges <= 2 + kCappedAsks / 10);
+        CHECK(capped.percentile(50) >= kStallMs);
+        HedgePolicy::instance().configure(true, 95, kHedgeDelayMs, 100);
+    }
+
+    // Without a failover endpoint the duplicate goes to the same endpoint, over the same h2c connection where libcurl can
+    void hedgeMultiplexesOverH2c()
+    {
+        MockLlmServer server(queueing(kStallMs));
+        CHECK(server.start());
+        CollectingHost host;
+        HostScope scope(host);
+        std::shared_ptr<ConfigSnapshot> config = localConfig(server.port());
+        config->httpVersion = "2-prior-knowledge";
+
+        ChatResult result = ask(config, {localEndpoint(L"local", server.port())});
+        CHECK(result.ok);
+        CHECK_EQ(host.text(), MockLlmServer::answerText(kTokens));
+        CHECK_EQ(server.requestCount(), 2);
+        CHECK_EQ(server.http2ConnectionCount(), reusesH2cConnections() ? 1 : 2);
+    }
+}
+
+int main()
+{
+    // The budget starts with one credit, so the first slow request can be hedged
+    HedgePolicy::instance().configure(true, 95, kHedgeDelayMs, 100);
+    CHECK(HedgePolicy::instance().tryAcquireHedge());
+    CHECK(!HedgePolicy::instance().tryAcquireHedge());
+
+    collectsSamples();
+    hedgeWinsOnContent();
+    hedgeMultiplexesOverH2c();
+    cutsTailLatency();
+    HedgePolicy::instance().configure(false, 95, kHedgeDelayMs, 10);
+    HTTPClient::shutdown();
+    return finish();
+}
@@ -0,0 +1,145 @@
+/**
+ * Http2Test.cpp - HTTP version selection and connection reuse against the mock server's h2c support
+ */
+
+#include <thread>
+#include <vector>
+#include "TestSupport.h"
+#include "MockLlmServer.h"
+#include "api/ChatPipeline.h"
+#include "api/HTTPClient.h"
+
+using namespace TestSupport;
+
+namespace
+{
+    ChatResult ask(const std::shared_ptr<ConfigSnapshot> &config)
+    {
+        return ChatPipeline::send("Say something", L"You are a test", config, ChatPipeline::candidateEndpoints(*config));
+    }
+
+    // Streamed over h2c, with events split across DATA frames; the second ask reuses the connection
+    void streamsOverPriorKnowledge()
+    {
+        MockServerOptions options;
+        options.tokens = 40;
+        options.chunkBytes = 7;
+        MockLlmServer server(options);
+        CHECK(server.start());
+
+        std::shared_ptr<ConfigSnapshot> config = localConfig(server.port());
+        config->httpVersion = "2-prior-knowledge";
+        CollectingHost host;
+        HostScope scope(host);
+
+        ChatResult first = ask(config);
+        CHECK(first.ok);
+        CHECK_EQ(host.text(), MockLlmServer::answerText(40));
+        CHECK_EQ(server.http2ConnectionCount(), 1);
+
+        host.clear();
+        ChatResult second = ask(config);
+        CHECK(second.ok);
+        CHECK_EQ(host.text(), MockLlmServer::answerText(40));
+        CHECK_EQ(server.requestCount(), 2);
+        CHECK_EQ(server.connectionCount(), reusesH2cConnections() ? 1 : 2);
+    }
+
+    // A complete (non-streamed) JSON answer over h2c
+    void completeOverPriorKnowledge()
+    {
+        MockServerOptions options;
+        options.tokens = 12;
+        options.chunkBytes = 5;
+        MockLlmServer server(options);
+        CHECK(server.start());
+
+        std::shared_ptr<ConfigSnapshot> config = localConfig(server.port(), "claude");
+        config->httpVersion = "h2c";
+        config->streaming = false;
+        config->streamTransport = false;
+        CollectingHost host;
+        HostScope scope(host);
+
+        ChatResult result = ask(config);
+        CHECK(result.ok);
+        CHECK(!result.collected);
+        CHECK_EQ(ChatPipeline::answerText(result, config->showReasoning), MockLlmServer::answerText(12));
+        CHECK_EQ(server.http2ConnectionCount(), 1);
+    }
+
+    // "auto" only negotiates HTTP/2 through TLS ALPN; plain http:// stays on HTTP/1.1, as does "1.1"
+    void plainHttpDefaultsToHttp11()
+    {
+        const char *versions[] = {"auto", "2", "1.1"};
+        for (const char *version : versions)
+        {
+            MockLlmServer server(MockServerOptions{});
+            CHECK(server.start());
+            std::shared_ptr<ConfigSnapshot> config = localConfig(server.port());
+            config->httpVersion = version;
+            CollectingHost host;
+            HostScope scope(host);
+
+            CHECK(ask(config).ok);
+            CHECK_EQ(host.text(), MockLlmServer::answerText(50));
+            CHECK_EQ(server.http2ConnectionCount(), 0);
+        }
+    }
+
+    // Asks sent at the same time run on one multi handle and multiplex over a single h2c connection
+    // (libcurl 7.x cannot reuse h2c connections, so there each ask opens its own); a later ask reuses it
+    void concurrentAsks()
+    {
+        MockServerOptions options;
+        options.tokens = 20;
+        options.tokensPerSecond = 200;
+        MockLlmServer server(options);
+        CHECK(server.start());
+
+        std::shared_ptr<ConfigSnapshot> config = localConfig(server.port());
+        config->httpVersion = "2-prior-knowledge";
+        CollectingHost host;
+        HostScope scope(host);
+
+        const int kAsks = 4;
+        std::vector<double> latencies(kAsks, 0);
+        std::vector<int> answered(kAsks, 0);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < kAsks; ++i)
+        {
+            threads.emplace_back([&, i]()
+                                 {
+                                     auto start = std::chrono::steady_clock::now();
+                                     answered[i] = ask(config).ok ? 1 : 0;
+                                     latencies[i] = elapsedMs(start); });
+        }
+        for (std::thread &thread : threads)
+            thread.join();
+
+        for (int i = 0; i < kAsks; ++i)
+        {
+            CHECK(answered[i]);
+            report("concurrent ask %d: %.1f ms", i, latencies[i]);
+        }
+        CHECK_EQ(host.text().size(), kAsks * MockLlmServer::answerText(20).size());
+        CHECK_EQ(server.requestCount(), kAsks);
+        CHECK_EQ(server.http2ConnectionCount(), server.connectionCount());
+        int afterConcurrent = server.connectionCount();
+        report("%d concurrent asks used %d connections", kAsks, afterConcurrent);
+        CHECK_EQ(afterConcurrent, reusesH2cConnections() ? 1 : kAsks);
+
+        CHECK(ask(config).ok);
+        CHECK_EQ(server.connectionCount(), afterConcurrent + (reusesH2cConnections() ? 0 : 1));
+    }
+}
+
+int main()
+{
+    streamsOverPriorKnowledge();
+    completeOverPriorKnowledge();
+    plainHttpDefaultsToHttp11();
+    concurrentAsks();
+    HTTPClient::shutdown();
+    return finish();
+}
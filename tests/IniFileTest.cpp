@@ -0,0 +1,208 @@
+/**
+ * IniFileTest.cpp - IniFile round trips: layout and comments, file encodings and long values
+ */
+
+#include <cstdio>
+#include <string>
+#include "TestSupport.h"
+#include "config/IniFile.h"
+#include "utils/EncodingUtils.h"
+
+using namespace TestSupport;
+
+namespace
+{
+    const std::string kPath = "nppopenai-ini-test.ini";
+
+    void writeBytes(const std::string &bytes)
+    {
+        FILE *file = std::fopen(kPath.c_str(), "wb");
+        CHECK(file != nullptr);
+        if (file)
+        {
+            std::fwrite(bytes.data(), 1, bytes.size(), file);
+            std::fclose(file);
+        }
+    }
+
+    std::string readBytes()
+    {
+        std::string bytes;
+        FILE *file = std::fopen(kPath.c_str(), "rb");
+        if (file)
+        {
+            char chunk[4096];
+            size_t size;
+            while ((size = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+            {
+                bytes.append(chunk, size);
+            }
+            std::fclose(file);
+        }
+        return bytes;
+    }
+
+    // Little-endian UTF-16 of ASCII and BMP text, with BOM
+    std::string utf16le(const std::wstring &text)
+    {
+        std::string bytes("\xFF\xFE", 2);
+        for (wchar_t c : text)
+        {
+            bytes.push_back(static_cast<char>(c & 0xFF));
+            bytes.push_back(static_cast<char>((c >> 8) & 0xFF));
+        }
+        return bytes;
+    }
+
+    // Lookups follow GetPrivateProfileString; a rewrite keeps everything it does not change
+    void preservesLayout()
+    {
+        const std::wstring text = L"; NppOpenAI configuration\r\n"
+                                  L"orphan=before any section\r\n"
+                                  L"\r\n"
+                                  L"[API]\r\n"
+                                  L"  Model =  \"gpt-4o-mini\"  \r\n"
+                                  L"; secret_key=commented out\r\n"
+                                  L"secret_key='sk-test'\r\n"
+                                  L"model=duplicate\r\n"
+                                  L"proxy_url=\r\n"
+                                  L"\r\n"
+                                  L"[Profile:local]\r\n"
+                                  L"api_url=http://localhost:11434/\r\n";
+        IniFile ini;
+        ini.parse(text);
+        CHECK(ini.toString() == text);
+
+        CHECK(ini.get(L"api", L"MODEL") == L"gpt-4o-mini");
+        CHECK(ini.get(L"API", L"secret_key") == L"sk-test");
+        CHECK(ini.has(L"API", L"proxy_url"));
+        CHECK(ini.get(L"API", L"proxy_url", L"fallback").empty());
+        CHECK(!ini.has(L"API", L"orphan"));
+        CHECK(ini.get(L"API", L"missing", L"fallback") == L"fallback");
+        CHECK(ini.get(L"Nowhere", L"model", L"fallback") == L"fallback");
+        CHECK_EQ(ini.sections().size(), static_cast<size_t>(2));
+
+        // In place (keeping the key's spelling), after the section's last line, in a new section at the end
+        ini.set(L"api", L"model", L"gpt-4o");
+        ini.set(L"API", L"streaming", L"0");
+        ini.set(L"PLUGIN", L"keep_question", L"1");
+        CHECK(ini.toString() == L"; NppOpenAI configuration\r\n"
+                                L"orphan=before any section\r\n"
+                                L"\r\n"
+                                L"[API]\r\n"
+                                L"  Model =gpt-4o\r\n"
+                                L"; secret_key=commented out\r\n"
+                                L"secret_key='sk-test'\r\n"
+                                L"model=duplicate\r\n"
+                                L"proxy_url=\r\n"
+                                L"streaming=0\r\n"
+                                L"\r\n"
+                                L"[Profile:local]\r\n"
+                                L"api_url=http://localhost:11434/\r\n"
+                                L"[PLUGIN]\r\n"
+                                L"keep_question=1\r\n");
+        CHECK(ini.get(L"API", L"model") == L"gpt-4o");
+
+        // LF-only files are read the same and written with CRLF, like the Win32 API writes them
+        IniFile unix;
+        unix.parse(L"[API]\nmodel=llama3\n");
+        CHECK(unix.get(L"API", L"model") == L"llama3");
+        CHECK(unix.toString() == L"[API]\r\nmodel=llama3\r\n");
+    }
+
+    // Values are not cut at GetPrivateProfileString's buffer size
+    void keepsLongValues()
+    {
+        std::wstring instructions;
+        while (instructions.size() < 5000)
+        {
+            instructions += L"You are a careful reviewer. ";
+        }
+        instructions.pop_back(); // Trailing whitespace is trimmed like GetPrivateProfileString does
+        std::wstring url = L"https://gateway.example.com/" + std::wstring(1500, L'a') + L"/v1/";
+        writeBytes("[API]\r\napi_url=" + toUTF8(url) + "\r\n");
+
+        IniFile ini;
+        CHECK(ini.load(stringToWstring(kPath)));
+        CHECK(ini.get(L"API", L"api_url") == url);
+        ini.set(L"API", L"instructions", instructions);
+        CHECK(ini.save(stringToWstring(kPath)));
+
+        IniFile reloaded;
+        CHECK(reloaded.load(stringToWstring(kPath)));
+        CHECK_EQ(reloaded.get(L"API", L"instructions").size(), instructions.size());
+        CHECK(reloaded.get(L"API", L"instructions") == instructions);
+        CHECK(reloaded.get(L"API", L"api_url") == url);
+    }
+
+    /**
+     * A file is written back in the encoding it was read in, byte for byte where nothing changed
+     *
+     * @param name Encoding, for the messages
+     * @param bytes File content with a line "model=<value>" in [API]
+     * @param value The model value as text
+     * @param prefix Bytes every saved file must start with (the BOM)
+     */
+    void roundTrips(const char *name, const std::string &bytes, const std::wstring &value, const std::string &prefix)
+    {
+        report("%s", name);
+        writeBytes(bytes);
+        IniFile ini;
+        CHECK(ini.load(stringToWstring(kPath)));
+        CHECK(ini.get(L"API", L"model") == value);
+        CHECK(ini.get(L"API", L"temperature") == L"0.7");
+
+        CHECK(ini.save(stringToWstring(kPath)));
+        CHECK(readBytes() == bytes);
+
+        ini.set(L"API", L"model", value + L"-2");
+        CHECK(ini.save(stringToWstring(kPath)));
+        std::string saved = readBytes();
+        CHECK(saved.compare(0, prefix.size(), prefix) == 0);
+
+        IniFile reloaded;
+        CHECK(reloaded.load(stringToWstring(kPath)));
+        CHECK(reloaded.get(L"API", L"model") == value + L"-2");
+        CHECK(reloaded.get(L"API", L"temperature") == L"0.7");
+        CHECK(reloaded.toString() == ini.toString());
+    }
+
+    void keepsEncodings()
+    {
+        const std::wstring accented = L"\u00E1rv\u00EDzt\u0171r\u0151";
+        const std::wstring japanese = L"\u65E5\u672C\u8A9E";
+        auto file = [](const std::wstring &model)
+        { return L"; comment \u00E9\r\n[API]\r\nmodel=" + model + L"\r\ntemperature=0.7\r\n"; };
+
+        roundTrips("UTF-8", toUTF8(file(accented + japanese)), accented + japanese, "; comment");
+        roundTrips("UTF-8 with BOM", "\xEF\xBB\xBF" + toUTF8(file(japanese)), japanese, "\xEF\xBB\xBF");
+        roundTrips("UTF-16LE", utf16le(file(accented + japanese)), accented + japanese, "\xFF\xFE");
+        roundTrips("ASCII", toUTF8(L"[API]\r\nmodel=gpt-4o\r\ntemperature=0.7\r\n"), L"gpt-4o", "[API]");
+#ifndef _WIN32
+        // Not valid UTF-8: the system code page, which is Latin-1 outside Windows
+        roundTrips("ANSI", "; comment \xE9\r\n[API]\r\nmodel=caf\xE9\r\ntemperature=0.7\r\n", L"caf\u00E9", "; comment \xE9");
+#endif
+    }
+
+    // Nothing to read: an empty document, which can still be written
+    void createsMissingFile()
+    {
+        std::remove(kPath.c_str());
+        IniFile ini;
+        CHECK(!ini.load(stringToWstring(kPath)));
+        CHECK(ini.sections().empty());
+        ini.set(L"PLUGIN", L"chat_limit", L"10");
+        CHECK(ini.save(stringToWstring(kPath)));
+        CHECK(readBytes() == "[PLUGIN]\r\nchat_limit=10\r\n");
+    }
+}
+
+int main()
+{
+    preservesLayout();
+    keepsLongValues();
+    keepsEncodings();
+    createsMissingFile();
+    std::remove(kPath.c_str());
+    return finish();
+}
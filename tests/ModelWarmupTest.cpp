@@ -0,0 +1,65 @@
+/**
+ * ModelWarmupTest.cpp - keep_alive parsing and Ollama model loads against the mock server
+ */
+
+#include "TestSupport.h"
+#include "MockLlmServer.h"
+#include "api/HTTPClient.h"
+#include "api/ModelWarmup.h"
+
+using namespace TestSupport;
+
+namespace
+{
+    void parsesKeepAlive()
+    {
+        CHECK_EQ(ModelWarmup::keepAliveSeconds(L""), static_cast<int64_t>(300));
+        CHECK_EQ(ModelWarmup::keepAliveSeconds(L"3600"), static_cast<int64_t>(3600));
+        CHECK_EQ(ModelWarmup::keepAliveSeconds(L"10m"), static_cast<int64_t>(600));
+        CHECK_EQ(ModelWarmup::keepAliveSeconds(L"1h30m"), static_cast<int64_t>(5400));
+        CHECK_EQ(ModelWarmup::keepAliveSeconds(L"1500ms"), static_cast<int64_t>(1));
+        CHECK_EQ(ModelWarmup::keepAliveSeconds(L"0"), static_cast<int64_t>(0));
+        CHECK_EQ(ModelWarmup::keepAliveSeconds(L"-1"), static_cast<int64_t>(-1));
+        CHECK_EQ(ModelWarmup::keepAliveSeconds(L"-99999999999999999999"), static_cast<int64_t>(-1));
+        CHECK_EQ(ModelWarmup::keepAliveSeconds(L"5 minutes"), static_cast<int64_t>(300));
+        CHECK_EQ(ModelWarmup::keepAliveSeconds(L"1d"), static_cast<int64_t>(300));
+
+        // Too large for Ollama (and for an int64): the default
+        CHECK_EQ(ModelWarmup::keepAliveSeconds(L"99999999999999999999"), static_cast<int64_t>(300));
+        CHECK_EQ(ModelWarmup::keepAliveSeconds(L"99999999999h"), static_cast<int64_t>(300));
+    }
+
+    // The load request carries keep_alive as a number where it is one; out-of-range numbers do not throw
+    void loadsModel(const std::wstring &keepAlive, bool resident)
+    {
+        MockLlmServer server{MockServerOptions()};
+        CHECK(server.start());
+        std::shared_ptr<ConfigSnapshot> config = localConfig(server.port(), "ollama");
+        config->ollamaWarmup = true;
+        config->keepAlive = keepAlive;
+
+        ModelWarmup::instance().warmUp(config);
+        CHECK(ModelWarmup::instance().waitIdle(10000));
+        ModelWarmup::Status status = ModelWarmup::instance().status();
+        CHECK(status.active);
+        CHECK(status.lastLoadMs >= 0);
+        CHECK_EQ(status.resident, resident);
+        CHECK_EQ(server.loadCount(), resident ? 1 : 0);
+
+        ModelWarmup::instance().warmUp(localConfig(server.port()));
+        CHECK(!ModelWarmup::instance().status().active);
+    }
+}
+
+int main()
+{
+    parsesKeepAlive();
+    loadsModel(L"3600", true);
+    loadsModel(L"-1", true);
+    loadsModel(L"99999999999999999999", true);
+    loadsModel(L"-99999999999999999999", true);
+    loadsModel(L"0", false);
+    ModelWarmup::instance().shutdown();
+    HTTPClient::shutdown();
+    return finish();
+}
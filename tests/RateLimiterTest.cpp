@@ -0,0 +1,172 @@
+/**
+ * RateLimiterTest.cpp - Token buckets under a virtual clock: refill, header sync and reservation order
+ */
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "TestSupport.h"
+#include "api/RateLimiter.h"
+#include "api/ResponseHeaders.h"
+
+using namespace TestSupport;
+
+namespace
+{
+    // 2024-05-01T12:00:00Z, so Anthropic reset timestamps can be given as text
+    const int64_t kStartMs = 1714564800000LL;
+
+    ResponseHeaders headersOf(const std::vector<std::string> &lines)
+    {
+        ResponseHeaders headers;
+        std::string status = "HTTP/1.1 200 OK\r\n";
+        headers.parseLine(status.data(), status.size());
+        for (std::string line : lines)
+        {
+            line += "\r\n";
+            headers.parseLine(line.data(), line.size());
+        }
+        return headers;
+    }
+
+    // A configured bucket starts full and refills continuously up to its capacity
+    void refillsConfiguredBucket()
+    {
+        int64_t now = kStartMs;
+        RateLimiter limiter([&now]()
+                            { return now; });
+        CHECK_EQ(limiter.availableRequests(), -1.0);
+        CHECK_EQ(limiter.reserve(1000), static_cast<int64_t>(0));
+
+        limiter.configure(60, 6000);
+        CHECK_EQ(limiter.availableRequests(), 60.0);
+        for (int i = 0; i < 60; ++i)
+        {
+            CHECK_EQ(limiter.reserve(10), static_cast<int64_t>(0));
+        }
+        CHECK_EQ(limiter.availableRequests(), 0.0);
+        CHECK_EQ(limiter.availableTokens(), 5400.0);
+
+        now += 500;
+        CHECK_EQ(limiter.availableRequests(), 0.5);
+        now += 120000;
+        CHECK_EQ(limiter.availableRequests(), 60.0);
+        CHECK_EQ(limiter.availableTokens(), 6000.0);
+
+        // The clock going backwards (a wall-clock adjustment) refills nothing
+        now -= 10000;
+        CHECK_EQ(limiter.reserve(0), static_cast<int64_t>(0));
+        CHECK_EQ(limiter.availableRequests(), 59.0);
+    }
+
+    // Requests beyond the bucket queue up: each waits one refill interval longer than the one before it
+    void reservesInArrivalOrder()
+    {
+        int64_t now = kStartMs;
+        RateLimiter limiter([&now]()
+                            { return now; });
+        limiter.configure(60, 0);
+        for (int i = 0; i < 60; ++i)
+        {
+            limiter.reserve(0);
+        }
+        CHECK_EQ(limiter.reserve(0), static_cast<int64_t>(1000));
+        CHECK_EQ(limiter.reserve(0), static_cast<int64_t>(2000));
+        CHECK_EQ(limiter.reserve(0), static_cast<int64_t>(3000));
+        CHECK_EQ(limiter.availableRequests(), -3.0);
+
+        // Time passing shortens the queue
+        now += 1500;
+        CHECK_EQ(limiter.reserve(0), static_cast<int64_t>(2500));
+
+        // Concurrent requests each get a slot of their own
+        const int kThreads = 8;
+        std::vector<int64_t> waits(kThreads);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < kThreads; ++i)
+        {
+            threads.emplace_back([&limiter, &waits, i]()
+                                 { waits[i] = limiter.reserve(0); });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        std::sort(waits.begin(), waits.end());
+        for (int i = 0; i < kThreads; ++i)
+        {
+            CHECK_EQ(waits[i], static_cast<int64_t>(3500 + 1000 * i));
+        }
+
+        // A request larger than the whole bucket waits for a full bucket, not forever
+        RateLimiter tokens([&now]()
+                           { return now; });
+        tokens.configure(0, 600);
+        CHECK_EQ(tokens.reserve(5000), static_cast<int64_t>(0));
+        CHECK_EQ(tokens.reserve(300), static_cast<int64_t>(30000));
+    }
+
+    // The server's remaining count does not include requests still in flight
+    void syncsWithHeaders()
+    {
+        int64_t now = kStartMs;
+        RateLimiter limiter([&now]()
+                            { return now; });
+        limiter.updateFromHeaders(headersOf({"x-ratelimit-limit-requests: 100", "x-ratelimit-remaining-requests: 100",
+                                             "x-ratelimit-limit-tokens: 10000", "x-ratelimit-remaining-tokens: 10000"}));
+        CHECK_EQ(limiter.availableRequests(), 100.0);
+
+        // Three requests sent; the response to the first one has only seen that one
+        limiter.reserve(100);
+        limiter.reserve(100);
+        limiter.reserve(100);
+        limiter.updateFromHeaders(headersOf({"x-ratelimit-limit-requests: 100", "x-ratelimit-remaining-requests: 99",
+                                             "x-ratelimit-reset-requests: 600ms", "x-ratelimit-limit-tokens: 10000",
+                                             "x-ratelimit-remaining-tokens: 9900", "x-ratelimit-reset-tokens: 600ms"}));
+        CHECK_EQ(limiter.availableRequests(), 97.0);
+        CHECK_EQ(limiter.availableTokens(), 9700.0);
+
+        // Other clients on the same key used more than the local estimate
+        limiter.updateFromHeaders(headersOf({"x-ratelimit-limit-requests: 100", "x-ratelimit-remaining-requests: 10",
+                                             "x-ratelimit-reset-requests: 9s"}));
+        CHECK_EQ(limiter.availableRequests(), 10.0);
+
+        // The reset time gives the refill rate: 90 requests in 9 seconds
+        now += 1000;
+        CHECK_EQ(limiter.availableRequests(), 20.0);
+
+        // A limit lowered by the server caps the bucket
+        limiter.updateFromHeaders(headersOf({"x-ratelimit-limit-requests: 15", "x-ratelimit-remaining-requests: 15"}));
+        CHECK_EQ(limiter.availableRequests(), 15.0);
+
+        // Configured limits no longer apply once the server reported its own
+        limiter.configure(1, 1);
+        CHECK_EQ(limiter.availableRequests(), 15.0);
+    }
+
+    // Anthropic reports the reset as a timestamp; the refill runs until then
+    void syncsAnthropicTimestamps()
+    {
+        int64_t now = kStartMs;
+        RateLimiter limiter([&now]()
+                            { return now; });
+        limiter.updateFromHeaders(headersOf({"anthropic-ratelimit-requests-limit: 50", "anthropic-ratelimit-requests-remaining: 0",
+                                             "anthropic-ratelimit-requests-reset: 2024-05-01T12:00:10Z",
+                                             "anthropic-ratelimit-input-tokens-limit: 1000", "anthropic-ratelimit-input-tokens-remaining: 500"}));
+        CHECK_EQ(limiter.availableRequests(), 0.0);
+        CHECK_EQ(limiter.availableTokens(), 500.0);
+        CHECK_EQ(limiter.reserve(100), static_cast<int64_t>(200));
+        now += 5000;
+        CHECK_EQ(limiter.availableRequests(), 24.0);
+    }
+}
+
+int main()
+{
+    refillsConfiguredBucket();
+    reservesInArrivalOrder();
+    syncsWithHeaders();
+    syncsAnthropicTimestamps();
+    CHECK_EQ(RateLimiter::estimateTokens(std::string(401, 'x')), 101.0);
+    return finish();
+}
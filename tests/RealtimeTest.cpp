@@ -0,0 +1,172 @@
+/**
+ * RealtimeTest.cpp - Asks over the persistent Realtime API session of the mock server: reuse, idle reconnects, cancel
+ */
+
+#include <thread>
+#include "TestSupport.h"
+#include "MockLlmServer.h"
+#include "api/ChatPipeline.h"
+#include "api/HTTPClient.h"
+#include "api/RealtimeSession.h"
+
+using namespace TestSupport;
+
+namespace
+{
+    const int kTokens = 12;
+    const std::wstring kSystemPrompt = L"You are a terse assistant";
+
+    ChatResult ask(const std::shared_ptr<ConfigSnapshot> &config)
+    {
+        return ChatPipeline::send("Say something", kSystemPrompt, config, ChatPipeline::candidateEndpoints(*config));
+    }
+
+    MockServerOptions answering(int realtimeIdleMs = 0)
+    {
+        MockServerOptions options;
+        options.tokens = kTokens;
+        options.realtimeIdleMs = realtimeIdleMs;
+        return options;
+    }
+
+    std::shared_ptr<ConfigSnapshot> realtimeConfig(int port)
+    {
+        std::shared_ptr<ConfigSnapshot> config = localConfig(port);
+        config->realtime = true;
+        return config;
+    }
+
+    // Follow-up asks reuse the session the first one opened; the instructions hit the prompt cache
+    void reusesSession()
+    {
+        MockLlmServer server(answering());
+        CHECK(server.start());
+        CollectingHost host;
+        HostScope scope(host);
+        std::shared_ptr<ConfigSnapshot> config = realtimeConfig(server.port());
+
+        for (int i = 0; i < 3; ++i)
+        {
+            host.clear();
+            ChatResult result = ask(config);
+            CHECK(result.ok);
+            CHECK(result.realtime);
+            CHECK_EQ(result.sessionOpened, i == 0);
+            CHECK_EQ(host.text(), MockLlmServer::answerText(kTokens));
+            CHECK_EQ(result.usage.completionTokens, static_cast<int64_t>(kTokens));
+            CHECK_EQ(result.usage.cachedTokens, static_cast<int64_t>(i == 0 ? 0 : 5));
+        }
+        CHECK_EQ(server.sessionCount(), 1);
+        CHECK_EQ(server.requestCount(), 3);
+        CHECK_EQ(server.connectionCount(), 1);
+    }
+
+    // The server closed the idle session: the next ask opens a new one and still gets its answer
+    void reconnectsAfterServerClose()
+    {
+        MockLlmServer server(answering(200));
+        CHECK(server.start());
+        CollectingHost host;
+        HostScope scope(host);
+        std::shared_ptr<ConfigSnapshot> config = realtimeConfig(server.port());
+
+        CHECK(ask(config).sessionOpened);
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        host.clear();
+        ChatResult result = ask(config);
+        CHECK(result.ok);
+        CHECK(result.realtime);
+        CHECK(result.sessionOpened);
+        CHECK_EQ(host.text(), MockLlmServer::answerText(kTokens));
+        CHECK_EQ(server.sessionCount(), 2);
+        CHECK_EQ(server.requestCount(), 2);
+    }
+
+    // A session unused for longer than realtime_idle_s is replaced before the ask, even if the server kept it
+    void replacesIdleSession()
+    {
+        MockLlmServer server(answering());
+        CHECK(server.start());
+        CollectingHost host;
+        HostScope scope(host);
+        std::shared_ptr<ConfigSnapshot> config = realtimeConfig(server.port());
+        config->realtimeIdleS = 1;
+
+        CHECK(ask(config).sessionOpened);
+        CHECK(!ask(config).sessionOpened);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1200));
+        host.clear();
+        ChatResult result = ask(config);
+        CHECK(result.ok);
+        CHECK(result.sessionOpened);
+        CHECK_EQ(host.text(), MockLlmServer::answerText(kTokens));
+        CHECK_EQ(server.sessionCount(), 2);
+        CHECK_EQ(server.requestCount(), 3);
+    }
+
+    // Cancelling closes the session to stop the answer; the next ask opens a new one
+    void cancelsAnswer()
+    {
+        MockServerOptions options = answering();
+        options.tokens = 200;
+        options.tokensPerSecond = 200;
+        MockLlmServer server(options);
+        CHECK(server.start());
+        CollectingHost host;
+        HostScope scope(host);
+        std::shared_ptr<ConfigSnapshot> config = realtimeConfig(server.port());
+
+        host.cancelAfter = 20;
+        auto start = std::chrono::steady_clock::now();
+        ChatResult result = ask(config);
+        report("cancelled after %.1f ms", elapsedMs(start));
+        CHECK(!result.ok);
+        CHECK(result.realtime);
+        CHECK(elapsedMs(start) < 900);
+        CHECK(host.text().size() >= 20);
+        CHECK(host.text().size() < MockLlmServer::answerText(200).size());
+
+        host.cancelAfter = 0;
+        host.clear();
+        std::shared_ptr<ConfigSnapshot> quick = realtimeConfig(server.port());
+        quick->maxTokens = 5;
+        result = ask(quick);
+        CHECK(result.ok);
+        CHECK(result.sessionOpened);
+        CHECK_EQ(host.text(), MockLlmServer::answerText(5));
+        CHECK_EQ(server.sessionCount(), 2);
+    }
+
+    // No Realtime API at the endpoint: the ask goes over HTTP
+    void fallsBackToHttp()
+    {
+        MockLlmServer server(answering());
+        CHECK(server.start());
+        CollectingHost host;
+        HostScope scope(host);
+        std::shared_ptr<ConfigSnapshot> config = realtimeConfig(server.port());
+        config->realtimeRoute = "no-realtime";
+
+        ChatResult result = ask(config);
+        CHECK(result.ok);
+        CHECK(!result.realtime);
+        CHECK_EQ(host.text(), MockLlmServer::answerText(kTokens));
+        CHECK_EQ(server.sessionCount(), 0);
+        CHECK_EQ(server.requestCount(), 2); // The rejected upgrade and the ask
+    }
+}
+
+int main()
+{
+    CHECK_EQ(RealtimeSession::buildUrl("https://api.openai.com/v1/", "realtime", L"gpt-4o-realtime-preview"),
+             std::string("wss://api.openai.com/v1/realtime?model=gpt-4o-realtime-preview"));
+
+    reusesSession();
+    reconnectsAfterServerClose();
+    replacesIdleSession();
+    cancelsAnswer();
+    fallsBackToHttp();
+    RealtimeSession::instance().close();
+    HTTPClient::shutdown();
+    return finish();
+}
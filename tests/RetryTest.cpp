@@ -0,0 +1,163 @@
+/**
+ * RetryTest.cpp - Retries and backoff against scripted 429/503 sequences of the mock server
+ */
+
+#include "TestSupport.h"
+#include "MockLlmServer.h"
+#include "api/ChatPipeline.h"
+#include "api/HTTPClient.h"
+#include "api/RetryPolicy.h"
+
+using namespace TestSupport;
+
+namespace
+{
+    ChatResult ask(const std::shared_ptr<ConfigSnapshot> &config)
+    {
+        return ChatPipeline::send("Say something", L"", config, ChatPipeline::candidateEndpoints(*config));
+    }
+
+    MockServerOptions failing(int status, int count, int retryAfterSeconds = -1)
+    {
+        MockServerOptions options;
+        options.tokens = 10;
+        options.errorStatus = status;
+        options.errorCount = count;
+        options.retryAfterSeconds = retryAfterSeconds;
+        return options;
+    }
+
+    // Capped exponential backoff with full jitter
+    void backoffBounds()
+    {
+        RetryPolicy policy(10, 100, 1000);
+        ResponseHeaders overloaded;
+        overloaded.statusCode = 503;
+        for (int i = 0; i < 200; ++i)
+        {
+            int first = policy.nextDelayMs(1, 0, overloaded);
+            int third = policy.nextDelayMs(3, 0, overloaded);
+            int ninth = policy.nextDelayMs(9, 0, overloaded);
+            CHECK(first >= 0 && first <= 100);
+            CHECK(third >= 0 && third <= 400);
+            CHECK(ninth >= 0 && ninth <= 1000);
+        }
+        CHECK_EQ(policy.nextDelayMs(10, 0, overloaded), -1);
+
+        ResponseHeaders unauthorized;
+        unauthorized.statusCode = 401;
+        CHECK_EQ(policy.nextDelayMs(1, 0, unauthorized), -1);
+
+        CHECK_EQ(RetryPolicy::parseResetDurationMs("6m0s"), 360000);
+        CHECK_EQ(RetryPolicy::parseResetDurationMs("1.5s"), 1500);
+        CHECK_EQ(RetryPolicy::parseResetDurationMs("20ms"), 20);
+        CHECK_EQ(RetryPolicy::parseRetryAfterMs("2", 0), 2000);
+        CHECK_EQ(RetryPolicy::parseRetryAfterMs("Thu, 01 Jan 1970 00:00:05 GMT", 1000), 4000);
+    }
+
+    // Two 429s, then the answer
+    void retriesRateLimits()
+    {
+        MockLlmServer server(failing(429, 2));
+        CHECK(server.start());
+        std::shared_ptr<ConfigSnapshot> config = localConfig(server.port());
+        config->retryMaxAttempts = 3;
+        CollectingHost host;
+        HostScope scope(host);
+
+        ChatResult result = ask(config);
+        CHECK(result.ok);
+        CHECK_EQ(server.requestCount(), 3);
+        CHECK_EQ(host.text(), MockLlmServer::answerText(10));
+    }
+
+    // Retry-After is waited for instead of the backoff
+    void honoursRetryAfter()
+    {
+        MockLlmServer server(failing(503, 1, 1));
+        CHECK(server.start());
+        std::shared_ptr<ConfigSnapshot> config = localConfig(server.port());
+        config->retryMaxDelayMs = 5000;
+        CollectingHost host;
+        HostScope scope(host);
+
+        auto start = std::chrono::steady_clock::now();
+        ChatResult result = ask(config);
+        double ms = elapsedMs(start);
+        CHECK(result.ok);
+        CHECK_EQ(server.requestCount(), 2);
+        CHECK(ms >= 950);
+        report("503 with Retry-After: 1 answered after %.0f ms", ms);
+    }
+
+    // A wait beyond retry_max_delay_ms is not worth it: the error is returned at once
+    void givesUpOnLongRetryAfter()
+    {
+        MockLlmServer server(failing(429, -1, 60));
+        CHECK(server.start());
+        std::shared_ptr<ConfigSnapshot> config = localConfig(server.port());
+        CollectingHost host;
+        HostScope scope(host);
+
+        auto start = std::chrono::steady_clock::now();
+        ChatResult result = ask(config);
+        CHECK(!result.ok);
+        CHECK_EQ(server.requestCount(), 1);
+        CHECK(elapsedMs(start) < 1000);
+        CHECK(result.response.find("rate_limit_error") != std::string::npos);
+    }
+
+    // Attempts are capped; errors that cannot succeed on a retry are not retried
+    void stopsAfterMaxAttempts()
+    {
+        MockLlmServer overloaded(failing(529, -1));
+        CHECK(overloaded.start());
+        std::shared_ptr<ConfigSnapshot> config = localConfig(overloaded.port());
+        config->retryMaxAttempts = 4;
+        CollectingHost host;
+        HostScope scope(host);
+        CHECK(!ask(config).ok);
+        CHECK_EQ(overloaded.requestCount(), 4);
+
+        MockLlmServer unauthorized(failing(401, -1));
+        CHECK(unauthorized.start());
+        CHECK(!ask(localConfig(unauthorized.port())).ok);
+        CHECK_EQ(unauthorized.requestCount(), 1);
+    }
+
+    // A stream that already inserted text is never sent again; a collected one is
+    void neverRepeatsDeliveredContent()
+    {
+        MockServerOptions options;
+        options.tokens = 10;
+        options.disconnectAfterTokens = 4;
+        MockLlmServer server(options);
+        CHECK(server.start());
+        std::shared_ptr<ConfigSnapshot> config = localConfig(server.port());
+        CollectingHost host;
+        HostScope scope(host);
+
+        CHECK(!ask(config).ok);
+        CHECK_EQ(server.requestCount(), 1);
+        CHECK_EQ(host.text(), MockLlmServer::answerText(4));
+
+        host.clear();
+        config->streaming = false;
+        ChatResult collected = ask(config);
+        CHECK(!collected.ok);
+        CHECK_EQ(server.requestCount(), 1 + config->retryMaxAttempts);
+        CHECK(host.text().empty());
+    }
+}
+
+int main()
+{
+    backoffBounds();
+    retriesRateLimits();
+    honoursRetryAfter();
+    givesUpOnLongRetryAfter();
+    stopsAfterMaxAttempts();
+    neverRepeatsDeliveredContent();
+    HTTPClient::shutdown();
+    return finish();
+}
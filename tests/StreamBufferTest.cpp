@@ -0,0 +1,162 @@
+/**
+ * StreamBufferTest.cpp - Backpressure: a slow front-end pauses the transfer instead of losing or stalling text
+ */
+
+#include <thread>
+#include "TestSupport.h"
+#include "MockLlmServer.h"
+#include "api/ChatPipeline.h"
+#include "api/HTTPClient.h"
+#include "api/StreamBuffer.h"
+
+using namespace TestSupport;
+
+namespace
+{
+    const int kTokens = 3000;
+
+    ChatResult ask(const std::shared_ptr<ConfigSnapshot> &config)
+    {
+        return ChatPipeline::send("Say something", L"", config, ChatPipeline::candidateEndpoints(*config));
+    }
+
+    // Pause at the high watermark, resume at the low one
+    void watermarks()
+    {
+        StreamBuffer buffer(100, 40);
+        CHECK(!buffer.isFull());
+        CHECK(buffer.hasRoom());
+        buffer.push(std::string(60, 'a'));
+        CHECK(!buffer.isFull());
+        CHECK(!buffer.hasRoom());
+        buffer.push(std::string(60, 'b')); // Taken whole although it crosses the high watermark
+        CHECK(buffer.isFull());
+        CHECK_EQ(buffer.peakBytes(), static_cast<size_t>(120));
+
+        std::string text = buffer.take();
+        CHECK_EQ(text, std::string(60, 'a') + std::string(60, 'b'));
+        CHECK(buffer.hasRoom());
+        CHECK(buffer.take().empty());
+
+        auto start = std::chrono::steady_clock::now();
+        buffer.waitForContent(std::chrono::milliseconds(50));
+        CHECK(elapsedMs(start) >= 40);
+        CHECK_EQ(buffer.peakBytes(), static_cast<size_t>(120));
+    }
+
+    /**
+     * A front-end that waits until the server has streamed more than 'bytes' of text (at most 5 s)
+     *
+     * A paused transfer can stop the server before that once the socket buffers
+     * are full; the wait then ends at its limit.
+     */
+    std::function<void()> untilStreamed(const MockLlmServer &server, size_t bytes)
+    {
+        int tokens = 0;
+        while (MockLlmServer::answerText(tokens).size() <= bytes)
+            ++tokens;
+        return [&server, tokens]()
+        {
+            auto start = std::chrono::steady_clock::now();
+            while (server.tokensStreamed() < tokens && elapsedMs(start) < 5000)
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        };
+    }
+
+    /**
+     * A front-end that takes 100 ms per insert: the transfer pauses, the text arrives whole and in order
+     *
+     * Each insert also waits until the server has streamed more than the high
+     * watermark, so the queue fills however slowly a loaded machine runs the server.
+     *
+     * @param httpVersion http_version of the request (pausing works per stream on HTTP/2)
+     */
+    void pausesForSlowConsumer(const std::string &httpVersion)
+    {
+        report("HTTP version %s", httpVersion.c_str());
+        MockServerOptions options;
+        options.tokens = kTokens;
+        MockLlmServer server(options);
+        CHECK(server.start());
+        CollectingHost host;
+        HostScope scope(host);
+        std::shared_ptr<ConfigSnapshot> config = localConfig(server.port());
+        config->httpVersion = httpVersion;
+        config->streamBufferKb = 4;
+        config->streamResumeKb = 1;
+
+        host.busy = untilStreamed(server, 4096 + 1024);
+        host.delayMs = 100;
+        ChatResult result = ask(config);
+        report("%zu inserts, queue peaked at %zu bytes, %zu pauses for %.1f ms", static_cast<size_t>(host.deliveries.load()),
+               result.stats.peakQueuedBytes, result.stats.pauses, result.stats.pausedMs);
+        CHECK(result.ok);
+        CHECK_EQ(host.text(), MockLlmServer::answerText(kTokens));
+        CHECK(result.stats.pauses > 0);
+        CHECK(result.stats.pausedMs > 0);
+        CHECK(result.stats.peakQueuedBytes >= 4096);
+        CHECK(result.stats.peakQueuedBytes < 4096 + 1024);
+
+        // The same text without the queue
+        host.busy = nullptr;
+        host.delayMs = 0;
+        host.clear();
+        config->streamBufferKb = 0;
+        result = ask(config);
+        CHECK(result.ok);
+        CHECK_EQ(host.text(), MockLlmServer::answerText(kTokens));
+        CHECK_EQ(result.stats.pauses, static_cast<size_t>(0));
+        CHECK_EQ(result.stats.peakQueuedBytes, static_cast<size_t>(0));
+    }
+
+    // The write callback does not run while the transfer is paused; a cancel stops it anyway
+    void cancelsWhilePaused()
+    {
+        MockServerOptions options;
+        options.tokens = kTokens;
+        MockLlmServer server(options);
+        CHECK(server.start());
+        CollectingHost host;
+        HostScope scope(host);
+        std::shared_ptr<ConfigSnapshot> config = localConfig(server.port());
+        config->streamBufferKb = 4;
+        config->streamResumeKb = 1;
+
+        // The first insert waits for the queue to fill, then cancels; the time counts from the end of that wait
+        std::function<void()> untilFull = untilStreamed(server, 4096 + 1024);
+        auto start = std::chrono::steady_clock::now();
+        host.busy = [&untilFull, &start]()
+        {
+            untilFull();
+            start = std::chrono::steady_clock::now();
+        };
+        host.delayMs = 100;
+        host.cancelAfter = 1;
+        ChatResult result = ask(config);
+        double ms = elapsedMs(start);
+        report("cancelled after %.1f ms, %zu pauses", ms, result.stats.pauses);
+        CHECK(!result.ok);
+        CHECK(result.stats.pauses > 0);
+        CHECK(ms < 900);
+        CHECK_EQ(host.deliveries.load(), 1); // Nothing is inserted after the cancel
+        CHECK(host.text().size() < MockLlmServer::answerText(kTokens).size());
+
+        // The server is still usable
+        host.busy = nullptr;
+        host.delayMs = 0;
+        host.cancelAfter = 0;
+        host.clear();
+        CHECK(ask(config).ok);
+        CHECK_EQ(host.text(), MockLlmServer::answerText(kTokens));
+    }
+}
+
+int main()
+{
+    watermarks();
+    pausesForSlowConsumer("1.1");
+    pausesForSlowConsumer("2-prior-knowledge");
+    cancelsWhilePaused();
+    HTTPClient::shutdown();
+    return finish();
+}
@@ -0,0 +1,138 @@
+/**
+ * StreamParserTest.cpp - Every response type's stream and response parser against the mock server's wire formats
+ */
+
+#include "TestSupport.h"
+#include "MockLlmServer.h"
+#include "api/ChatPipeline.h"
+#include "api/HTTPClient.h"
+#include "api/ResponseParsers.h"
+#include "api/StreamParser.h"
+#include "config/ConfigSnapshot.h"
+#include "utils/EncodingUtils.h"
+
+using namespace TestSupport;
+
+namespace
+{
+    const int kTokens = 25;
+    const char *const kResponseTypes[] = {"openai", "claude", "ollama", "openai-responses", "gemini"};
+
+    ChatResult ask(const std::shared_ptr<ConfigSnapshot> &config)
+    {
+        return ChatPipeline::send("Say something", L"Answer briefly", config, ChatPipeline::candidateEndpoints(*config));
+    }
+
+    // Payloads without content give nothing; metadata lines have no payload
+    void parsesPayloads()
+    {
+        CHECK_EQ(StreamParser::parseOpenAIPayload(R"({"choices":[{"delta":{"content":"Hi"}}]})"), std::string("Hi"));
+        CHECK_EQ(StreamParser::parseOpenAIPayload(R"({"choices":[{"delta":{"role":"assistant"}}]})"), std::string());
+        CHECK_EQ(StreamParser::parseOpenAIPayload(R"({"choices":[],"usage":{"prompt_tokens":3}})"), std::string());
+        CHECK_EQ(StreamParser::parseClaudePayload(R"({"type":"content_block_delta","delta":{"type":"text_delta","text":"Hi"}})"), std::string("Hi"));
+        CHECK_EQ(StreamParser::parseClaudePayload(R"({"type":"message_start","message":{"usage":{"input_tokens":3}}})"), std::string());
+        CHECK_EQ(StreamParser::parseOllamaPayload(R"({"response":"Hi","done":false})"), std::string("Hi"));
+        CHECK_EQ(StreamParser::parseOllamaPayload(R"({"message":{"role":"assistant","content":"Hi"},"done":false})"), std::string("Hi"));
+        CHECK_EQ(StreamParser::parseResponsesPayload(R"({"type":"response.output_text.delta","delta":"Hi"})"), std::string("Hi"));
+        CHECK_EQ(StreamParser::parseResponsesPayload(R"({"type":"response.text.delta","delta":"Hi"})"), std::string("Hi"));
+        CHECK_EQ(StreamParser::parseResponsesPayload(R"({"type":"response.output_text.done","text":"Hi"})"), std::string());
+        CHECK_EQ(StreamParser::parseGeminiPayload(R"({"candidates":[{"content":{"parts":[{"text":"H"},{"text":"i"}]}}]})"), std::string("Hi"));
+        CHECK_EQ(StreamParser::parseGeminiPayload(R"({"usageMetadata":{"promptTokenCount":3}})"), std::string());
+        CHECK_EQ(StreamParser::parseOpenAIPayload("not json"), std::string());
+
+        CHECK_EQ(StreamParser::extractLinePayload("data: {\"a\":1}"), std::string("{\"a\":1}"));
+        CHECK_EQ(StreamParser::extractLinePayload("data: [DONE]"), std::string());
+        CHECK_EQ(StreamParser::extractLinePayload("event: message_start"), std::string());
+        CHECK_EQ(StreamParser::extractLinePayload("{\"response\":\"Hi\"}"), std::string("{\"response\":\"Hi\"}"));
+    }
+
+    // <think> sections follow show_reasoning of the ask's snapshot, not of the one published since
+    void handlesReasoning()
+    {
+        std::shared_ptr<ConfigSnapshot> published = std::make_shared<ConfigSnapshot>();
+        published->showReasoning = true;
+        ConfigSnapshot::publish(published);
+
+        ChatResult collected;
+        collected.collected = true;
+        collected.answer = "<think>plan</think>Hi";
+        CHECK_EQ(ChatPipeline::answerText(collected, false), std::string("Hi"));
+        CHECK_EQ(ChatPipeline::answerText(collected, true), collected.answer);
+
+        ChatResult parsed;
+        parsed.responseType = L"claude";
+        parsed.response = R"({"content":[{"type":"text","text":"<think>plan</think>Hi"}]})";
+        CHECK_EQ(ChatPipeline::answerText(parsed, false), std::string("Hi"));
+        CHECK_EQ(ChatPipeline::answerText(parsed, true), std::string("<think>plan</think>Hi"));
+
+        ConfigSnapshot::publish(std::make_shared<ConfigSnapshot>());
+    }
+
+    /**
+     * A streamed answer comes out whole however the server splits its writes
+     *
+     * @param responseType Response type of the endpoint
+     * @param chunkBytes Size of the server's writes (0 = one write per event)
+     */
+    void streams(const char *responseType, size_t chunkBytes)
+    {
+        report("%s, %zu-byte writes", responseType, chunkBytes);
+        MockServerOptions options;
+        options.tokens = kTokens;
+        options.chunkBytes = chunkBytes;
+        MockLlmServer server(options);
+        CHECK(server.start());
+        CollectingHost host;
+        HostScope scope(host);
+
+        ChatResult result = ask(localConfig(server.port(), responseType));
+        CHECK(result.ok);
+        CHECK_EQ(host.text(), MockLlmServer::answerText(kTokens));
+        CHECK_EQ(host.answerTypes().size(), static_cast<size_t>(1));
+        CHECK_EQ(host.answerTypes().empty() ? std::string() : host.answerTypes().front(), std::string(responseType));
+
+        // OpenAI chat streams only carry usage when asked for it with stream_options
+        if (std::string(responseType) != "openai")
+        {
+            CHECK_EQ(result.usage.completionTokens, static_cast<int64_t>(kTokens));
+            CHECK(result.usage.promptTokens > 0);
+        }
+    }
+
+    // streaming=0 without stream_transport: one JSON body, read by the type's response parser
+    void parsesResponse(const char *responseType)
+    {
+        report("%s, not streamed", responseType);
+        MockServerOptions options;
+        options.tokens = kTokens;
+        MockLlmServer server(options);
+        CHECK(server.start());
+        CollectingHost host;
+        HostScope scope(host);
+        std::shared_ptr<ConfigSnapshot> config = localConfig(server.port(), responseType);
+        config->streaming = false;
+        config->streamTransport = false;
+
+        ChatResult result = ask(config);
+        CHECK(result.ok);
+        CHECK(!result.collected);
+        CHECK(host.text().empty());
+        CHECK_EQ(ResponseParsers::getParserForEndpoint(stringToWstring(responseType))(result.response, false), MockLlmServer::answerText(kTokens));
+        CHECK_EQ(result.usage.completionTokens, static_cast<int64_t>(kTokens));
+    }
+}
+
+int main()
+{
+    parsesPayloads();
+    handlesReasoning();
+    for (const char *responseType : kResponseTypes)
+    {
+        streams(responseType, 0);
+        streams(responseType, 1);
+        streams(responseType, 7);
+        parsesResponse(responseType);
+    }
+    HTTPClient::shutdown();
+    return finish();
+}
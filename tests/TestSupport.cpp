@@ -0,0 +1,148 @@
+/**
+ * TestSupport.cpp - Checks and fixtures shared by the ctest programs
+ */
+
+#include "TestSupport.h"
+#include <cstdarg>
+#include <thread>
+#include <curl/curl.h>
+#include "config/ConfigSnapshot.h"
+#include "utils/EncodingUtils.h"
+
+// Debug switch read by StreamParser (the plugin toggles it from its menu)
+bool debugMode = false;
+
+namespace
+{
+    std::atomic<int> g_failures(0);
+}
+
+namespace TestSupport
+{
+    void fail(const char *file, int line, const std::string &message)
+    {
+        ++g_failures;
+        std::fprintf(stderr, "%s:%d: %s\n", file, line, message.c_str());
+    }
+
+    int finish()
+    {
+        if (g_failures == 0)
+        {
+            std::printf("All checks passed\n");
+            return 0;
+        }
+        std::printf("%d check(s) failed\n", g_failures.load());
+        return 1;
+    }
+
+    void report(const char *format, ...)
+    {
+        va_list arguments;
+        va_start(arguments, format);
+        std::vprintf(format, arguments);
+        va_end(arguments);
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+
+    bool CollectingHost::deliverContent(const std::string &content)
+    {
+        size_t total;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _text += content;
+            total = _text.size();
+        }
+        ++deliveries;
+        if (busy)
+            busy();
+        if (delayMs > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+        if (cancelAfter > 0 && total >= cancelAfter)
+            cancelled = true;
+        return true;
+    }
+
+    void CollectingHost::beginAnswer(const std::string &responseType)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _answerTypes.push_back(responseType);
+    }
+
+    std::string CollectingHost::text() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _text;
+    }
+
+    std::vector<std::string> CollectingHost::answerTypes() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _answerTypes;
+    }
+
+    void CollectingHost::clear()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _text.clear();
+        _answerTypes.clear();
+        deliveries = 0;
+        streamsBegun = 0;
+        cancelled = false;
+    }
+
+    std::shared_ptr<ConfigSnapshot> localConfig(int port, const std::string &responseType)
+    {
+        std::shared_ptr<ConfigSnapshot> config = std::make_shared<ConfigSnapshot>();
+        std::string origin = "http://127.0.0.1:" + std::to_string(port) + "/";
+        config->responseType = responseType;
+        config->responseTypeW = stringToWstring(responseType);
+        config->provider = ConfigSnapshot::providerFromString(config->responseTypeW);
+        config->secretKey = "test-key";
+        config->model = L"mock-model";
+        config->baseUrl = origin + "v1/";
+        if (responseType == "claude")
+            config->chatRoute = "messages";
+        else if (responseType == "openai-responses")
+            config->chatRoute = "responses";
+        else if (responseType == "gemini")
+        {
+            config->baseUrl = origin + "v1beta/";
+            config->chatRoute = "models/{model}:generateContent";
+        }
+        else if (responseType == "ollama")
+        {
+            config->baseUrl = origin;
+            config->chatRoute = "api/generate";
+            config->ollamaWarmup = false;
+        }
+        config->retryBaseDelayMs = 10;
+        config->retryMaxDelayMs = 100;
+        config->connectTimeoutMs = 2000;
+        return config;
+    }
+
+    Endpoint localEndpoint(const std::wstring &name, int port, const std::string &responseType)
+    {
+        std::shared_ptr<ConfigSnapshot> local = localConfig(port, responseType);
+        Endpoint endpoint;
+        endpoint.name = name;
+        endpoint.baseUrl = stringToWstring(local->baseUrl);
+        endpoint.chatRoute = stringToWstring(local->chatRoute);
+        endpoint.responseType = local->responseTypeW;
+        endpoint.secretKey = stringToWstring(local->secretKey);
+        endpoint.model = local->model;
+        return endpoint;
+    }
+
+    double elapsedMs(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    bool reusesH2cConnections()
+    {
+        return curl_version_info(CURLVERSION_NOW)->version_num >= 0x080000;
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "api/EndpointRouter.h"
+#include "api/TransferHost.h"
+#include "config/ConfigSnapshot.h"
+
+/**
+ * TestSupport - Checks and fixtures shared by the ctest programs in tests/
+ *
+ * Each program is a plain main() that runs its test functions in order. A
+ * failed CHECK prints its location and the program exits non-zero at the end,
+ * so one run reports every failure rather than the first.
+ */
+namespace TestSupport
+{
+    // Record a failure (prints "file:line: message")
+    void fail(const char *file, int line, const std::string &message);
+
+    // Exit code of the program: 0 if no check failed; prints a summary
+    int finish();
+
+    // Print a measurement (not checked) so ctest --verbose shows it
+    void report(const char *format, ...);
+
+    template <typename A, typename B>
+    void checkEqual(const A &actual, const B &expected, const char *expression, const char *file, int line)
+    {
+        if (actual == expected)
+            return;
+        std::ostringstream message;
+        message << expression << ": got \"" << actual << "\", expected \"" << expected << "\"";
+        fail(file, line, message.str());
+    }
+
+    /**
+     * TransferHost that keeps the streamed text; safe to share between threads
+     */
+    class CollectingHost : public TransferHost
+    {
+    public:
+        bool isCancelled() const override { return cancelled; }
+        bool deliverContent(const std::string &content) override;
+        void beginStream() override { ++streamsBegun; }
+        void beginAnswer(const std::string &responseType) override;
+
+        std::string text() const;
+        std::vector<std::string> answerTypes() const; // Response type of each beginAnswer call
+        void clear();
+
+        std::atomic<bool> cancelled{false};
+        std::atomic<int> deliveries{0};
+        std::atomic<int> streamsBegun{0};
+        int delayMs = 0;            // Time each delivery takes (a busy front-end)
+        std::function<void()> busy; // Runs in each delivery before the delay (a front-end waiting for something)
+        size_t cancelAfter = 0;     // Cancel once this many bytes were delivered (0 = never)
+
+    private:
+        mutable std::mutex _mutex;
+        std::string _text;
+        std::vector<std::string> _answerTypes;
+    };
+
+    // Installs a host for the lifetime of the object
+    class HostScope
+    {
+    public:
+        explicit HostScope(TransferHost &host) { TransferHost::install(&host); }
+        ~HostScope() { TransferHost::install(nullptr); }
+    };
+
+    // Configuration of a backend on 127.0.0.1:port ("openai", "claude", "ollama", "openai-responses", "gemini", ...)
+    std::shared_ptr<ConfigSnapshot> localConfig(int port, const std::string &responseType = "openai");
+
+    // The same backend as a failover endpoint
+    Endpoint localEndpoint(const std::wstring &name, int port, const std::string &responseType = "openai");
+
+    // Milliseconds since 'start'
+    double elapsedMs(std::chrono::steady_clock::time_point start);
+
+    // libcurl 7.x cannot reuse h2c connections across requests, so HTTPClient opens one per request there
+    bool reusesH2cConnections();
+}
+
+#define CHECK(condition) \
+    ((condition) ? (void)0 : TestSupport::fail(__FILE__, __LINE__, "CHECK(" #condition ") failed"))
+#define CHECK_EQ(actual, expected) \
+    TestSupport::checkEqual((actual), (expected), #actual, __FILE__, __LINE__)
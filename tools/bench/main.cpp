@@ -0,0 +1,516 @@
+/**
+ * main.cpp - nppopenai-bench, micro-benchmarks for the request/response hot paths
+ *
+ * Times the code every request runs through (request formatting, response
+ * parsing, per-chunk stream parsing and its dispatch by provider, <think>
+ * filtering, prompt file parsing and the UTF-8/UTF-16 conversions) on inputs
+ * from a few bytes to several megabytes, and the configuration loading done
+ * on startup, and prints the results as JSON:
+ *
+ *   {"benchmarks": [{"name": "...", "input_bytes": N, "iterations": N,
+ *     "ns_per_op": X, "bytes_per_second": X, "allocs_per_op": X,
+ *     "alloc_bytes_per_op": X, "peak_bytes": X}, ...]}
+ *
+ * peak_bytes is the most heap memory the benchmarked code held at once on top
+ * of what was allocated before it ran.
+ *
+ * Usage: nppopenai-bench [--filter text] [--min-time-ms 200] [--out results.json]
+ *
+ * Run it on a Release build and compare two result files before and after a change.
+ */
+
+#include "AllocationCounter.h"
+#include "api/APIUtils.h"
+#include "api/ProviderTraits.h"
+#include "api/RequestFormatters.h"
+#include "api/ResponseParsers.h"
+#include "api/StreamParser.h"
+#include "api/TokenUsage.h"
+#include "config/ConfigSnapshot.h"
+#include "config/IniFile.h"
+#include "config/PromptManager.h"
+#include "utils/EncodingUtils.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Debug switch read by StreamParser (off, so no debug files are written)
+bool debugMode = false;
+
+namespace
+{
+    struct BenchResult
+    {
+        std::string name;
+        size_t inputBytes = 0;
+        uint64_t iterations = 0;
+        double nsPerOp = 0;
+        double allocsPerOp = 0;
+        double allocBytesPerOp = 0;
+        int64_t peakBytes = 0;
+    };
+
+    // Results are folded into this so the compiler cannot drop the benchmarked calls
+    volatile size_t g_sink = 0;
+
+    std::string g_filter;
+    double g_minTimeNs = 200e6;
+    std::vector<BenchResult> g_results;
+
+    /**
+     * Time 'op' in batches of doubling size until a batch takes at least the
+     * minimum time; the last batch gives the per-operation figures
+     */
+    void bench(const std::string &name, size_t inputBytes, const std::function<size_t()> &op)
+    {
+        if (!g_filter.empty() && name.find(g_filter) == std::string::npos)
+            return;
+
+        g_sink = g_sink + op(); // Warm-up: first-use allocations, caches
+
+        uint64_t iterations = 1;
+        for (;;)
+        {
+            AllocationCounter::resetPeak();
+            AllocationCounter::Counts before = AllocationCounter::snapshot();
+            auto start = std::chrono::steady_clock::now();
+            size_t sink = 0;
+            for (uint64_t i = 0; i < iterations; ++i)
+                sink += op();
+            double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            AllocationCounter::Counts after = AllocationCounter::snapshot();
+            g_sink = g_sink + sink;
+
+            if (elapsedNs >= g_minTimeNs || iterations >= (1ull << 30))
+            {
+                BenchResult result;
+                result.name = name;
+                result.inputBytes = inputBytes;
+                result.iterations = iterations;
+                result.nsPerOp = elapsedNs / iterations;
+                result.allocsPerOp = double(after.allocations - before.allocations) / iterations;
+                result.allocBytesPerOp = double(after.bytes - before.bytes) / iterations;
+                result.peakBytes = after.peakBytes - before.liveBytes;
+                g_results.push_back(result);
+                std::fprintf(stderr, "%-44s %10zu B %14.1f ns/op %10.1f allocs/op\n",
+                             name.c_str(), inputBytes, result.nsPerOp, result.allocsPerOp);
+                return;
+            }
+            iterations *= 2;
+        }
+    }
+
+    /**
+     * Deterministic text of about 'bytes' bytes: words, punctuation, some
+     * characters outside ASCII and JSON escapes (quotes, newlines)
+     */
+    std::string makeText(size_t bytes)
+    {
+        static const char *const words[] = {
+            "lorem", "ipsum", "dolor", "sit", "amet,", "consectetur", "\"adipiscing\"", "elit.",
+            "sed", "do", "eiusmod", "tempor", "incididunt\n", "ut", "labore", "\xC3\xA1rv\xC3\xADzt\xC5\xB1r\xC5\x91",
+            "t\xC3\xBCk\xC3\xB6rf\xC3\xBAr\xC3\xB3g\xC3\xA9p", "\xE6\x97\xA5\xE6\x9C\xAC", "{\"k\": 1}", "\t"};
+        const size_t wordCount = sizeof(words) / sizeof(words[0]);
+
+        std::string text;
+        text.reserve(bytes + 32);
+        for (size_t i = 0; text.size() < bytes; ++i)
+        {
+            text += words[(i * 7 + i / wordCount) % wordCount];
+            text += ' ';
+        }
+        return text;
+    }
+
+    // Text with a <think> block every few hundred bytes
+    std::string makeThinkingText(size_t bytes)
+    {
+        std::string text;
+        text.reserve(bytes + 512);
+        std::string visible = makeText(300);
+        std::string hidden = "<think>" + makeText(200) + "</think>";
+        while (text.size() < bytes)
+            text += hidden + visible;
+        return text;
+    }
+
+    // Instructions file content with 'count' prompts of about 'promptBytes' each
+    std::string makeInstructions(size_t count, size_t promptBytes)
+    {
+        std::string body = makeText(promptBytes);
+        std::string text;
+        for (size_t i = 0; i < count; ++i)
+        {
+            text += "[Prompt:Bench_" + std::to_string(i) + "]\n";
+            text += body;
+            text += "\n\n";
+        }
+        return text;
+    }
+
+    std::string quoted(const std::string &text)
+    {
+        return json(text).dump();
+    }
+
+    void benchFormatters(const std::vector<size_t> &sizes)
+    {
+        struct Formatter
+        {
+            const char *name;
+            RequestFormatters::FormatterFunction function;
+        };
+        const Formatter formatters[] = {
+            {"openai", RequestFormatters::formatOpenAIRequest},
+            {"ollama", RequestFormatters::formatOllamaRequest},
+            {"claude", RequestFormatters::formatClaudeRequest},
+            {"openai-responses", RequestFormatters::formatResponsesRequest},
+            {"gemini", RequestFormatters::formatGeminiRequest},
+            {"simple", RequestFormatters::formatSimpleRequest}};
+
+        const std::wstring model = L"gpt-4o-mini";
+        const std::wstring systemPrompt = stringToWstring(makeText(400));
+        for (size_t size : sizes)
+        {
+            std::wstring prompt = stringToWstring(makeText(size));
+            for (const Formatter &formatter : formatters)
+            {
+                bench(std::string("format_request/") + formatter.name, size, [&]()
+                      { return formatter.function(model, prompt, systemPrompt, 0.7f, 0, 0.8f, 0, 0, L"5m").size(); });
+            }
+        }
+    }
+
+    void benchPrepareRequest(const std::vector<size_t> &sizes)
+    {
+        const std::wstring systemPrompt = stringToWstring(makeText(400));
+        for (size_t size : sizes)
+        {
+            std::string selectedText = makeText(size);
+            for (bool streaming : {false, true})
+            {
+                bench(std::string("prepare_api_request/openai") + (streaming ? "_stream" : ""), size, [&]()
+                      { return APIUtils::prepareApiRequest(selectedText, systemPrompt, L"gpt-4o-mini", L"openai",
+                                                           0.7f, 0, 0.8f, 0, 0, L"5m", streaming)
+                            .size(); });
+            }
+        }
+    }
+
+    void benchResponseParsers(const std::vector<size_t> &sizes)
+    {
+        for (size_t size : sizes)
+        {
+            std::string answer = quoted(makeText(size));
+            const std::pair<std::string, std::string> responses[] = {
+                {"openai", "{\"id\":\"chatcmpl-1\",\"object\":\"chat.completion\",\"choices\":[{\"index\":0,\"message\":"
+                           "{\"role\":\"assistant\",\"content\":" + answer + "},\"finish_reason\":\"stop\"}],"
+                           "\"usage\":{\"prompt_tokens\":10,\"completion_tokens\":100}}"},
+                {"ollama", "{\"model\":\"llama3\",\"response\":" + answer + ",\"done\":true}"},
+                {"claude", "{\"id\":\"msg_1\",\"type\":\"message\",\"role\":\"assistant\",\"content\":"
+                           "[{\"type\":\"text\",\"text\":" + answer + "}],\"stop_reason\":\"end_turn\"}"},
+                {"simple", "{\"text\":" + answer + "}"}};
+
+            for (const auto &response : responses)
+            {
+                ResponseParsers::ParserFunction parser = ResponseParsers::getParserForEndpoint(stringToWstring(response.first));
+                const std::string &body = response.second;
+                bench("parse_response/" + response.first, body.size(), [&]()
+                      { return parser(body, false).size(); });
+            }
+        }
+    }
+
+    void benchStreamChunks()
+    {
+        // One event per token is the common case; the large ones are a whole paragraph per event
+        for (size_t size : {size_t(4), size_t(64), size_t(4096)})
+        {
+            std::string token = quoted(makeText(size));
+            const std::pair<std::string, std::string> chunks[] = {
+                {"openai", "data: {\"id\":\"chatcmpl-1\",\"object\":\"chat.completion.chunk\",\"choices\":"
+                           "[{\"index\":0,\"delta\":{\"content\":" + token + "},\"finish_reason\":null}]}"},
+                {"ollama", "{\"model\":\"llama3\",\"created_at\":\"2024-01-01T00:00:00Z\",\"response\":" + token + ",\"done\":false}"},
+                {"claude", "data: {\"type\":\"content_block_delta\",\"index\":0,\"delta\":{\"type\":\"text_delta\",\"text\":" + token + "}}"}};
+
+            for (const auto &chunk : chunks)
+            {
+                const std::string &line = chunk.second;
+                const std::string &apiType = chunk.first;
+                bench("stream_extract_content/" + apiType, line.size(), [&]()
+                      { return StreamParser::extractContent(line, apiType).size(); });
+            }
+        }
+    }
+
+    /**
+     * What the stream callback does with one payload: extract its text and, for a line without text, its usage.
+     * "detect" is the dispatch before ProviderTraits (every format tried on each line, then the type compared, and
+     * every metadata line given to TokenUsage); "bound" uses the provider table resolved once per request.
+     */
+    void benchStreamDispatch()
+    {
+        std::string token = quoted("Hello");
+        const std::pair<std::string, std::string> payloads[] = {
+            {"openai", "{\"id\":\"chatcmpl-1\",\"object\":\"chat.completion.chunk\",\"choices\":"
+                       "[{\"index\":0,\"delta\":{\"content\":" + token + "},\"finish_reason\":null}]}"},
+            {"openai", "{\"id\":\"chatcmpl-1\",\"object\":\"chat.completion.chunk\",\"choices\":"
+                       "[{\"index\":0,\"delta\":{},\"finish_reason\":\"stop\"}]}"},
+            {"ollama", "{\"model\":\"llama3\",\"created_at\":\"2024-01-01T00:00:00Z\",\"response\":" + token + ",\"done\":false}"},
+            {"claude", "{\"type\":\"content_block_delta\",\"index\":0,\"delta\":{\"type\":\"text_delta\",\"text\":" + token + "}}"},
+            {"claude", "{\"type\":\"ping\"}"},
+            {"openai-responses", "{\"type\":\"response.output_text.delta\",\"item_id\":\"msg_1\",\"output_index\":0,"
+                                 "\"content_index\":0,\"delta\":" + token + "}"},
+            {"openai-responses", "{\"type\":\"response.created\",\"response\":{\"id\":\"resp_1\",\"object\":\"response\","
+                                 "\"status\":\"in_progress\",\"output\":[],\"usage\":null}}"},
+            {"gemini", "{\"candidates\":[{\"content\":{\"parts\":[{\"text\":" + token + "}],\"role\":\"model\"},"
+                       "\"index\":0}],\"modelVersion\":\"gemini-2.5-flash\"}"}};
+
+        for (const auto &payload : payloads)
+        {
+            const std::string &apiType = payload.first;
+            const std::string &line = payload.second;
+            const ProviderOps *provider = &ProviderOps::forType(apiType);
+            std::string name = "stream_dispatch/" + apiType + (provider->delta(line).empty() ? "/metadata" : "/content");
+            bench(name + "/detect", line.size(), [&]()
+                  {
+                      std::string content = StreamParser::extractContent(line, apiType);
+                      if (content.empty())
+                      {
+                          TokenUsage usage;
+                          usage.update(line);
+                          return static_cast<size_t>(usage.known());
+                      }
+                      return content.size(); });
+            bench(name + "/bound", line.size(), [&]()
+                  {
+                      std::string content = provider->delta(line);
+                      if (content.empty() && provider->reportsUsage(line))
+                      {
+                          TokenUsage usage;
+                          usage.update(line);
+                          return static_cast<size_t>(usage.known());
+                      }
+                      return content.size(); });
+        }
+    }
+
+    void benchThinking(const std::vector<size_t> &sizes)
+    {
+        for (size_t size : sizes)
+        {
+            std::string text = makeThinkingText(size);
+            // Reasoning hidden (the default), so the sections are removed
+            bench("process_thinking_sections", text.size(), [&]()
+                  { return ResponseParsers::processThinkingSections(text, false).size(); });
+        }
+    }
+
+    void benchInstructionsFile()
+    {
+        const std::string path = "nppopenai-bench-instructions.tmp";
+        const std::pair<size_t, size_t> shapes[] = {{1, 200}, {20, 2000}, {1000, 4000}};
+        for (const auto &shape : shapes)
+        {
+            std::string content = makeInstructions(shape.first, shape.second);
+            FILE *file = std::fopen(path.c_str(), "wb");
+            if (!file)
+            {
+                std::fprintf(stderr, "Cannot write %s, skipping parse_instructions_file\n", path.c_str());
+                return;
+            }
+            std::fwrite(content.data(), 1, content.size(), file);
+            std::fclose(file);
+
+            std::wstring widePath = stringToWstring(path);
+            bench("parse_instructions_file/" + std::to_string(shape.first) + "_prompts", content.size(), [&]()
+                  {
+                      std::vector<Prompt> prompts;
+                      parseInstructionsFile(widePath.c_str(), prompts);
+                      return prompts.size(); });
+        }
+        std::remove(path.c_str());
+    }
+
+    /**
+     * NppOpenAI.ini with every [API] setting and 'profiles' [Profile:name] sections
+     * of a few keys each; 'keys' receives the section and key of every value
+     */
+    std::string makeIniFile(size_t profiles, std::vector<std::pair<std::wstring, std::wstring>> &keys)
+    {
+        static const char *const apiValues[][2] = {
+            {"secret_key", "sk-0123456789abcdef0123456789abcdef"}, {"api_url", "https://api.openai.com/v1/"},
+            {"route_chat_completions", "chat/completions"}, {"response_type", "openai"}, {"model", "gpt-4o-mini"},
+            {"temperature", "0.7"}, {"max_tokens", "0"}, {"top_p", "0.8"}, {"frequency_penalty", "0"},
+            {"presence_penalty", "0"}, {"keep_alive", "5m"}, {"streaming", "1"}, {"stream_transport", "1"},
+            {"stream_buffer_kb", "64"}, {"stream_resume_kb", "16"}, {"show_reasoning", "0"}, {"proxy_url", "0"},
+            {"http_version", "auto"}, {"connect_timeout_ms", "10000"}, {"retry_max_attempts", "3"},
+            {"retry_base_delay_ms", "500"}, {"retry_max_delay_ms", "20000"}, {"rate_limit_rpm", "0"},
+            {"rate_limit_tpm", "0"}, {"ollama_warmup", "1"}, {"preconnect", "0"}, {"preconnect_dwell_ms", "500"},
+            {"ollama_context", "0"}, {"ollama_context_max_tokens", "32768"}, {"llamacpp_slots", "1"},
+            {"realtime", "0"}, {"route_realtime", "realtime"}, {"realtime_idle_s", "120"}, {"capture_dir", ""},
+            {"trace_file", ""}};
+
+        std::string ini = "[INFO]\r\n; NppOpenAI configuration, see docs/llm_backends.md\r\n\r\n"
+                          "[PLUGIN]\r\nkeep_question=1\r\nis_chat=0\r\nchat_limit=10\r\nactive_profile=\r\n\r\n[API]\r\n";
+        for (const auto &value : apiValues)
+        {
+            ini += std::string(value[0]) + "=" + value[1] + "\r\n";
+            keys.emplace_back(L"API", stringToWstring(value[0]));
+        }
+        for (size_t i = 0; i < profiles; ++i)
+        {
+            std::string name = "backend" + std::to_string(i);
+            ini += "\r\n; Backend " + std::to_string(i) + "\r\n[Profile:" + name + "]\r\n"
+                   "api_url=http://10.0.0." + std::to_string(i % 250) + ":11434/\r\n"
+                   "response_type=ollama\r\nmodel=qwen2.5-coder:" + std::to_string(i) + "b\r\ntemperature=0.2\r\n";
+            for (const wchar_t *key : {L"api_url", L"response_type", L"model", L"temperature"})
+                keys.emplace_back(L"Profile:" + stringToWstring(name), key);
+        }
+        return ini;
+    }
+
+    void benchStartupConfig()
+    {
+        const std::string path = "nppopenai-bench-config.tmp";
+        const std::wstring widePath = stringToWstring(path);
+        for (size_t profiles : {0, 10, 100})
+        {
+            std::vector<std::pair<std::wstring, std::wstring>> keys;
+            std::string content = makeIniFile(profiles, keys);
+            FILE *file = std::fopen(path.c_str(), "wb");
+            if (!file)
+            {
+                std::fprintf(stderr, "Cannot write %s, skipping startup_config\n", path.c_str());
+                return;
+            }
+            std::fwrite(content.data(), 1, content.size(), file);
+            std::fclose(file);
+
+            // What loadConfig does on startup: read the file once, parse [API] and every profile
+            std::string suffix = "/" + std::to_string(profiles) + "_profiles";
+            bench("startup_config" + suffix, content.size(), [&]()
+                  {
+                      IniFile ini;
+                      ini.load(widePath);
+                      std::shared_ptr<ConfigSnapshot> base = ConfigSnapshot::fromSection(ConfigSnapshot(), ini, L"API");
+                      size_t modelChars = base->model.size();
+                      for (const std::wstring &section : ini.sections())
+                      {
+                          if (section.compare(0, 8, L"Profile:") == 0)
+                              modelChars += ConfigSnapshot::forProfile(*base, ini, section.substr(8))->model.size();
+                      }
+                      return modelChars; });
+
+            // The same values read the way GetPrivateProfileString reads them: the file is opened and scanned once per key
+            bench("startup_config_reread_per_key" + suffix, content.size(), [&]()
+                  {
+                      size_t found = 0;
+                      for (const auto &key : keys)
+                      {
+                          IniFile ini;
+                          ini.load(widePath);
+                          found += ini.get(key.first, key.second).size();
+                      }
+                      return found; });
+        }
+        std::remove(path.c_str());
+    }
+
+    void benchEncoding(const std::vector<size_t> &sizes)
+    {
+        for (size_t size : sizes)
+        {
+            std::string utf8 = makeText(size);
+            std::wstring wide = stringToWstring(utf8);
+            bench("string_to_wstring", utf8.size(), [&]()
+                  { return stringToWstring(utf8).size(); });
+            bench("to_utf8", utf8.size(), [&]()
+                  { return toUTF8(wide).size(); });
+            bench("multi_byte_to_wide_char", utf8.size(), [&]()
+                  {
+                      wchar_t *converted = multiByteToWideChar(utf8.c_str());
+                      size_t first = static_cast<size_t>(converted[0]);
+                      delete[] converted;
+                      return first; });
+            bench("multi_byte_to_wstring", utf8.size(), [&]()
+                  { return multiByteToWstring(utf8).size(); });
+        }
+    }
+
+    void printUsage()
+    {
+        std::fprintf(stderr,
+                     "Usage: nppopenai-bench [options]\n"
+                     "  --filter TEXT       Only run benchmarks whose name contains TEXT\n"
+                     "  --min-time-ms N     Minimum measured time per benchmark (default 200)\n"
+                     "  --out FILE          Write the JSON results to FILE instead of stdout\n");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::string outPath;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--filter" && hasValue)
+            g_filter = argv[++i];
+        else if (arg == "--min-time-ms" && hasValue)
+            g_minTimeNs = std::atof(argv[++i]) * 1e6;
+        else if (arg == "--out" && hasValue)
+            outPath = argv[++i];
+        else
+        {
+            printUsage();
+            return (arg == "--help" || arg == "-h") ? 0 : 2;
+        }
+    }
+
+    // Tiny (a word), typical (a function), large (a file) and huge (a log dump) selections
+    const std::vector<size_t> sizes = {16, 4 * 1024, 256 * 1024, 4 * 1024 * 1024};
+
+    benchFormatters(sizes);
+    benchPrepareRequest(sizes);
+    benchResponseParsers(sizes);
+    benchStreamChunks();
+    benchStreamDispatch();
+    benchThinking(sizes);
+    benchInstructionsFile();
+    benchStartupConfig();
+    benchEncoding(sizes);
+
+    json report;
+    report["benchmarks"] = json::array();
+    for (const BenchResult &result : g_results)
+    {
+        report["benchmarks"].push_back({{"name", result.name},
+                                        {"input_bytes", result.inputBytes},
+                                        {"iterations", result.iterations},
+                                        {"ns_per_op", result.nsPerOp},
+                                        {"bytes_per_second", result.nsPerOp > 0 ? result.inputBytes * 1e9 / result.nsPerOp : 0.0},
+                                        {"allocs_per_op", result.allocsPerOp},
+                                        {"alloc_bytes_per_op", result.allocBytesPerOp},
+                                        {"peak_bytes", result.peakBytes}});
+    }
+    std::string text = report.dump(2) + "\n";
+
+    if (outPath.empty())
+    {
+        std::fwrite(text.data(), 1, text.size(), stdout);
+        return 0;
+    }
+    FILE *file = std::fopen(outPath.c_str(), "wb");
+    if (!file)
+    {
+        std::fprintf(stderr, "Cannot write %s\n", outPath.c_str());
+        return 1;
+    }
+    std::fwrite(text.data(), 1, text.size(), file);
+    std::fclose(file);
+    return 0;
+}
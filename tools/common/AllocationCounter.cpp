@@ -0,0 +1,96 @@
+/**
+ * AllocationCounter.cpp - Counting replacements of the global operator new/delete
+ *
+ * Each block carries its size in a header in front of the returned pointer, so
+ * unsized operator delete can subtract it from the live total.
+ */
+
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    // Keeps the returned pointers aligned like malloc's
+    const std::size_t kHeaderSize = alignof(std::max_align_t);
+
+    std::atomic<uint64_t> g_allocations(0);
+    std::atomic<uint64_t> g_bytes(0);
+    std::atomic<int64_t> g_liveBytes(0);
+    std::atomic<int64_t> g_peakBytes(0);
+
+    void *countedAlloc(std::size_t size)
+    {
+        char *block = static_cast<char *>(std::malloc(size + kHeaderSize));
+        if (!block)
+            return nullptr;
+        *reinterpret_cast<std::size_t *>(block) = size;
+
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+        g_bytes.fetch_add(size, std::memory_order_relaxed);
+        int64_t live = g_liveBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size);
+        int64_t peak = g_peakBytes.load(std::memory_order_relaxed);
+        while (live > peak && !g_peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        {
+        }
+        return block + kHeaderSize;
+    }
+
+    void countedFree(void *p)
+    {
+        if (!p)
+            return;
+        char *block = static_cast<char *>(p) - kHeaderSize;
+        g_liveBytes.fetch_sub(static_cast<int64_t>(*reinterpret_cast<std::size_t *>(block)), std::memory_order_relaxed);
+        std::free(block);
+    }
+}
+
+AllocationCounter::Counts AllocationCounter::snapshot()
+{
+    Counts counts;
+    counts.allocations = g_allocations.load(std::memory_order_relaxed);
+    counts.bytes = g_bytes.load(std::memory_order_relaxed);
+    counts.liveBytes = g_liveBytes.load(std::memory_order_relaxed);
+    counts.peakBytes = g_peakBytes.load(std::memory_order_relaxed);
+    return counts;
+}
+
+void AllocationCounter::resetPeak()
+{
+    g_peakBytes.store(g_liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void *operator new(std::size_t size)
+{
+    void *p = countedAlloc(size);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](std::size_t size)
+{
+    void *p = countedAlloc(size);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAlloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAlloc(size);
+}
+
+void operator delete(void *p) noexcept { countedFree(p); }
+void operator delete[](void *p) noexcept { countedFree(p); }
+void operator delete(void *p, std::size_t) noexcept { countedFree(p); }
+void operator delete[](void *p, std::size_t) noexcept { countedFree(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { countedFree(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { countedFree(p); }
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * AllocationCounter - Counts heap allocations made through operator new
+ *
+ * Linking AllocationCounter.cpp into an executable replaces the global
+ * operator new/delete with versions that count calls and bytes and keep track
+ * of the bytes currently allocated, so benchmarks and the command-line client
+ * can report allocations per operation, transient peaks and memory retained
+ * after a request for any code they call. Counting uses relaxed atomics and a
+ * small header per block; it is meant for the benchmark and tool builds only,
+ * never for the plugin.
+ */
+namespace AllocationCounter
+{
+    struct Counts
+    {
+        uint64_t allocations = 0; // Calls to operator new / new[]
+        uint64_t bytes = 0;       // Bytes requested from them
+        int64_t liveBytes = 0;    // Bytes allocated and not yet freed
+        int64_t peakBytes = 0;    // Highest liveBytes since the last resetPeak()
+    };
+
+    // Totals since program start
+    Counts snapshot();
+
+    // Restart peak tracking at the current live size
+    void resetPeak();
+}
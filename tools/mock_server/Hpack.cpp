@@ -0,0 +1,254 @@
+/**
+ * Hpack.cpp - HTTP/2 header compression for the mock server's h2c connections
+ */
+
+#include "Hpack.h"
+
+namespace
+{
+    const char *const kStaticTable[][2] = {
+        {":authority", ""}, {":method", "GET"}, {":method", "POST"}, {":path", "/"}, {":path", "/index.html"},
+        {":scheme", "http"}, {":scheme", "https"}, {":status", "200"}, {":status", "204"}, {":status", "206"},
+        {":status", "304"}, {":status", "400"}, {":status", "404"}, {":status", "500"}, {"accept-charset", ""},
+        {"accept-encoding", "gzip, deflate"}, {"accept-language", ""}, {"accept-ranges", ""}, {"accept", ""},
+        {"access-control-allow-origin", ""}, {"age", ""}, {"allow", ""}, {"authorization", ""}, {"cache-control", ""},
+        {"content-disposition", ""}, {"content-encoding", ""}, {"content-language", ""}, {"content-length", ""},
+        {"content-location", ""}, {"content-range", ""}, {"content-type", ""}, {"cookie", ""}, {"date", ""},
+        {"etag", ""}, {"expect", ""}, {"expires", ""}, {"from", ""}, {"host", ""}, {"if-match", ""},
+        {"if-modified-since", ""}, {"if-none-match", ""}, {"if-range", ""}, {"if-unmodified-since", ""},
+        {"last-modified", ""}, {"link", ""}, {"location", ""}, {"max-forwards", ""}, {"proxy-authenticate", ""},
+        {"proxy-authorization", ""}, {"range", ""}, {"referer", ""}, {"refresh", ""}, {"retry-after", ""},
+        {"server", ""}, {"set-cookie", ""}, {"strict-transport-security", ""}, {"transfer-encoding", ""},
+        {"user-agent", ""}, {"vary", ""}, {"via", ""}, {"www-authenticate", ""}};
+    const size_t kStaticCount = sizeof(kStaticTable) / sizeof(kStaticTable[0]);
+
+    // Code length of each symbol (256 = EOS); the code is canonical, so the lengths define it
+    const uint8_t kHuffmanLengths[257] = {
+        13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+        28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+        6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+        5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+        13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+        7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+        15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+        6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+        20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+        24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+        22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+        21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+        26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+        19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+        20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+        26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+        30
+    };
+
+    /**
+     * Canonical Huffman decoding tables: for each length, the first code, the
+     * number of codes and where their symbols start in the sorted symbol list
+     */
+    struct HuffmanTable
+    {
+        uint32_t firstCode[31] = {};
+        uint32_t count[31] = {};
+        uint32_t offset[31] = {};
+        std::vector<uint16_t> symbols;
+
+        HuffmanTable()
+        {
+            for (uint16_t length = 1; length <= 30; ++length)
+            {
+                for (uint16_t symbol = 0; symbol < 257; ++symbol)
+                {
+                    if (kHuffmanLengths[symbol] == length)
+                        symbols.push_back(symbol);
+                }
+            }
+            uint32_t code = 0;
+            uint32_t index = 0;
+            for (int length = 1; length <= 30; ++length)
+            {
+                for (int symbol = 0; symbol < 257; ++symbol)
+                    count[length] += (kHuffmanLengths[symbol] == length) ? 1 : 0;
+                firstCode[length] = code;
+                offset[length] = index;
+                code = (code + count[length]) << 1;
+                index += count[length];
+            }
+        }
+    };
+
+    bool decodeHuffman(const std::string &input, std::string &output)
+    {
+        static const HuffmanTable table;
+        uint32_t code = 0;
+        int length = 0;
+        for (unsigned char byte : input)
+        {
+            for (int bit = 7; bit >= 0; --bit)
+            {
+                code = (code << 1) | ((byte >> bit) & 1);
+                if (++length > 30)
+                    return false;
+                if (code - table.firstCode[length] < table.count[length])
+                {
+                    uint16_t symbol = table.symbols[table.offset[length] + code - table.firstCode[length]];
+                    if (symbol == 256)
+                        return false; // EOS must not appear in a string
+                    output += static_cast<char>(symbol);
+                    code = 0;
+                    length = 0;
+                }
+            }
+        }
+        // Padding: at most 7 bits, all ones (the start of EOS)
+        return length <= 7 && code == (1u << length) - 1;
+    }
+
+    bool readInteger(const std::string &block, size_t &position, int prefixBits, uint64_t &value)
+    {
+        if (position >= block.size())
+            return false;
+        uint64_t limit = (1u << prefixBits) - 1;
+        value = static_cast<unsigned char>(block[position++]) & limit;
+        if (value < limit)
+            return true;
+        for (int shift = 0; shift < 56; shift += 7)
+        {
+            if (position >= block.size())
+                return false;
+            unsigned char byte = static_cast<unsigned char>(block[position++]);
+            value += static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    bool readString(const std::string &block, size_t &position, std::string &text)
+    {
+        if (position >= block.size())
+            return false;
+        bool huffman = (static_cast<unsigned char>(block[position]) & 0x80) != 0;
+        uint64_t length;
+        if (!readInteger(block, position, 7, length) || length > block.size() - position)
+            return false;
+        std::string raw = block.substr(position, static_cast<size_t>(length));
+        position += static_cast<size_t>(length);
+        text.clear();
+        if (!huffman)
+        {
+            text = raw;
+            return true;
+        }
+        return decodeHuffman(raw, text);
+    }
+
+    void writeInteger(std::string &out, unsigned char firstByte, int prefixBits, uint64_t value)
+    {
+        uint64_t limit = (1u << prefixBits) - 1;
+        if (value < limit)
+        {
+            out += static_cast<char>(firstByte | value);
+            return;
+        }
+        out += static_cast<char>(firstByte | limit);
+        value -= limit;
+        while (value >= 0x80)
+        {
+            out += static_cast<char>((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+}
+
+bool HpackDecoder::decode(const std::string &block, HeaderList &headers)
+{
+    headers.clear();
+    size_t position = 0;
+    while (position < block.size())
+    {
+        unsigned char first = static_cast<unsigned char>(block[position]);
+        uint64_t index;
+        std::string name;
+        std::string value;
+        if (first & 0x80)
+        {
+            // Indexed header field
+            if (!readInteger(block, position, 7, index) || index == 0 || !lookup(index, name, value))
+                return false;
+            headers.emplace_back(name, value);
+            continue;
+        }
+        if ((first & 0xe0) == 0x20)
+        {
+            // Dynamic table size update
+            if (!readInteger(block, position, 5, index) || index > 4096)
+                return false;
+            _maxSize = static_cast<size_t>(index);
+            evict();
+            continue;
+        }
+
+        // Literal: with incremental indexing (01), without indexing (0000) or never indexed (0001)
+        bool indexed = (first & 0xc0) == 0x40;
+        if (!readInteger(block, position, indexed ? 6 : 4, index))
+            return false;
+        if (index == 0 ? !readString(block, position, name) : !lookup(index, name, value))
+            return false;
+        if (!readString(block, position, value))
+            return false;
+        if (indexed)
+            insert(name, value);
+        headers.emplace_back(name, value);
+    }
+    return true;
+}
+
+std::string HpackDecoder::encode(const HeaderList &headers)
+{
+    std::string block;
+    for (const auto &header : headers)
+    {
+        block += '\0'; // Literal without indexing, new name
+        writeInteger(block, 0, 7, header.first.size());
+        block += header.first;
+        writeInteger(block, 0, 7, header.second.size());
+        block += header.second;
+    }
+    return block;
+}
+
+bool HpackDecoder::lookup(uint64_t index, std::string &name, std::string &value) const
+{
+    if (index <= kStaticCount)
+    {
+        name = kStaticTable[index - 1][0];
+        value = kStaticTable[index - 1][1];
+        return true;
+    }
+    index -= kStaticCount + 1;
+    if (index >= _dynamic.size())
+        return false;
+    name = _dynamic[static_cast<size_t>(index)].first;
+    value = _dynamic[static_cast<size_t>(index)].second;
+    return true;
+}
+
+void HpackDecoder::insert(const std::string &name, const std::string &value)
+{
+    // An entry larger than the table empties it and is not added
+    _dynamic.emplace_front(name, value);
+    _size += name.size() + value.size() + 32;
+    evict();
+}
+
+void HpackDecoder::evict()
+{
+    while (_size > _maxSize && !_dynamic.empty())
+    {
+        _size -= _dynamic.back().first.size() + _dynamic.back().second.size() + 32;
+        _dynamic.pop_back();
+    }
+}
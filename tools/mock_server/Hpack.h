@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+typedef std::vector<std::pair<std::string, std::string>> HeaderList;
+
+/**
+ * HpackDecoder - HTTP/2 header block decoding (RFC 7541) for the mock server
+ *
+ * Keeps the dynamic table of one connection, so every header block the client
+ * sends on it must go through the same decoder, in order. Huffman-coded
+ * strings are decoded with the canonical code of RFC 7541 Appendix B.
+ */
+class HpackDecoder
+{
+public:
+    // Decode one complete header block; false on a malformed block (a connection error)
+    bool decode(const std::string &block, HeaderList &headers);
+
+    // Encode headers as literals that are never indexed or Huffman-coded (what the server sends)
+    static std::string encode(const HeaderList &headers);
+
+private:
+    bool lookup(uint64_t index, std::string &name, std::string &value) const;
+    void insert(const std::string &name, const std::string &value);
+    void evict();
+
+    std::deque<std::pair<std::string, std::string>> _dynamic; // Newest entry first
+    size_t _size = 0;
+    size_t _maxSize = 4096;
+};
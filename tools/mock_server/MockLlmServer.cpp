@@ -0,0 +1,1566 @@
+/**
+ * MockLlmServer.cpp - Loopback HTTP/1.1 and h2c server imitating the OpenAI, Claude and Ollama APIs (and OpenAI Realtime)
+ */
+
+#include "MockLlmServer.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <sstream>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // No per-call flag; the tools ignore SIGPIPE instead
+#endif
+
+namespace
+{
+    const char *const kWords[] = {"Lorem", " ipsum", " dolor", " sit", " amet", ",", " consectetur", " adipiscing",
+                                  " elit", ".", " Sed", " do", " eiusmod", " tempor", " incididunt", " ut",
+                                  " labore", " et", " dolore", " magna", " aliqua", "."};
+    const size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+    const size_t kMaxHeaderBytes = 64 * 1024;
+    const char kWebSocketGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+    // HTTP/2 frame types, flags and settings (RFC 9113)
+    enum : uint8_t
+    {
+        kFrameData = 0x0,
+        kFrameHeaders = 0x1,
+        kFrameRstStream = 0x3,
+        kFrameSettings = 0x4,
+        kFramePing = 0x6,
+        kFrameGoAway = 0x7,
+        kFrameWindowUpdate = 0x8,
+        kFrameContinuation = 0x9
+    };
+    const uint8_t kFlagEndStream = 0x1;
+    const uint8_t kFlagAck = 0x1;
+    const uint8_t kFlagEndHeaders = 0x4;
+    const uint8_t kFlagPadded = 0x8;
+    const uint8_t kFlagPriority = 0x20;
+    const uint16_t kSettingMaxConcurrentStreams = 0x3;
+    const uint16_t kSettingInitialWindowSize = 0x4;
+    const uint16_t kSettingMaxFrameSize = 0x5;
+    const int64_t kDefaultWindow = 65535;
+
+    uint32_t readUint32(const std::string &data, size_t offset)
+    {
+        return (static_cast<uint32_t>(static_cast<unsigned char>(data[offset])) << 24) |
+               (static_cast<uint32_t>(static_cast<unsigned char>(data[offset + 1])) << 16) |
+               (static_cast<uint32_t>(static_cast<unsigned char>(data[offset + 2])) << 8) |
+               static_cast<uint32_t>(static_cast<unsigned char>(data[offset + 3]));
+    }
+
+    std::string uint32Bytes(uint32_t value)
+    {
+        const char bytes[4] = {static_cast<char>(value >> 24), static_cast<char>(value >> 16), static_cast<char>(value >> 8), static_cast<char>(value)};
+        return std::string(bytes, 4);
+    }
+
+    std::string setting(uint16_t id, uint32_t value)
+    {
+        const char bytes[2] = {static_cast<char>(id >> 8), static_cast<char>(id)};
+        return std::string(bytes, 2) + uint32Bytes(value);
+    }
+
+    // Read from the socket until the buffer holds at least 'size' bytes
+    bool receiveAtLeast(int fd, std::string &buffer, size_t size)
+    {
+        char data[16384];
+        while (buffer.size() < size)
+        {
+            ssize_t received = ::recv(fd, data, sizeof(data), 0);
+            if (received <= 0)
+            {
+                if (received < 0 && errno == EINTR)
+                    continue;
+                return false;
+            }
+            buffer.append(data, static_cast<size_t>(received));
+        }
+        return true;
+    }
+
+    std::string lower(std::string text)
+    {
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+        return text;
+    }
+
+    const char *reasonPhrase(int status)
+    {
+        switch (status)
+        {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 429: return "Too Many Requests";
+        case 500: return "Internal Server Error";
+        case 502: return "Bad Gateway";
+        case 503: return "Service Unavailable";
+        case 529: return "Overloaded";
+        default: return "Error";
+        }
+    }
+
+    // Wire format served on a path ("" for unknown paths)
+    std::string formatForPath(const std::string &path)
+    {
+        std::string route = path.substr(0, path.find('?'));
+        auto endsWith = [&](const char *suffix)
+        {
+            size_t length = std::strlen(suffix);
+            return route.size() >= length && route.compare(route.size() - length, length, suffix) == 0;
+        };
+        if (endsWith("/chat/completions"))
+            return "openai";
+        if (endsWith("/messages"))
+            return "claude";
+        if (endsWith("/api/chat"))
+            return "ollama-chat";
+        if (endsWith("/api/generate"))
+            return "ollama";
+        if (endsWith("/realtime"))
+            return "realtime";
+        if (endsWith("/responses"))
+            return "responses";
+        if (route.find(":generateContent") != std::string::npos || route.find(":streamGenerateContent") != std::string::npos)
+            return "gemini";
+        return "";
+    }
+
+    // SHA-1 digest (for Sec-WebSocket-Accept)
+    std::string sha1(const std::string &text)
+    {
+        uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+        std::string data = text;
+        uint64_t bits = static_cast<uint64_t>(text.size()) * 8;
+        data += static_cast<char>(0x80);
+        while (data.size() % 64 != 56)
+            data += '\0';
+        for (int shift = 56; shift >= 0; shift -= 8)
+            data += static_cast<char>((bits >> shift) & 0xFF);
+
+        auto rotate = [](uint32_t value, int count)
+        { return (value << count) | (value >> (32 - count)); };
+        for (size_t block = 0; block < data.size(); block += 64)
+        {
+            uint32_t words[80];
+            for (int i = 0; i < 16; ++i)
+            {
+                words[i] = 0;
+                for (int j = 0; j < 4; ++j)
+                    words[i] = (words[i] << 8) | static_cast<unsigned char>(data[block + 4 * i + j]);
+            }
+            for (int i = 16; i < 80; ++i)
+                words[i] = rotate(words[i - 3] ^ words[i - 8] ^ words[i - 14] ^ words[i - 16], 1);
+
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+            for (int i = 0; i < 80; ++i)
+            {
+                uint32_t f, k;
+                if (i < 20)
+                    f = (b & c) | (~b & d), k = 0x5A827999;
+                else if (i < 40)
+                    f = b ^ c ^ d, k = 0x6ED9EBA1;
+                else if (i < 60)
+                    f = (b & c) | (b & d) | (c & d), k = 0x8F1BBCDC;
+                else
+                    f = b ^ c ^ d, k = 0xCA62C1D6;
+                uint32_t next = rotate(a, 5) + f + e + k + words[i];
+                e = d;
+                d = c;
+                c = rotate(b, 30);
+                b = a;
+                a = next;
+            }
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+        }
+
+        std::string digest;
+        for (uint32_t value : state)
+            for (int shift = 24; shift >= 0; shift -= 8)
+                digest += static_cast<char>((value >> shift) & 0xFF);
+        return digest;
+    }
+
+    std::string base64(const std::string &data)
+    {
+        static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string encoded;
+        for (size_t i = 0; i < data.size(); i += 3)
+        {
+            uint32_t block = static_cast<uint32_t>(static_cast<unsigned char>(data[i])) << 16;
+            if (i + 1 < data.size())
+                block |= static_cast<uint32_t>(static_cast<unsigned char>(data[i + 1])) << 8;
+            if (i + 2 < data.size())
+                block |= static_cast<unsigned char>(data[i + 2]);
+            encoded += alphabet[(block >> 18) & 0x3F];
+            encoded += alphabet[(block >> 12) & 0x3F];
+            encoded += (i + 1 < data.size()) ? alphabet[(block >> 6) & 0x3F] : '=';
+            encoded += (i + 2 < data.size()) ? alphabet[block & 0x3F] : '=';
+        }
+        return encoded;
+    }
+
+    // Tokens of a text (the mock's tokenizer: one per whitespace-separated word)
+    int countWords(const std::string &text)
+    {
+        int words = 0;
+        bool inWord = false;
+        for (char c : text)
+        {
+            bool space = std::isspace(static_cast<unsigned char>(c)) != 0;
+            if (!space && !inWord)
+                ++words;
+            inWord = !space;
+        }
+        return words;
+    }
+
+    // The words of a text, in order
+    std::vector<std::string> splitWords(const std::string &text)
+    {
+        std::vector<std::string> words;
+        std::istringstream stream(text);
+        std::string word;
+        while (stream >> word)
+            words.push_back(word);
+        return words;
+    }
+
+    // llama-server's timings object (prompt_ms follows the simulated prefill time)
+    json llamaTimings(int evalTokens, int cachedTokens, int prefillUsPerToken, int tokens, double predictedMs)
+    {
+        double promptMs = evalTokens * prefillUsPerToken / 1000.0;
+        return {{"cache_n", cachedTokens}, {"prompt_n", evalTokens}, {"prompt_ms", promptMs},
+                {"prompt_per_second", promptMs > 0 ? evalTokens * 1000.0 / promptMs : 0.0},
+                {"predicted_n", tokens}, {"predicted_ms", predictedMs},
+                {"predicted_per_second", predictedMs > 0 ? tokens * 1000.0 / predictedMs : 0.0}};
+    }
+
+    // OpenAI's usage object; prompt_tokens includes the cached prefix
+    json openAIUsage(int evalTokens, int cachedTokens, int completionTokens)
+    {
+        return {{"prompt_tokens", evalTokens + cachedTokens}, {"completion_tokens", completionTokens},
+                {"total_tokens", evalTokens + cachedTokens + completionTokens},
+                {"prompt_tokens_details", {{"cached_tokens", cachedTokens}}}};
+    }
+
+    // Responses API usage (input_tokens includes the cached part)
+    json responsesUsage(int evalTokens, int cachedTokens, int completionTokens)
+    {
+        return {{"input_tokens", evalTokens + cachedTokens}, {"input_tokens_details", {{"cached_tokens", cachedTokens}}},
+                {"output_tokens", completionTokens}, {"total_tokens", evalTokens + cachedTokens + completionTokens}};
+    }
+
+    // Gemini usageMetadata (promptTokenCount includes the cached part)
+    json geminiUsage(int evalTokens, int cachedTokens, int completionTokens)
+    {
+        return {{"promptTokenCount", evalTokens + cachedTokens}, {"cachedContentTokenCount", cachedTokens},
+                {"candidatesTokenCount", completionTokens}, {"totalTokenCount", evalTokens + cachedTokens + completionTokens}};
+    }
+
+    // Gemini candidate list with one text part
+    json geminiCandidates(const std::string &text, bool last)
+    {
+        json candidate = {{"content", {{"role", "model"}, {"parts", json::array({{{"text", text}}})}}}, {"index", 0}};
+        if (last)
+            candidate["finishReason"] = "STOP";
+        return json::array({candidate});
+    }
+
+    // Text of the "text" members of a Gemini parts array
+    std::string geminiText(const json &content)
+    {
+        std::string text;
+        if (content.is_object() && content.contains("parts") && content["parts"].is_array())
+        {
+            for (const json &part : content["parts"])
+            {
+                if (part.is_object() && part.contains("text") && part["text"].is_string())
+                    text += part["text"].get<std::string>() + " ";
+            }
+        }
+        return text;
+    }
+
+    // Context after an answer of 'tokens' tokens: what was evaluated before plus one id per answer token
+    json answerContext(std::vector<int64_t> context, int tokens)
+    {
+        for (int i = 0; i < tokens; ++i)
+            context.push_back(2000 + i);
+        return context;
+    }
+
+    // Ollama's keep_alive: seconds or a duration such as "10m"; absent = 5 minutes, negative = forever
+    int64_t keepAliveSeconds(const json &body)
+    {
+        if (!body.contains("keep_alive"))
+            return 300;
+        const json &value = body["keep_alive"];
+        if (value.is_number())
+            return value.get<int64_t>();
+        if (!value.is_string())
+            return 300;
+        std::string text = value.get<std::string>();
+        if (text.empty())
+            return 300;
+        char *unit = nullptr;
+        double amount = std::strtod(text.c_str(), &unit);
+        if (std::strcmp(unit, "m") == 0)
+            amount *= 60;
+        else if (std::strcmp(unit, "h") == 0)
+            amount *= 3600;
+        return static_cast<int64_t>(amount);
+    }
+}
+
+MockLlmServer::MockLlmServer(const MockServerOptions &options)
+    : _options(options), _running(false), _requests(0), _connections(0), _errorsSent(0), _loads(0), _sessions(0), _http2Connections(0), _tokensStreamed(0)
+{
+}
+
+MockLlmServer::~MockLlmServer()
+{
+    stop();
+}
+
+bool MockLlmServer::start()
+{
+    _listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (_listenFd < 0)
+        return false;
+
+    int reuse = 1;
+    ::setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(_options.port));
+    if (::bind(_listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || ::listen(_listenFd, 64) != 0)
+    {
+        ::close(_listenFd);
+        _listenFd = -1;
+        return false;
+    }
+
+    socklen_t length = sizeof(address);
+    ::getsockname(_listenFd, reinterpret_cast<sockaddr *>(&address), &length);
+    _port = ntohs(address.sin_port);
+
+    _running = true;
+    _acceptThread = std::thread(&MockLlmServer::acceptLoop, this);
+    return true;
+}
+
+void MockLlmServer::stop()
+{
+    if (!_running.exchange(false))
+        return;
+
+    // Unblock accept() and every recv()
+    ::shutdown(_listenFd, SHUT_RDWR);
+    ::close(_listenFd);
+    if (_acceptThread.joinable())
+        _acceptThread.join();
+    _listenFd = -1;
+
+    std::vector<std::thread> workers;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (int fd : _clientFds)
+            ::shutdown(fd, SHUT_RDWR);
+        workers.swap(_workers);
+    }
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+std::string MockLlmServer::lastModel() const
+{
+    std::lock_guard<std::mutex> lock(_modelsMutex);
+    return _lastModel;
+}
+
+void MockLlmServer::acceptLoop()
+{
+    while (_running)
+    {
+        int fd = ::accept(_listenFd, nullptr, nullptr);
+        if (fd < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        // Write every event (or fragment) as its own segment
+        int noDelay = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        ++_connections;
+        std::lock_guard<std::mutex> lock(_mutex);
+        _clientFds.push_back(fd);
+        _workers.emplace_back(&MockLlmServer::serveConnection, this, fd);
+    }
+}
+
+/**
+ * HTTP/1.1 response on a connection: Content-Length or chunked transfer encoding
+ */
+class MockLlmServer::Http1Reply : public MockLlmServer::Reply
+{
+public:
+    Http1Reply(int fd, bool keepAlive) : _fd(fd), _keepAlive(keepAlive) {}
+
+    bool head(int status, const HeaderList &headers, int64_t contentLength) override
+    {
+        std::string response = "HTTP/1.1 " + std::to_string(status) + " " + reasonPhrase(status) + "\r\n";
+        for (const auto &header : headers)
+            response += header.first + ": " + header.second + "\r\n";
+        _chunked = (contentLength < 0);
+        response += _chunked ? "Transfer-Encoding: chunked\r\n" : "Content-Length: " + std::to_string(contentLength) + "\r\n";
+        response += _keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+        return sendAll(_fd, response.data(), response.size());
+    }
+
+    bool body(const char *data, size_t size) override
+    {
+        if (!_chunked)
+            return sendAll(_fd, data, size);
+        char sizeLine[32];
+        int length = std::snprintf(sizeLine, sizeof(sizeLine), "%zx\r\n", size);
+        std::string chunk(sizeLine, static_cast<size_t>(length));
+        chunk.append(data, size);
+        chunk += "\r\n";
+        return sendAll(_fd, chunk.data(), chunk.size());
+    }
+
+    bool end() override
+    {
+        const char terminator[] = "0\r\n\r\n";
+        return !_chunked || sendAll(_fd, terminator, sizeof(terminator) - 1);
+    }
+
+private:
+    int _fd;
+    bool _keepAlive;
+    bool _chunked = false;
+};
+
+void MockLlmServer::serveConnection(int fd)
+{
+    std::string buffer;
+    Request request;
+    while (_running && readRequest(fd, buffer, request))
+    {
+        // The connection becomes a Realtime API session until either side closes it
+        if (!request.webSocketKey.empty() && formatForPath(request.path) == "realtime")
+        {
+            serveRealtime(fd, request, buffer);
+            break;
+        }
+        // "PRI * HTTP/2.0" starts the HTTP/2 connection preface (prior knowledge)
+        if (request.method == "PRI" && request.path == "*")
+        {
+            serveHttp2(fd, buffer);
+            break;
+        }
+        ++_requests;
+        Http1Reply reply(fd, request.keepAlive);
+        if (!respond(reply, request) || !request.keepAlive)
+            break;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _clientFds.erase(std::remove(_clientFds.begin(), _clientFds.end(), fd), _clientFds.end());
+    }
+    ::close(fd);
+}
+
+bool MockLlmServer::readRequest(int fd, std::string &buffer, Request &request)
+{
+    char data[16384];
+    size_t headerEnd;
+    while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos)
+    {
+        if (buffer.size() > kMaxHeaderBytes)
+            return false;
+        ssize_t received = ::recv(fd, data, sizeof(data), 0);
+        if (received <= 0)
+            return false;
+        buffer.append(data, static_cast<size_t>(received));
+    }
+
+    request = Request();
+    std::string head = buffer.substr(0, headerEnd);
+    buffer.erase(0, headerEnd + 4);
+
+    size_t lineEnd = head.find("\r\n");
+    std::string requestLine = head.substr(0, lineEnd);
+    size_t firstSpace = requestLine.find(' ');
+    size_t secondSpace = requestLine.find(' ', firstSpace + 1);
+    if (firstSpace == std::string::npos || secondSpace == std::string::npos)
+        return false;
+    request.method = requestLine.substr(0, firstSpace);
+    request.path = requestLine.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+    request.keepAlive = requestLine.compare(secondSpace + 1, std::string::npos, "HTTP/1.0") != 0;
+
+    size_t contentLength = 0;
+    bool expectContinue = false;
+    size_t position = (lineEnd == std::string::npos) ? head.size() : lineEnd + 2;
+    while (position < head.size())
+    {
+        size_t next = head.find("\r\n", position);
+        std::string line = head.substr(position, (next == std::string::npos) ? std::string::npos : next - position);
+        position = (next == std::string::npos) ? head.size() : next + 2;
+
+        size_t colon = line.find(':');
+        if (colon == std::string::npos)
+            continue;
+        std::string name = lower(line.substr(0, colon));
+        size_t valueStart = line.find_first_not_of(' ', colon + 1);
+        std::string value = (valueStart == std::string::npos) ? std::string() : line.substr(valueStart);
+        if (name == "content-length")
+            contentLength = static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 10));
+        else if (name == "connection")
+            request.keepAlive = lower(value) != "close";
+        else if (name == "expect")
+            expectContinue = lower(value) == "100-continue";
+        else if (name == "sec-websocket-key")
+            request.webSocketKey = value;
+    }
+
+    if (expectContinue && buffer.size() < contentLength)
+    {
+        const char continueLine[] = "HTTP/1.1 100 Continue\r\n\r\n";
+        if (!sendAll(fd, continueLine, sizeof(continueLine) - 1))
+            return false;
+    }
+
+    while (buffer.size() < contentLength)
+    {
+        ssize_t received = ::recv(fd, data, sizeof(data), 0);
+        if (received <= 0)
+            return false;
+        buffer.append(data, static_cast<size_t>(received));
+    }
+    request.body = buffer.substr(0, contentLength);
+    buffer.erase(0, contentLength);
+    return true;
+}
+
+bool MockLlmServer::respond(Reply &reply, const Request &request)
+{
+    std::string route = request.path.substr(0, request.path.find('?'));
+    if (request.method == "GET" && route.size() >= 7 && route.compare(route.size() - 7, 7, "/api/ps") == 0)
+        return sendRunningModels(reply);
+
+    std::string format = formatForPath(request.path);
+    if (request.method == "HEAD")
+        return sendError(reply, format.empty() ? 404 : 405, false); // Pre-connects (no body allowed)
+    if (request.method != "POST" || format.empty() || format == "realtime")
+        return sendError(reply, 404);
+
+    if (_options.errorStatus > 0 && (_options.errorCount < 0 || _errorsSent.fetch_add(1) < _options.errorCount))
+    {
+        if (_options.ttfbMs > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(_options.ttfbMs));
+        return sendError(reply, _options.errorStatus);
+    }
+
+    json body = json::parse(request.body, nullptr, false);
+    if (body.is_discarded() || !body.is_object())
+        return sendError(reply, 400);
+
+    std::string model = body.value("model", std::string("mock-model"));
+    // Ollama streams unless told otherwise, OpenAI and Claude only on request
+    bool isOllama = (format.compare(0, 6, "ollama") == 0);
+    bool stream = body.contains("stream") && body["stream"].is_boolean() ? body["stream"].get<bool>() : isOllama;
+    if (format == "gemini")
+    {
+        // Gemini: the model and the streaming method are in the path (models/MODEL:streamGenerateContent), not the body
+        if (body.contains("stream"))
+            return sendError(reply, 400);
+        size_t start = route.find("models/");
+        size_t colon = route.rfind(':');
+        if (start != std::string::npos && colon > start)
+            model = route.substr(start + 7, colon - start - 7);
+        stream = route.find(":streamGenerateContent") != std::string::npos;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_modelsMutex);
+        _lastModel = model;
+    }
+
+    if (isOllama)
+    {
+        int64_t keepAlive = keepAliveSeconds(body);
+        loadModel(model, keepAlive);
+
+        // Nothing to generate: Ollama answers the load (or unload) request with a single object
+        bool empty = (format == "ollama") ? body.value("prompt", std::string()).empty()
+                                          : (!body.contains("messages") || body["messages"].empty());
+        if (empty)
+        {
+            json done = {{"model", model}, {"done", true}, {"done_reason", keepAlive == 0 ? "unload" : "load"}};
+            if (format == "ollama-chat")
+                done["message"] = {{"role", "assistant"}, {"content", ""}};
+            else
+                done["response"] = "";
+            return sendJson(reply, done.dump());
+        }
+    }
+
+    // One token per word of the system prompt and the question
+    Prompt prompt;
+    std::string system;
+    std::string question;
+    bool cacheSystem = false;
+    if (format == "ollama")
+    {
+        system = body.value("system", std::string());
+        question = body.value("prompt", std::string());
+    }
+    else if (body.contains("messages") && body["messages"].is_array())
+    {
+        for (const json &message : body["messages"])
+        {
+            std::string content = (message.contains("content") && message["content"].is_string()) ? message["content"].get<std::string>() : "";
+            (message.value("role", std::string()) == "system" ? system : question) += content + " ";
+        }
+        // OpenAI caches the prompt prefix automatically
+        cacheSystem = (format == "openai");
+    }
+    else if (format == "responses")
+    {
+        // Instructions and input: a string or a list of messages whose content is a string or input_text parts
+        system = body.value("instructions", std::string());
+        const json &input = body.contains("input") ? body["input"] : json();
+        if (input.is_string())
+            question = input.get<std::string>();
+        for (const json &message : input.is_array() ? input : json::array())
+        {
+            const json &content = message.is_object() && message.contains("content") ? message["content"] : json();
+            if (content.is_string())
+                question += content.get<std::string>() + " ";
+            for (const json &part : content.is_array() ? content : json::array())
+                question += part.value("text", std::string()) + " ";
+        }
+        cacheSystem = true;
+    }
+    else if (format == "gemini")
+    {
+        if (body.contains("systemInstruction"))
+            system = geminiText(body["systemInstruction"]);
+        for (const json &content : body.contains("contents") && body["contents"].is_array() ? body["contents"] : json::array())
+            question += geminiText(content);
+        // Gemini 2.5 models cache repeated prompt prefixes implicitly
+        cacheSystem = true;
+    }
+
+    // llama-server (cache_prompt): each slot reuses the words its previous prompt starts with
+    if (format == "openai" && body.contains("cache_prompt") && body["cache_prompt"].is_boolean() && body["cache_prompt"].get<bool>())
+    {
+        cacheSystem = false;
+        prompt.reportsTimings = true;
+        int slot = (body.contains("id_slot") && body["id_slot"].is_number_integer()) ? (std::max)(body["id_slot"].get<int>(), 0) : 0;
+        std::vector<std::string> words = splitWords(system + " " + question);
+        std::lock_guard<std::mutex> lock(_modelsMutex);
+        std::vector<std::string> &previous = _slotPrompts[slot];
+        size_t common = 0;
+        while (common < words.size() && common < previous.size() && words[common] == previous[common])
+            ++common;
+        if (common == words.size() && common > 0)
+            --common; // The last prompt token is always evaluated again
+        prompt.cachedTokens = static_cast<int>(common);
+        prompt.evalTokens = static_cast<int>(words.size() - common);
+        previous = std::move(words);
+    }
+    if (format == "claude" && body.contains("system"))
+    {
+        // A string, or text blocks of which any can carry a cache_control breakpoint
+        const json &blocks = body["system"];
+        if (blocks.is_string())
+            system = blocks.get<std::string>();
+        for (const json &block : blocks.is_array() ? blocks : json::array())
+        {
+            system += block.value("text", std::string()) + " ";
+            cacheSystem = cacheSystem || block.contains("cache_control");
+        }
+    }
+    int systemTokens = countWords(system);
+    int questionTokens = countWords(question);
+    if (!prompt.reportsTimings)
+        prompt.evalTokens = systemTokens + questionTokens;
+
+    // Prompt cache: a system prompt seen before for the model is not processed again
+    if (cacheSystem && systemTokens > 0)
+    {
+        size_t key = std::hash<std::string>()(format + '\n' + model + '\n' + system);
+        std::lock_guard<std::mutex> lock(_modelsMutex);
+        if (_cachedPrompts.insert(key).second)
+            prompt.cacheWriteTokens = systemTokens;
+        else
+        {
+            prompt.cachedTokens = systemTokens;
+            prompt.evalTokens = questionTokens;
+        }
+    }
+
+    // Generate continues the context of the request; only the new prompt words are evaluated
+    if (format == "ollama")
+    {
+        prompt.returnsContext = true;
+        if (body.contains("context") && body["context"].is_array())
+        {
+            for (const json &id : body["context"])
+            {
+                if (id.is_number_integer())
+                    prompt.context.push_back(id.get<int64_t>());
+            }
+        }
+        for (int i = 0; i < prompt.evalTokens; ++i)
+            prompt.context.push_back(1000 + i);
+    }
+    prompt.includeUsage = body.contains("stream_options") && body["stream_options"].is_object() &&
+                          body["stream_options"].value("include_usage", false);
+
+    // Prompt processing comes before the first byte; cached tokens are skipped
+    int64_t prefillUs = static_cast<int64_t>(_options.prefillUsPerToken) * prompt.evalTokens;
+    if (_options.ttfbMs > 0 || prefillUs > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(_options.ttfbMs) + std::chrono::microseconds(prefillUs));
+
+    return stream ? sendStream(reply, format, model, prompt) : sendComplete(reply, format, model, prompt);
+}
+
+bool MockLlmServer::sendError(Reply &reply, int status, bool withBody)
+{
+    json error;
+    error["error"]["message"] = "Mock server error " + std::to_string(status);
+    error["error"]["type"] = (status == 429) ? "rate_limit_error" : "server_error";
+    std::string body = error.dump();
+
+    HeaderList headers = {{"Content-Type", "application/json"}};
+    if (_options.retryAfterSeconds >= 0 && status != 404 && status != 400)
+        headers.emplace_back("Retry-After", std::to_string(_options.retryAfterSeconds));
+    if (!reply.head(status, headers, static_cast<int64_t>(body.size())))
+        return false;
+    return (!withBody || reply.body(body.data(), body.size())) && reply.end();
+}
+
+bool MockLlmServer::sendJson(Reply &reply, const std::string &payload)
+{
+    if (!reply.head(200, {{"Content-Type", "application/json"}}, static_cast<int64_t>(payload.size())))
+        return false;
+
+    // Fragmentation applies to the body, so parsers see it arrive in pieces
+    size_t step = (_options.chunkBytes > 0) ? _options.chunkBytes : payload.size();
+    for (size_t offset = 0; offset < payload.size(); offset += step)
+    {
+        if (!reply.body(payload.data() + offset, (std::min)(step, payload.size() - offset)))
+            return false;
+    }
+    return reply.end();
+}
+
+bool MockLlmServer::sendRunningModels(Reply &reply)
+{
+    json models = json::array();
+    {
+        std::lock_guard<std::mutex> lock(_modelsMutex);
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        for (auto it = _residentUntil.begin(); it != _residentUntil.end();)
+        {
+            if (it->second <= now)
+            {
+                it = _residentUntil.erase(it);
+                continue;
+            }
+
+            char expiresAt[32] = "9999-12-31T23:59:59Z";
+            if (it->second != std::chrono::steady_clock::time_point::max())
+            {
+                std::time_t expires = std::chrono::system_clock::to_time_t(
+                    std::chrono::system_clock::now() + std::chrono::duration_cast<std::chrono::system_clock::duration>(it->second - now));
+                std::strftime(expiresAt, sizeof(expiresAt), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&expires));
+            }
+            models.push_back({{"name", it->first}, {"model", it->first}, {"expires_at", expiresAt}});
+            ++it;
+        }
+    }
+    json body = {{"models", models}};
+    return sendJson(reply, body.dump());
+}
+
+void MockLlmServer::loadModel(const std::string &model, int64_t keepAliveSeconds)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    bool resident;
+    {
+        std::lock_guard<std::mutex> lock(_modelsMutex);
+        auto it = _residentUntil.find(model);
+        resident = (it != _residentUntil.end() && it->second > now);
+    }
+
+    // Loading takes a while only when keep_alive 0 does not unload it right away anyway
+    if (!resident && keepAliveSeconds != 0)
+    {
+        ++_loads;
+        if (_options.loadMs > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(_options.loadMs));
+    }
+
+    // Like Ollama, the unload timer starts when the request has been handled
+    std::lock_guard<std::mutex> lock(_modelsMutex);
+    if (keepAliveSeconds == 0)
+        _residentUntil.erase(model);
+    else if (keepAliveSeconds < 0)
+        _residentUntil[model] = std::chrono::steady_clock::time_point::max();
+    else
+        _residentUntil[model] = std::chrono::steady_clock::now() + std::chrono::seconds(keepAliveSeconds);
+}
+
+bool MockLlmServer::sendStream(Reply &reply, const std::string &format, const std::string &model, const Prompt &prompt)
+{
+    bool sse = (format == "openai" || format == "claude" || format == "responses" || format == "gemini");
+    HeaderList headers = {{"Content-Type", sse ? "text/event-stream" : "application/x-ndjson"}, {"Cache-Control", "no-cache"}};
+    if (!reply.head(200, headers, -1))
+        return false;
+
+    const int tokens = _options.tokens;
+    if (format == "claude")
+    {
+        json usage = {{"input_tokens", prompt.evalTokens - prompt.cacheWriteTokens}, {"output_tokens", 1},
+                      {"cache_creation_input_tokens", prompt.cacheWriteTokens}, {"cache_read_input_tokens", prompt.cachedTokens}};
+        json start = {{"type", "message_start"},
+                      {"message", {{"id", "msg_mock"}, {"type", "message"}, {"role", "assistant"}, {"model", model}, {"content", json::array()}, {"usage", usage}}}};
+        json blockStart = {{"type", "content_block_start"}, {"index", 0}, {"content_block", {{"type", "text"}, {"text", ""}}}};
+        if (!sendChunk(reply, "event: message_start\ndata: " + start.dump() + "\n\n") ||
+            !sendChunk(reply, "event: content_block_start\ndata: " + blockStart.dump() + "\n\n"))
+            return false;
+    }
+    else if (format == "responses")
+    {
+        json created = {{"type", "response.created"},
+                        {"response", {{"id", "resp_mock"}, {"object", "response"}, {"status", "in_progress"}, {"model", model}, {"output", json::array()}}}};
+        if (!sendChunk(reply, "event: response.created\ndata: " + created.dump() + "\n\n"))
+            return false;
+    }
+
+    auto generationStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < tokens; ++i)
+    {
+        if (i == _options.disconnectAfterTokens)
+            return false; // Drop the connection without the terminating chunk
+
+        pace(i);
+
+        std::string event;
+        if (format == "openai")
+        {
+            json chunk = {{"id", "chatcmpl-mock"}, {"object", "chat.completion.chunk"}, {"model", model},
+                          {"choices", json::array({{{"index", 0}, {"delta", {{"content", token(i)}}}, {"finish_reason", nullptr}}})}};
+            event = "data: " + chunk.dump() + "\n\n";
+        }
+        else if (format == "claude")
+        {
+            json delta = {{"type", "content_block_delta"}, {"index", 0}, {"delta", {{"type", "text_delta"}, {"text", token(i)}}}};
+            event = "event: content_block_delta\ndata: " + delta.dump() + "\n\n";
+        }
+        else if (format == "ollama-chat")
+        {
+            json line = {{"model", model}, {"message", {{"role", "assistant"}, {"content", token(i)}}}, {"done", false}};
+            event = line.dump() + "\n";
+        }
+        else if (format == "responses")
+        {
+            json delta = {{"type", "response.output_text.delta"}, {"item_id", "msg_mock"}, {"output_index", 0}, {"content_index", 0}, {"delta", token(i)}};
+            event = "event: response.output_text.delta\ndata: " + delta.dump() + "\n\n";
+        }
+        else if (format == "gemini")
+        {
+            json chunk = {{"candidates", geminiCandidates(token(i), false)}, {"modelVersion", model}};
+            event = "data: " + chunk.dump() + "\r\n\r\n";
+        }
+        else
+        {
+            json line = {{"model", model}, {"response", token(i)}, {"done", false}};
+            event = line.dump() + "\n";
+        }
+        if (!sendChunk(reply, event))
+            return false;
+        ++_tokensStreamed;
+    }
+    if (tokens == _options.disconnectAfterTokens)
+        return false;
+
+    std::string tail;
+    if (format == "openai")
+    {
+        json last = {{"id", "chatcmpl-mock"}, {"object", "chat.completion.chunk"}, {"model", model},
+                     {"choices", json::array({{{"index", 0}, {"delta", json::object()}, {"finish_reason", "stop"}}})}};
+        if (prompt.reportsTimings)
+        {
+            double predictedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - generationStart).count();
+            last["timings"] = llamaTimings(prompt.evalTokens, prompt.cachedTokens, _options.prefillUsPerToken, tokens, predictedMs);
+        }
+        tail = "data: " + last.dump() + "\n\n";
+        if (prompt.includeUsage)
+        {
+            json usage = {{"id", "chatcmpl-mock"}, {"object", "chat.completion.chunk"}, {"model", model}, {"choices", json::array()},
+                          {"usage", openAIUsage(prompt.evalTokens, prompt.cachedTokens, tokens)}};
+            tail += "data: " + usage.dump() + "\n\n";
+        }
+        tail += "data: [DONE]\n\n";
+    }
+    else if (format == "claude")
+    {
+        json blockStop = {{"type", "content_block_stop"}, {"index", 0}};
+        json messageDelta = {{"type", "message_delta"}, {"delta", {{"stop_reason", "end_turn"}}}, {"usage", {{"output_tokens", tokens}}}};
+        tail = "event: content_block_stop\ndata: " + blockStop.dump() + "\n\n" +
+               "event: message_delta\ndata: " + messageDelta.dump() + "\n\n" +
+               "event: message_stop\ndata: {\"type\":\"message_stop\"}\n\n";
+    }
+    else if (format == "responses")
+    {
+        std::string text = answerText(tokens);
+        json done = {{"type", "response.output_text.done"}, {"item_id", "msg_mock"}, {"output_index", 0}, {"content_index", 0}, {"text", text}};
+        json completed = {{"type", "response.completed"},
+                          {"response", {{"id", "resp_mock"}, {"object", "response"}, {"status", "completed"}, {"model", model},
+                                        {"output", json::array({{{"type", "message"}, {"id", "msg_mock"}, {"role", "assistant"},
+                                                                 {"content", json::array({{{"type", "output_text"}, {"text", text}}})}}})},
+                                        {"usage", responsesUsage(prompt.evalTokens, prompt.cachedTokens, tokens)}}}};
+        tail = "event: response.output_text.done\ndata: " + done.dump() + "\n\n" +
+               "event: response.completed\ndata: " + completed.dump() + "\n\n";
+    }
+    else if (format == "gemini")
+    {
+        // The last chunk carries the finish reason and the usage; there is no [DONE] marker
+        json last = {{"candidates", geminiCandidates("", true)}, {"usageMetadata", geminiUsage(prompt.evalTokens, prompt.cachedTokens, tokens)},
+                     {"modelVersion", model}};
+        tail = "data: " + last.dump() + "\r\n\r\n";
+    }
+    else
+    {
+        json last = {{"model", model}, {"done", true}, {"done_reason", "stop"}, {"eval_count", tokens}, {"prompt_eval_count", prompt.evalTokens}};
+        if (format == "ollama-chat")
+            last["message"] = {{"role", "assistant"}, {"content", ""}};
+        else
+            last["response"] = "";
+        if (prompt.returnsContext)
+            last["context"] = answerContext(prompt.context, tokens);
+        tail = last.dump() + "\n";
+    }
+
+    return sendChunk(reply, tail) && reply.end();
+}
+
+bool MockLlmServer::sendComplete(Reply &reply, const std::string &format, const std::string &model, const Prompt &prompt)
+{
+    // The whole answer is "generated" before the response is sent
+    auto generationStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < _options.tokens; ++i)
+        pace(i);
+    double predictedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - generationStart).count();
+
+    std::string text = answerText(_options.tokens);
+    json body;
+    if (format == "openai")
+    {
+        body = {{"id", "chatcmpl-mock"}, {"object", "chat.completion"}, {"model", model},
+                {"choices", json::array({{{"index", 0}, {"message", {{"role", "assistant"}, {"content", text}}}, {"finish_reason", "stop"}}})},
+                {"usage", openAIUsage(prompt.evalTokens, prompt.cachedTokens, _options.tokens)}};
+        if (prompt.reportsTimings)
+            body["timings"] = llamaTimings(prompt.evalTokens, prompt.cachedTokens, _options.prefillUsPerToken, _options.tokens, predictedMs);
+    }
+    else if (format == "claude")
+    {
+        body = {{"id", "msg_mock"}, {"type", "message"}, {"role", "assistant"}, {"model", model},
+                {"content", json::array({{{"type", "text"}, {"text", text}}})}, {"stop_reason", "end_turn"},
+                {"usage", {{"input_tokens", prompt.evalTokens - prompt.cacheWriteTokens}, {"output_tokens", _options.tokens},
+                           {"cache_creation_input_tokens", prompt.cacheWriteTokens}, {"cache_read_input_tokens", prompt.cachedTokens}}}};
+    }
+    else if (format == "responses")
+    {
+        body = {{"id", "resp_mock"}, {"object", "response"}, {"status", "completed"}, {"model", model},
+                {"output", json::array({{{"type", "message"}, {"id", "msg_mock"}, {"role", "assistant"},
+                                         {"content", json::array({{{"type", "output_text"}, {"text", text}}})}}})},
+                {"usage", responsesUsage(prompt.evalTokens, prompt.cachedTokens, _options.tokens)}};
+    }
+    else if (format == "gemini")
+    {
+        body = {{"candidates", geminiCandidates(text, true)}, {"usageMetadata", geminiUsage(prompt.evalTokens, prompt.cachedTokens, _options.tokens)},
+                {"modelVersion", model}};
+    }
+    else
+    {
+        body = {{"model", model}, {"done", true}, {"done_reason", "stop"}, {"eval_count", _options.tokens}, {"prompt_eval_count", prompt.evalTokens}};
+        if (format == "ollama-chat")
+            body["message"] = {{"role", "assistant"}, {"content", text}};
+        else
+            body["response"] = text;
+        if (prompt.returnsContext)
+            body["context"] = answerContext(prompt.context, _options.tokens);
+    }
+
+    return sendJson(reply, body.dump());
+}
+
+bool MockLlmServer::sendChunk(Reply &reply, const std::string &data)
+{
+    // With chunkBytes set, events are cut at arbitrary byte positions (mid-line, mid-UTF-8)
+    size_t step = (_options.chunkBytes > 0) ? _options.chunkBytes : data.size();
+    for (size_t offset = 0; offset < data.size(); offset += step)
+    {
+        if (!reply.body(data.data() + offset, (std::min)(step, data.size() - offset)))
+            return false;
+    }
+    return true;
+}
+
+void MockLlmServer::pace(int tokenIndex)
+{
+    if (tokenIndex == _options.stallAfterTokens && _options.stallMs > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(_options.stallMs));
+    if (_options.tokensPerSecond > 0 && tokenIndex > 0)
+        std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(1e6 / _options.tokensPerSecond)));
+}
+
+void MockLlmServer::serveRealtime(int fd, const Request &request, std::string &buffer)
+{
+    std::string response = "HTTP/1.1 101 Switching Protocols\r\n"
+                           "Upgrade: websocket\r\n"
+                           "Connection: Upgrade\r\n"
+                           "Sec-WebSocket-Accept: " + base64(sha1(request.webSocketKey + kWebSocketGuid)) + "\r\n\r\n";
+    if (!sendAll(fd, response.data(), response.size()))
+        return;
+
+    int session = ++_sessions;
+    std::string model = "mock-realtime";
+    size_t modelParam = request.path.find("model=");
+    if (modelParam != std::string::npos)
+        model = request.path.substr(modelParam + 6, request.path.find('&', modelParam) - modelParam - 6);
+    json created = {{"type", "session.created"}, {"session", {{"id", "sess_mock" + std::to_string(session)}, {"model", model}}}};
+    if (!sendFrame(fd, 0x1, created.dump()))
+        return;
+
+    for (;;)
+    {
+        int opcode = 0;
+        std::string payload;
+        int read = readFrame(fd, buffer, opcode, payload, _options.realtimeIdleMs);
+        if (read == 0)
+        {
+            sendFrame(fd, 0x8, std::string("\x03\xE9", 2) + "idle timeout"); // 1001 going away
+            return;
+        }
+        if (read < 0)
+            return;
+        if (opcode == 0x8)
+        {
+            sendFrame(fd, 0x8, payload.substr(0, 2));
+            return;
+        }
+        if (opcode == 0x9)
+        {
+            if (!sendFrame(fd, 0xA, payload))
+                return;
+            continue;
+        }
+        if (opcode != 0x1)
+            continue;
+
+        json event = json::parse(payload, nullptr, false);
+        std::string type = event.is_object() ? event.value("type", std::string()) : "";
+        bool sent;
+        if (type == "session.update")
+        {
+            json updated = {{"type", "session.updated"}, {"session", event.value("session", json::object())}};
+            sent = sendFrame(fd, 0x1, updated.dump());
+        }
+        else if (type == "response.create")
+        {
+            ++_requests;
+            sent = sendRealtimeResponse(fd, model, payload);
+        }
+        else
+        {
+            json error = {{"type", "error"}, {"error", {{"type", "invalid_request_error"}, {"message", "Unsupported event type: " + type}}}};
+            sent = sendFrame(fd, 0x1, error.dump());
+        }
+        if (!sent)
+            return;
+    }
+}
+
+bool MockLlmServer::sendRealtimeResponse(int fd, const std::string &model, const std::string &event)
+{
+    json body = json::parse(event, nullptr, false);
+    json response = body.is_object() ? body.value("response", json::object()) : json::object();
+    std::string system = response.value("instructions", std::string());
+    std::string question;
+    for (const json &item : response.value("input", json::array()))
+    {
+        for (const json &content : item.value("content", json::array()))
+            question += content.value("text", std::string()) + " ";
+    }
+
+    // Instructions are a cached prefix like an OpenAI system prompt
+    int systemTokens = countWords(system);
+    int evalTokens = systemTokens + countWords(question);
+    int cachedTokens = 0;
+    if (systemTokens > 0)
+    {
+        size_t key = std::hash<std::string>()("realtime\n" + model + '\n' + system);
+        std::lock_guard<std::mutex> lock(_modelsMutex);
+        if (!_cachedPrompts.insert(key).second)
+        {
+            cachedTokens = systemTokens;
+            evalTokens -= systemTokens;
+        }
+    }
+    int tokens = _options.tokens;
+    if (response.contains("max_output_tokens") && response["max_output_tokens"].is_number_integer())
+        tokens = (std::min)(tokens, response["max_output_tokens"].get<int>());
+
+    int64_t prefillUs = static_cast<int64_t>(_options.prefillUsPerToken) * evalTokens;
+    if (_options.ttfbMs > 0 || prefillUs > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(_options.ttfbMs) + std::chrono::microseconds(prefillUs));
+
+    std::string id = "resp_mock" + std::to_string(_requests.load());
+    json created = {{"type", "response.created"}, {"response", {{"id", id}, {"status", "in_progress"}}}};
+    if (!sendFrame(fd, 0x1, created.dump()))
+        return false;
+    for (int i = 0; i < tokens; ++i)
+    {
+        pace(i);
+        if (i == _options.disconnectAfterTokens)
+            return false;
+        json delta = {{"type", "response.text.delta"}, {"response_id", id}, {"output_index", 0}, {"content_index", 0}, {"delta", token(i)}};
+        if (!sendFrame(fd, 0x1, delta.dump()))
+            return false;
+    }
+    json textDone = {{"type", "response.text.done"}, {"response_id", id}, {"text", answerText(tokens)}};
+    json usage = {{"total_tokens", evalTokens + cachedTokens + tokens}, {"input_tokens", evalTokens + cachedTokens}, {"output_tokens", tokens},
+                  {"input_token_details", {{"cached_tokens", cachedTokens}, {"text_tokens", evalTokens + cachedTokens}}},
+                  {"output_token_details", {{"text_tokens", tokens}}}};
+    json done = {{"type", "response.done"}, {"response", {{"id", id}, {"status", "completed"}, {"usage", usage}}}};
+    return sendFrame(fd, 0x1, textDone.dump()) && sendFrame(fd, 0x1, done.dump());
+}
+
+// Server frames are not masked; messages always fit one frame
+bool MockLlmServer::sendFrame(int fd, int opcode, const std::string &payload)
+{
+    std::string frame(1, static_cast<char>(0x80 | opcode));
+    if (payload.size() < 126)
+    {
+        frame += static_cast<char>(payload.size());
+    }
+    else if (payload.size() <= 0xFFFF)
+    {
+        frame += static_cast<char>(126);
+        frame += static_cast<char>((payload.size() >> 8) & 0xFF);
+        frame += static_cast<char>(payload.size() & 0xFF);
+    }
+    else
+    {
+        frame += static_cast<char>(127);
+        for (int shift = 56; shift >= 0; shift -= 8)
+            frame += static_cast<char>((static_cast<uint64_t>(payload.size()) >> shift) & 0xFF);
+    }
+    frame += payload;
+    return sendAll(fd, frame.data(), frame.size());
+}
+
+// 1 = a frame was read (payload unmasked), 0 = nothing arrived within timeoutMs (0 = wait forever), -1 = closed
+int MockLlmServer::readFrame(int fd, std::string &buffer, int &opcode, std::string &payload, int timeoutMs)
+{
+    for (;;)
+    {
+        if (buffer.size() >= 2)
+        {
+            uint64_t length = static_cast<unsigned char>(buffer[1]) & 0x7F;
+            size_t extended = (length == 126) ? 2 : (length == 127) ? 8 : 0;
+            bool masked = (static_cast<unsigned char>(buffer[1]) & 0x80) != 0;
+            size_t headerSize = 2 + extended + (masked ? 4 : 0);
+            if (buffer.size() >= headerSize)
+            {
+                if (extended)
+                {
+                    length = 0;
+                    for (size_t i = 0; i < extended; ++i)
+                        length = (length << 8) | static_cast<unsigned char>(buffer[2 + i]);
+                }
+                if (buffer.size() - headerSize >= length)
+                {
+                    opcode = static_cast<unsigned char>(buffer[0]) & 0x0F;
+                    payload = buffer.substr(headerSize, static_cast<size_t>(length));
+                    if (masked)
+                    {
+                        for (size_t i = 0; i < payload.size(); ++i)
+                            payload[i] = static_cast<char>(payload[i] ^ buffer[headerSize - 4 + i % 4]);
+                    }
+                    buffer.erase(0, headerSize + static_cast<size_t>(length));
+                    return 1;
+                }
+            }
+        }
+
+        pollfd readable = {fd, POLLIN, 0};
+        int ready = ::poll(&readable, 1, timeoutMs > 0 ? timeoutMs : -1);
+        if (ready == 0)
+            return 0;
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        char data[16384];
+        ssize_t received = ::recv(fd, data, sizeof(data), 0);
+        if (received <= 0)
+            return -1;
+        buffer.append(data, static_cast<size_t>(received));
+    }
+}
+
+/**
+ * An HTTP/2 connection: the reader thread and the threads answering its streams
+ * write frames under one mutex and share the flow-control windows
+ */
+struct MockLlmServer::Http2Connection
+{
+    explicit Http2Connection(int socket) : fd(socket) {}
+
+    // Caller holds the mutex
+    bool writeFrame(uint8_t type, uint8_t flags, uint32_t stream, const std::string &payload)
+    {
+        std::string frame;
+        frame += static_cast<char>(payload.size() >> 16);
+        frame += static_cast<char>(payload.size() >> 8);
+        frame += static_cast<char>(payload.size());
+        frame += static_cast<char>(type);
+        frame += static_cast<char>(flags);
+        frame += uint32Bytes(stream & 0x7fffffff);
+        frame += payload;
+        return sendAll(fd, frame.data(), frame.size());
+    }
+
+    int fd;
+    std::mutex mutex;
+    std::condition_variable windowOpened;
+    int64_t sendWindow = kDefaultWindow;        // Connection flow-control window
+    int64_t initialWindow = kDefaultWindow;     // The client's SETTINGS_INITIAL_WINDOW_SIZE
+    size_t maxFrameSize = 16384;                // The client's SETTINGS_MAX_FRAME_SIZE
+    std::map<uint32_t, int64_t> streamWindows;  // Streams still open for sending
+    bool closed = false;
+};
+
+/**
+ * HTTP/2 response on one stream: HEADERS, then DATA frames within the flow-control windows
+ */
+class MockLlmServer::Http2Stream : public MockLlmServer::Reply
+{
+public:
+    Http2Stream(Http2Connection &connection, uint32_t id) : _connection(connection), _id(id) {}
+
+    bool head(int status, const HeaderList &headers, int64_t contentLength) override
+    {
+        HeaderList fields = {{":status", std::to_string(status)}};
+        for (const auto &header : headers)
+            fields.emplace_back(lower(header.first), header.second);
+        if (contentLength >= 0)
+            fields.emplace_back("content-length", std::to_string(contentLength));
+        std::lock_guard<std::mutex> lock(_connection.mutex);
+        return isOpen() && _connection.writeFrame(kFrameHeaders, kFlagEndHeaders, _id, HpackDecoder::encode(fields));
+    }
+
+    bool body(const char *data, size_t size) override
+    {
+        while (size > 0)
+        {
+            std::unique_lock<std::mutex> lock(_connection.mutex);
+            _connection.windowOpened.wait(lock, [this]()
+                                          { return !isOpen() || (_connection.sendWindow > 0 && _connection.streamWindows[_id] > 0); });
+            if (!isOpen())
+                return false;
+            int64_t window = (std::min)(_connection.sendWindow, _connection.streamWindows[_id]);
+            size_t length = (std::min)({size, _connection.maxFrameSize, static_cast<size_t>(window)});
+            if (!_connection.writeFrame(kFrameData, 0, _id, std::string(data, length)))
+                return false;
+            _connection.sendWindow -= static_cast<int64_t>(length);
+            _connection.streamWindows[_id] -= static_cast<int64_t>(length);
+            data += length;
+            size -= length;
+        }
+        return true;
+    }
+
+    bool end() override
+    {
+        std::lock_guard<std::mutex> lock(_connection.mutex);
+        if (!isOpen())
+            return false;
+        _connection.streamWindows.erase(_id);
+        return _connection.writeFrame(kFrameData, kFlagEndStream, _id, std::string());
+    }
+
+    // The response was abandoned midway (a dropped connection on HTTP/1.1): reset the stream
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock(_connection.mutex);
+        if (isOpen())
+        {
+            _connection.streamWindows.erase(_id);
+            _connection.writeFrame(kFrameRstStream, 0, _id, uint32Bytes(0x2)); // INTERNAL_ERROR
+        }
+    }
+
+private:
+    // Caller holds the mutex; false once the client reset the stream or the connection ended
+    bool isOpen() const
+    {
+        return !_connection.closed && _connection.streamWindows.count(_id) != 0;
+    }
+
+    Http2Connection &_connection;
+    uint32_t _id;
+};
+
+/**
+ * Serve an HTTP/2 connection whose preface started with "PRI * HTTP/2.0"
+ *
+ * This thread reads the frames; each complete request is answered by a thread
+ * of its own, so a slow stream does not hold up the others on the connection.
+ * Request bodies are acknowledged with WINDOW_UPDATE as soon as they arrive.
+ */
+void MockLlmServer::serveHttp2(int fd, std::string &buffer)
+{
+    if (!receiveAtLeast(fd, buffer, 6) || buffer.compare(0, 6, "SM\r\n\r\n") != 0)
+        return;
+    buffer.erase(0, 6);
+    ++_http2Connections;
+
+    struct PendingRequest
+    {
+        std::string headerBlock;
+        Request request;
+        bool headersDone = false;
+        bool bodyDone = false;
+    };
+    Http2Connection connection(fd);
+    HpackDecoder decoder;
+    std::map<uint32_t, PendingRequest> pending;
+    std::vector<std::thread> streams;
+    uint32_t continuedStream = 0; // Stream whose header block continues in CONTINUATION frames
+
+    auto dispatch = [&](uint32_t id)
+    {
+        Request request = pending[id].request;
+        pending.erase(id);
+        ++_requests;
+        streams.emplace_back([this, &connection, id, request]()
+                             {
+                                 Http2Stream reply(connection, id);
+                                 if (!respond(reply, request))
+                                     reply.reset(); });
+    };
+
+    bool ok;
+    {
+        std::lock_guard<std::mutex> lock(connection.mutex);
+        ok = connection.writeFrame(kFrameSettings, 0, 0, setting(kSettingMaxConcurrentStreams, 100));
+    }
+    while (ok && _running && receiveAtLeast(fd, buffer, 9))
+    {
+        size_t length = (static_cast<size_t>(static_cast<unsigned char>(buffer[0])) << 16) |
+                        (static_cast<size_t>(static_cast<unsigned char>(buffer[1])) << 8) | static_cast<unsigned char>(buffer[2]);
+        uint8_t type = static_cast<uint8_t>(buffer[3]);
+        uint8_t flags = static_cast<uint8_t>(buffer[4]);
+        uint32_t stream = readUint32(buffer, 5) & 0x7fffffff;
+        if (!receiveAtLeast(fd, buffer, 9 + length))
+            break;
+        std::string payload = buffer.substr(9, length);
+        buffer.erase(0, 9 + length);
+        if (continuedStream != 0 && (type != kFrameContinuation || stream != continuedStream))
+            break; // Protocol error: a header block must not be interleaved
+
+        // Padding and priority fields of DATA and HEADERS
+        if ((type == kFrameData || type == kFrameHeaders) && (flags & kFlagPadded))
+        {
+            size_t padding = payload.empty() ? 0 : static_cast<unsigned char>(payload[0]);
+            if (payload.empty() || padding >= payload.size())
+                break;
+            payload = payload.substr(1, payload.size() - 1 - padding);
+        }
+        if (type == kFrameHeaders && (flags & kFlagPriority))
+            payload.erase(0, (std::min)(payload.size(), static_cast<size_t>(5)));
+
+        std::lock_guard<std::mutex> lock(connection.mutex);
+        switch (type)
+        {
+        case kFrameSettings:
+            if (flags & kFlagAck)
+                break;
+            for (size_t offset = 0; offset + 6 <= payload.size(); offset += 6)
+            {
+                uint16_t id = static_cast<uint16_t>((static_cast<unsigned char>(payload[offset]) << 8) | static_cast<unsigned char>(payload[offset + 1]));
+                uint32_t value = readUint32(payload, offset + 2);
+                if (id == kSettingInitialWindowSize)
+                {
+                    // Applies to every open stream as a change of its window
+                    for (auto &window : connection.streamWindows)
+                        window.second += static_cast<int64_t>(value) - connection.initialWindow;
+                    connection.initialWindow = value;
+                }
+                else if (id == kSettingMaxFrameSize)
+                    connection.maxFrameSize = value;
+            }
+            ok = connection.writeFrame(kFrameSettings, kFlagAck, 0, std::string());
+            connection.windowOpened.notify_all();
+            break;
+        case kFramePing:
+            if (!(flags & kFlagAck))
+                ok = connection.writeFrame(kFramePing, kFlagAck, 0, payload);
+            break;
+        case kFrameWindowUpdate:
+            if (payload.size() == 4)
+            {
+                int64_t increment = readUint32(payload, 0) & 0x7fffffff;
+                if (stream == 0)
+                    connection.sendWindow += increment;
+                else if (connection.streamWindows.count(stream))
+                    connection.streamWindows[stream] += increment;
+                connection.windowOpened.notify_all();
+            }
+            break;
+        case kFrameRstStream:
+            connection.streamWindows.erase(stream);
+            pending.erase(stream);
+            connection.windowOpened.notify_all();
+            break;
+        case kFrameHeaders:
+        case kFrameContinuation:
+        {
+            if (type == kFrameHeaders)
+                connection.streamWindows[stream] = connection.initialWindow;
+            PendingRequest &request = pending[stream];
+            request.headerBlock += payload;
+            if (type == kFrameHeaders && (flags & kFlagEndStream))
+                request.bodyDone = true; // No body follows
+            if (!(flags & kFlagEndHeaders))
+            {
+                continuedStream = stream;
+                break;
+            }
+            continuedStream = 0;
+            HeaderList headers;
+            if (!decoder.decode(request.headerBlock, headers))
+            {
+                ok = false;
+                break;
+            }
+            for (const auto &header : headers)
+            {
+                if (header.first == ":method")
+                    request.request.method = header.second;
+                else if (header.first == ":path")
+                    request.request.path = header.second;
+            }
+            request.headersDone = true;
+            if (request.bodyDone)
+                dispatch(stream);
+            break;
+        }
+        case kFrameData:
+            // Hand the received bytes back to the client's windows right away
+            if (length > 0)
+            {
+                ok = connection.writeFrame(kFrameWindowUpdate, 0, 0, uint32Bytes(static_cast<uint32_t>(length))) &&
+                     connection.writeFrame(kFrameWindowUpdate, 0, stream, uint32Bytes(static_cast<uint32_t>(length)));
+            }
+            if (pending.count(stream))
+            {
+                PendingRequest &request = pending[stream];
+                request.request.body += payload;
+                request.bodyDone = (flags & kFlagEndStream) != 0;
+                if (request.bodyDone && request.headersDone)
+                    dispatch(stream);
+            }
+            break;
+        case kFrameGoAway:
+            ok = false;
+            break;
+        default:
+            break; // PRIORITY and unknown frames are ignored
+        }
+    }
+
+    // Unblock the streams still being answered, then wait for them
+    {
+        std::lock_guard<std::mutex> lock(connection.mutex);
+        connection.closed = true;
+        connection.windowOpened.notify_all();
+    }
+    ::shutdown(fd, SHUT_RDWR);
+    for (std::thread &stream : streams)
+        stream.join();
+}
+
+std::string MockLlmServer::token(int index)
+{
+    return kWords[static_cast<size_t>(index) % kWordCount];
+}
+
+std::string MockLlmServer::answerText(int tokens)
+{
+    std::string text;
+    for (int i = 0; i < tokens; ++i)
+        text += token(i);
+    return text;
+}
+
+bool MockLlmServer::sendAll(int fd, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t sent = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            if (sent < 0 && errno == EINTR)
+                continue;
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
@@ -0,0 +1,192 @@
+#pragma once
+#include "Hpack.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Behaviour of the mock server; every value applies to each request
+ */
+struct MockServerOptions
+{
+    int port = 0;                   // 0 = any free port (see MockLlmServer::port)
+    int tokens = 50;                // Tokens per answer
+    double tokensPerSecond = 0;     // Token rate (0 = as fast as possible)
+    int ttfbMs = 0;                 // Delay before the response headers and first token
+    size_t chunkBytes = 0;          // Split each event into writes of this size (0 = one write per event)
+    int errorStatus = 0;            // Answer with this HTTP status instead (0 = never)
+    int errorCount = -1;            // Number of requests answered with errorStatus (-1 = all)
+    int retryAfterSeconds = -1;     // Retry-After header on error responses (-1 = none)
+    int stallAfterTokens = -1;      // Pause the stream after this many tokens (-1 = never)
+    int stallMs = 0;                // Length of the pause
+    int disconnectAfterTokens = -1; // Drop the connection after this many tokens (-1 = never)
+    int loadMs = 0;                 // Ollama: delay of a request for a model that is not loaded
+    int prefillUsPerToken = 0;      // Prompt processing time per uncached prompt token, in microseconds
+    int realtimeIdleMs = 0;         // Realtime: close a session that sent no event for this long (0 = never)
+};
+
+/**
+ * MockLlmServer - Deterministic stand-in for LLM APIs on the loopback interface
+ *
+ * Speaks the wire formats the plugin parses:
+ *   POST /v1/chat/completions  OpenAI (SSE with "stream": true, JSON otherwise)
+ *   POST /v1/messages          Claude (event stream with "stream": true, JSON otherwise)
+ *   POST /v1/responses         OpenAI Responses API (event stream with "stream": true, JSON otherwise)
+ *   POST .../models/M:generateContent, :streamGenerateContent  Gemini (JSON; SSE from the streaming method)
+ *   POST /api/chat             Ollama chat (NDJSON unless "stream": false)
+ *   POST /api/generate         Ollama generate (NDJSON unless "stream": false)
+ *   GET  /api/ps               Ollama models currently loaded
+ *   GET  /v1/realtime          Realtime API (WebSocket upgrade; text responses to response.create)
+ *
+ * Ollama models are "loaded" by their first request, which takes loadMs, and
+ * stay resident for the request's keep_alive (default 5m). An empty prompt
+ * only loads the model (or unloads it with keep_alive 0), like Ollama does.
+ * Generate responses end with a "context" array: the request's context, one
+ * id per prompt word and one per answer token; prompt_eval_count only counts
+ * the prompt words, so a request that continues a context evaluates less.
+ *
+ * Prompts count one token per word. System prompts are cached per model like
+ * the providers do: automatically for OpenAI (instructions of the Responses
+ * API included) and Gemini, when a system block carries cache_control for
+ * Claude. Cached tokens skip the prefill delay and are
+ * reported in the usage (cached_tokens, cache_read_input_tokens). OpenAI
+ * requests with "cache_prompt" are answered like llama-server: the prompt
+ * reuses the prefix it shares with the previous prompt of its slot (id_slot)
+ * and responses carry llama-server's "timings".
+ *
+ * A realtime session answers each response.create with response.created,
+ * one response.text.delta per token and response.done with the usage (the
+ * instructions are cached like a system prompt). With realtimeIdleMs it is
+ * closed (status 1001) once the client stays silent for that long, the way
+ * the service and proxies end idle sessions.
+ *
+ * Answers are a fixed word sequence, so runs are reproducible. HTTP/1.1 with
+ * keep-alive, or HTTP/2 over cleartext when the client sends the connection
+ * preface right away (prior knowledge, h2c); one thread per connection and,
+ * on HTTP/2, one per stream, so concurrent streams share the connection.
+ */
+class MockLlmServer
+{
+public:
+    explicit MockLlmServer(const MockServerOptions &options);
+    ~MockLlmServer();
+
+    // Bind 127.0.0.1 and start accepting connections; false if the port is not available
+    bool start();
+
+    // Stop accepting, close open connections and join all threads
+    void stop();
+
+    // Port the server listens on (valid after start)
+    int port() const { return _port; }
+
+    // Requests answered / connections accepted since start
+    int requestCount() const { return _requests; }
+    int connectionCount() const { return _connections; }
+
+    // Ollama model loads (requests that had to wait loadMs)
+    int loadCount() const { return _loads; }
+
+    // Realtime WebSocket sessions opened since start (each response.create counts as a request)
+    int sessionCount() const { return _sessions; }
+
+    // Connections that spoke HTTP/2
+    int http2ConnectionCount() const { return _http2Connections; }
+
+    // Model named by the latest chat request (body, or path for Gemini)
+    std::string lastModel() const;
+
+    // Tokens of streamed HTTP answers written to the socket, over all requests
+    int tokensStreamed() const { return _tokensStreamed; }
+
+    // The text of a complete answer of 'tokens' tokens
+    static std::string answerText(int tokens);
+
+private:
+    struct Request
+    {
+        std::string method;
+        std::string path;
+        std::string body;
+        bool keepAlive = true;
+        std::string webSocketKey; // Sec-WebSocket-Key of an upgrade request
+    };
+
+    /**
+     * Destination of a response: an HTTP/1.1 connection or an HTTP/2 stream
+     */
+    class Reply
+    {
+    public:
+        virtual ~Reply() {}
+
+        // Status and headers; a negative contentLength sends a body of unknown length (chunked on HTTP/1.1)
+        virtual bool head(int status, const HeaderList &headers, int64_t contentLength) = 0;
+        virtual bool body(const char *data, size_t size) = 0;
+        virtual bool end() = 0;
+    };
+    class Http1Reply;
+    class Http2Stream;
+    struct Http2Connection;
+
+    // What the model evaluates for a request
+    struct Prompt
+    {
+        int evalTokens = 0;           // Prompt tokens processed (not read from the cache)
+        int cachedTokens = 0;         // Prompt tokens read from the cache
+        int cacheWriteTokens = 0;     // Prompt tokens written to the cache
+        bool includeUsage = false;    // OpenAI stream_options.include_usage
+        bool reportsTimings = false;  // llama-server (cache_prompt): responses carry "timings"
+        bool returnsContext = false;  // Ollama generate: the done line carries "context"
+        std::vector<int64_t> context; // Context before the answer (request context + prompt)
+    };
+
+    void acceptLoop();
+    void serveConnection(int fd);
+    bool readRequest(int fd, std::string &buffer, Request &request);
+    bool respond(Reply &reply, const Request &request);
+    bool sendError(Reply &reply, int status, bool withBody = true);
+    bool sendJson(Reply &reply, const std::string &payload);
+    bool sendRunningModels(Reply &reply);
+    void loadModel(const std::string &model, int64_t keepAliveSeconds);
+    bool sendStream(Reply &reply, const std::string &format, const std::string &model, const Prompt &prompt);
+    bool sendComplete(Reply &reply, const std::string &format, const std::string &model, const Prompt &prompt);
+    bool sendChunk(Reply &reply, const std::string &data);
+    void pace(int tokenIndex);
+    void serveRealtime(int fd, const Request &request, std::string &buffer);
+    void serveHttp2(int fd, std::string &buffer);
+    bool sendRealtimeResponse(int fd, const std::string &model, const std::string &event);
+
+    static std::string token(int index);
+    static bool sendAll(int fd, const char *data, size_t size);
+    static bool sendFrame(int fd, int opcode, const std::string &payload);
+    static int readFrame(int fd, std::string &buffer, int &opcode, std::string &payload, int timeoutMs);
+
+    MockServerOptions _options;
+    int _listenFd = -1;
+    int _port = 0;
+    std::atomic<bool> _running;
+    std::atomic<int> _requests;
+    std::atomic<int> _connections;
+    std::atomic<int> _errorsSent;
+    std::atomic<int> _loads;
+    std::atomic<int> _sessions;
+    std::atomic<int> _http2Connections;
+    std::atomic<int> _tokensStreamed;
+    mutable std::mutex _modelsMutex;
+    std::string _lastModel;
+    std::map<std::string, std::chrono::steady_clock::time_point> _residentUntil; // Loaded Ollama models
+    std::set<size_t> _cachedPrompts;                                             // Hashes of cached format + model + system prompt
+    std::map<int, std::vector<std::string>> _slotPrompts;                         // llama-server: last prompt (words) of each slot
+    std::thread _acceptThread;
+    std::mutex _mutex;
+    std::vector<std::thread> _workers;
+    std::vector<int> _clientFds;
+};
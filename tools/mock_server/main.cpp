@@ -0,0 +1,125 @@
+/**
+ * main.cpp - nppopenai-mock-server, a deterministic local LLM API for tests and benchmarks
+ *
+ * Usage: nppopenai-mock-server [--port 8080] [--tokens 50] [--token-rate 0] [--ttfb-ms 0]
+ *                              [--chunk-bytes 0] [--error-status 0] [--error-count -1]
+ *                              [--retry-after -1] [--stall-after -1] [--stall-ms 0]
+ *                              [--disconnect-after -1] [--load-ms 0] [--prefill-us 0]
+ *                              [--ws-idle-ms 0]
+ *
+ * Point api_url at http://127.0.0.1:PORT/v1/ (openai, claude) or http://127.0.0.1:PORT/
+ * (ollama) and use it like the real service; realtime sessions connect to
+ * ws://127.0.0.1:PORT/v1/realtime. Clients that start with the HTTP/2 preface
+ * (http_version=2-prior-knowledge) are answered over h2c.
+ */
+
+#include "MockLlmServer.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace
+{
+    std::atomic<bool> g_stop(false);
+
+    extern "C" void onSignal(int)
+    {
+        g_stop = true;
+    }
+
+    void printUsage()
+    {
+        std::fprintf(stderr,
+                     "Usage: nppopenai-mock-server [options]\n"
+                     "  --port N              Listen on 127.0.0.1:N (default 8080, 0 = any free port)\n"
+                     "  --tokens N            Tokens per answer (default 50)\n"
+                     "  --token-rate R        Tokens per second (default 0 = unlimited)\n"
+                     "  --ttfb-ms N           Delay before the first byte of each response\n"
+                     "  --chunk-bytes N       Send events in writes of N bytes (splits lines)\n"
+                     "  --error-status CODE   Answer with this HTTP status (e.g. 429, 503)\n"
+                     "  --error-count N       Only the first N requests get the error (default all)\n"
+                     "  --retry-after S       Retry-After header on errors\n"
+                     "  --stall-after N       Pause the stream after N tokens ...\n"
+                     "  --stall-ms N          ... for N milliseconds\n"
+                     "  --disconnect-after N  Drop the connection after N tokens\n"
+                     "  --load-ms N           Ollama: first request for a model waits N ms (load)\n"
+                     "  --prefill-us N        Prompt processing time per uncached prompt token in microseconds\n"
+                     "  --ws-idle-ms N        Realtime: close sessions idle for N ms\n");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    MockServerOptions options;
+    options.port = 8080;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc || arg.compare(0, 2, "--") != 0)
+        {
+            printUsage();
+            return (arg == "--help" || arg == "-h") ? 0 : 2;
+        }
+        const char *value = argv[++i];
+        if (arg == "--port")
+            options.port = std::atoi(value);
+        else if (arg == "--tokens")
+            options.tokens = std::atoi(value);
+        else if (arg == "--token-rate")
+            options.tokensPerSecond = std::atof(value);
+        else if (arg == "--ttfb-ms")
+            options.ttfbMs = std::atoi(value);
+        else if (arg == "--chunk-bytes")
+            options.chunkBytes = static_cast<size_t>(std::strtoul(value, nullptr, 10));
+        else if (arg == "--error-status")
+            options.errorStatus = std::atoi(value);
+        else if (arg == "--error-count")
+            options.errorCount = std::atoi(value);
+        else if (arg == "--retry-after")
+            options.retryAfterSeconds = std::atoi(value);
+        else if (arg == "--stall-after")
+            options.stallAfterTokens = std::atoi(value);
+        else if (arg == "--stall-ms")
+            options.stallMs = std::atoi(value);
+        else if (arg == "--disconnect-after")
+            options.disconnectAfterTokens = std::atoi(value);
+        else if (arg == "--load-ms")
+            options.loadMs = std::atoi(value);
+        else if (arg == "--prefill-us")
+            options.prefillUsPerToken = std::atoi(value);
+        else if (arg == "--ws-idle-ms")
+            options.realtimeIdleMs = std::atoi(value);
+        else
+        {
+            printUsage();
+            return 2;
+        }
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    MockLlmServer server(options);
+    if (!server.start())
+    {
+        std::fprintf(stderr, "Cannot listen on 127.0.0.1:%d: %s\n", options.port, std::strerror(errno));
+        return 1;
+    }
+    std::printf("Listening on http://127.0.0.1:%d\n", server.port());
+    std::fflush(stdout);
+
+    while (!g_stop)
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    server.stop();
+    std::printf("%d requests on %d connections, %d model loads, %d realtime sessions\n", server.requestCount(), server.connectionCount(),
+                server.loadCount(), server.sessionCount());
+    return 0;
+}